@@ -21,6 +21,7 @@
 //
 
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Graphics/DebugRenderer.h>
@@ -52,6 +53,9 @@ URHO3D_DEFINE_APPLICATION_MAIN(PhysicsStressTest)
 
 PhysicsStressTest::PhysicsStressTest(Context* context) :
     Sample(context),
+    statsUpdateTime_(0),
+    statsBodies_(0),
+    statsTimer_(0.0f),
     drawDebug_(false)
 {
 }
@@ -190,7 +194,9 @@ void PhysicsStressTest::CreateInstructions()
         "Use WASD keys and mouse/touch to move\n"
         "LMB to spawn physics objects\n"
         "F5 to save scene, F7 to load\n"
-        "Space to toggle physics debug geometry"
+        "Space to toggle physics debug geometry\n"
+        "T to toggle threaded physics simulation\n"
+        "R to benchmark batched raycasts"
     );
     instructionText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
     // The text has multiple rows. Center them in relation to each other
@@ -200,6 +206,11 @@ void PhysicsStressTest::CreateInstructions()
     instructionText->SetHorizontalAlignment(HA_CENTER);
     instructionText->SetVerticalAlignment(VA_CENTER);
     instructionText->SetPosition(0, ui->GetRoot()->GetHeight() / 4);
+
+    // Construct the physics benchmark text to the top left corner
+    statsText_ = ui->GetRoot()->CreateChild<Text>();
+    statsText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
+    statsText_->SetPosition(10, 10);
 }
 
 void PhysicsStressTest::SetupViewport()
@@ -272,6 +283,17 @@ void PhysicsStressTest::MoveCamera(float timeStep)
     // Toggle physics debug geometry with space
     if (input->GetKeyPress(KEY_SPACE))
         drawDebug_ = !drawDebug_;
+
+    // Toggle threaded physics simulation with T
+    if (input->GetKeyPress(KEY_T))
+    {
+        auto* physicsWorld = scene_->GetComponent<PhysicsWorld>();
+        physicsWorld->SetThreadedSimulation(!physicsWorld->GetThreadedSimulation());
+    }
+
+    // Compare batched raycasts against single raycasts with R
+    if (input->GetKeyPress(KEY_R))
+        RunRaycastBenchmark();
 }
 
 void PhysicsStressTest::SpawnObject()
@@ -311,6 +333,57 @@ void PhysicsStressTest::HandleUpdate(StringHash eventType, VariantMap& eventData
 
     // Move the camera, scale movement with time step
     MoveCamera(timeStep);
+
+    UpdateStats(timeStep);
+}
+
+void PhysicsStressTest::UpdateStats(float timeStep)
+{
+    // Measure the throughput as simulated active bodies per millisecond of physics update time, averaged over half a second
+    auto* physicsWorld = scene_->GetComponent<PhysicsWorld>();
+    statsUpdateTime_ += physicsWorld->GetUpdateTime();
+    statsBodies_ += physicsWorld->GetNumActiveBodies();
+    statsTimer_ += timeStep;
+
+    if (statsTimer_ >= 0.5f)
+    {
+        float updateMs = statsUpdateTime_ / 1000.0f;
+        float bodiesPerMs = updateMs > 0.0f ? statsBodies_ / updateMs : 0.0f;
+        statsText_->SetText(ToString("Physics: %s\nActive bodies: %u\nBodies per ms: %.1f\n%s",
+            physicsWorld->GetThreadedSimulation() ? "threaded" : "single-threaded", physicsWorld->GetNumActiveBodies(),
+            bodiesPerMs, raycastStats_.CString()));
+
+        statsUpdateTime_ = 0;
+        statsBodies_ = 0;
+        statsTimer_ = 0.0f;
+    }
+}
+
+void PhysicsStressTest::RunRaycastBenchmark()
+{
+    const unsigned NUM_RAYS = 10000;
+    const float RAY_DISTANCE = 250.0f;
+
+    // Spread the rays randomly in front of the camera
+    PODVector<PhysicsRaycastQuery> queries(NUM_RAYS);
+    for (unsigned i = 0; i < NUM_RAYS; ++i)
+    {
+        Vector3 direction = cameraNode_->GetRotation() * Vector3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), 1.0f);
+        queries[i] = PhysicsRaycastQuery(Ray(cameraNode_->GetPosition(), direction), RAY_DISTANCE);
+    }
+
+    auto* physicsWorld = scene_->GetComponent<PhysicsWorld>();
+    PODVector<PhysicsRaycastResult> results(NUM_RAYS);
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_RAYS; ++i)
+        physicsWorld->RaycastSingle(results[i], queries[i].ray_, queries[i].maxDistance_);
+    long long singleTime = timer.GetUSec(true);
+
+    physicsWorld->RaycastBatch(results, queries);
+    long long batchTime = timer.GetUSec(false);
+
+    raycastStats_ = ToString("%u raycasts: single %.2f ms, batched %.2f ms", NUM_RAYS, singleTime / 1000.0f, batchTime / 1000.0f);
 }
 
 void PhysicsStressTest::HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData)
@@ -29,6 +29,7 @@ namespace Urho3D
 
 class Node;
 class Scene;
+class Text;
 
 }
 
@@ -37,6 +38,8 @@ class Scene;
 ///     - Physics and rendering performance with a high (1000) moving object count
 ///     - Using triangle meshes for collision
 ///     - Optimizing physics simulation by leaving out collision event signaling
+///     - Threaded physics simulation and measuring its throughput
+///     - Batched raycasts compared to casting rays one at a time
 class PhysicsStressTest : public Sample
 {
     URHO3D_OBJECT(PhysicsStressTest, Sample);
@@ -88,7 +91,21 @@ private:
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle the post-render update event.
     void HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Accumulate physics timing and update the benchmark text.
+    void UpdateStats(float timeStep);
+    /// Cast rays from the camera one at a time and as a batch, and store the timings.
+    void RunRaycastBenchmark();
 
+    /// Physics benchmark text.
+    SharedPtr<Text> statsText_;
+    /// Accumulated physics update time in microseconds.
+    long long statsUpdateTime_;
+    /// Accumulated active body count over the measured frames.
+    unsigned long long statsBodies_;
+    /// Time since the benchmark text was last updated.
+    float statsTimer_;
+    /// Result of the last raycast benchmark.
+    String raycastStats_;
     /// Flag for drawing debug geometry.
     bool drawDebug_;
 };
@@ -24,6 +24,7 @@
 #include <Urho3D/Audio/AudioEvents.h>
 #include <Urho3D/Audio/Sound.h>
 #include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/IO/Log.h>
@@ -56,11 +57,15 @@ static const char* soundResourceNames[] = {
     "Sounds/Powerup.wav"
 };
 
+/// Number of voices added to the mixing stress test at a time.
+static const unsigned STRESS_TEST_VOICES = 256;
+
 URHO3D_DEFINE_APPLICATION_MAIN(SoundEffects)
 
 SoundEffects::SoundEffects(Context* context) :
     Sample(context),
-    musicSource_(nullptr)
+    musicSource_(nullptr),
+    statsText_(nullptr)
 {
 }
 
@@ -90,6 +95,9 @@ void SoundEffects::Start()
     // Create the user interface
     CreateUI();
 
+    // Subscribe to the update event for the mixing stress test
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(SoundEffects, HandleUpdate));
+
     // Set the mouse mode to use in the sample
     Sample::InitMouseMode(MM_FREE);
 }
@@ -118,6 +126,13 @@ void SoundEffects::CreateUI()
     button = CreateButton(160, 80, 120, 40, "Stop Music");
     SubscribeToEvent(button, E_RELEASED, URHO3D_HANDLER(SoundEffects, HandleStopMusic));
 
+    // Create buttons for the mixing stress test
+    button = CreateButton(300, 80, 120, 40, "Add 256 Voices");
+    SubscribeToEvent(button, E_RELEASED, URHO3D_HANDLER(SoundEffects, HandleAddStressVoices));
+
+    button = CreateButton(440, 80, 120, 40, "Remove Voices");
+    SubscribeToEvent(button, E_RELEASED, URHO3D_HANDLER(SoundEffects, HandleRemoveStressVoices));
+
     auto* audio = GetSubsystem<Audio>();
 
     // Create sliders for controlling sound and music master volume
@@ -128,6 +143,11 @@ void SoundEffects::CreateUI()
     slider = CreateSlider(20, 200, 200, 20, "Music Volume");
     slider->SetValue(audio->GetMasterGain(SOUND_MUSIC));
     SubscribeToEvent(slider, E_SLIDERCHANGED, URHO3D_HANDLER(SoundEffects, HandleMusicVolume));
+
+    // Create a text for the mixing statistics
+    statsText_ = root->CreateChild<Text>();
+    statsText_->SetPosition(20, 260);
+    statsText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 12);
 }
 
 Button* SoundEffects::CreateButton(int x, int y, int xSize, int ySize, const String& text)
@@ -226,3 +246,52 @@ void SoundEffects::HandleMusicVolume(StringHash eventType, VariantMap& eventData
     float newVolume = eventData[P_VALUE].GetFloat();
     GetSubsystem<Audio>()->SetMasterGain(SOUND_MUSIC, newVolume);
 }
+
+void SoundEffects::HandleAddStressVoices(StringHash eventType, VariantMap& eventData)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+
+    Node* stressGroup = scene_->GetChild("StressVoices");
+    if (!stressGroup)
+        stressGroup = scene_->CreateChild("StressVoices");
+
+    for (unsigned i = 0; i < STRESS_TEST_VOICES; ++i)
+    {
+        // Play the sound effects at varying frequencies so that the mixer has to resample them. Keep the gain low so that
+        // the sum of all the voices does not clip
+        auto* sound = cache->GetResource<Sound>(soundResourceNames[Rand() % NUM_SOUNDS]);
+        auto* soundSource = stressGroup->CreateComponent<SoundSource>();
+        soundSource->Play(sound, sound->GetFrequency() * Random(0.5f, 1.5f), 0.02f, Random(-1.0f, 1.0f));
+    }
+}
+
+void SoundEffects::HandleRemoveStressVoices(StringHash eventType, VariantMap& eventData)
+{
+    Node* stressGroup = scene_->GetChild("StressVoices");
+    if (stressGroup)
+        stressGroup->Remove();
+}
+
+void SoundEffects::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    Node* stressGroup = scene_->GetChild("StressVoices");
+    if (!stressGroup)
+    {
+        statsText_->SetText(String::EMPTY);
+        return;
+    }
+
+    // Restart the stress test voices as they finish. The playback commands are queued to the mixer without waiting for it
+    const Vector<SharedPtr<Component> >& components = stressGroup->GetComponents();
+    for (unsigned i = 0; i < components.Size(); ++i)
+    {
+        auto* soundSource = static_cast<SoundSource*>(components[i].Get());
+        if (!soundSource->IsPlaying())
+            soundSource->Play(soundSource->GetSound());
+    }
+
+    AudioMixStats stats = GetSubsystem<Audio>()->GetMixStats();
+    statsText_->SetText("Stress test voices " + String(components.Size()) + "\nMixed voices " + String(stats.numVoices_) +
+        "\nMix time " + String((int)stats.mixTime_) + " us, max " +
+        String((int)stats.maxMixTime_) + " us");
+}
@@ -30,6 +30,7 @@ namespace Urho3D
 class Button;
 class Scene;
 class Slider;
+class Text;
 
 }
 
@@ -37,6 +38,7 @@ class Slider;
 /// This sample demonstrates:
 ///     - Playing sound effects and music
 ///     - Controlling sound and music master volume
+///     - Mixing a large number of simultaneous sounds and reading the mixing statistics
 class SoundEffects : public Sample
 {
     URHO3D_OBJECT(SoundEffects, Sample);
@@ -83,6 +85,15 @@ private:
     void HandleSoundVolume(StringHash eventType, VariantMap& eventData);
     /// Handle music volume slider change.
     void HandleMusicVolume(StringHash eventType, VariantMap& eventData);
+    /// Handle "add voices" button click.
+    void HandleAddStressVoices(StringHash eventType, VariantMap& eventData);
+    /// Handle "remove voices" button click.
+    void HandleRemoveStressVoices(StringHash eventType, VariantMap& eventData);
+    /// Handle the logic update event. Restart finished stress test voices and show the mixing statistics.
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+
+    /// Mixing statistics text.
+    Text* statsText_;
 };
 
 
@@ -51,6 +51,15 @@
 
 URHO3D_DEFINE_APPLICATION_MAIN(CrowdNavigation)
 
+/// Number of agents added to the crowd stress test at a time.
+static const unsigned STRESS_TEST_BATCH_SIZE = 1000;
+/// Size of the crowd partition regions used in the stress test.
+static const float STRESS_TEST_PARTITION_SIZE = 25.0f;
+/// Maximum number of agents, including the ghost agents near the borders, in each crowd partition region.
+static const unsigned STRESS_TEST_MAX_AGENTS = 1500;
+/// Maximum number of agents in the single crowd used outside the stress test. Same as the CrowdManager default.
+static const unsigned DEFAULT_MAX_AGENTS = 512;
+
 CrowdNavigation::CrowdNavigation(Context* context) :
     Sample(context)
 {
@@ -213,6 +222,7 @@ void CrowdNavigation::CreateUI()
         "MMB or O key to add obstacles or remove obstacles/agents\n"
         "F5 to save scene, F7 to load\n"
         "Tab to toggle navigation mesh streaming\n"
+        "B to add 1000 stress test agents, N to remove them\n"
         "Space to toggle debug geometry\n"
         "F12 to toggle this instruction text"
     );
@@ -224,6 +234,11 @@ void CrowdNavigation::CreateUI()
     instructionText_->SetHorizontalAlignment(HA_CENTER);
     instructionText_->SetVerticalAlignment(VA_CENTER);
     instructionText_->SetPosition(0, ui->GetRoot()->GetHeight() / 4);
+
+    // Construct a text for the crowd statistics of the stress test to the top left corner
+    statsText_ = ui->GetRoot()->CreateChild<Text>();
+    statsText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
+    statsText_->SetPosition(10, 10);
 }
 
 void CrowdNavigation::SetupViewport()
@@ -270,6 +285,10 @@ void CrowdNavigation::SpawnJack(const Vector3& pos, Node* jackGroup)
     agent->SetHeight(2.0f);
     agent->SetMaxSpeed(3.0f);
     agent->SetMaxAccel(5.0f);
+
+    // Stream the navigation mesh tiles in around the new jack as well
+    if (useStreaming_)
+        scene_->GetComponent<DynamicNavigationMesh>()->AddStreamingObserver(jackNode);
 }
 
 void CrowdNavigation::CreateMushroom(const Vector3& pos)
@@ -336,6 +355,55 @@ void CrowdNavigation::CreateMovingBarrels(DynamicNavigationMesh* navMesh)
     barrel->Remove();
 }
 
+void CrowdNavigation::AddStressTestAgents()
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto* navMesh = scene_->GetComponent<DynamicNavigationMesh>();
+    auto* crowdManager = scene_->GetComponent<CrowdManager>();
+
+    // A single Detour crowd would need to simulate all the agents on the main thread. Instead split the crowd into square
+    // regions, each simulated by its own Detour crowd and updated in parallel on the work queue. Agents are handed over to the
+    // neighbouring region when they cross a border. Note that the maximum number of agents now applies to each region
+    crowdManager->SetPartitionSize(STRESS_TEST_PARTITION_SIZE);
+    crowdManager->SetMaxAgents(STRESS_TEST_MAX_AGENTS);
+
+    Node* stressGroup = scene_->GetChild("StressAgents");
+    if (!stressGroup)
+        stressGroup = scene_->CreateChild("StressAgents");
+    Model* model = cache->GetResource<Model>("Models/Cylinder.mdl");
+    Material* material = cache->GetResource<Material>("Materials/Stone.xml");
+    for (unsigned i = 0; i < STRESS_TEST_BATCH_SIZE; ++i)
+    {
+        Node* agentNode = stressGroup->CreateChild("StressAgent");
+        agentNode->SetPosition(navMesh->GetRandomPoint());
+        agentNode->SetScale(Vector3(0.6f, 1.5f, 0.6f));
+        auto* modelObject = agentNode->CreateComponent<StaticModel>();
+        modelObject->SetModel(model);
+        modelObject->SetMaterial(material);
+
+        // Use the cheaper medium navigation quality, which does not do obstacle avoidance velocity planning
+        auto* agent = agentNode->CreateComponent<CrowdAgent>();
+        agent->SetRadius(0.3f);
+        agent->SetHeight(1.5f);
+        agent->SetMaxSpeed(3.0f);
+        agent->SetMaxAccel(5.0f);
+        agent->SetNavigationQuality(NAVIGATIONQUALITY_MEDIUM);
+        agent->SetTargetPosition(navMesh->GetRandomPoint());
+    }
+}
+
+void CrowdNavigation::RemoveStressTestAgents()
+{
+    Node* stressGroup = scene_->GetChild("StressAgents");
+    if (stressGroup)
+        stressGroup->Remove();
+
+    // Go back to a single Detour crowd
+    auto* crowdManager = scene_->GetComponent<CrowdManager>();
+    crowdManager->SetPartitionSize(0.0f);
+    crowdManager->SetMaxAgents(DEFAULT_MAX_AGENTS);
+}
+
 void CrowdNavigation::SetPathPoint(bool spawning)
 {
     Vector3 hitPos;
@@ -478,72 +546,31 @@ void CrowdNavigation::ToggleStreaming(bool enabled)
     auto* navMesh = scene_->GetComponent<DynamicNavigationMesh>();
     if (enabled)
     {
-        int maxTiles = (2 * streamingDistance_ + 1) * (2 * streamingDistance_ + 1);
-        BoundingBox boundingBox = navMesh->GetBoundingBox();
-        SaveNavigationData();
-        navMesh->Allocate(boundingBox, maxTiles);
-    }
-    else
-        navMesh->Build();
-}
-
-void CrowdNavigation::UpdateStreaming()
-{
-    // Center the navigation mesh at the crowd of jacks
-    Vector3 averageJackPosition;
-    if (Node* jackGroup = scene_->GetChild("Jacks"))
-    {
-        const unsigned numJacks = jackGroup->GetNumChildren();
-        for (unsigned i = 0; i < numJacks; ++i)
-            averageJackPosition += jackGroup->GetChild(i)->GetWorldPosition();
-        averageJackPosition /= (float)numJacks;
-    }
-
-    // Compute currently loaded area
-    auto* navMesh = scene_->GetComponent<DynamicNavigationMesh>();
-    const IntVector2 jackTile = navMesh->GetTileIndex(averageJackPosition);
-    const IntVector2 numTiles = navMesh->GetNumTiles();
-    const IntVector2 beginTile = VectorMax(IntVector2::ZERO, jackTile - IntVector2::ONE * streamingDistance_);
-    const IntVector2 endTile = VectorMin(jackTile + IntVector2::ONE * streamingDistance_, numTiles - IntVector2::ONE);
-
-    // Remove tiles
-    for (HashSet<IntVector2>::Iterator i = addedTiles_.Begin(); i != addedTiles_.End();)
-    {
-        const IntVector2 tileIdx = *i;
-        if (beginTile.x_ <= tileIdx.x_ && tileIdx.x_ <= endTile.x_ && beginTile.y_ <= tileIdx.y_ && tileIdx.y_ <= endTile.y_)
-            ++i;
-        else
-        {
-            navMesh->RemoveTile(tileIdx);
-            i = addedTiles_.Erase(i);
-        }
-    }
-
-    // Add tiles
-    for (int z = beginTile.y_; z <= endTile.y_; ++z)
-        for (int x = beginTile.x_; x <= endTile.x_; ++x)
+        // Save the tiles to a tile file, then stream them back in from the file around the jacks. Only the tiles near the jacks
+        // are kept in memory. The file goes to the preferences directory, as the program directory may not be writable
+        String preferencesDir = GetSubsystem<FileSystem>()->GetAppPreferencesDir("urho3d", "samples");
+        if (preferencesDir.Empty())
+            return;
+        String fileName = preferencesDir + "CrowdNavigationTiles.bin";
         {
-            const IntVector2 tileIdx(x, z);
-            if (!navMesh->HasTile(tileIdx) && tileData_.Contains(tileIdx))
-            {
-                addedTiles_.Insert(tileIdx);
-                navMesh->AddTile(tileData_[tileIdx]);
-            }
+            File saveFile(context_, fileName, FILE_WRITE);
+            if (!navMesh->SaveStreamingData(saveFile))
+                return;
         }
-}
 
-void CrowdNavigation::SaveNavigationData()
-{
-    auto* navMesh = scene_->GetComponent<DynamicNavigationMesh>();
-    tileData_.Clear();
-    addedTiles_.Clear();
-    const IntVector2 numTiles = navMesh->GetNumTiles();
-    for (int z = 0; z < numTiles.y_; ++z)
-        for (int x = 0; x <= numTiles.x_; ++x)
+        if (Node* jackGroup = scene_->GetChild("Jacks"))
         {
-            const IntVector2 tileIdx = IntVector2(x, z);
-            tileData_[tileIdx] = navMesh->GetTileData(tileIdx);
+            for (unsigned i = 0; i < jackGroup->GetNumChildren(); ++i)
+                navMesh->AddStreamingObserver(jackGroup->GetChild(i));
         }
+        navMesh->SetStreamingDistance(streamingDistance_);
+        navMesh->SetStreamingFile(fileName);
+    }
+    else
+    {
+        navMesh->SetStreamingFile(String::EMPTY);
+        navMesh->Build();
+    }
 }
 
 void CrowdNavigation::HandleUpdate(StringHash eventType, VariantMap& eventData)
@@ -563,9 +590,23 @@ void CrowdNavigation::HandleUpdate(StringHash eventType, VariantMap& eventData)
         useStreaming_ = !useStreaming_;
         ToggleStreaming(useStreaming_);
     }
-    if (useStreaming_)
-        UpdateStreaming();
 
+    // Add or remove crowd stress test agents
+    if (input->GetKeyPress(KEY_B))
+        AddStressTestAgents();
+    else if (input->GetKeyPress(KEY_N))
+        RemoveStressTestAgents();
+
+    // Show the crowd statistics while the stress test is running
+    Node* stressGroup = scene_->GetChild("StressAgents");
+    if (stressGroup)
+    {
+        auto* crowdManager = scene_->GetComponent<CrowdManager>();
+        statsText_->SetText("Stress test agents " + String(stressGroup->GetNumChildren()) + "\nCrowd partitions " +
+            String(crowdManager->GetNumPartitions()) + "\nFrame time " + String(timeStep * 1000.0f) + " ms");
+    }
+    else
+        statsText_->SetText(String::EMPTY);
 }
 
 void CrowdNavigation::HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData)
@@ -607,6 +648,13 @@ void CrowdNavigation::HandleCrowdAgentReposition(StringHash eventType, VariantMa
     Vector3 velocity = eventData[P_VELOCITY].GetVector3();
     float timeStep = eventData[P_TIMESTEP].GetFloat();
 
+    // Keep the stress test agents wandering: pick a new random target once arrived
+    if (eventData[P_ARRIVED].GetBool() && node->GetParent()->GetName() == "StressAgents")
+    {
+        agent->SetTargetPosition(scene_->GetComponent<DynamicNavigationMesh>()->GetRandomPoint());
+        return;
+    }
+
     // Only Jack agent has animation controller
     auto* animCtrl = node->GetComponent<AnimationController>();
     if (animCtrl)
@@ -43,6 +43,7 @@ class Scene;
 ///     - Accessing crowd agents with the crowd manager
 ///     - Using off-mesh connections to make boxes climbable
 ///     - Using agents to simulate moving obstacles
+///     - Partitioning a large crowd into regions that are updated in parallel
 class CrowdNavigation : public Sample
 {
     URHO3D_OBJECT(CrowdNavigation, Sample);
@@ -150,14 +151,14 @@ private:
     void CreateBoxOffMeshConnections(DynamicNavigationMesh* navMesh, Node* boxGroup);
     /// Create some movable barrels as crowd agents.
     void CreateMovingBarrels(DynamicNavigationMesh* navMesh);
+    /// Add a batch of lightweight agents for the crowd stress test and partition the crowd.
+    void AddStressTestAgents();
+    /// Remove the stress test agents.
+    void RemoveStressTestAgents();
     /// Utility function to raycast to the cursor position. Return true if hit.
     bool Raycast(float maxDistance, Vector3& hitPos, Drawable*& hitDrawable);
     /// Toggle navigation mesh streaming.
     void ToggleStreaming(bool enabled);
-    /// Update navigation mesh streaming.
-    void UpdateStreaming();
-    /// Save navigation data for streaming.
-    void SaveNavigationData();
     /// Handle the logic update event.
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle the post-render update event.
@@ -173,12 +174,10 @@ private:
     bool useStreaming_{};
     /// Streaming distance.
     int streamingDistance_{2};
-    /// Tile data.
-    HashMap<IntVector2, PODVector<unsigned char> > tileData_;
-    /// Added tiles.
-    HashSet<IntVector2> addedTiles_;
     /// Flag for drawing debug geometry.
     bool drawDebug_{};
     /// Instruction text UI-element.
     Text* instructionText_{};
+    /// Crowd statistics text UI-element.
+    Text* statsText_{};
 };
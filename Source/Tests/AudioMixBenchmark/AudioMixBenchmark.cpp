@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Audio/Audio.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <SDL/SDL.h>
+
+#include <cstdio>
+
+#include "TestEngine.h"
+
+using namespace Urho3D;
+
+/// Number of playing sound sources.
+static const unsigned NUM_VOICES = 256;
+/// Output frames mixed per audio callback.
+static const unsigned FRAGMENT_FRAMES = 1024;
+/// Fragments mixed before measuring.
+static const unsigned NUM_WARMUP_FRAGMENTS = 16;
+/// Measured batches of fragments. The fastest batch is reported to filter out scheduling noise.
+static const unsigned NUM_BATCHES = 8;
+/// Fragments per measured batch.
+static const unsigned NUM_BATCH_FRAGMENTS = 50;
+/// Output mixing rate.
+static const int MIX_RATE = 44100;
+
+/// Create a looped sine wave sound in the specified format.
+static SharedPtr<Sound> CreateSound(Context* context, int frequency, bool sixteenBit, bool stereo)
+{
+    unsigned numChannels = stereo ? 2 : 1;
+    // Use an odd length so that loop wraparound falls at varying positions within the fragments
+    unsigned numFrames = (unsigned)frequency / 2 + 37;
+    unsigned numSamples = numFrames * numChannels;
+    unsigned dataSize = numSamples * (sixteenBit ? 2 : 1);
+
+    PODVector<signed char> data(dataSize);
+    for (unsigned i = 0; i < numSamples; ++i)
+    {
+        float value = Sin(i * 2.0f) * 0.8f;
+        if (sixteenBit)
+            reinterpret_cast<short*>(&data[0])[i] = (short)(value * 32767.0f);
+        else
+            data[i] = (signed char)(value * 127.0f);
+    }
+
+    SharedPtr<Sound> sound(new Sound(context));
+    sound->SetSize(dataSize);
+    sound->SetFormat((unsigned)frequency, sixteenBit, stereo);
+    sound->SetData(&data[0], dataSize);
+    sound->SetLooped(true);
+    return sound;
+}
+
+/// Pause the dummy audio device so that the mixer is only driven by the benchmark.
+static void PauseAudioDevice()
+{
+    // Device ID 1 is reserved for the legacy SDL audio API
+    for (SDL_AudioDeviceID id = 2; id < 16; ++id)
+    {
+        if (SDL_GetAudioDeviceStatus(id) == SDL_AUDIO_PLAYING)
+            SDL_PauseAudioDevice(id, 1);
+    }
+}
+
+/// Mix the sound sources and print the timing. Return false if no output was produced.
+static bool RunBenchmark(Context* context, const Vector<SharedPtr<Sound> >& sounds)
+{
+    auto* audio = context->GetSubsystem<Audio>();
+    if (!audio->SetMode(100, MIX_RATE, true, true))
+        return false;
+    PauseAudioDevice();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    for (unsigned i = 0; i < NUM_VOICES; ++i)
+    {
+        Sound* sound = sounds[i % sounds.Size()];
+        // Mix unity rate and resampled voices with varying panning
+        float frequency = sound->GetFrequency() * (i % 3 ? 0.7f + 0.1f * (i % 7) : 1.0f);
+        float panning = ((int)(i % 9) - 4) * 0.25f;
+        scene->CreateComponent<SoundSource>()->Play(sound, frequency, 0.01f, panning);
+    }
+
+    PODVector<short> output(FRAGMENT_FRAMES * 2);
+    bool audible = false;
+    for (unsigned i = 0; i < NUM_WARMUP_FRAGMENTS; ++i)
+    {
+        audio->MixOutput(&output[0], FRAGMENT_FRAMES);
+        for (unsigned j = 0; j < output.Size(); ++j)
+            audible |= output[j] != 0;
+    }
+
+    long long bestTime = M_MAX_INT;
+    HiresTimer timer;
+    for (unsigned i = 0; i < NUM_BATCHES; ++i)
+    {
+        timer.Reset();
+        for (unsigned j = 0; j < NUM_BATCH_FRAGMENTS; ++j)
+            audio->MixOutput(&output[0], FRAGMENT_FRAMES);
+        bestTime = Min(bestTime, timer.GetUSec(false));
+    }
+
+    AudioMixStats stats = audio->GetMixStats();
+    double fragmentTime = (double)bestTime / NUM_BATCH_FRAGMENTS;
+    double realTime = 1000000.0 * FRAGMENT_FRAMES / MIX_RATE;
+    printf("%u voices: %.1f us per %u-frame fragment (%.1f%% of real time), %u active voices\n", NUM_VOICES, fragmentTime,
+        FRAGMENT_FRAMES, 100.0 * fragmentTime / realTime, stats.numVoices_);
+
+    if (!audible || !stats.numVoices_)
+    {
+        printf("No output was mixed\n");
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine = CreateTestEngine(context);
+    if (!engine)
+        return EXIT_FAILURE;
+
+    // Cover the 16-bit and 8-bit, mono and stereo mixing paths
+    Vector<SharedPtr<Sound> > sounds;
+    sounds.Push(CreateSound(context, 44100, true, false));
+    sounds.Push(CreateSound(context, 22050, true, false));
+    sounds.Push(CreateSound(context, 44100, true, true));
+    sounds.Push(CreateSound(context, 11025, false, false));
+    sounds.Push(CreateSound(context, 48000, false, true));
+
+    if (!RunBenchmark(context, sounds))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Light.h>
+#include <Urho3D/Graphics/LightClusters.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+#include "TestEngine.h"
+
+using namespace Urho3D;
+
+/// Number of clustered lights in the scene.
+static const unsigned NUM_LIGHTS = 512;
+/// Binnings done before measuring.
+static const unsigned NUM_WARMUP_BINS = 10;
+/// Binnings measured.
+static const unsigned NUM_BINS = 200;
+
+/// Return whether a cluster contains a light, or has overflown so that the light may have been dropped.
+static bool ClusterHasLight(LightClusters* clusters, unsigned index, Light* light)
+{
+    unsigned numLights = clusters->GetClusterNumLights(index);
+    if (numLights == MAX_LIGHTS_PER_CLUSTER)
+        return true;
+
+    for (unsigned i = 0; i < numLights; ++i)
+    {
+        if (clusters->GetClusterLight(index, i) == light)
+            return true;
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine = CreateTestEngine(context);
+    if (!engine)
+        return EXIT_FAILURE;
+
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+
+    auto* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+    camera->SetFarClip(300.0f);
+    camera->SetAspectRatio(16.0f / 9.0f);
+
+    // Scatter point and spot lights in front of the camera, with a fixed seed so that every run bins the same lights
+    SetRandomSeed(1);
+    PODVector<Light*> lights;
+    for (unsigned i = 0; i < NUM_LIGHTS; ++i)
+    {
+        Node* node = scene->CreateChild("Light");
+        node->SetPosition(Vector3(Random(-150.0f, 150.0f), Random(-20.0f, 20.0f), Random(5.0f, 250.0f)));
+        node->SetRotation(Quaternion(Random(-90.0f, 90.0f), Random(-180.0f, 180.0f), 0.0f));
+        auto* light = node->CreateComponent<Light>();
+        light->SetLightType((i & 3) ? LIGHT_POINT : LIGHT_SPOT);
+        light->SetRange(Random(5.0f, 20.0f));
+        lights.Push(light);
+    }
+
+    SharedPtr<LightClusters> clusters(new LightClusters(context));
+
+    long long binTime = 0;
+    for (unsigned i = 0; i < NUM_WARMUP_BINS + NUM_BINS; ++i)
+    {
+        clusters->Bin(camera, lights);
+        if (i >= NUM_WARMUP_BINS)
+            binTime += clusters->GetBinTime();
+    }
+
+    // Every light must be found in the clusters of points well inside its volume that the camera sees
+    const Frustum& frustum = camera->GetFrustum();
+    unsigned numChecked = 0;
+    for (unsigned i = 0; i < lights.Size(); ++i)
+    {
+        Light* light = lights[i];
+        Node* node = light->GetNode();
+        float range = light->GetRange();
+
+        Vector3 points[7];
+        unsigned numPoints;
+        if (light->GetLightType() == LIGHT_POINT)
+        {
+            points[0] = node->GetWorldPosition();
+            points[1] = points[0] + Vector3(0.5f * range, 0.0f, 0.0f);
+            points[2] = points[0] - Vector3(0.5f * range, 0.0f, 0.0f);
+            points[3] = points[0] + Vector3(0.0f, 0.5f * range, 0.0f);
+            points[4] = points[0] - Vector3(0.0f, 0.5f * range, 0.0f);
+            points[5] = points[0] + Vector3(0.0f, 0.0f, 0.5f * range);
+            points[6] = points[0] - Vector3(0.0f, 0.0f, 0.5f * range);
+            numPoints = 7;
+        }
+        else
+        {
+            points[0] = node->GetWorldPosition() + node->GetWorldDirection() * 0.25f * range;
+            points[1] = node->GetWorldPosition() + node->GetWorldDirection() * 0.5f * range;
+            points[2] = node->GetWorldPosition() + node->GetWorldDirection() * 0.75f * range;
+            numPoints = 3;
+        }
+
+        for (unsigned j = 0; j < numPoints; ++j)
+        {
+            if (frustum.IsInside(points[j]) == OUTSIDE)
+                continue;
+
+            ++numChecked;
+            if (!ClusterHasLight(clusters, clusters->GetClusterIndex(points[j]), light))
+            {
+                printf("Light %u is missing from the cluster at %s\n", i, points[j].ToString().CString());
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (!numChecked)
+    {
+        printf("No lights were in view\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned numIndices = 0;
+    for (unsigned i = 0; i < clusters->GetNumClusters(); ++i)
+        numIndices += clusters->GetClusterNumLights(i);
+
+    printf("%u lights, %u clusters, %u binnings: %.1f us per binning, %u light indices, %u points checked\n", NUM_LIGHTS,
+        clusters->GetNumClusters(), NUM_BINS, (double)binTime / NUM_BINS, numIndices, numChecked);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/IOEvents.h>
+#include <Urho3D/IO/PackageFile.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Network/Protocol.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+#include "TestEngine.h"
+
+using namespace Urho3D;
+
+/// Loopback server port.
+static const unsigned short SERVER_PORT = 2347;
+/// Time allowed for connecting, downloading and loading the scene.
+static const unsigned TIMEOUT_MSEC = 20000;
+
+/// File entry to write into a test package.
+struct TestEntry
+{
+    /// Name.
+    String name_;
+    /// Data.
+    PODVector<unsigned char> data_;
+};
+
+/// Return pseudo-random data.
+static PODVector<unsigned char> CreateData(unsigned size, unsigned seed)
+{
+    SetRandomSeed(seed);
+    PODVector<unsigned char> data(size);
+    for (unsigned i = 0; i < size; ++i)
+        data[i] = (unsigned char)Rand();
+    return data;
+}
+
+/// Write an uncompressed package in the original format. Return the package checksum.
+static unsigned WritePackage(Context* context, const String& fileName, const Vector<TestEntry>& entries)
+{
+    unsigned headerSize = 3 * sizeof(unsigned);
+    for (unsigned i = 0; i < entries.Size(); ++i)
+        headerSize += entries[i].name_.Length() + 1 + 3 * sizeof(unsigned);
+
+    unsigned checksum = 0;
+    PODVector<unsigned> entryChecksums;
+    for (unsigned i = 0; i < entries.Size(); ++i)
+    {
+        unsigned entryChecksum = 0;
+        for (unsigned j = 0; j < entries[i].data_.Size(); ++j)
+        {
+            checksum = SDBMHash(checksum, entries[i].data_[j]);
+            entryChecksum = SDBMHash(entryChecksum, entries[i].data_[j]);
+        }
+        entryChecksums.Push(entryChecksum);
+    }
+
+    File dest(context, fileName, FILE_WRITE);
+    dest.WriteFileID("UPAK");
+    dest.WriteUInt(entries.Size());
+    dest.WriteUInt(checksum);
+    unsigned offset = headerSize;
+    for (unsigned i = 0; i < entries.Size(); ++i)
+    {
+        dest.WriteString(entries[i].name_);
+        dest.WriteUInt(offset);
+        dest.WriteUInt(entries[i].data_.Size());
+        dest.WriteUInt(entryChecksums[i]);
+        offset += entries[i].data_.Size();
+    }
+    for (unsigned i = 0; i < entries.Size(); ++i)
+        dest.Write(entries[i].data_.Buffer(), entries[i].data_.Size());
+    dest.WriteUInt(dest.GetSize() + sizeof(unsigned));
+
+    return checksum;
+}
+
+/// Package download test. Assigns the server scene to connecting clients and records the log.
+class PackageDownloadTest : public Object
+{
+    URHO3D_OBJECT(PackageDownloadTest, Object);
+
+public:
+    /// Construct.
+    PackageDownloadTest(Context* context, Scene* serverScene) :
+        Object(context),
+        serverScene_(serverScene)
+    {
+        SubscribeToEvent(E_CLIENTCONNECTED, URHO3D_HANDLER(PackageDownloadTest, HandleClientConnected));
+        SubscribeToEvent(E_LOGMESSAGE, URHO3D_HANDLER(PackageDownloadTest, HandleLogMessage));
+    }
+
+    /// Return whether a log message contains the text.
+    bool HasLogMessage(const String& text) const
+    {
+        for (unsigned i = 0; i < logMessages_.Size(); ++i)
+        {
+            if (logMessages_[i].Contains(text))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    /// Handle a client connecting to the server.
+    void HandleClientConnected(StringHash eventType, VariantMap& eventData)
+    {
+        auto* connection = static_cast<Connection*>(eventData[ClientConnected::P_CONNECTION].GetPtr());
+        connection->SetScene(serverScene_);
+    }
+
+    /// Handle a log message.
+    void HandleLogMessage(StringHash eventType, VariantMap& eventData)
+    {
+        logMessages_.Push(eventData[LogMessage::P_MESSAGE].GetString());
+    }
+
+    /// Scene to replicate.
+    SharedPtr<Scene> serverScene_;
+    /// Received log messages.
+    Vector<String> logMessages_;
+};
+
+/// Print a failure and return the exit code.
+static int Fail(const char* message)
+{
+    printf("%s\n", message);
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine = CreateTestEngine(context);
+    if (!engine)
+        return EXIT_FAILURE;
+
+    auto* fileSystem = context->GetSubsystem<FileSystem>();
+    String testDir = fileSystem->GetTemporaryDir() + "Urho3DPackageDownload/";
+    String serverDir = testDir + "Server/";
+    String cacheDir = testDir + "Cache/";
+    fileSystem->CreateDir(testDir);
+    fileSystem->CreateDir(serverDir);
+    fileSystem->CreateDir(cacheDir);
+    Vector<String> oldFiles;
+    fileSystem->ScanDir(oldFiles, cacheDir, "*.*", SCAN_FILES, false);
+    for (unsigned i = 0; i < oldFiles.Size(); ++i)
+        fileSystem->Delete(cacheDir + oldFiles[i]);
+
+    // The client has an older version of the first package, which shares an unchanged entry with the new one
+    Vector<TestEntry> deltaEntries(2);
+    deltaEntries[0].name_ = "Unchanged.bin";
+    deltaEntries[0].data_ = CreateData(64 * PACKAGE_FRAGMENT_SIZE, 1);
+    deltaEntries[1].name_ = "Changed.bin";
+    deltaEntries[1].data_ = CreateData(4 * PACKAGE_FRAGMENT_SIZE, 2);
+    unsigned oldChecksum = WritePackage(context, cacheDir + "Base.tmp", deltaEntries);
+    fileSystem->Rename(cacheDir + "Base.tmp", cacheDir + ToStringHex(oldChecksum) + "_DeltaData.pak");
+    deltaEntries[1].data_ = CreateData(4 * PACKAGE_FRAGMENT_SIZE, 3);
+    unsigned deltaChecksum = WritePackage(context, serverDir + "DeltaData.pak", deltaEntries);
+
+    // The download of the second package was interrupted halfway
+    Vector<TestEntry> resumeEntries(1);
+    resumeEntries[0].name_ = "Resumed.bin";
+    resumeEntries[0].data_ = CreateData(32 * PACKAGE_FRAGMENT_SIZE, 4);
+    unsigned resumeChecksum = WritePackage(context, serverDir + "ResumeData.pak", resumeEntries);
+    String partFileName = cacheDir + ToStringHex(resumeChecksum) + "_ResumeData.pak.part";
+    fileSystem->Copy(serverDir + "ResumeData.pak", partFileName);
+    {
+        File partFile(context, partFileName);
+        unsigned fileSize = partFile.GetSize();
+        unsigned numFragments = (fileSize + PACKAGE_FRAGMENT_SIZE - 1) / PACKAGE_FRAGMENT_SIZE;
+        PODVector<unsigned char> receivedFragments((numFragments + 7) >> 3);
+        memset(&receivedFragments[0], 0, receivedFragments.Size());
+        for (unsigned i = 0; i < numFragments / 2; ++i)
+            receivedFragments[i >> 3] |= (unsigned char)(1u << (i & 7));
+
+        File resumeFile(context, partFileName + ".resume", FILE_WRITE);
+        resumeFile.WriteUInt(fileSize);
+        resumeFile.WriteBuffer(receivedFragments);
+    }
+
+    SharedPtr<Scene> serverScene(new Scene(context));
+    SharedPtr<PackageFile> deltaPackage(new PackageFile(context, serverDir + "DeltaData.pak"));
+    SharedPtr<PackageFile> resumePackage(new PackageFile(context, serverDir + "ResumeData.pak"));
+    serverScene->AddRequiredPackageFile(deltaPackage);
+    serverScene->AddRequiredPackageFile(resumePackage);
+    SharedPtr<PackageDownloadTest> test(new PackageDownloadTest(context, serverScene));
+
+    auto* network = context->GetSubsystem<Network>();
+    network->SetPackageCacheDir(cacheDir);
+    if (!network->StartServer(SERVER_PORT))
+        return Fail("Could not start the server");
+
+    SharedPtr<Scene> clientScene(new Scene(context));
+    if (!network->Connect("127.0.0.1", SERVER_PORT, clientScene))
+        return Fail("Could not connect to the server");
+
+    Timer timer;
+    while (timer.GetMSec(false) < TIMEOUT_MSEC)
+    {
+        engine->RunFrame();
+        Connection* serverConnection = network->GetServerConnection();
+        if (!serverConnection)
+            break;
+        if (serverConnection->IsSceneLoaded())
+            break;
+    }
+
+    bool sceneLoaded = network->GetServerConnection() && network->GetServerConnection()->IsSceneLoaded();
+    network->Disconnect();
+    network->StopServer();
+
+    if (!sceneLoaded)
+        return Fail("The client did not load the scene");
+    if (!test->HasLogMessage("Copied 1 unchanged files of package DeltaData.pak"))
+        return Fail("The unchanged entry was not copied from the older package version");
+    if (!test->HasLogMessage("Resuming download of package ResumeData.pak"))
+        return Fail("The interrupted download was not resumed");
+
+    // Downloaded packages are verified before use, but check them again against the originals
+    SharedPtr<PackageFile> downloadedDelta(new PackageFile(context, cacheDir + ToStringHex(deltaChecksum) + "_DeltaData.pak"));
+    SharedPtr<PackageFile> downloadedResume(new PackageFile(context, cacheDir + ToStringHex(resumeChecksum) + "_ResumeData.pak"));
+    if (downloadedDelta->GetChecksum() != deltaChecksum || !downloadedDelta->VerifyChecksums() ||
+        downloadedResume->GetChecksum() != resumeChecksum || !downloadedResume->VerifyChecksums())
+        return Fail("A downloaded package does not match the original");
+
+    printf("Downloaded a patched and a resumed package over loopback\n");
+    return EXIT_SUCCESS;
+}
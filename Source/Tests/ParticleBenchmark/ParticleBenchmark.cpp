@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/ParticleEffect.h>
+#include <Urho3D/Graphics/ParticleEmitter.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+#include "TestEngine.h"
+
+using namespace Urho3D;
+
+/// Number of particle emitters in the scene.
+static const unsigned NUM_EMITTERS = 32;
+/// Maximum number of particles per emitter.
+static const unsigned NUM_PARTICLES = 2000;
+/// Frames simulated before measuring so that the emitters are saturated.
+static const unsigned NUM_WARMUP_FRAMES = 60;
+/// Frames measured.
+static const unsigned NUM_FRAMES = 300;
+/// Simulation time step.
+static const float TIME_STEP = 1.0f / 60.0f;
+
+/// Create an effect that exercises every per-particle update: forces, damping, size change, color and texture animation.
+static SharedPtr<ParticleEffect> CreateEffect(Context* context)
+{
+    SharedPtr<ParticleEffect> effect(new ParticleEffect(context));
+    effect->SetNumParticles(NUM_PARTICLES);
+    effect->SetUpdateInvisible(true);
+    effect->SetEmitterType(EMITTER_SPHERE);
+    effect->SetEmitterSize(Vector3::ONE);
+    effect->SetMinDirection(Vector3(-1.0f, 0.0f, -1.0f));
+    effect->SetMaxDirection(Vector3(1.0f, 1.0f, 1.0f));
+    effect->SetMinEmissionRate(6000.0f);
+    effect->SetMaxEmissionRate(6000.0f);
+    effect->SetMinTimeToLive(100.0f);
+    effect->SetMaxTimeToLive(100.0f);
+    effect->SetMinVelocity(1.0f);
+    effect->SetMaxVelocity(2.0f);
+    effect->SetMinRotationSpeed(-90.0f);
+    effect->SetMaxRotationSpeed(90.0f);
+    effect->SetConstantForce(Vector3(0.0f, -1.0f, 0.0f));
+    effect->SetDampingForce(0.1f);
+    effect->SetSizeAdd(0.1f);
+    effect->SetSizeMul(0.99f);
+    effect->AddColorTime(Color::WHITE, 0.0f);
+    effect->AddColorTime(Color::RED, 25.0f);
+    effect->AddColorTime(Color::TRANSPARENT, 100.0f);
+    effect->AddTextureTime(Rect(0.0f, 0.0f, 0.5f, 0.5f), 0.0f);
+    effect->AddTextureTime(Rect(0.5f, 0.0f, 1.0f, 0.5f), 50.0f);
+    return effect;
+}
+
+int main(int argc, char** argv)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine = CreateTestEngine(context);
+    if (!engine)
+        return EXIT_FAILURE;
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+
+    SharedPtr<ParticleEffect> effect = CreateEffect(context);
+    PODVector<ParticleEmitter*> emitters;
+    for (unsigned i = 0; i < NUM_EMITTERS; ++i)
+    {
+        Node* node = scene->CreateChild("Emitter");
+        node->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+        auto* emitter = node->CreateComponent<ParticleEmitter>();
+        emitter->SetEffect(effect);
+        emitters.Push(emitter);
+    }
+
+    FrameInfo frame;
+    frame.frameNumber_ = 0;
+    frame.timeStep_ = TIME_STEP;
+    frame.viewSize_ = IntVector2(1920, 1080);
+    frame.camera_ = nullptr;
+
+    long long updateTime = 0;
+    unsigned long long numUpdatedParticles = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < NUM_WARMUP_FRAMES + NUM_FRAMES; ++i)
+    {
+        ++frame.frameNumber_;
+        // Scene update marks the emitters for update, like the scene post update of a running application does
+        scene->Update(TIME_STEP);
+
+        // The octree updates the marked emitters on the worker threads, the same way as when rendering a view
+        timer.Reset();
+        octree->Update(frame);
+        long long elapsed = timer.GetUSec(false);
+
+        if (i >= NUM_WARMUP_FRAMES)
+        {
+            updateTime += elapsed;
+            for (unsigned j = 0; j < emitters.Size(); ++j)
+            {
+                PODVector<Billboard>& billboards = emitters[j]->GetBillboards();
+                for (unsigned k = 0; k < billboards.Size(); ++k)
+                {
+                    if (billboards[k].enabled_)
+                        ++numUpdatedParticles;
+                }
+            }
+        }
+    }
+
+    if (!numUpdatedParticles || !updateTime)
+    {
+        printf("No particles were updated\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%u emitters, %u frames, %u worker threads: %llu particles in %.3f ms, %.1f particles/ms\n", NUM_EMITTERS, NUM_FRAMES,
+        context->GetSubsystem<WorkQueue>()->GetNumThreads(), numUpdatedParticles, updateTime / 1000.0,
+        numUpdatedParticles * 1000.0 / updateTime);
+
+    return EXIT_SUCCESS;
+}
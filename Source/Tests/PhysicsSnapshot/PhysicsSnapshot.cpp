@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/Constraint.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+#include "TestEngine.h"
+
+using namespace Urho3D;
+
+/// Number of piles.
+static const unsigned NUM_PILES = 16;
+/// Number of objects per pile.
+static const unsigned NUM_OBJECTS_PER_PILE = 8;
+/// Steps simulated before saving the snapshot.
+static const unsigned NUM_STEPS_BEFORE_SAVE = 60;
+/// Steps simulated after saving or restoring the snapshot.
+static const unsigned NUM_STEPS_AFTER_SAVE = 1000;
+/// Simulation time step.
+static const float TIME_STEP = 1.0f / 60.0f;
+
+/// Create a scene with piles of boxes and spheres, some of them linked with hinges, and simulate it up to the snapshot.
+static SharedPtr<Scene> CreateScene(Context* context)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<PhysicsWorld>();
+
+    Node* floorNode = scene->CreateChild("Floor");
+    floorNode->CreateComponent<RigidBody>();
+    floorNode->CreateComponent<CollisionShape>()->SetBox(Vector3(100.0f, 1.0f, 100.0f));
+
+    for (unsigned i = 0; i < NUM_PILES; ++i)
+    {
+        RigidBody* previousBody = nullptr;
+        for (unsigned j = 0; j < NUM_OBJECTS_PER_PILE; ++j)
+        {
+            Node* node = scene->CreateChild("Object");
+            // Offset the objects slightly so that the piles topple
+            node->SetPosition(Vector3((i % 4) * 4.0f + j * 0.05f, 1.0f + j * 1.05f, (i / 4) * 4.0f));
+            auto* body = node->CreateComponent<RigidBody>();
+            body->SetMass(1.0f);
+            body->SetFriction(0.75f);
+            auto* shape = node->CreateComponent<CollisionShape>();
+            if (j % 2)
+                shape->SetSphere(1.0f);
+            else
+                shape->SetBox(Vector3::ONE);
+
+            if (previousBody && i % 2)
+            {
+                auto* constraint = node->CreateComponent<Constraint>();
+                constraint->SetConstraintType(CONSTRAINT_HINGE);
+                constraint->SetOtherBody(previousBody);
+                constraint->SetWorldPosition(node->GetPosition() - Vector3(0.0f, 0.5f, 0.0f));
+                constraint->SetAxis(Vector3::RIGHT);
+                constraint->SetOtherAxis(Vector3::RIGHT);
+            }
+            previousBody = body;
+        }
+    }
+
+    auto* physicsWorld = scene->GetComponent<PhysicsWorld>();
+    for (unsigned i = 0; i < NUM_STEPS_BEFORE_SAVE; ++i)
+        physicsWorld->Update(TIME_STEP);
+
+    return scene;
+}
+
+/// Simulate the steps after the snapshot and return the state hash.
+static unsigned Simulate(Scene* scene)
+{
+    auto* physicsWorld = scene->GetComponent<PhysicsWorld>();
+    for (unsigned i = 0; i < NUM_STEPS_AFTER_SAVE; ++i)
+        physicsWorld->Update(TIME_STEP);
+    return physicsWorld->GetStateHash();
+}
+
+/// Restore a snapshot, simulate and return the state hash, or 0 if restoring failed.
+static unsigned RestoreAndSimulate(Scene* scene, VectorBuffer& snapshot)
+{
+    snapshot.Seek(0);
+    if (!scene->GetComponent<PhysicsWorld>()->RestoreSnapshot(snapshot))
+        return 0;
+    return Simulate(scene);
+}
+
+static bool Check(bool condition, const char* description)
+{
+    printf("%s: %s\n", description, condition ? "passed" : "FAILED");
+    return condition;
+}
+
+int main(int argc, char** argv)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine = CreateTestEngine(context);
+    if (!engine)
+        return EXIT_FAILURE;
+
+    bool success = true;
+
+    // Saving must not modify the simulation: a world that saved a snapshot continues like one that did not
+    SharedPtr<Scene> savedScene = CreateScene(context);
+    SharedPtr<Scene> unsavedScene = CreateScene(context);
+    auto* savedWorld = savedScene->GetComponent<PhysicsWorld>();
+    unsigned hashBeforeSave = savedWorld->GetStateHash();
+    VectorBuffer snapshot;
+    VectorBuffer secondSnapshot;
+    success &= Check(savedWorld->SaveSnapshot(snapshot) && savedWorld->SaveSnapshot(secondSnapshot), "Save snapshot");
+    success &= Check(snapshot.GetBuffer() == secondSnapshot.GetBuffer() && savedWorld->GetStateHash() == hashBeforeSave,
+        "Saving twice gives the same snapshot");
+    unsigned originalHash = Simulate(savedScene);
+    success &= Check(originalHash == Simulate(unsavedScene), "Saving does not change the simulation");
+
+    // Restoring over the state the original continuation ended in resimulates that continuation exactly, every time
+    unsigned restoredHash = RestoreAndSimulate(savedScene, snapshot);
+    printf("Original hash %u, restored hash %u\n", originalHash, restoredHash);
+    success &= Check(restoredHash == originalHash, "Restoring matches the original continuation");
+    success &= Check(RestoreAndSimulate(savedScene, snapshot) == originalHash, "Restoring twice matches the original continuation");
+
+    // Restoring into another world with the same bodies, which has simulated further, also matches
+    SharedPtr<Scene> otherScene = CreateScene(context);
+    Simulate(otherScene);
+    success &= Check(RestoreAndSimulate(otherScene, snapshot) == originalHash, "Restoring into another world matches the original continuation");
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+
+#include <SDL/SDL.h>
+
+/// Create and initialize a headless engine without resource paths for a test. Return null if initialization fails.
+inline Urho3D::SharedPtr<Urho3D::Engine> CreateTestEngine(Urho3D::Context* context)
+{
+    // Tests must not depend on an audio device, so open audio streams on SDL's dummy driver
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+    Urho3D::SharedPtr<Urho3D::Engine> engine(new Urho3D::Engine(context));
+
+    Urho3D::VariantMap engineParameters;
+    engineParameters[Urho3D::EP_HEADLESS] = true;
+    engineParameters[Urho3D::EP_RESOURCE_PATHS] = Urho3D::String::EMPTY;
+    engineParameters[Urho3D::EP_AUTOLOAD_PATHS] = Urho3D::String::EMPTY;
+    engineParameters[Urho3D::EP_LOG_QUIET] = true;
+    if (!engine->Initialize(engineParameters))
+        engine.Reset();
+
+    return engine;
+}
@@ -164,6 +164,11 @@ bool noOverwriteNewerTexture_ = false;
 bool checkUniqueModel_ = true;
 bool moveToBindPose_ = false;
 unsigned maxBones_ = 64;
+unsigned generateLodLevels_ = 0;
+float lodReduction_ = 0.5f;
+float lodMaxError_ = 0.02f;
+float lodDistanceStep_ = 20.0f;
+bool optimizeVertexCache_ = false;
 Vector<String> nonSkinningBoneIncludes_;
 Vector<String> nonSkinningBoneExcludes_;
 
@@ -296,6 +301,11 @@ void Run(const Vector<String>& arguments)
             "            if its name contains any of the filters. Prefix filter with minus\n"
             "            sign to use as an exclude. For example -s \"Bip01;-Dummy;-Helper\"\n"
             "-t          Generate tangents\n"
+            "-gl <n>     Generate n LOD levels by mesh simplification\n"
+            "-glr <x>    Triangle count multiplier of each generated LOD level. Default 0.5\n"
+            "-gle <x>    Maximum simplification error relative to model size. Default 0.02\n"
+            "-gld <x>    LOD distance step of generated LOD levels. Default 20\n"
+            "-vc         Reorder triangles of all LOD levels for vertex cache efficiency\n"
             "-v          Enable verbose Assimp library logging\n"
             "-eao        Interpret material emissive texture as ambient occlusion\n"
             "-cm         Check and do not overwrite if material exists\n"
@@ -412,6 +422,28 @@ void Run(const Vector<String>& arguments)
                     maxBones_ = 1;
                 ++i;
             }
+            else if (argument == "gl" && !value.Empty())
+            {
+                generateLodLevels_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "glr" && !value.Empty())
+            {
+                lodReduction_ = Clamp(ToFloat(value), 0.0f, 1.0f);
+                ++i;
+            }
+            else if (argument == "gle" && !value.Empty())
+            {
+                lodMaxError_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
+            else if (argument == "gld" && !value.Empty())
+            {
+                lodDistanceStep_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
+            else if (argument == "vc")
+                optimizeVertexCache_ = true;
             else if (argument == "p" && !value.Empty())
             {
                 resourcePath_ = AddTrailingSlash(value);
@@ -1218,6 +1250,14 @@ void BuildAndSaveModel(OutModel& model)
             outModel->SetGeometryBoneMappings(allBoneMappings);
     }
 
+    if (generateLodLevels_)
+    {
+        PrintLine("Generating " + String(generateLodLevels_) + " LOD levels");
+        outModel->GenerateLodLevels(generateLodLevels_, lodReduction_, lodMaxError_, lodDistanceStep_);
+    }
+    if (optimizeVertexCache_)
+        outModel->OptimizeVertexCache();
+
     File outFile(context_);
     if (!outFile.Open(model.outName_, FILE_WRITE))
         ErrorExit("Could not open output file " + model.outName_);
@@ -22,10 +22,13 @@
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Container/ArrayPtr.h>
+#include <Urho3D/Container/Sort.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
+#include <Urho3D/IO/VectorBuffer.h>
 
 #ifdef WIN32
 #include <windows.h>
@@ -39,13 +42,17 @@
 using namespace Urho3D;
 
 static const unsigned COMPRESSED_BLOCK_SIZE = 32768;
+static const unsigned MAX_HASH_SEED = 65536;
+static const unsigned MAX_BUCKET_LAYOUTS = 16;
 
 struct FileEntry
 {
     String name_;
     unsigned offset_{};
     unsigned size_{};
+    unsigned storedSize_{};
     unsigned checksum_{};
+    PackageCodec codec_{};
 };
 
 SharedPtr<Context> context_(new Context());
@@ -54,7 +61,11 @@ String basePath_;
 Vector<FileEntry> entries_;
 unsigned checksum_ = 0;
 bool compress_ = false;
+bool fastCompress_ = false;
+bool legacyFormat_ = false;
 bool quiet_ = false;
+unsigned directoryOffset_ = 0;
+unsigned bucketSeed_ = 0;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
 
 String ignoreExtensions_[] = {
@@ -68,6 +79,11 @@ void Run(const Vector<String>& arguments);
 void ProcessFile(const String& fileName, const String& rootDir);
 void WritePackageFile(const String& fileName, const String& rootDir);
 void WriteHeader(File& dest);
+void WriteEntries(File& dest);
+void WriteDirectory(File& dest);
+bool BuildPerfectHash(const Vector<String>& names, unsigned bucketSeed, PODVector<int>& seeds, PODVector<int>& slots);
+void CompressBlocks(const unsigned char* data, unsigned dataSize, VectorBuffer& dest, const String& fileName);
+void BenchmarkPackageFile(const String& fileName, bool memoryMapping);
 
 int main(int argc, char** argv)
 {
@@ -91,6 +107,8 @@ void Run(const Vector<String>& arguments)
             "\n"
             "Options:\n"
             "-c      Enable package file LZ4 compression\n"
+            "-f      Use fast LZ4 instead of LZ4 HC for compression\n"
+            "-1      Write the original package format instead of version 2\n"
             "-q      Enable quiet mode\n"
             "\n"
             "Basepath is an optional prefix that will be added to the file entries.\n\n"
@@ -99,6 +117,7 @@ void Run(const Vector<String>& arguments)
             "-i      Output package file information\n"
             "-l      Output file names (including their paths) contained in the package\n"
             "-L      Similar to -l but also output compression ratio (compressed package file only)\n"
+            "-b      Benchmark reading all files in the package with and without memory mapping\n"
         );
 
     const String& dirName = arguments[0];
@@ -119,6 +138,12 @@ void Run(const Vector<String>& arguments)
                     case 'c':
                         compress_ = true;
                         break;
+                    case 'f':
+                        fastCompress_ = true;
+                        break;
+                    case '1':
+                        legacyFormat_ = true;
+                        break;
                     case 'q':
                         quiet_ = true;
                         break;
@@ -167,6 +192,7 @@ void Run(const Vector<String>& arguments)
         switch (arguments[0][1])
         {
         case 'i':
+            PrintLine("Format version: " + String(packageFile->GetVersion()));
             PrintLine("Number of files: " + String(packageFile->GetNumFiles()));
             PrintLine("File data size: " + String(packageFile->GetTotalDataSize()));
             PrintLine("Package size: " + String(packageFile->GetTotalSize()));
@@ -181,22 +207,24 @@ void Run(const Vector<String>& arguments)
         case 'l':
             {
                 const HashMap<String, PackageEntry>& entries = packageFile->GetEntries();
-                for (HashMap<String, PackageEntry>::ConstIterator i = entries.Begin(); i != entries.End();)
+                for (HashMap<String, PackageEntry>::ConstIterator i = entries.Begin(); i != entries.End(); ++i)
                 {
-                    HashMap<String, PackageEntry>::ConstIterator current = i++;
-                    String fileEntry(current->first_);
+                    String fileEntry(i->first_);
                     if (outputCompressionRatio)
                     {
-                        unsigned compressedSize =
-                            (i == entries.End() ? packageFile->GetTotalSize() - sizeof(unsigned) : i->second_.offset_) -
-                            current->second_.offset_;
-                        fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", current->second_.size_, compressedSize,
-                            compressedSize ? 1.f * current->second_.size_ / compressedSize : 0.f);
+                        unsigned compressedSize = i->second_.storedSize_;
+                        fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", i->second_.size_, compressedSize,
+                            compressedSize ? 1.f * i->second_.size_ / compressedSize : 0.f);
                     }
                     PrintLine(fileEntry);
                 }
             }
             break;
+        case 'b':
+            BenchmarkPackageFile(packageName, false);
+            if (!packageFile->IsCompressed())
+                BenchmarkPackageFile(packageName, true);
+            break;
         default:
             ErrorExit("Unrecognized output option");
         }
@@ -232,22 +260,18 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     // Write ID, number of files & placeholder for checksum
     WriteHeader(dest);
 
-    for (unsigned i = 0; i < entries_.Size(); ++i)
-    {
-        // Write entry (correct offset is still unknown, will be filled in later)
-        dest.WriteString(basePath_ + entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
-    }
+    // In the original format the file entries precede the data (correct offsets are still unknown, will be filled
+    // in later), in version 2 the directory is written after the data
+    if (legacyFormat_)
+        WriteEntries(dest);
 
     unsigned totalDataSize = 0;
-    unsigned lastOffset;
+    PODVector<unsigned char> padding(PACKAGE_ENTRY_ALIGNMENT);
+    memset(&padding[0], 0, padding.Size());
 
     // Write file data, calculate checksums & correct offsets
     for (unsigned i = 0; i < entries_.Size(); ++i)
     {
-        lastOffset = entries_[i].offset_ = dest.GetSize();
         String fileFullPath = rootDir + "/" + entries_[i].name_;
 
         File srcFile(context_, fileFullPath);
@@ -268,64 +292,90 @@ void WritePackageFile(const String& fileName, const String& rootDir)
             entries_[i].checksum_ = SDBMHash(entries_[i].checksum_, buffer[j]);
         }
 
-        if (!compress_)
+        VectorBuffer compressed;
+        entries_[i].codec_ = PACKAGE_CODEC_NONE;
+        if (compress_)
         {
-            if (!quiet_)
-                PrintLine(entries_[i].name_ + " size " + String(dataSize));
-            dest.Write(&buffer[0], entries_[i].size_);
-        }
-        else
-        {
-            SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
-
-            unsigned pos = 0;
+            CompressBlocks(&buffer[0], dataSize, compressed, entries_[i].name_);
+            entries_[i].codec_ = fastCompress_ ? PACKAGE_CODEC_LZ4 : PACKAGE_CODEC_LZ4HC;
 
-            while (pos < dataSize)
-            {
-                unsigned unpackedSize = blockSize_;
-                if (pos + unpackedSize > dataSize)
-                    unpackedSize = dataSize - pos;
+            // The codec is chosen per file in version 2, so store the files that do not compress well, such as
+            // already compressed images and sounds. They can then be read in place from a memory mapping
+            if (!legacyFormat_ && compressed.GetSize() >= dataSize - dataSize / 16)
+                entries_[i].codec_ = PACKAGE_CODEC_NONE;
+        }
 
-                auto packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
-                if (!packedSize)
-                    ErrorExit("LZ4 compression failed for file " + entries_[i].name_ + " at offset " + String(pos));
+        // Align uncompressed data for memory mapping
+        if (!legacyFormat_ && entries_[i].codec_ == PACKAGE_CODEC_NONE && dest.GetSize() % PACKAGE_ENTRY_ALIGNMENT)
+            dest.Write(&padding[0], PACKAGE_ENTRY_ALIGNMENT - dest.GetSize() % PACKAGE_ENTRY_ALIGNMENT);
 
-                dest.WriteUShort((unsigned short)unpackedSize);
-                dest.WriteUShort((unsigned short)packedSize);
-                dest.Write(compressBuffer.Get(), packedSize);
+        // The engine file streams use 32-bit offsets, so the format's 64-bit offsets can not be used yet
+        unsigned long long storedSize = entries_[i].codec_ == PACKAGE_CODEC_NONE ? dataSize : compressed.GetSize();
+        if (dest.GetSize() + storedSize > M_MAX_UNSIGNED)
+            ErrorExit("Package size would exceed 4 GB, which is not supported");
 
-                pos += unpackedSize;
-            }
+        entries_[i].offset_ = dest.GetSize();
+        if (entries_[i].codec_ == PACKAGE_CODEC_NONE)
+            dest.Write(&buffer[0], dataSize);
+        else
+            dest.Write(compressed.GetData(), compressed.GetSize());
+        entries_[i].storedSize_ = dest.GetSize() - entries_[i].offset_;
 
-            if (!quiet_)
+        if (!quiet_)
+        {
+            if (!compress_)
+                PrintLine(entries_[i].name_ + " size " + String(dataSize));
+            else
             {
-                unsigned totalPackedBytes = dest.GetSize() - lastOffset;
+                unsigned totalPackedBytes = entries_[i].storedSize_;
                 String fileEntry(entries_[i].name_);
                 fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", dataSize, totalPackedBytes,
                     totalPackedBytes ? 1.f * dataSize / totalPackedBytes : 0.f);
+                if (entries_[i].codec_ == PACKAGE_CODEC_NONE)
+                    fileEntry += "\tstored";
                 PrintLine(fileEntry);
             }
         }
     }
 
-    // Write package size to the end of file to allow finding it linked to an executable file
-    unsigned currentSize = dest.GetSize();
-    dest.WriteUInt(currentSize + sizeof(unsigned));
+    if (legacyFormat_)
+    {
+        // Write package size to the end of file to allow finding it linked to an executable file
+        unsigned currentSize = dest.GetSize();
+        dest.WriteUInt(currentSize + sizeof(unsigned));
+
+        // Write header again with correct offsets & checksums
+        dest.Seek(0);
+        WriteHeader(dest);
+        WriteEntries(dest);
+    }
+    else
+    {
+        // Seeds, fixed size entries, name table and the package size
+        unsigned long long directorySize = sizeof(unsigned) + sizeof(unsigned long long);
+        for (unsigned i = 0; i < entries_.Size(); ++i)
+        {
+            directorySize += sizeof(int) + 3 * sizeof(unsigned long long) + 3 * sizeof(unsigned) + basePath_.Length() +
+                entries_[i].name_.Length() + 1;
+        }
+        if (dest.GetSize() + directorySize > M_MAX_UNSIGNED)
+            ErrorExit("Package size would exceed 4 GB, which is not supported");
+
+        directoryOffset_ = dest.GetSize();
+        WriteDirectory(dest);
 
-    // Write header again with correct offsets & checksums
-    dest.Seek(0);
-    WriteHeader(dest);
+        // Version 2 stores the package size as 64-bit
+        unsigned long long currentSize = dest.GetSize();
+        dest.WriteUInt64(currentSize + sizeof(unsigned long long));
 
-    for (unsigned i = 0; i < entries_.Size(); ++i)
-    {
-        dest.WriteString(basePath_ + entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
+        // Write header again with correct checksum & directory offset
+        dest.Seek(0);
+        WriteHeader(dest);
     }
 
     if (!quiet_)
     {
+        PrintLine("Format version: " + String(legacyFormat_ ? 1 : 2));
         PrintLine("Number of files: " + String(entries_.Size()));
         PrintLine("File data size: " + String(totalDataSize));
         PrintLine("Package size: " + String(dest.GetSize()));
@@ -336,6 +386,16 @@ void WritePackageFile(const String& fileName, const String& rootDir)
 
 void WriteHeader(File& dest)
 {
+    if (!legacyFormat_)
+    {
+        dest.WriteFileID("UPK2");
+        dest.WriteUInt(entries_.Size());
+        dest.WriteUInt(checksum_);
+        dest.WriteUInt(bucketSeed_);
+        dest.WriteUInt64(directoryOffset_);
+        return;
+    }
+
     if (!compress_)
         dest.WriteFileID("UPAK");
     else
@@ -343,3 +403,187 @@ void WriteHeader(File& dest)
     dest.WriteUInt(entries_.Size());
     dest.WriteUInt(checksum_);
 }
+
+void WriteEntries(File& dest)
+{
+    for (unsigned i = 0; i < entries_.Size(); ++i)
+    {
+        dest.WriteString(basePath_ + entries_[i].name_);
+        dest.WriteUInt(entries_[i].offset_);
+        dest.WriteUInt(entries_[i].size_);
+        dest.WriteUInt(entries_[i].checksum_);
+    }
+}
+
+void WriteDirectory(File& dest)
+{
+    unsigned numFiles = entries_.Size();
+    Vector<String> names(numFiles);
+    for (unsigned i = 0; i < numFiles; ++i)
+        names[i] = basePath_ + entries_[i].name_;
+
+    // Search for a perfect hash with a few bucket layouts, as a seed search can fail when several large buckets
+    // compete for the last free slots
+    PODVector<int> seeds(numFiles);
+    PODVector<int> slots(numFiles);
+    for (bucketSeed_ = 0; bucketSeed_ < MAX_BUCKET_LAYOUTS; ++bucketSeed_)
+    {
+        if (BuildPerfectHash(names, bucketSeed_, seeds, slots))
+            break;
+    }
+    if (bucketSeed_ == MAX_BUCKET_LAYOUTS)
+        ErrorExit("Could not build the package directory");
+
+    for (unsigned i = 0; i < numFiles; ++i)
+        dest.WriteInt(seeds[i]);
+
+    // Write the fixed size entries in slot order, followed by the name table
+    VectorBuffer nameTable;
+    for (unsigned i = 0; i < numFiles; ++i)
+    {
+        const FileEntry& entry = entries_[slots[i]];
+        dest.WriteUInt64(entry.offset_);
+        dest.WriteUInt64(entry.size_);
+        dest.WriteUInt64(entry.storedSize_);
+        dest.WriteUInt(entry.checksum_);
+        dest.WriteUInt(nameTable.GetSize());
+        dest.WriteUInt(entry.codec_);
+        nameTable.WriteString(names[slots[i]]);
+    }
+
+    dest.WriteUInt(nameTable.GetSize());
+    if (nameTable.GetSize())
+        dest.Write(nameTable.GetData(), nameTable.GetSize());
+}
+
+bool BuildPerfectHash(const Vector<String>& names, unsigned bucketSeed, PODVector<int>& seeds, PODVector<int>& slots)
+{
+    // Build a perfect hash (hash and displace): distribute the names to buckets with the bucket seed, then for each
+    // bucket, largest first, search for a seed that hashes all of its names to free slots. Buckets with a single name
+    // are placed directly to the remaining free slots, which is marked by a negative seed. Fail if the seed search of
+    // a bucket is exhausted
+    unsigned numFiles = names.Size();
+    Vector<PODVector<unsigned> > buckets(numFiles);
+    for (unsigned i = 0; i < numFiles; ++i)
+        buckets[PackageFile::HashEntryName(names[i].CString(), bucketSeed) % numFiles].Push(i);
+
+    PODVector<Pair<unsigned, unsigned> > bucketOrder;
+    for (unsigned i = 0; i < numFiles; ++i)
+        bucketOrder.Push(MakePair(buckets[i].Size(), i));
+    Sort(bucketOrder.Begin(), bucketOrder.End());
+
+    for (unsigned i = 0; i < numFiles; ++i)
+    {
+        seeds[i] = 0;
+        slots[i] = -1;
+    }
+
+    PODVector<unsigned> candidateSlots;
+    unsigned freeSlot = 0;
+    for (unsigned i = bucketOrder.Size() - 1; i < bucketOrder.Size(); --i)
+    {
+        const PODVector<unsigned>& bucket = buckets[bucketOrder[i].second_];
+        if (bucket.Empty())
+            break;
+
+        if (bucket.Size() == 1)
+        {
+            while (slots[freeSlot] >= 0)
+                ++freeSlot;
+            slots[freeSlot] = bucket[0];
+            seeds[bucketOrder[i].second_] = -(int)freeSlot - 1;
+            continue;
+        }
+
+        unsigned seed = 1;
+        for (; seed <= MAX_HASH_SEED; ++seed)
+        {
+            candidateSlots.Clear();
+            for (unsigned j = 0; j < bucket.Size(); ++j)
+            {
+                unsigned slot = PackageFile::HashEntryName(names[bucket[j]].CString(), seed) % numFiles;
+                if (slots[slot] >= 0 || candidateSlots.Contains(slot))
+                    break;
+                candidateSlots.Push(slot);
+            }
+
+            if (candidateSlots.Size() == bucket.Size())
+            {
+                for (unsigned j = 0; j < bucket.Size(); ++j)
+                    slots[candidateSlots[j]] = bucket[j];
+                seeds[bucketOrder[i].second_] = seed;
+                break;
+            }
+        }
+
+        if (seed > MAX_HASH_SEED)
+            return false;
+    }
+
+    return true;
+}
+
+void CompressBlocks(const unsigned char* data, unsigned dataSize, VectorBuffer& dest, const String& fileName)
+{
+    SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
+
+    unsigned pos = 0;
+
+    while (pos < dataSize)
+    {
+        unsigned unpackedSize = blockSize_;
+        if (pos + unpackedSize > dataSize)
+            unpackedSize = dataSize - pos;
+
+        unsigned packedSize;
+        if (fastCompress_)
+            packedSize = (unsigned)LZ4_compress_default((const char*)&data[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize));
+        else
+            packedSize = (unsigned)LZ4_compress_HC((const char*)&data[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
+        if (!packedSize)
+            ErrorExit("LZ4 compression failed for file " + fileName + " at offset " + String(pos));
+
+        dest.WriteUShort((unsigned short)unpackedSize);
+        dest.WriteUShort((unsigned short)packedSize);
+        dest.Write(compressBuffer.Get(), packedSize);
+
+        pos += unpackedSize;
+    }
+}
+
+void BenchmarkPackageFile(const String& fileName, bool memoryMapping)
+{
+    static const unsigned NUM_PASSES = 5;
+
+    SharedPtr<PackageFile> packageFile(new PackageFile(context_));
+    packageFile->SetMemoryMapping(memoryMapping);
+    if (!packageFile->Open(fileName))
+        ErrorExit("Could not open package file " + fileName);
+
+    const HashMap<String, PackageEntry>& entries = packageFile->GetEntries();
+    PODVector<unsigned char> buffer;
+    unsigned long long totalBytes = 0;
+    unsigned totalFiles = 0;
+
+    HiresTimer timer;
+    for (unsigned pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for (HashMap<String, PackageEntry>::ConstIterator i = entries.Begin(); i != entries.End(); ++i)
+        {
+            // Open each file like the resource cache does, then read it whole like most resource loaders
+            File file(context_, packageFile, i->first_);
+            unsigned size = file.GetSize();
+            buffer.Resize(size);
+            if (size && file.Read(&buffer[0], size) != size)
+                ErrorExit("Could not read file " + i->first_);
+            totalBytes += size;
+            ++totalFiles;
+        }
+    }
+    long long usec = Max(timer.GetUSec(false), 1LL);
+
+    PrintLine(String(memoryMapping ? "Memory-mapped" : "Buffered") + " read: " + String(totalFiles) + " files, " +
+        String((unsigned)(totalBytes / 1024)) + " KB in " + String((float)usec / 1000.0f) + " ms, " +
+        String((float)totalBytes / (float)usec) + " MB/s, " + String((float)totalFiles * 1000000.0f / (float)usec) +
+        " files/s");
+}
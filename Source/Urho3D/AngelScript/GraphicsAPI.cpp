@@ -33,6 +33,7 @@
 #include "../Graphics/DecalSet.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
+#include "../Graphics/ImpostorGroup.h"
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Light.h"
 #include "../Graphics/Material.h"
@@ -42,6 +43,7 @@
 #include "../Graphics/Renderer.h"
 #include "../Graphics/RenderPath.h"
 #include "../Graphics/RibbonTrail.h"
+#include "../Graphics/StaticBatcher.h"
 #include "../Graphics/StaticModelGroup.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Terrain.h"
@@ -50,6 +52,7 @@
 #include "../Graphics/Texture2DArray.h"
 #include "../Graphics/Texture3D.h"
 #include "../Graphics/TextureCube.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Graphics/Skybox.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../Graphics/Zone.h"
@@ -382,6 +385,7 @@ static void RegisterRenderPath(asIScriptEngine* engine)
     engine->RegisterObjectProperty("RenderPathCommand", "bool markToStencil", offsetof(RenderPathCommand, markToStencil_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool vertexLights", offsetof(RenderPathCommand, vertexLights_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool useLitBase", offsetof(RenderPathCommand, useLitBase_));
+    engine->RegisterObjectProperty("RenderPathCommand", "bool clusteredLights", offsetof(RenderPathCommand, clusteredLights_));
     engine->RegisterObjectProperty("RenderPathCommand", "String vertexShaderName", offsetof(RenderPathCommand, vertexShaderName_));
     engine->RegisterObjectProperty("RenderPathCommand", "String pixelShaderName", offsetof(RenderPathCommand, pixelShaderName_));
     engine->RegisterObjectProperty("RenderPathCommand", "String vertexShaderDefines", offsetof(RenderPathCommand, vertexShaderDefines_));
@@ -1002,6 +1006,8 @@ static void RegisterModel(asIScriptEngine* engine)
 {
     RegisterResourceWithMetadata<Model>(engine, "Model");
     engine->RegisterObjectMethod("Model", "Model@ Clone(const String&in cloneName = String()) const", asFUNCTION(ModelClone), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Model", "bool GenerateLodLevels(uint, float reduction = 0.5f, float maxError = 0.02f, float lodDistanceStep = 20.0f, bool replaceExisting = false)", asMETHOD(Model, GenerateLodLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Model", "void OptimizeVertexCache()", asMETHOD(Model, OptimizeVertexCache), asCALL_THISCALL);
     engine->RegisterObjectMethod("Model", "bool SetVertexBuffers(Array<VertexBuffer@>@+, Array<uint>@+, Array<uint>@+)", asFUNCTION(ModelSetVertexBuffers), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Model", "bool SetIndexBuffers(Array<IndexBuffer@>@+)", asFUNCTION(ModelSetIndexBuffers), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Model", "bool SetGeometry(uint, uint, Geometry@+)", asMETHOD(Model, SetGeometry), asCALL_THISCALL);
@@ -1337,6 +1343,22 @@ static void RegisterStaticModelGroup(asIScriptEngine* engine)
     engine->RegisterObjectMethod("StaticModelGroup", "Node@+ get_instanceNodes(uint) const", asMETHOD(StaticModelGroup, GetInstanceNode), asCALL_THISCALL);
 }
 
+static void RegisterStaticBatcher(asIScriptEngine* engine)
+{
+    RegisterComponent<StaticBatcher>(engine, "StaticBatcher");
+    engine->RegisterObjectMethod("StaticBatcher", "bool Build()", asMETHOD(StaticBatcher, Build), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "void Clear()", asMETHOD(StaticBatcher, Clear), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "void set_clusterSize(float)", asMETHOD(StaticBatcher, SetClusterSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "float get_clusterSize() const", asMETHOD(StaticBatcher, GetClusterSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "void set_buildOnLoad(bool)", asMETHOD(StaticBatcher, SetBuildOnLoad), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "bool get_buildOnLoad() const", asMETHOD(StaticBatcher, GetBuildOnLoad), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "bool get_built() const", asMETHOD(StaticBatcher, IsBuilt), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "uint get_numSourceModels() const", asMETHOD(StaticBatcher, GetNumSourceModels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "uint get_numSourceBatches() const", asMETHOD(StaticBatcher, GetNumSourceBatches), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "uint get_numClusters() const", asMETHOD(StaticBatcher, GetNumClusters), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticBatcher", "uint get_numBatches() const", asMETHOD(StaticBatcher, GetNumBatches), asCALL_THISCALL);
+}
+
 static void RegisterSkybox(asIScriptEngine* engine)
 {
     RegisterStaticModel<Skybox>(engine, "Skybox", true);
@@ -1691,6 +1713,40 @@ static void RegisterParticleEmitter(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ParticleEmitter", "void ApplyEffect()", asMETHOD(ParticleEmitter, ApplyEffect), asCALL_THISCALL);
 }
 
+static void RegisterImpostorGroup(asIScriptEngine* engine)
+{
+    RegisterDrawable<ImpostorGroup>(engine, "ImpostorGroup");
+    // Copy from BillboardSet
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_material(Material@+)", asMETHOD(ImpostorGroup, SetMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "Material@+ get_material() const", asMETHOD(ImpostorGroup, GetMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_sorted(bool)", asMETHOD(ImpostorGroup, SetSorted), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "bool get_sorted() const", asMETHOD(ImpostorGroup, IsSorted), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "Zone@+ get_zone() const", asMETHOD(ImpostorGroup, GetZone), asCALL_THISCALL);
+
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_model(Model@+)", asMETHOD(ImpostorGroup, SetModel), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "Model@+ get_model() const", asMETHOD(ImpostorGroup, GetModel), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_modelMaterial(Material@+)", asMETHODPR(ImpostorGroup, SetModelMaterial, (Material*), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "bool set_modelMaterials(uint, Material@+)", asMETHODPR(ImpostorGroup, SetModelMaterial, (unsigned, Material*), bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "Material@+ get_modelMaterials(uint) const", asMETHOD(ImpostorGroup, GetModelMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_numFrames(uint)", asMETHOD(ImpostorGroup, SetNumFrames), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "uint get_numFrames() const", asMETHOD(ImpostorGroup, GetNumFrames), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_frameSize(int)", asMETHOD(ImpostorGroup, SetFrameSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "int get_frameSize() const", asMETHOD(ImpostorGroup, GetFrameSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_impostorDistance(float)", asMETHOD(ImpostorGroup, SetImpostorDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "float get_impostorDistance() const", asMETHOD(ImpostorGroup, GetImpostorDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void set_fadeDistance(float)", asMETHOD(ImpostorGroup, SetFadeDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "float get_fadeDistance() const", asMETHOD(ImpostorGroup, GetFadeDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "Texture2D@+ get_impostorTexture() const", asMETHOD(ImpostorGroup, GetImpostorTexture), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void Bake()", asMETHOD(ImpostorGroup, Bake), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "uint UpdateImpostors(const Vector3&in)", asMETHOD(ImpostorGroup, UpdateImpostors), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "uint get_numVisibleImpostors() const", asMETHOD(ImpostorGroup, GetNumVisibleImpostors), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void AddInstanceNode(Node@+)", asMETHOD(ImpostorGroup, AddInstanceNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void RemoveInstanceNode(Node@+)", asMETHOD(ImpostorGroup, RemoveInstanceNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "void RemoveAllInstanceNodes()", asMETHOD(ImpostorGroup, RemoveAllInstanceNodes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "uint get_numInstanceNodes() const", asMETHOD(ImpostorGroup, GetNumInstanceNodes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ImpostorGroup", "Node@+ get_instanceNodes(uint) const", asMETHOD(ImpostorGroup, GetInstanceNode), asCALL_THISCALL);
+}
+
 static void RegisterRibbonTrail(asIScriptEngine* engine)
 {
     engine->RegisterEnum("TrailType");
@@ -1823,6 +1879,9 @@ static void RegisterTerrain(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Terrain", "float get_drawDistance() const", asMETHOD(Terrain, GetDrawDistance), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_shadowDistance(float)", asMETHOD(Terrain, SetShadowDistance), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "float get_shadowDistance() const", asMETHOD(Terrain, GetShadowDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "void set_streamingDistance(float)", asMETHOD(Terrain, SetStreamingDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "float get_streamingDistance() const", asMETHOD(Terrain, GetStreamingDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "uint get_numResidentPatches() const", asMETHOD(Terrain, GetNumResidentPatches), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_lodBias(float)", asMETHOD(Terrain, SetLodBias), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "float get_lodBias() const", asMETHOD(Terrain, GetLodBias), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_viewMask(uint)", asMETHOD(Terrain, SetViewMask), asCALL_THISCALL);
@@ -1909,6 +1968,9 @@ static void RegisterGraphics(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Graphics", "const String& get_orientations() const", asMETHOD(Graphics, GetOrientations), asCALL_THISCALL);
     engine->RegisterObjectMethod("Graphics", "void set_shaderCacheDir(const String&in)", asMETHOD(Graphics, SetShaderCacheDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("Graphics", "const String& get_shaderCacheDir() const", asMETHOD(Graphics, GetShaderCacheDir), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Graphics", "uint get_numShaderCacheHits() const", asMETHOD(Graphics, GetNumShaderCacheHits), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Graphics", "uint get_numShaderCacheMisses() const", asMETHOD(Graphics, GetNumShaderCacheMisses), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Graphics", "int64 get_shaderCompileTime() const", asMETHOD(Graphics, GetShaderCompileTime), asCALL_THISCALL);
     engine->RegisterObjectMethod("Graphics", "int get_width() const", asMETHOD(Graphics, GetWidth), asCALL_THISCALL);
     engine->RegisterObjectMethod("Graphics", "int get_height() const", asMETHOD(Graphics, GetHeight), asCALL_THISCALL);
     engine->RegisterObjectMethod("Graphics", "int get_multiSample() const", asMETHOD(Graphics, GetMultiSample), asCALL_THISCALL);
@@ -1964,6 +2026,20 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterEnumValue("ShadowQuality", "SHADOWQUALITY_VSM", SHADOWQUALITY_VSM);
     engine->RegisterEnumValue("ShadowQuality", "SHADOWQUALITY_BLUR_VSM", SHADOWQUALITY_BLUR_VSM);
 
+    RegisterObject<TextureStreamer>(engine, "TextureStreamer");
+    engine->RegisterObjectMethod("TextureStreamer", "void set_budget(uint64)", asMETHOD(TextureStreamer, SetBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint64 get_budget() const", asMETHOD(TextureStreamer, GetBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "void set_initialMipsToSkip(uint)", asMETHOD(TextureStreamer, SetInitialMipsToSkip), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint get_initialMipsToSkip() const", asMETHOD(TextureStreamer, GetInitialMipsToSkip), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "void set_maxPendingLoads(uint)", asMETHOD(TextureStreamer, SetMaxPendingLoads), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint get_maxPendingLoads() const", asMETHOD(TextureStreamer, GetMaxPendingLoads), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "void set_evictFrames(uint)", asMETHOD(TextureStreamer, SetEvictFrames), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint get_evictFrames() const", asMETHOD(TextureStreamer, GetEvictFrames), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint get_numTextures() const", asMETHOD(TextureStreamer, GetNumTextures), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint get_numFullResolution() const", asMETHOD(TextureStreamer, GetNumFullResolution), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint get_numPendingLoads() const", asMETHOD(TextureStreamer, GetNumPendingLoads), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TextureStreamer", "uint64 get_memoryUse() const", asMETHOD(TextureStreamer, GetMemoryUse), asCALL_THISCALL);
+
     RegisterObject<Renderer>(engine, "Renderer");
     engine->RegisterObjectMethod("Renderer", "void DrawDebugGeometry(bool) const", asMETHOD(Renderer, DrawDebugGeometry), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void ReloadShaders() const", asMETHOD(Renderer, ReloadShaders), asCALL_THISCALL);
@@ -2010,6 +2086,11 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "int get_maxShadowMaps() const", asMETHOD(Renderer, GetMaxShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_reuseShadowMaps(bool)", asMETHOD(Renderer, SetReuseShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "bool get_reuseShadowMaps() const", asMETHOD(Renderer, GetReuseShadowMaps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_textureStreaming(bool)", asMETHOD(Renderer, SetTextureStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "bool get_textureStreaming() const", asMETHOD(Renderer, GetTextureStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "TextureStreamer@+ get_textureStreamer() const", asMETHOD(Renderer, GetTextureStreamer), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_shadowMapCaching(bool)", asMETHOD(Renderer, SetShadowMapCaching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "bool get_shadowMapCaching() const", asMETHOD(Renderer, GetShadowMapCaching), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_dynamicInstancing(bool)", asMETHOD(Renderer, SetDynamicInstancing), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "bool get_dynamicInstancing() const", asMETHOD(Renderer, GetDynamicInstancing), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_minInstances(int)", asMETHOD(Renderer, SetMinInstances), asCALL_THISCALL);
@@ -2038,6 +2119,8 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "uint get_numGeometries(bool) const", asMETHOD(Renderer, GetNumGeometries), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numLights(bool) const", asMETHOD(Renderer, GetNumLights), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numShadowMaps(bool) const", asMETHOD(Renderer, GetNumShadowMaps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_numRenderedShadowSplits(bool) const", asMETHOD(Renderer, GetNumRenderedShadowSplits), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_numCachedShadowSplits(bool) const", asMETHOD(Renderer, GetNumCachedShadowSplits), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numOccluders(bool) const", asMETHOD(Renderer, GetNumOccluders), asCALL_THISCALL);
     engine->RegisterGlobalFunction("Renderer@+ get_renderer()", asFUNCTION(GetRenderer), asCALL_CDECL);
 }
@@ -2236,12 +2319,14 @@ void RegisterGraphicsAPI(asIScriptEngine* engine)
     RegisterZone(engine);
     RegisterStaticModel(engine);
     RegisterStaticModelGroup(engine);
+    RegisterStaticBatcher(engine);
     RegisterSkybox(engine);
     RegisterAnimatedModel(engine);
     RegisterAnimationController(engine);
     RegisterBillboardSet(engine);
     RegisterParticleEffect(engine);
     RegisterParticleEmitter(engine);
+    RegisterImpostorGroup(engine);
     RegisterRibbonTrail(engine);
     RegisterCustomGeometry(engine);
     RegisterDecalSet(engine);
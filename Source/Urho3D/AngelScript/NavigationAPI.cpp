@@ -42,17 +42,17 @@ void RegisterNavigable(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Navigable", "bool get_recursive() const", asMETHOD(Navigable, IsRecursive), asCALL_THISCALL);
 }
 
-static CScriptArray* NavigationMeshFindPath(const Vector3& start, const Vector3& end, const Vector3& extents, NavigationMesh* ptr)
+static CScriptArray* NavigationMeshFindPath(const Vector3& start, const Vector3& end, const Vector3& extents, bool hierarchical, NavigationMesh* ptr)
 {
     PODVector<Vector3> dest;
-    ptr->FindPath(dest, start, end, extents);
+    ptr->FindPath(dest, start, end, extents, nullptr, hierarchical);
     return VectorToArray<Vector3>(dest, "Array<Vector3>");
 }
 
-static CScriptArray* DynamicNavigationMeshFindPath(const Vector3& start, const Vector3& end, const Vector3& extents, DynamicNavigationMesh* ptr)
+static CScriptArray* DynamicNavigationMeshFindPath(const Vector3& start, const Vector3& end, const Vector3& extents, bool hierarchical, DynamicNavigationMesh* ptr)
 {
     PODVector<Vector3> dest;
-    ptr->FindPath(dest, start, end, extents);
+    ptr->FindPath(dest, start, end, extents, nullptr, hierarchical);
     return VectorToArray<Vector3>(dest, "Array<Vector3>");
 }
 
@@ -104,6 +104,16 @@ static Vector3 NavigationMeshRaycast(const Vector3& start, const Vector3& end, c
     return ptr->Raycast(start, end, extents);
 }
 
+static unsigned NavigationMeshFindPathAsync(const Vector3& start, const Vector3& end, unsigned priority, const Vector3& extents, NavigationMesh* ptr)
+{
+    return ptr->FindPathAsync(start, end, priority, extents);
+}
+
+static bool NavigationMeshSaveStreamingData(File* file, NavigationMesh* ptr)
+{
+    return file && ptr->SaveStreamingData(*file);
+}
+
 static Vector3 CrowdManagerGetRandomPoint(int queryFilterType, CrowdManager* crowdManager)
 {
     return crowdManager->GetRandomPoint(queryFilterType);
@@ -120,6 +130,7 @@ template<class T> static void RegisterNavMeshBase(asIScriptEngine* engine, const
     engine->RegisterObjectMethod(name, "bool Build()", asMETHODPR(T, Build, (), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "bool Build(const BoundingBox&in)", asMETHODPR(T, Build, (const BoundingBox&), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "bool Build(const IntVector2&, const IntVector2&)", asMETHODPR(T, Build, (const IntVector2&, const IntVector2&), bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool BuildChangedTiles()", asMETHOD(T, BuildChangedTiles), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "VectorBuffer GetTileData(const IntVector2&) const", asFUNCTION(NavigationMeshGetTileData), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod(name, "bool AddTile(const VectorBuffer&in) const", asFUNCTION(NavigationMeshAddTile), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod(name, "void RemoveTile(const IntVector2&)", asMETHOD(T, RemoveTile), asCALL_THISCALL);
@@ -135,6 +146,14 @@ template<class T> static void RegisterNavMeshBase(asIScriptEngine* engine, const
     engine->RegisterObjectMethod(name, "Vector3 GetRandomPointInCircle(const Vector3&in, float, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshGetRandomPointInCircle), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod(name, "float GetDistanceToWall(const Vector3&in, float, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshGetDistanceToWall), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod(name, "Vector3 Raycast(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshRaycast), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "uint FindPathAsync(const Vector3&in, const Vector3&in, uint priority = 0, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshFindPathAsync), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "bool CancelPathQuery(uint)", asMETHOD(T, CancelPathQuery), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void UpdatePathQueries()", asMETHOD(T, UpdatePathQueries), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool SaveStreamingData(File@+) const", asFUNCTION(NavigationMeshSaveStreamingData), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "void AddStreamingObserver(Node@+)", asMETHOD(T, AddStreamingObserver), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void RemoveStreamingObserver(Node@+)", asMETHOD(T, RemoveStreamingObserver), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void UpdateStreaming()", asMETHOD(T, UpdateStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void BuildPathClusters()", asMETHOD(T, BuildPathClusters), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "void DrawDebugGeometry(bool)", asMETHODPR(NavigationMesh, DrawDebugGeometry, (bool), void), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "void set_tileSize(int)", asMETHOD(T, SetTileSize), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "int get_tileSize() const", asMETHOD(T, GetTileSize), asCALL_THISCALL);
@@ -174,6 +193,22 @@ template<class T> static void RegisterNavMeshBase(asIScriptEngine* engine, const
     engine->RegisterObjectMethod(name, "bool get_drawOffMeshConnections() const", asMETHOD(T, GetDrawOffMeshConnections), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "void set_drawNavAreas(bool)", asMETHOD(T, SetDrawNavAreas), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "bool get_drawNavAreas() const", asMETHOD(T, GetDrawNavAreas), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_threadedBuild(bool)", asMETHOD(T, SetThreadedBuild), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool get_threadedBuild() const", asMETHOD(T, GetThreadedBuild), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_pathIterationBudget(uint)", asMETHOD(T, SetPathIterationBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_pathIterationBudget() const", asMETHOD(T, GetPathIterationBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_maxActivePathQueries(uint)", asMETHOD(T, SetMaxActivePathQueries), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_maxActivePathQueries() const", asMETHOD(T, GetMaxActivePathQueries), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_streamingFile(const String&in)", asMETHOD(T, SetStreamingFile), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "const String& get_streamingFile() const", asMETHOD(T, GetStreamingFile), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_streamingDistance(int)", asMETHOD(T, SetStreamingDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "int get_streamingDistance() const", asMETHOD(T, GetStreamingDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_maxStreamedTiles(uint)", asMETHOD(T, SetMaxStreamedTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_maxStreamedTiles() const", asMETHOD(T, GetMaxStreamedTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool get_streaming() const", asMETHOD(T, IsStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_numStreamedTiles() const", asMETHOD(T, GetNumStreamedTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_pathClusterSize(int)", asMETHOD(T, SetPathClusterSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "int get_pathClusterSize() const", asMETHOD(T, GetPathClusterSize), asCALL_THISCALL);
 }
 
 void RegisterNavigationMesh(asIScriptEngine* engine)
@@ -184,7 +219,7 @@ void RegisterNavigationMesh(asIScriptEngine* engine)
 
     RegisterComponent<NavigationMesh>(engine, "NavigationMesh");
     RegisterNavMeshBase<NavigationMesh>(engine, "NavigationMesh");
-    engine->RegisterObjectMethod("NavigationMesh", "Array<Vector3>@ FindPath(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshFindPath), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("NavigationMesh", "Array<Vector3>@ FindPath(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0), bool hierarchical = false)", asFUNCTION(NavigationMeshFindPath), asCALL_CDECL_OBJLAST);
 }
 
 void RegisterDynamicNavigationMesh(asIScriptEngine* engine)
@@ -192,7 +227,7 @@ void RegisterDynamicNavigationMesh(asIScriptEngine* engine)
     RegisterComponent<DynamicNavigationMesh>(engine, "DynamicNavigationMesh");
     RegisterSubclass<NavigationMesh, DynamicNavigationMesh>(engine, "NavigationMesh", "DynamicNavigationMesh");
     RegisterNavMeshBase<DynamicNavigationMesh>(engine, "DynamicNavigationMesh");
-    engine->RegisterObjectMethod("DynamicNavigationMesh", "Array<Vector3>@ FindPath(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(DynamicNavigationMeshFindPath), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("DynamicNavigationMesh", "Array<Vector3>@ FindPath(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0), bool hierarchical = false)", asFUNCTION(DynamicNavigationMeshFindPath), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("DynamicNavigationMesh", "void set_drawObstacles(bool)", asMETHOD(DynamicNavigationMesh, SetDrawObstacles), asCALL_THISCALL);
     engine->RegisterObjectMethod("DynamicNavigationMesh", "bool get_drawObstacles() const", asMETHOD(DynamicNavigationMesh, GetDrawObstacles), asCALL_THISCALL);
     engine->RegisterObjectMethod("DynamicNavigationMesh", "void set_maxLayers(uint)", asMETHOD(DynamicNavigationMesh, SetMaxLayers), asCALL_THISCALL);
@@ -267,6 +302,7 @@ void RegisterCrowdManager(asIScriptEngine* engine)
     engine->RegisterObjectMethod("CrowdManager", "Vector3 GetRandomPointInCircle(const Vector3&in, float, int)", asFUNCTION(CrowdManagerRandomPointInCircle), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("CrowdManager", "float GetDistanceToWall(const Vector3&in, float, int)", asMETHOD(CrowdManager, GetDistanceToWall), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "Vector3 Raycast(const Vector3&in, const Vector3&in, int)", asMETHOD(CrowdManager, Raycast), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "uint FindPathAsync(const Vector3&in, const Vector3&in, int, uint priority = 0)", asMETHOD(CrowdManager, FindPathAsync), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint16 GetIncludeFlags(uint)", asMETHOD(CrowdManager, GetIncludeFlags), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint16 GetExcludeFlags(uint)", asMETHOD(CrowdManager, GetExcludeFlags), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "float GetAreaCost(uint, uint)", asMETHOD(CrowdManager, GetAreaCost), asCALL_THISCALL);
@@ -275,6 +311,9 @@ void RegisterCrowdManager(asIScriptEngine* engine)
     engine->RegisterObjectMethod("CrowdManager", "void set_maxAgents(int)", asMETHOD(CrowdManager, SetMaxAgents), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "float get_maxAgentRadius() const", asMETHOD(CrowdManager, GetMaxAgentRadius), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "void set_maxAgentRadius(float)", asMETHOD(CrowdManager, SetMaxAgentRadius), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "float get_partitionSize() const", asMETHOD(CrowdManager, GetPartitionSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_partitionSize(float)", asMETHOD(CrowdManager, SetPartitionSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "uint get_numPartitions() const", asMETHOD(CrowdManager, GetNumPartitions), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "void set_navMesh(NavigationMesh@+)", asMETHOD(CrowdManager, SetNavigationMesh), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "NavigationMesh@+ get_navMesh() const", asMETHOD(CrowdManager, GetNavigationMesh), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint get_numQueryFilterTypes() const", asMETHOD(CrowdManager, GetNumQueryFilterTypes), asCALL_THISCALL);
@@ -28,6 +28,7 @@
 #include "../Network/HttpRequest.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkPriority.h"
+#include "../Network/TransformHistory.h"
 
 namespace Urho3D
 {
@@ -45,6 +46,19 @@ static void RegisterNetworkPriority(asIScriptEngine* engine)
     engine->RegisterObjectMethod("NetworkPriority", "bool get_alwaysUpdateOwner() const", asMETHOD(NetworkPriority, GetAlwaysUpdateOwner), asCALL_THISCALL);
 }
 
+static void RegisterTransformHistory(asIScriptEngine* engine)
+{
+    RegisterComponent<TransformHistory>(engine, "TransformHistory");
+    engine->RegisterObjectMethod("TransformHistory", "void Record(float)", asMETHOD(TransformHistory, Record), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "void ClearHistory()", asMETHOD(TransformHistory, ClearHistory), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "bool Rewind(float)", asMETHOD(TransformHistory, Rewind), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "void Restore()", asMETHOD(TransformHistory, Restore), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "void set_historyLength(uint)", asMETHOD(TransformHistory, SetHistoryLength), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "uint get_historyLength() const", asMETHOD(TransformHistory, GetHistoryLength), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "uint get_numSamples() const", asMETHOD(TransformHistory, GetNumSamples), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TransformHistory", "bool get_rewound() const", asMETHOD(TransformHistory, IsRewound), asCALL_THISCALL);
+}
+
 void SendRemoteEvent(const String& eventType, bool inOrder, const VariantMap& eventData, Connection* ptr)
 {
     ptr->SendRemoteEvent(eventType, inOrder, eventData);
@@ -87,6 +101,11 @@ static void RegisterConnection(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Connection", "void set_rotation(const Quaternion&in)", asMETHOD(Connection, SetRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "const Quaternion& get_rotation() const", asMETHOD(Connection, GetRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "void SendPackageToClient(PackageFile@+)", asMETHOD(Connection, SendPackageToClient), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "const Controls& GetSentControls(uint8) const", asMETHOD(Connection, GetSentControls), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "void RewindScene(float interpolationDelay = 0.0f)", asMETHOD(Connection, RewindScene), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "void RestoreScene()", asMETHOD(Connection, RestoreScene), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint8 get_ackedTimeStamp() const", asMETHOD(Connection, GetAckedTimeStamp), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint get_numPendingControls() const", asMETHOD(Connection, GetNumPendingControls), asCALL_THISCALL);
     engine->RegisterObjectProperty("Connection", "Controls controls", offsetof(Connection, controls_));
     engine->RegisterObjectProperty("Connection", "uint8 timeStamp", offsetof(Connection, timeStamp_));
     engine->RegisterObjectProperty("Connection", "VariantMap identity", offsetof(Connection, identity_));
@@ -190,6 +209,8 @@ void RegisterNetwork(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Network", "float get_simulatedPacketLoss() const", asMETHOD(Network, GetSimulatedPacketLoss), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_packageCacheDir(const String&in)", asMETHOD(Network, SetPackageCacheDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "const String& get_packageCacheDir() const", asMETHOD(Network, GetPackageCacheDir), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "void set_packageUploadRate(uint)", asMETHOD(Network, SetPackageUploadRate), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "uint get_packageUploadRate() const", asMETHOD(Network, GetPackageUploadRate), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "bool get_serverRunning() const", asMETHOD(Network, IsServerRunning), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "Connection@+ get_serverConnection() const", asMETHOD(Network, GetServerConnection), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "Array<Connection@>@ get_clientConnections() const", asFUNCTION(NetworkGetClientConnections), asCALL_CDECL_OBJLAST);
@@ -199,6 +220,7 @@ void RegisterNetwork(asIScriptEngine* engine)
 void RegisterNetworkAPI(asIScriptEngine* engine)
 {
     RegisterNetworkPriority(engine);
+    RegisterTransformHistory(engine);
     RegisterConnection(engine);
     RegisterHttpRequest(engine);
     RegisterNetwork(engine);
@@ -295,6 +295,16 @@ static CScriptArray* PhysicsWorldGetCollidingBodies(RigidBody* body, PhysicsWorl
     return VectorToHandleArray<RigidBody>(result, "Array<RigidBody@>");
 }
 
+static bool PhysicsWorldSaveSnapshot(VectorBuffer& buffer, PhysicsWorld* ptr)
+{
+    return ptr->SaveSnapshot(buffer);
+}
+
+static bool PhysicsWorldRestoreSnapshot(VectorBuffer& buffer, PhysicsWorld* ptr)
+{
+    return ptr->RestoreSnapshot(buffer);
+}
+
 static void RegisterPhysicsWorld(asIScriptEngine* engine)
 {
     engine->RegisterObjectType("PhysicsRaycastResult", sizeof(PhysicsRaycastResult), asOBJ_VALUE | asOBJ_APP_CLASS_C);
@@ -310,6 +320,8 @@ static void RegisterPhysicsWorld(asIScriptEngine* engine)
     RegisterComponent<PhysicsWorld>(engine, "PhysicsWorld");
     engine->RegisterObjectMethod("PhysicsWorld", "void Update(float)", asMETHOD(PhysicsWorld, Update), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld", "void UpdateCollisions()", asMETHOD(PhysicsWorld, UpdateCollisions), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "bool SaveSnapshot(VectorBuffer&) const", asFUNCTION(PhysicsWorldSaveSnapshot), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("PhysicsWorld", "bool RestoreSnapshot(VectorBuffer&)", asFUNCTION(PhysicsWorldRestoreSnapshot), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("PhysicsWorld", "Array<PhysicsRaycastResult>@ Raycast(const Ray&in, float, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldRaycast), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("PhysicsWorld", "PhysicsRaycastResult RaycastSingle(const Ray&in, float, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldRaycastSingle), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("PhysicsWorld", "PhysicsRaycastResult RaycastSingleSegmented(const Ray&in, float, float, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldRaycastSingleSegmented), asCALL_CDECL_OBJLAST);
@@ -339,6 +351,13 @@ static void RegisterPhysicsWorld(asIScriptEngine* engine)
     engine->RegisterObjectMethod("PhysicsWorld", "bool get_internalEdge() const", asMETHOD(PhysicsWorld, GetInternalEdge), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld", "void set_splitImpulse(bool)", asMETHOD(PhysicsWorld, SetSplitImpulse), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld", "bool get_splitImpulse() const", asMETHOD(PhysicsWorld, GetSplitImpulse), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "void set_threadedSimulation(bool)", asMETHOD(PhysicsWorld, SetThreadedSimulation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "bool get_threadedSimulation() const", asMETHOD(PhysicsWorld, GetThreadedSimulation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "void set_deterministic(bool)", asMETHOD(PhysicsWorld, SetDeterministic), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "bool get_deterministic() const", asMETHOD(PhysicsWorld, GetDeterministic), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "int64 get_updateTime() const", asMETHOD(PhysicsWorld, GetUpdateTime), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "uint get_numActiveBodies() const", asMETHOD(PhysicsWorld, GetNumActiveBodies), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "uint get_stateHash() const", asMETHOD(PhysicsWorld, GetStateHash), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "PhysicsWorld@+ get_physicsWorld() const", asFUNCTION(SceneGetPhysicsWorld), asCALL_CDECL_OBJLAST);
     engine->RegisterGlobalFunction("PhysicsWorld@+ get_physicsWorld()", asFUNCTION(GetPhysicsWorld), asCALL_CDECL);
 }
@@ -26,14 +26,20 @@
 #include "../Audio/Sound.h"
 #include "../Audio/SoundListener.h"
 #include "../Audio/SoundSource3D.h"
+#include "../Audio/SoundStream.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
 
 #include <SDL/SDL.h>
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 #ifdef _MSC_VER
@@ -49,14 +55,41 @@ static const int MIN_BUFFERLENGTH = 20;
 static const int MIN_MIXRATE = 11025;
 static const int MAX_MIXRATE = 48000;
 static const StringHash SOUND_MASTER_HASH("Master");
-
+/// Voice command ring buffer size. Must be a power of two.
+static const unsigned NUM_VOICE_COMMANDS = 4096;
 static void SDLAudioCallback(void* userdata, Uint8* stream, int len);
 
+// Without SSE the buffer kernels fall back to simple indexed loops, which the compiler vectorizes for NEON on ARM.
+
+/// Convert a floating point mixing buffer to saturated 16-bit output.
+static void ConvertMixBuffer(short* dest, const float* src, unsigned count)
+{
+#ifdef URHO3D_SSE
+    // Truncate like the integer conversion would; packing saturates to the 16-bit range
+    for (; count >= 8; count -= 8, dest += 8, src += 8)
+    {
+        __m128i low = _mm_cvttps_epi32(_mm_loadu_ps(src));
+        __m128i high = _mm_cvttps_epi32(_mm_loadu_ps(src + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (unsigned i = 0; i < count; ++i)
+        dest[i] = (short)Clamp(src[i], -32768.0f, 32767.0f);
+}
+
 Audio::Audio(Context* context) :
-    Object(context)
+    Object(context),
+    writeIndex_(0),
+    readIndex_(0),
+    mixVoices_(0),
+    mixCallbacks_(0),
+    mixTime_(0),
+    maxMixTime_(0)
 {
     context_->RequireSDL(SDL_INIT_AUDIO);
 
+    commands_.Resize(NUM_VOICE_COMMANDS);
+
     // Set the master to the default value
     masterGain_[SOUND_MASTER_HASH] = 1.0f;
 
@@ -69,6 +102,12 @@ Audio::Audio(Context* context) :
 Audio::~Audio()
 {
     Release();
+
+    // The mixer has consumed all commands at this point, so retired voices can be deleted
+    for (unsigned i = 0; i < retiredResources_.Size(); ++i)
+        delete retiredResources_[i].voice_;
+    retiredResources_.Clear();
+
     context_->ReleaseSDL();
 }
 
@@ -118,7 +157,14 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     fragmentSize_ = Min(NextPowerOfTwo((unsigned)(mixRate >> 6)), (unsigned)obtained.samples);
     mixRate_ = obtained.freq;
     interpolation_ = interpolation;
-    clipBuffer_ = new int[stereo ? fragmentSize_ << 1 : fragmentSize_];
+    // Work buffers hold stereo frames regardless of the output mode, as stereo sounds are resampled before downmixing
+    unsigned bufferSize = fragmentSize_ << 1;
+    mixBuffer_ = new float[bufferSize];
+    workBuffer_ = new float[bufferSize];
+    mixVoices_.store(0, std::memory_order_relaxed);
+    mixCallbacks_.store(0, std::memory_order_relaxed);
+    mixTime_.store(0, std::memory_order_relaxed);
+    maxMixTime_.store(0, std::memory_order_relaxed);
 
     URHO3D_LOGINFO("Set audio mode " + String(mixRate_) + " Hz " + (stereo_ ? "stereo" : "mono") + " " +
             (interpolation_ ? "interpolated" : ""));
@@ -128,6 +174,8 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
 
 void Audio::Update(float timeStep)
 {
+    ReleaseRetiredResources();
+
     if (!playing_)
         return;
 
@@ -170,22 +218,23 @@ void Audio::SetMasterGain(const String& type, float gain)
 void Audio::PauseSoundType(const String& type)
 {
     pausedSoundTypes_.Insert(type);
+    UpdateVoices();
 }
 
 void Audio::ResumeSoundType(const String& type)
 {
-    MutexLock lock(audioMutex_);
     pausedSoundTypes_.Erase(type);
-    // Update sound sources before resuming playback to make sure 3D positions are up to date
-    // Done under mutex to ensure no mixing happens before we are ready
+    // Update sound sources before resuming playback to make sure 3D positions are up to date. Voices are only
+    // unpaused afterward, so no mixing happens before we are ready
     UpdateInternal(0.0f);
+    UpdateVoices();
 }
 
 void Audio::ResumeAll()
 {
-    MutexLock lock(audioMutex_);
     pausedSoundTypes_.Clear();
     UpdateInternal(0.0f);
+    UpdateVoices();
 }
 
 void Audio::SetListener(SoundListener* listener)
@@ -217,6 +266,16 @@ bool Audio::IsSoundTypePaused(const String& type) const
     return pausedSoundTypes_.Contains(type);
 }
 
+AudioMixStats Audio::GetMixStats() const
+{
+    AudioMixStats stats;
+    stats.numVoices_ = mixVoices_.load(std::memory_order_relaxed);
+    stats.numCallbacks_ = mixCallbacks_.load(std::memory_order_relaxed);
+    stats.mixTime_ = mixTime_.load(std::memory_order_relaxed);
+    stats.maxMixTime_ = maxMixTime_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 SoundListener* Audio::GetListener() const
 {
     return listener_;
@@ -224,8 +283,12 @@ SoundListener* Audio::GetListener() const
 
 void Audio::AddSoundSource(SoundSource* soundSource)
 {
-    MutexLock lock(audioMutex_);
     soundSources_.Push(soundSource);
+
+    SoundVoiceCommand command{};
+    command.type_ = VOICE_ADD;
+    command.voice_ = soundSource->GetVoice();
+    PushVoiceCommand(command);
 }
 
 void Audio::RemoveSoundSource(SoundSource* soundSource)
@@ -233,9 +296,53 @@ void Audio::RemoveSoundSource(SoundSource* soundSource)
     PODVector<SoundSource*>::Iterator i = soundSources_.Find(soundSource);
     if (i != soundSources_.End())
     {
-        MutexLock lock(audioMutex_);
         soundSources_.Erase(i);
+
+        SoundVoiceCommand command{};
+        command.type_ = VOICE_REMOVE;
+        command.voice_ = soundSource->GetVoice();
+        PushVoiceCommand(command);
+    }
+}
+
+unsigned Audio::PushVoiceCommand(const SoundVoiceCommand& command)
+{
+    unsigned writeIndex = writeIndex_.load(std::memory_order_relaxed);
+
+    // Without an open device there is no mixer running, so apply directly
+    if (!deviceID_)
+    {
+        ApplyVoiceCommand(command);
+        writeIndex_.store(writeIndex + 1, std::memory_order_relaxed);
+        readIndex_.store(writeIndex + 1, std::memory_order_release);
+        return writeIndex + 1;
+    }
+
+    // If the ring is full, the audio callback is not keeping up or not running. Block it briefly and drain the ring here
+    if (writeIndex - readIndex_.load(std::memory_order_acquire) >= NUM_VOICE_COMMANDS)
+    {
+        SDL_LockAudioDevice(deviceID_);
+        ProcessVoiceCommands();
+        SDL_UnlockAudioDevice(deviceID_);
     }
+
+    commands_[writeIndex & (NUM_VOICE_COMMANDS - 1)] = command;
+    writeIndex_.store(writeIndex + 1, std::memory_order_release);
+    return writeIndex + 1;
+}
+
+void Audio::RetireVoiceResources(Sound* sound, SoundStream* stream, Sound* streamBuffer, SoundVoice* voice)
+{
+    if (!sound && !stream && !streamBuffer && !voice)
+        return;
+
+    RetiredSoundResources resources;
+    resources.seq_ = writeIndex_.load(std::memory_order_relaxed) + 1;
+    resources.sound_ = sound;
+    resources.stream_ = stream;
+    resources.streamBuffer_ = streamBuffer;
+    resources.voice_ = voice;
+    retiredResources_.Push(resources);
 }
 
 float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
@@ -256,53 +363,136 @@ float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
 void SDLAudioCallback(void* userdata, Uint8* stream, int len)
 {
     auto* audio = static_cast<Audio*>(userdata);
-    {
-        MutexLock Lock(audio->GetMutex());
-        audio->MixOutput(stream, len / audio->GetSampleSize());
-    }
+    MutexLock lock(audio->GetMutex());
+    audio->MixOutput(stream, len / audio->GetSampleSize());
 }
 
 void Audio::MixOutput(void* dest, unsigned samples)
 {
-    if (!playing_ || !clipBuffer_)
+    // Apply pending commands even when not playing so that the main thread can free retired resources
+    ProcessVoiceCommands();
+
+    if (!playing_ || !mixBuffer_)
     {
         memset(dest, 0, samples * (size_t)sampleSize_);
         return;
     }
 
+    HiresTimer mixTimer;
+
     while (samples)
     {
-        // If sample count exceeds the fragment (clip buffer) size, split the work
+        // If sample count exceeds the fragment (mix buffer) size, split the work
         unsigned workSamples = Min(samples, fragmentSize_);
-        unsigned clipSamples = workSamples;
+        unsigned mixSamples = workSamples;
         if (stereo_)
-            clipSamples <<= 1;
+            mixSamples <<= 1;
 
-        // Clear clip buffer
-        int* clipPtr = clipBuffer_.Get();
-        memset(clipPtr, 0, clipSamples * sizeof(int));
-
-        // Mix samples to clip buffer
-        for (PODVector<SoundSource*>::Iterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+        // Gather the voices that produce output
+        activeVoices_.Clear();
+        for (PODVector<SoundVoice*>::Iterator i = voices_.Begin(); i != voices_.End(); ++i)
         {
-            SoundSource* source = *i;
+            SoundVoice* voice = *i;
+            if (voice->position_.load(std::memory_order_relaxed) && !voice->paused_.load(std::memory_order_relaxed))
+                activeVoices_.Push(voice);
+        }
 
-            // Check for pause if necessary
-            if (!pausedSoundTypes_.Empty())
-            {
-                if (pausedSoundTypes_.Contains(source->GetSoundType()))
-                    continue;
-            }
+        float* mixPtr = mixBuffer_.Get();
+        MixVoices(mixPtr, workSamples);
 
-            source->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
-        }
-        // Copy output from clip buffer to destination
-        auto* destPtr = (short*)dest;
-        while (clipSamples--)
-            *destPtr++ = (short)Clamp(*clipPtr++, -32768, 32767);
+        // Copy output from mix buffer to destination
+        ConvertMixBuffer((short*)dest, mixPtr, mixSamples);
         samples -= workSamples;
         ((unsigned char*&)dest) += sampleSize_ * workSamples;
     }
+
+    long long mixTime = mixTimer.GetUSec(false);
+    mixTime_.store(mixTime, std::memory_order_relaxed);
+    if (mixTime > maxMixTime_.load(std::memory_order_relaxed))
+        maxMixTime_.store(mixTime, std::memory_order_relaxed);
+    mixCallbacks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Audio::MixVoices(float* dest, unsigned samples)
+{
+    mixVoices_.store(activeVoices_.Size(), std::memory_order_relaxed);
+
+    memset(dest, 0, (stereo_ ? samples << 1 : samples) * sizeof(float));
+    float* work = workBuffer_.Get();
+    for (PODVector<SoundVoice*>::Iterator i = activeVoices_.Begin(); i != activeVoices_.End(); ++i)
+        (*i)->Mix(dest, work, samples, mixRate_, stereo_, interpolation_);
+}
+
+void Audio::ProcessVoiceCommands()
+{
+    unsigned readIndex = readIndex_.load(std::memory_order_relaxed);
+    unsigned writeIndex = writeIndex_.load(std::memory_order_acquire);
+
+    while (readIndex != writeIndex)
+    {
+        ApplyVoiceCommand(commands_[readIndex & (NUM_VOICE_COMMANDS - 1)]);
+        ++readIndex;
+    }
+
+    readIndex_.store(readIndex, std::memory_order_release);
+}
+
+void Audio::ApplyVoiceCommand(const SoundVoiceCommand& command)
+{
+    SoundVoice* voice = command.voice_;
+
+    switch (command.type_)
+    {
+    case VOICE_ADD:
+        voices_.Push(voice);
+        break;
+
+    case VOICE_REMOVE:
+        voices_.RemoveSwap(voice);
+        break;
+
+    case VOICE_PLAY:
+        voice->sound_ = command.sound_;
+        voice->stream_ = command.stream_;
+        voice->streamBuffer_ = command.streamBuffer_;
+        voice->position_.store(command.position_, std::memory_order_relaxed);
+        voice->fractPosition_ = 0;
+        voice->timePosition_.store(command.timePosition_, std::memory_order_relaxed);
+        voice->unusedStreamSize_ = 0;
+        break;
+
+    case VOICE_STOP:
+        voice->sound_ = nullptr;
+        voice->stream_ = nullptr;
+        voice->streamBuffer_ = nullptr;
+        voice->position_.store(nullptr, std::memory_order_relaxed);
+        voice->timePosition_.store(0.0f, std::memory_order_relaxed);
+        break;
+
+    case VOICE_SEEK:
+        voice->sound_ = command.sound_;
+        voice->stream_ = command.stream_;
+        voice->streamBuffer_ = command.streamBuffer_;
+        if (command.position_)
+            voice->position_.store(command.position_, std::memory_order_relaxed);
+        voice->timePosition_.store(command.timePosition_, std::memory_order_relaxed);
+        break;
+    }
+}
+
+void Audio::ReleaseRetiredResources()
+{
+    unsigned i = 0;
+    while (i < retiredResources_.Size())
+    {
+        if (!IsVoiceCommandPending(retiredResources_[i].seq_))
+        {
+            delete retiredResources_[i].voice_;
+            retiredResources_.EraseSwap(i);
+        }
+        else
+            ++i;
+    }
 }
 
 void Audio::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
@@ -320,10 +510,22 @@ void Audio::Release()
     {
         SDL_CloseAudioDevice(deviceID_);
         deviceID_ = 0;
-        clipBuffer_.Reset();
+
+        // The callback no longer runs, so apply the remaining commands here. Further commands are applied immediately
+        ProcessVoiceCommands();
+        ReleaseRetiredResources();
+
+        mixBuffer_.Reset();
+        workBuffer_.Reset();
     }
 }
 
+void Audio::UpdateVoices()
+{
+    for (PODVector<SoundSource*>::Iterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+        (*i)->UpdateVoice();
+}
+
 void Audio::UpdateInternal(float timeStep)
 {
     URHO3D_PROFILE(UpdateAudio);
@@ -28,6 +28,8 @@
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -35,6 +37,55 @@ class AudioImpl;
 class Sound;
 class SoundListener;
 class SoundSource;
+class SoundStream;
+struct SoundVoice;
+
+/// Playback command from a sound source to the mixer.
+struct SoundVoiceCommand
+{
+    /// Command type.
+    SoundVoiceCommandType type_;
+    /// Target voice.
+    SoundVoice* voice_;
+    /// Sound to play.
+    Sound* sound_;
+    /// Sound stream to play.
+    SoundStream* stream_;
+    /// Decode buffer of the sound stream.
+    Sound* streamBuffer_;
+    /// New playback position, or null to keep the current position when seeking.
+    signed char* position_;
+    /// New playback time position.
+    float timePosition_;
+};
+
+/// Sound resources and voices waiting for the mixer to consume a command before they can be freed.
+struct RetiredSoundResources
+{
+    /// Command sequence number that must be consumed first.
+    unsigned seq_;
+    /// Sound.
+    SharedPtr<Sound> sound_;
+    /// Sound stream.
+    SharedPtr<SoundStream> stream_;
+    /// Decode buffer.
+    SharedPtr<Sound> streamBuffer_;
+    /// Voice to delete.
+    SoundVoice* voice_;
+};
+
+/// %Audio mixing statistics.
+struct AudioMixStats
+{
+    /// Number of voices producing output in the last fragment.
+    unsigned numVoices_{};
+    /// Number of audio callbacks mixed since the mode was set.
+    unsigned numCallbacks_{};
+    /// Mixing time of the last audio callback in microseconds.
+    long long mixTime_{};
+    /// Longest mixing time of an audio callback in microseconds.
+    long long maxMixTime_{};
+};
 
 /// %Audio subsystem.
 class URHO3D_API Audio : public Object
@@ -92,6 +143,9 @@ public:
     /// Return whether specific sound type has been paused.
     bool IsSoundTypePaused(const String& type) const;
 
+    /// Return mixing statistics. Each value is read atomically, as the audio thread updates them while mixing.
+    AudioMixStats GetMixStats() const;
+
     /// Return active sound listener.
     SoundListener* GetListener() const;
 
@@ -106,12 +160,20 @@ public:
     /// Remove a sound source. Called by SoundSource.
     void RemoveSoundSource(SoundSource* soundSource);
 
-    /// Return audio thread mutex.
-    Mutex& GetMutex() { return audioMutex_; }
+    /// Queue a playback command for the mixer, or apply it immediately when no audio device is open. Return the command sequence number. Called by SoundSource.
+    unsigned PushVoiceCommand(const SoundVoiceCommand& command);
+    /// Keep sound resources, and optionally delete a voice, once the mixer has consumed the next command. Called by SoundSource.
+    void RetireVoiceResources(Sound* sound, SoundStream* stream, Sound* streamBuffer, SoundVoice* voice);
+
+    /// Return whether the mixer has not yet consumed a command.
+    bool IsVoiceCommandPending(unsigned seq) const { return (int)(seq - readIndex_.load(std::memory_order_acquire)) > 0; }
 
     /// Return sound type specific gain multiplied by master gain.
     float GetSoundSourceMasterGain(StringHash typeHash) const;
 
+    /// Return audio thread mutex. Deprecated: sound sources no longer need it, as they talk to the mixer through voice commands. It is still held while the audio callback mixes, so existing code that locks it keeps excluding the mixer.
+    Mutex& GetMutex() { return audioMutex_; }
+
     /// Mix sound sources into the buffer.
     void MixOutput(void* dest, unsigned samples);
 
@@ -122,11 +184,43 @@ private:
     void Release();
     /// Actually update sound sources with the specific timestep. Called internally.
     void UpdateInternal(float timeStep);
-
-    /// Clipping buffer for mixing.
-    SharedArrayPtr<int> clipBuffer_;
+    /// Copy voice parameters of all sound sources after a pause state change.
+    void UpdateVoices();
+    /// Apply queued voice commands. Called from the audio callback, or from the main thread when the callback can not run.
+    void ProcessVoiceCommands();
+    /// Apply a voice command.
+    void ApplyVoiceCommand(const SoundVoiceCommand& command);
+    /// Free retired resources whose commands have been consumed.
+    void ReleaseRetiredResources();
+    /// Mix the active voices.
+    void MixVoices(float* dest, unsigned samples);
+
+    /// Floating point buffer for mixing.
+    SharedArrayPtr<float> mixBuffer_;
+    /// Resampling work buffer.
+    SharedArrayPtr<float> workBuffer_;
     /// Audio thread mutex.
     Mutex audioMutex_;
+    /// Voice command ring buffer.
+    PODVector<SoundVoiceCommand> commands_;
+    /// Voice command write index. Only modified by the main thread.
+    std::atomic<unsigned> writeIndex_;
+    /// Voice command read index. Only modified by the mixer.
+    std::atomic<unsigned> readIndex_;
+    /// Resources waiting for command consumption.
+    Vector<RetiredSoundResources> retiredResources_;
+    /// Voices known to the mixer.
+    PODVector<SoundVoice*> voices_;
+    /// Voices producing output in the current fragment.
+    PODVector<SoundVoice*> activeVoices_;
+    /// Number of voices producing output in the last fragment. The mixing statistics are only written by the audio thread.
+    std::atomic<unsigned> mixVoices_;
+    /// Number of audio callbacks mixed since the mode was set.
+    std::atomic<unsigned> mixCallbacks_;
+    /// Mixing time of the last audio callback in microseconds.
+    std::atomic<long long> mixTime_;
+    /// Longest mixing time of an audio callback in microseconds.
+    std::atomic<long long> maxMixTime_;
     /// SDL audio device ID.
     unsigned deviceID_{};
     /// Sample size.
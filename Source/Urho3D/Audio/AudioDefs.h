@@ -34,4 +34,14 @@ static const String SOUND_AMBIENT = "Ambient";
 static const String SOUND_VOICE = "Voice";
 static const String SOUND_MUSIC = "Music";
 
+/// Playback command queued from a sound source to the mixer.
+enum SoundVoiceCommandType
+{
+    VOICE_ADD = 0,
+    VOICE_REMOVE,
+    VOICE_PLAY,
+    VOICE_STOP,
+    VOICE_SEEK
+};
+
 }
@@ -33,69 +33,207 @@
 #include "../Scene/Node.h"
 #include "../Scene/ReplicationState.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
-#define INC_POS_LOOPED() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_ONESHOT() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define INC_POS_STEREO_LOOPED() \
-    pos += (intAdd << 1); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_STEREO_ONESHOT() \
-    pos += (intAdd << 1); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define GET_IP_SAMPLE() (((((int)pos[1] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_LEFT() (((((int)pos[2] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_RIGHT() (((((int)pos[3] - (int)pos[1]) * fractPos) / 65536) + (int)pos[1])
-
 static const int STREAM_SAFETY_SAMPLES = 4;
 
+// The scalar loops of the conversion and mixing kernels are plain indexed loops, so that the compiler can vectorize them on
+// architectures without an SSE path, such as ARM with NEON.
+
+/// Convert 16-bit samples to floating point.
+static void ConvertSamples(float* dest, const short* src, unsigned count)
+{
+#ifdef URHO3D_SSE
+    for (; count >= 8; count -= 8, dest += 8, src += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        // Sign extend by unpacking into the high halves and shifting down
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(dest, _mm_cvtepi32_ps(low));
+        _mm_storeu_ps(dest + 4, _mm_cvtepi32_ps(high));
+    }
+#endif
+    for (unsigned i = 0; i < count; ++i)
+        dest[i] = (float)src[i];
+}
+
+/// Convert 8-bit samples to floating point.
+static void ConvertSamples(float* dest, const signed char* src, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        dest[i] = (float)src[i];
+}
+
+/// Resample sound data to floating point frames with 16.16 fixed point stepping. Return number of frames produced. The position is set to null when a one-shot sound ends.
+template <class T, unsigned CHANNELS, bool INTERPOLATE> static unsigned ResampleSamples(float* dest, T*& pos, int& fractPos,
+    T* end, T* repeat, bool looped, unsigned samples, int intAdd, int fractAdd)
+{
+    unsigned done = 0;
+
+    // At the native rate the data is converted in contiguous runs up to the end or loop point
+    if (intAdd == 1 && !fractAdd && !fractPos)
+    {
+        while (done < samples)
+        {
+            auto run = Min(samples - done, (unsigned)(end - pos) / CHANNELS);
+            if (!run)
+                break;
+
+            ConvertSamples(dest + done * CHANNELS, pos, run * CHANNELS);
+            pos += run * CHANNELS;
+            done += run;
+            if (pos >= end)
+            {
+                if (!looped)
+                {
+                    pos = nullptr;
+                    return done;
+                }
+                while (pos >= end)
+                    pos -= (end - repeat);
+            }
+        }
+    }
+
+    // Otherwise step through runs which end at the end or loop point, so that the inner loop needs no bounds checks
+    auto step = ((long long)intAdd << 16) + fractAdd;
+    while (done < samples)
+    {
+        auto remaining = (long long)(samples - done);
+        auto distance = ((long long)((end - pos) / CHANNELS) << 16) - fractPos;
+        auto run = distance > 0 ? (unsigned)(step ? Min(remaining, (distance + step - 1) / step) : remaining) : 0U;
+        if (!run)
+        {
+            // The position is already at the end, for example after seeking there. Stop, or wrap to the loop point
+            if (!looped || pos < end)
+            {
+                pos = nullptr;
+                return done;
+            }
+            while (pos >= end)
+                pos -= (end - repeat);
+            continue;
+        }
+
+        float* out = dest + done * CHANNELS;
+        auto offset = (long long)fractPos;
+        for (unsigned i = 0; i < run; ++i, offset += step, out += CHANNELS)
+        {
+            const T* src = pos + (offset >> 16) * CHANNELS;
+            if (INTERPOLATE)
+            {
+                float fract = (float)(offset & 65535) * (1.0f / 65536.0f);
+                for (unsigned j = 0; j < CHANNELS; ++j)
+                    out[j] = (float)src[j] + (float)(src[j + CHANNELS] - src[j]) * fract;
+            }
+            else
+            {
+                for (unsigned j = 0; j < CHANNELS; ++j)
+                    out[j] = (float)src[j];
+            }
+        }
+
+        pos += (offset >> 16) * CHANNELS;
+        fractPos = (int)(offset & 65535);
+        done += run;
+        if (pos >= end)
+        {
+            if (!looped)
+            {
+                pos = nullptr;
+                return done;
+            }
+            while (pos >= end)
+                pos -= (end - repeat);
+        }
+    }
+
+    return done;
+}
+
+/// Resample sound data choosing the routine for the channel count and interpolation mode.
+template <class T> static unsigned ResampleSound(float* dest, Sound* sound, signed char*& position, int& fractPos,
+    unsigned samples, int intAdd, int fractAdd, bool interpolation)
+{
+    auto* pos = (T*)position;
+    auto* end = (T*)sound->GetEnd();
+    auto* repeat = (T*)sound->GetRepeat();
+    bool looped = sound->IsLooped();
+    unsigned frames;
+
+    if (!sound->IsStereo())
+    {
+        frames = interpolation ? ResampleSamples<T, 1, true>(dest, pos, fractPos, end, repeat, looped, samples, intAdd, fractAdd) :
+            ResampleSamples<T, 1, false>(dest, pos, fractPos, end, repeat, looped, samples, intAdd, fractAdd);
+    }
+    else
+    {
+        frames = interpolation ? ResampleSamples<T, 2, true>(dest, pos, fractPos, end, repeat, looped, samples, intAdd, fractAdd) :
+            ResampleSamples<T, 2, false>(dest, pos, fractPos, end, repeat, looped, samples, intAdd, fractAdd);
+    }
+
+    position = (signed char*)pos;
+    return frames;
+}
+
+/// Add scaled samples to a mixing buffer.
+static void MixScaled(float* dest, const float* src, unsigned count, float gain)
+{
+#ifdef URHO3D_SSE
+    __m128 gains = _mm_set1_ps(gain);
+    for (; count >= 4; count -= 4, dest += 4, src += 4)
+        _mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), _mm_mul_ps(_mm_loadu_ps(src), gains)));
+#endif
+    for (unsigned i = 0; i < count; ++i)
+        dest[i] += src[i] * gain;
+}
+
+/// Add mono samples to a stereo mixing buffer with separate channel gains.
+static void MixMonoToStereo(float* dest, const float* src, unsigned frames, float leftGain, float rightGain)
+{
+#ifdef URHO3D_SSE
+    __m128 gains = _mm_setr_ps(leftGain, rightGain, leftGain, rightGain);
+    for (; frames >= 4; frames -= 4, dest += 8, src += 4)
+    {
+        __m128 samples = _mm_loadu_ps(src);
+        _mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), _mm_mul_ps(_mm_unpacklo_ps(samples, samples), gains)));
+        _mm_storeu_ps(dest + 4, _mm_add_ps(_mm_loadu_ps(dest + 4), _mm_mul_ps(_mm_unpackhi_ps(samples, samples), gains)));
+    }
+#endif
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        dest[i * 2] += src[i] * leftGain;
+        dest[i * 2 + 1] += src[i] * rightGain;
+    }
+}
+
+/// Add stereo samples to a mono mixing buffer by averaging the channels.
+static void MixStereoToMono(float* dest, const float* src, unsigned frames, float gain)
+{
+    gain *= 0.5f;
+#ifdef URHO3D_SSE
+    __m128 gains = _mm_set1_ps(gain);
+    for (; frames >= 4; frames -= 4, dest += 4, src += 8)
+    {
+        __m128 first = _mm_loadu_ps(src);
+        __m128 second = _mm_loadu_ps(src + 4);
+        __m128 left = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(dest, _mm_add_ps(_mm_loadu_ps(dest), _mm_mul_ps(_mm_add_ps(left, right), gains)));
+    }
+#endif
+    for (unsigned i = 0; i < frames; ++i)
+        dest[i] += (src[i * 2] + src[i * 2 + 1]) * gain;
+}
+
 extern const char* AUDIO_CATEGORY;
 
 extern const char* autoRemoveModeNames[];
@@ -109,10 +247,10 @@ SoundSource::SoundSource(Context* context) :
     panning_(0.0f),
     sendFinishedEvent_(false),
     autoRemove_(REMOVE_DISABLED),
-    position_(nullptr),
-    fractPosition_(0),
-    timePosition_(0.0f),
-    unusedStreamSize_(0)
+    voice_(new SoundVoice()),
+    commandSeq_(0),
+    pendingPosition_(nullptr),
+    pendingTimePosition_(0.0f)
 {
     audio_ = GetSubsystem<Audio>();
 
@@ -125,7 +263,13 @@ SoundSource::SoundSource(Context* context) :
 SoundSource::~SoundSource()
 {
     if (audio_)
+    {
+        // The mixer may still be using the voice and resources, so the audio subsystem frees them once it has caught up
+        audio_->RetireVoiceResources(sound_, soundStream_, streamBuffer_, voice_);
         audio_->RemoveSoundSource(this);
+    }
+    else
+        delete voice_;
 }
 
 void SoundSource::RegisterObject(Context* context)
@@ -144,6 +288,11 @@ void SoundSource::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Play Position", GetPositionAttr, SetPositionAttr, int, 0, AM_FILE);
 }
 
+void SoundSource::OnSetEnabled()
+{
+    UpdateVoice();
+}
+
 void SoundSource::Seek(float seekTime)
 {
     // Ignore buffered sound stream
@@ -162,9 +311,7 @@ void SoundSource::Seek(float seekTime)
     {
         // Ogg format
         if (soundStream_->Seek((unsigned)(seekTime * soundStream_->GetFrequency())))
-        {
-            timePosition_ = seekTime;
-        }
+            PushCommand(VOICE_SEEK, nullptr, seekTime);
     }
 }
 
@@ -177,14 +324,7 @@ void SoundSource::Play(Sound* sound)
     if (frequency_ == 0.0f && sound)
         SetFrequency(sound->GetFrequency());
 
-    // If sound source is currently playing, have to lock the audio mutex
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        PlayLockless(sound);
-    }
-    else
-        PlayLockless(sound);
+    PlayInternal(sound);
 
     // Forget the Sound & Is Playing attribute previous values so that they will be sent again, triggering
     // the sound correctly on network clients even after the initial playback
@@ -235,19 +375,10 @@ void SoundSource::Play(SoundStream* stream)
 
     SharedPtr<SoundStream> streamPtr(stream);
 
-    // If sound source is currently playing, have to lock the audio mutex. When stream playback is explicitly
-    // requested, clear the existing sound if any
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        sound_.Reset();
-        PlayLockless(streamPtr);
-    }
-    else
-    {
-        sound_.Reset();
-        PlayLockless(streamPtr);
-    }
+    // When stream playback is explicitly requested, clear the existing sound if any
+    RetireResources();
+    sound_.Reset();
+    PlayInternal(streamPtr);
 
     // Stream playback is not supported for network replication, no need to mark network dirty
 }
@@ -257,14 +388,7 @@ void SoundSource::Stop()
     if (!audio_)
         return;
 
-    // If sound source is currently playing, have to lock the audio mutex
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        StopLockless();
-    }
-    else
-        StopLockless();
+    StopInternal();
 
     MarkNetworkUpdate();
 }
@@ -284,24 +408,28 @@ void SoundSource::SetSoundType(const String& type)
 void SoundSource::SetFrequency(float frequency)
 {
     frequency_ = Clamp(frequency, 0.0f, 535232.0f);
+    UpdateVoice();
     MarkNetworkUpdate();
 }
 
 void SoundSource::SetGain(float gain)
 {
     gain_ = Max(gain, 0.0f);
+    UpdateVoice();
     MarkNetworkUpdate();
 }
 
 void SoundSource::SetAttenuation(float attenuation)
 {
     attenuation_ = Clamp(attenuation, 0.0f, 1.0f);
+    UpdateVoice();
     MarkNetworkUpdate();
 }
 
 void SoundSource::SetPanning(float panning)
 {
     panning_ = Clamp(panning, -1.0f, 1.0f);
+    UpdateVoice();
     MarkNetworkUpdate();
 }
 
@@ -311,9 +439,24 @@ void SoundSource::SetAutoRemoveMode(AutoRemoveMode mode)
     MarkNetworkUpdate();
 }
 
+volatile signed char* SoundSource::GetPlayPosition() const
+{
+    // Until the mixer has consumed the last command, report the position that the command sets
+    if (audio_ && audio_->IsVoiceCommandPending(commandSeq_))
+        return pendingPosition_;
+    return voice_->position_.load(std::memory_order_relaxed);
+}
+
+float SoundSource::GetTimePosition() const
+{
+    if (audio_ && audio_->IsVoiceCommandPending(commandSeq_))
+        return pendingTimePosition_;
+    return voice_->timePosition_.load(std::memory_order_relaxed);
+}
+
 bool SoundSource::IsPlaying() const
 {
-    return (sound_ || soundStream_) && position_ != nullptr;
+    return (sound_ || soundStream_) && GetPlayPosition() != nullptr;
 }
 
 void SoundSource::SetPlayPosition(signed char* pos)
@@ -322,13 +465,17 @@ void SoundSource::SetPlayPosition(signed char* pos)
     if (!audio_ || !sound_ || soundStream_)
         return;
 
-    MutexLock lock(audio_->GetMutex());
-    SetPlayPositionLockless(pos);
+    SetPlayPositionInternal(pos);
 }
 
 void SoundSource::Update(float timeStep)
 {
-    if (!audio_ || !IsEnabledEffective())
+    if (!audio_)
+        return;
+
+    UpdateVoice();
+
+    if (!IsEnabledEffective())
         return;
 
     // If there is no actual audio output, perform fake mixing into a nonexistent buffer to check stopping/looping
@@ -336,8 +483,8 @@ void SoundSource::Update(float timeStep)
         MixNull(timeStep);
 
     // Free the stream if playback has stopped
-    if (soundStream_ && !position_)
-        StopLockless();
+    if (soundStream_ && !GetPlayPosition())
+        StopInternal();
 
     bool playing = IsPlaying();
 
@@ -363,104 +510,21 @@ void SoundSource::Update(float timeStep)
     }
 }
 
-void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
+void SoundSource::UpdateMasterGain()
 {
-    if (!position_ || (!sound_ && !soundStream_) || !IsEnabledEffective())
-        return;
-
-    int streamFilledSize, outBytes;
-
-    if (soundStream_ && streamBuffer_)
-    {
-        int streamBufferSize = streamBuffer_->GetDataSize();
-        // Calculate how many bytes of stream sound data is needed
-        auto neededSize = (int)((float)samples * frequency_ / (float)mixRate);
-        // Add a little safety buffer. Subtract previous unused data
-        neededSize += STREAM_SAFETY_SAMPLES;
-        neededSize *= soundStream_->GetSampleSize();
-        neededSize -= unusedStreamSize_;
-        neededSize = Clamp(neededSize, 0, streamBufferSize - unusedStreamSize_);
-
-        // Always start play position at the beginning of the stream buffer
-        position_ = streamBuffer_->GetStart();
-
-        // Request new data from the stream
-        signed char* destination = streamBuffer_->GetStart() + unusedStreamSize_;
-        outBytes = neededSize ? soundStream_->GetData(destination, (unsigned)neededSize) : 0;
-        destination += outBytes;
-        // Zero-fill rest if stream did not produce enough data
-        if (outBytes < neededSize)
-            memset(destination, 0, (size_t)(neededSize - outBytes));
-
-        // Calculate amount of total bytes of data in stream buffer now, to know how much went unused after mixing
-        streamFilledSize = neededSize + unusedStreamSize_;
-    }
-
-    // If streaming, play the stream buffer. Otherwise play the original sound
-    Sound* sound = soundStream_ ? streamBuffer_ : sound_;
-    if (!sound)
-        return;
-
-    // Choose the correct mixing routine
-    if (!sound->IsStereo())
-    {
-        if (interpolation)
-        {
-            if (stereo)
-                MixMonoToStereoIP(sound, dest, samples, mixRate);
-            else
-                MixMonoToMonoIP(sound, dest, samples, mixRate);
-        }
-        else
-        {
-            if (stereo)
-                MixMonoToStereo(sound, dest, samples, mixRate);
-            else
-                MixMonoToMono(sound, dest, samples, mixRate);
-        }
-    }
-    else
-    {
-        if (interpolation)
-        {
-            if (stereo)
-                MixStereoToStereoIP(sound, dest, samples, mixRate);
-            else
-                MixStereoToMonoIP(sound, dest, samples, mixRate);
-        }
-        else
-        {
-            if (stereo)
-                MixStereoToStereo(sound, dest, samples, mixRate);
-            else
-                MixStereoToMono(sound, dest, samples, mixRate);
-        }
-    }
-
-    // Update the time position. In stream mode, copy unused data back to the beginning of the stream buffer
-    if (soundStream_)
+    if (audio_)
     {
-        timePosition_ += ((float)samples / (float)mixRate) * frequency_ / soundStream_->GetFrequency();
-
-        unusedStreamSize_ = Max(streamFilledSize - (int)(size_t)(position_ - streamBuffer_->GetStart()), 0);
-        if (unusedStreamSize_)
-            memcpy(streamBuffer_->GetStart(), (const void*)position_, (size_t)unusedStreamSize_);
-
-        // If stream did not produce any data, stop if applicable
-        if (!outBytes && soundStream_->GetStopAtEnd())
-        {
-            position_ = nullptr;
-            return;
-        }
+        masterGain_ = audio_->GetSoundSourceMasterGain(soundType_);
+        UpdateVoice();
     }
-    else if (sound_)
-        timePosition_ = ((float)(int)(size_t)(position_ - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
 }
 
-void SoundSource::UpdateMasterGain()
+void SoundSource::UpdateVoice()
 {
-    if (audio_)
-        masterGain_ = audio_->GetSoundSourceMasterGain(soundType_);
+    voice_->frequency_.store(frequency_, std::memory_order_relaxed);
+    voice_->gain_.store(masterGain_ * attenuation_ * gain_, std::memory_order_relaxed);
+    voice_->panning_.store(panning_, std::memory_order_relaxed);
+    voice_->paused_.store(!IsEnabledEffective() || (audio_ && audio_->IsSoundTypePaused(soundType_)), std::memory_order_relaxed);
 }
 
 void SoundSource::SetSoundAttr(const ResourceRef& value)
@@ -472,8 +536,7 @@ void SoundSource::SetSoundAttr(const ResourceRef& value)
     else
     {
         // When changing the sound and not playing, free previous sound stream and stream buffer (if any)
-        soundStream_.Reset();
-        streamBuffer_.Reset();
+        StopInternal();
         sound_ = newSound;
     }
 }
@@ -502,17 +565,15 @@ ResourceRef SoundSource::GetSoundAttr() const
 
 int SoundSource::GetPositionAttr() const
 {
-    if (sound_ && position_)
-        return (int)(GetPlayPosition() - sound_->GetStart());
+    volatile signed char* position = GetPlayPosition();
+    if (sound_ && position)
+        return (int)(position - sound_->GetStart());
     else
         return 0;
 }
 
-void SoundSource::PlayLockless(Sound* sound)
+void SoundSource::PlayInternal(Sound* sound)
 {
-    // Reset the time position in any case
-    timePosition_ = 0.0f;
-
     if (sound)
     {
         if (!sound->IsCompressed())
@@ -522,34 +583,33 @@ void SoundSource::PlayLockless(Sound* sound)
             if (start)
             {
                 // Free existing stream & stream buffer if any
+                RetireResources();
                 soundStream_.Reset();
                 streamBuffer_.Reset();
                 sound_ = sound;
-                position_ = start;
-                fractPosition_ = 0;
                 sendFinishedEvent_ = true;
+                PushCommand(VOICE_PLAY, start, 0.0f);
                 return;
             }
         }
         else
         {
             // Compressed sound start
-            PlayLockless(sound->GetDecoderStream());
+            RetireResources();
             sound_ = sound;
+            PlayInternal(sound->GetDecoderStream());
             return;
         }
     }
 
     // If sound pointer is null or if sound has no data, stop playback
-    StopLockless();
+    StopInternal();
     sound_.Reset();
 }
 
-void SoundSource::PlayLockless(const SharedPtr<SoundStream>& stream)
+void SoundSource::PlayInternal(const SharedPtr<SoundStream>& stream)
 {
-    // Reset the time position in any case
-    timePosition_ = 0.0f;
-
+    // The previous stream and decode buffer have been retired by the caller
     if (stream)
     {
         // Setup the stream buffer
@@ -562,28 +622,25 @@ void SoundSource::PlayLockless(const SharedPtr<SoundStream>& stream)
         streamBuffer_->SetLooped(true);
 
         soundStream_ = stream;
-        unusedStreamSize_ = 0;
-        position_ = streamBuffer_->GetStart();
-        fractPosition_ = 0;
         sendFinishedEvent_ = true;
+        PushCommand(VOICE_PLAY, streamBuffer_->GetStart(), 0.0f);
         return;
     }
 
     // If stream pointer is null, stop playback
-    StopLockless();
+    StopInternal();
 }
 
-void SoundSource::StopLockless()
+void SoundSource::StopInternal()
 {
-    position_ = nullptr;
-    timePosition_ = 0.0f;
-
     // Free the sound stream and decode buffer if a stream was playing
+    RetireResources();
     soundStream_.Reset();
     streamBuffer_.Reset();
+    PushCommand(VOICE_STOP, nullptr, 0.0f);
 }
 
-void SoundSource::SetPlayPositionLockless(signed char* pos)
+void SoundSource::SetPlayPositionInternal(signed char* pos)
 {
     // Setting position on a stream is not supported
     if (!sound_ || soundStream_)
@@ -598,642 +655,145 @@ void SoundSource::SetPlayPositionLockless(signed char* pos)
     if (pos > end)
         pos = end;
 
-    position_ = pos;
-    timePosition_ = ((float)(int)(size_t)(pos - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
+    PushCommand(VOICE_SEEK, pos, ((float)(int)(size_t)(pos - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency()));
 }
 
-void SoundSource::MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::RetireResources()
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    auto rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    if (audio_)
+        audio_->RetireVoiceResources(sound_, soundStream_, streamBuffer_, nullptr);
 }
 
-void SoundSource::MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::PushCommand(SoundVoiceCommandType type, signed char* position, float timePosition)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
+    if (!audio_)
         return;
-    }
 
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
+    // Make sure the voice starts with current parameters
+    UpdateVoice();
 
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
+    // A stream seek keeps the position of the decode buffer
+    pendingPosition_ = position || type != VOICE_SEEK ? position : (signed char*)GetPlayPosition();
+    pendingTimePosition_ = timePosition;
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    SoundVoiceCommand command;
+    command.type_ = type;
+    command.voice_ = voice_;
+    command.sound_ = sound_;
+    command.stream_ = soundStream_;
+    command.streamBuffer_ = streamBuffer_;
+    command.position_ = position;
+    command.timePosition_ = timePosition;
+    commandSeq_ = audio_->PushVoiceCommand(command);
 }
 
-void SoundSource::MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundVoice::Mix(float* dest, float* work, unsigned samples, int mixRate, bool stereo, bool interpolation)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    auto rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
+    // Work on a local copy of the position and publish it once at the end
+    signed char* position = position_.load(std::memory_order_relaxed);
+    if (!position || (!sound_ && !stream_))
         return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
+    int streamFilledSize, outBytes;
+    float frequency = frequency_.load(std::memory_order_relaxed);
 
-void SoundSource::MixStereoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
+    if (stream_ && streamBuffer_)
     {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
+        int streamBufferSize = streamBuffer_->GetDataSize();
+        // Calculate how many bytes of stream sound data is needed
+        auto neededSize = (int)((float)samples * frequency / (float)mixRate);
+        // Add a little safety buffer. Subtract previous unused data
+        neededSize += STREAM_SAFETY_SAMPLES;
+        neededSize *= stream_->GetSampleSize();
+        neededSize -= unusedStreamSize_;
+        neededSize = Clamp(neededSize, 0, streamBufferSize - unusedStreamSize_);
 
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
+        // Always start play position at the beginning of the stream buffer
+        position = streamBuffer_->GetStart();
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
+        // Request new data from the stream
+        signed char* destination = streamBuffer_->GetStart() + unusedStreamSize_;
+        outBytes = neededSize ? stream_->GetData(destination, (unsigned)neededSize) : 0;
+        destination += outBytes;
+        // Zero-fill rest if stream did not produce enough data
+        if (outBytes < neededSize)
+            memset(destination, 0, (size_t)(neededSize - outBytes));
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
+        // Calculate amount of total bytes of data in stream buffer now, to know how much went unused after mixing
+        streamFilledSize = neededSize + unusedStreamSize_;
     }
 
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
+    // If streaming, play the stream buffer. Otherwise play the original sound
+    Sound* sound = stream_ ? streamBuffer_ : sound_;
+    if (!sound)
         return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
 
-    if (sound->IsSixteenBit())
+    float gain = gain_.load(std::memory_order_relaxed);
+    if (RoundToInt(256.0f * gain))
     {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
+        float add = frequency / (float)mixRate;
+        auto intAdd = (int)add;
+        auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
+        int fractPos = fractPosition_;
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
+        // Resample to the work buffer, then mix with gain and panning. 8-bit samples are scaled to the 16-bit range
+        unsigned frames;
+        if (sound->IsSixteenBit())
+            frames = ResampleSound<short>(work, sound, position, fractPos, samples, intAdd, fractAdd, interpolation);
         else
         {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
+            frames = ResampleSound<signed char>(work, sound, position, fractPos, samples, intAdd, fractAdd, interpolation);
+            gain *= 256.0f;
         }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
+        fractPosition_ = fractPos;
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
+        if (!sound->IsStereo())
         {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
+            if (stereo)
             {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
+                float panning = panning_.load(std::memory_order_relaxed);
+                MixMonoToStereo(dest, work, frames, (1.0f - panning) * gain, (1.0f + panning) * gain);
             }
-            position_ = (signed char*)pos;
+            else
+                MixScaled(dest, work, frames, gain);
         }
         else
         {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
+            if (stereo)
+                MixScaled(dest, work, frames << 1, gain);
+            else
+                MixStereoToMono(dest, work, frames, gain);
         }
     }
     else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
+        MixZeroVolume(sound, position, frequency, samples, mixRate);
 
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
+    // Update the time position. In stream mode, copy unused data back to the beginning of the stream buffer
+    if (stream_)
     {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
+        timePosition_.store(timePosition_.load(std::memory_order_relaxed) + ((float)samples / (float)mixRate) * frequency /
+            stream_->GetFrequency(), std::memory_order_relaxed);
 
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
+        unusedStreamSize_ = Max(streamFilledSize - (int)(size_t)(position - streamBuffer_->GetStart()), 0);
+        if (unusedStreamSize_)
+            memcpy(streamBuffer_->GetStart(), (const void*)position, (size_t)unusedStreamSize_);
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
+        // If stream did not produce any data, stop if applicable
+        if (!outBytes && stream_->GetStopAtEnd())
+            position = nullptr;
     }
-    else
+    else if (sound_ && position)
     {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
+        timePosition_.store(((float)(int)(size_t)(position - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency()),
+            std::memory_order_relaxed);
     }
 
-    fractPosition_ = fractPos;
+    position_.store(position, std::memory_order_relaxed);
 }
 
-void SoundSource::MixZeroVolume(Sound* sound, unsigned samples, int mixRate)
+void SoundVoice::MixZeroVolume(Sound* sound, signed char*& position, float frequency, unsigned samples, int mixRate)
 {
-    float add = frequency_ * (float)samples / (float)mixRate;
+    float add = frequency * (float)samples / (float)mixRate;
     auto intAdd = (int)add;
     auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
     unsigned sampleSize = sound->GetSampleSize();
@@ -1242,46 +802,49 @@ void SoundSource::MixZeroVolume(Sound* sound, unsigned samples, int mixRate)
     if (fractPosition_ > 65535)
     {
         fractPosition_ &= 65535;
-        position_ += sampleSize;
+        position += sampleSize;
     }
-    position_ += intAdd * sampleSize;
+    position += intAdd * sampleSize;
 
-    if (position_ > sound->GetEnd())
+    if (position > sound->GetEnd())
     {
         if (sound->IsLooped())
         {
-            while (position_ >= sound->GetEnd())
+            while (position >= sound->GetEnd())
             {
-                position_ -= (sound->GetEnd() - sound->GetRepeat());
+                position -= (sound->GetEnd() - sound->GetRepeat());
             }
         }
         else
-            position_ = nullptr;
+            position = nullptr;
     }
 }
 
 void SoundSource::MixNull(float timeStep)
 {
-    if (!position_ || !sound_ || !IsEnabledEffective())
+    // Without an audio device voice commands are applied immediately, so the voice can be advanced directly
+    if (!voice_->position_.load(std::memory_order_relaxed) || !sound_ || !IsEnabledEffective())
         return;
 
     // Advance only the time position
-    timePosition_ += timeStep * frequency_ / sound_->GetFrequency();
+    float timePosition = voice_->timePosition_.load(std::memory_order_relaxed) + timeStep * frequency_ / sound_->GetFrequency();
 
     if (sound_->IsLooped())
     {
         // For simulated playback, simply reset the time position to zero when the sound loops
-        if (timePosition_ >= sound_->GetLength())
-            timePosition_ -= sound_->GetLength();
+        if (timePosition >= sound_->GetLength())
+            timePosition -= sound_->GetLength();
     }
     else
     {
-        if (timePosition_ >= sound_->GetLength())
+        if (timePosition >= sound_->GetLength())
         {
-            position_ = nullptr;
-            timePosition_ = 0.0f;
+            voice_->position_.store(nullptr, std::memory_order_relaxed);
+            timePosition = 0.0f;
         }
     }
+
+    voice_->timePosition_.store(timePosition, std::memory_order_relaxed);
 }
 
 }
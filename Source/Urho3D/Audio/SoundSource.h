@@ -25,6 +25,8 @@
 #include "../Audio/AudioDefs.h"
 #include "../Scene/Component.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -35,6 +37,38 @@ class SoundStream;
 /// Compressed audio decode buffer length in milliseconds.
 static const int STREAM_BUFFER_LENGTH = 100;
 
+/// Mixer side playback state of a sound source. Playback fields are only modified by the mixer through queued commands, while the sound source writes the mixing parameters directly. Fields shared between the threads are atomic; relaxed ordering suffices as each is an independent value.
+struct URHO3D_API SoundVoice
+{
+    /// Mix output to a floating point buffer, using the work buffer for resampling. Called by Audio.
+    void Mix(float* dest, float* work, unsigned samples, int mixRate, bool stereo, bool interpolation);
+    /// Advance playback position without producing audible output.
+    void MixZeroVolume(Sound* sound, signed char*& position, float frequency, unsigned samples, int mixRate);
+
+    /// Sound that is being played.
+    Sound* sound_{};
+    /// Sound stream that is being played.
+    SoundStream* stream_{};
+    /// Decode buffer.
+    Sound* streamBuffer_{};
+    /// Playback position.
+    std::atomic<signed char*> position_{};
+    /// Playback fractional position.
+    int fractPosition_{};
+    /// Playback time position.
+    std::atomic<float> timePosition_{};
+    /// Unused stream bytes from previous frame.
+    int unusedStreamSize_{};
+    /// Frequency.
+    std::atomic<float> frequency_{};
+    /// Total gain including master gain and attenuation.
+    std::atomic<float> gain_{};
+    /// Stereo panning.
+    std::atomic<float> panning_{};
+    /// Paused flag. Set when the sound source is disabled or its sound type is paused.
+    std::atomic<bool> paused_{};
+};
+
 /// %Sound source component with stereo position. A sound source needs to be created to a node to be considered "enabled" and be able to play, however that node does not need to belong to a scene.
 class URHO3D_API SoundSource : public Component
 {
@@ -48,6 +82,9 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
 
+    /// Handle enabled/disabled state change.
+    void OnSetEnabled() override;
+
     /// Seek to time.
     void Seek(float seekTime);
     /// Play a sound.
@@ -81,13 +118,13 @@ public:
     Sound* GetSound() const { return sound_; }
 
     /// Return playback position.
-    volatile signed char* GetPlayPosition() const { return position_; }
+    volatile signed char* GetPlayPosition() const;
 
     /// Return sound type, determines the master gain group.
     String GetSoundType() const { return soundType_; }
 
     /// Return playback time position.
-    float GetTimePosition() const { return timePosition_; }
+    float GetTimePosition() const;
 
     /// Return frequency.
     float GetFrequency() const { return frequency_; }
@@ -107,12 +144,15 @@ public:
     /// Return whether is playing.
     bool IsPlaying() const;
 
+    /// Return mixer voice. Called by Audio.
+    SoundVoice* GetVoice() const { return voice_; }
+
     /// Update the sound source. Perform subclass specific operations. Called by Audio.
     virtual void Update(float timeStep);
-    /// Mix sound source output to a 32-bit clipping buffer. Called by Audio.
-    void Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation);
     /// Update the effective master gain. Called internally and by Audio when the master gain changes.
     void UpdateMasterGain();
+    /// Copy frequency, gain, panning and pause state to the mixer voice. Called internally and by Audio when sound types are paused or resumed.
+    void UpdateVoice();
 
     /// Set sound attribute.
     void SetSoundAttr(const ResourceRef& value);
@@ -148,32 +188,18 @@ protected:
     AutoRemoveMode autoRemove_;
 
 private:
-    /// Play a sound without locking the audio mutex. Called internally.
-    void PlayLockless(Sound* sound);
-    /// Play a sound stream without locking the audio mutex. Called internally.
-    void PlayLockless(const SharedPtr<SoundStream>& stream);
-    /// Stop sound without locking the audio mutex. Called internally.
-    void StopLockless();
-    /// Set new playback position without locking the audio mutex. Called internally.
-    void SetPlayPositionLockless(signed char* pos);
-    /// Mix mono sample to mono buffer.
-    void MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix mono sample to stereo buffer.
-    void MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix mono sample to mono buffer interpolated.
-    void MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix mono sample to stereo buffer interpolated.
-    void MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to mono buffer.
-    void MixStereoToMono(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to stereo buffer.
-    void MixStereoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to mono buffer interpolated.
-    void MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to stereo buffer interpolated.
-    void MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Advance playback pointer without producing audible output.
-    void MixZeroVolume(Sound* sound, unsigned samples, int mixRate);
+    /// Play a sound. Called internally.
+    void PlayInternal(Sound* sound);
+    /// Play a sound stream. Called internally.
+    void PlayInternal(const SharedPtr<SoundStream>& stream);
+    /// Stop sound. Called internally.
+    void StopInternal();
+    /// Set new playback position. Called internally.
+    void SetPlayPositionInternal(signed char* pos);
+    /// Hand the current sound, stream and decode buffer to the audio subsystem so that they stay alive until the mixer has seen the next command.
+    void RetireResources();
+    /// Queue a playback command for the mixer voice.
+    void PushCommand(SoundVoiceCommandType type, signed char* position, float timePosition);
     /// Advance playback pointer to simulate audio playback in headless mode.
     void MixNull(float timeStep);
 
@@ -181,16 +207,16 @@ private:
     SharedPtr<Sound> sound_;
     /// Sound stream that is being played.
     SharedPtr<SoundStream> soundStream_;
-    /// Playback position.
-    volatile signed char* position_;
-    /// Playback fractional position.
-    volatile int fractPosition_;
-    /// Playback time position.
-    volatile float timePosition_;
     /// Decode buffer.
     SharedPtr<Sound> streamBuffer_;
-    /// Unused stream bytes from previous frame.
-    int unusedStreamSize_;
+    /// Mixer voice.
+    SoundVoice* voice_;
+    /// Sequence number of the last queued command.
+    unsigned commandSeq_;
+    /// Playback position after the last queued command.
+    signed char* pendingPosition_;
+    /// Playback time position after the last queued command.
+    float pendingTimePosition_;
 };
 
 }
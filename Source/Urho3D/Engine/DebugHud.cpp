@@ -150,6 +150,9 @@ void DebugHud::Update()
             renderer->GetNumLights(true),
             renderer->GetNumShadowMaps(true),
             renderer->GetNumOccluders(true));
+        if (renderer->GetShadowMapCaching())
+            stats.AppendWithFormat("\nShadow splits %u (cached %u)", renderer->GetNumRenderedShadowSplits(true),
+                renderer->GetNumCachedShadowSplits(true));
 
         if (!appStats_.Empty())
         {
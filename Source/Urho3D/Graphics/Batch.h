@@ -290,6 +290,10 @@ struct ShadowBatchQueue
     float nearSplit_;
     /// Directional light cascade far split distance.
     float farSplit_;
+    /// Hash of the shadow camera and casters for shadow map caching. Zero if the split can not be cached.
+    unsigned long long cacheHash_;
+    /// Split is valid in the cached shadow map and does not need rendering.
+    bool cached_;
 };
 
 /// Queue for light related draw calls.
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/BillboardSet.h"
 #include "../Graphics/Camera.h"
@@ -36,6 +37,10 @@
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Node.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -44,6 +49,12 @@ namespace Urho3D
 extern const char* GEOMETRY_CATEGORY;
 
 static const float INV_SQRT_TWO = 1.0f / sqrtf(2.0f);
+/// Insertion sort moves allowed per billboard before falling back to a full sort.
+static const unsigned INSERTION_SORT_MOVES_PER_BILLBOARD = 4;
+/// Minimum number of billboards to use radix sort instead of comparison sort.
+static const unsigned MIN_RADIX_SORT_BILLBOARDS = 256;
+/// Minimum number of billboards per work item when writing vertices in worker threads.
+static const unsigned MIN_BILLBOARDS_PER_WORK_ITEM = 1024;
 
 const char* faceCameraModeNames[] =
 {
@@ -74,6 +85,93 @@ inline bool CompareBillboards(Billboard* lhs, Billboard* rhs)
     return lhs->sortDistance_ > rhs->sortDistance_;
 }
 
+/// Parameters for writing billboard vertices, shared by the work items.
+struct BillboardVertexWriteData
+{
+    /// First billboard of the range being written.
+    Billboard** start_;
+    /// Vertex data of the first billboard.
+    float* dest_;
+    /// Scale applied to billboard size.
+    Vector3 scale_;
+    /// Fixed screen size flag.
+    bool fixedScreenSize_;
+    /// Direction billboards flag.
+    bool direction_;
+};
+
+static void WriteBillboardVertices(const BillboardVertexWriteData& data, Billboard** start, Billboard** end)
+{
+    unsigned vertexSize = data.direction_ ? 11 : 8;
+    float* dest = data.dest_ + (start - data.start_) * vertexSize * 4;
+
+#ifdef URHO3D_SSE
+    const __m128 signX = _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f);
+    const __m128 signY = _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f);
+#endif
+
+    for (; start != end; ++start)
+    {
+        const Billboard& billboard = **start;
+
+        Vector2 size(billboard.size_.x_ * data.scale_.x_, billboard.size_.y_ * data.scale_.y_);
+        unsigned color = billboard.color_.ToUInt();
+        if (data.fixedScreenSize_)
+            size *= billboard.screenScaleFactor_;
+
+        float sinAngle, cosAngle;
+        SinCos(billboard.rotation_, sinAngle, cosAngle);
+
+        // Rotated corner offsets, in the order top left, top right, bottom right, bottom left
+        float offsetX[4];
+        float offsetY[4];
+#ifdef URHO3D_SSE
+        __m128 x = _mm_add_ps(_mm_mul_ps(signX, _mm_set1_ps(size.x_ * cosAngle)), _mm_mul_ps(signY, _mm_set1_ps(size.y_ * sinAngle)));
+        __m128 y = _mm_sub_ps(_mm_mul_ps(signY, _mm_set1_ps(size.y_ * cosAngle)), _mm_mul_ps(signX, _mm_set1_ps(size.x_ * sinAngle)));
+        _mm_storeu_ps(offsetX, x);
+        _mm_storeu_ps(offsetY, y);
+#else
+        offsetX[0] = -size.x_ * cosAngle + size.y_ * sinAngle;
+        offsetY[0] = size.x_ * sinAngle + size.y_ * cosAngle;
+        offsetX[1] = size.x_ * cosAngle + size.y_ * sinAngle;
+        offsetY[1] = -size.x_ * sinAngle + size.y_ * cosAngle;
+        offsetX[2] = size.x_ * cosAngle - size.y_ * sinAngle;
+        offsetY[2] = -size.x_ * sinAngle - size.y_ * cosAngle;
+        offsetX[3] = -size.x_ * cosAngle - size.y_ * sinAngle;
+        offsetY[3] = size.x_ * sinAngle - size.y_ * cosAngle;
+#endif
+        const float uvX[4] = {billboard.uv_.min_.x_, billboard.uv_.max_.x_, billboard.uv_.max_.x_, billboard.uv_.min_.x_};
+        const float uvY[4] = {billboard.uv_.min_.y_, billboard.uv_.min_.y_, billboard.uv_.max_.y_, billboard.uv_.max_.y_};
+
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            dest[0] = billboard.position_.x_;
+            dest[1] = billboard.position_.y_;
+            dest[2] = billboard.position_.z_;
+            if (data.direction_)
+            {
+                dest[3] = billboard.direction_.x_;
+                dest[4] = billboard.direction_.y_;
+                dest[5] = billboard.direction_.z_;
+                dest += 3;
+            }
+            ((unsigned&)dest[3]) = color;
+            dest[4] = uvX[i];
+            dest[5] = uvY[i];
+            dest[6] = offsetX[i];
+            dest[7] = offsetY[i];
+
+            dest += 8;
+        }
+    }
+}
+
+static void WriteBillboardVerticesWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    WriteBillboardVertices(*reinterpret_cast<BillboardVertexWriteData*>(item->aux_), reinterpret_cast<Billboard**>(item->start_),
+        reinterpret_cast<Billboard**>(item->end_));
+}
+
 BillboardSet::BillboardSet(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY),
     animationLodBias_(1.0f),
@@ -269,6 +367,8 @@ void BillboardSet::SetNumBillboards(unsigned num)
         return;
 
     billboards_.Resize(num);
+    // The billboards may have been reallocated, so the previous sort order can not be reused
+    sortedBillboards_.Clear();
 
     // Set default values to new billboards
     for (unsigned i = oldNum; i < num; ++i)
@@ -476,22 +576,57 @@ void BillboardSet::OnWorldBoundingBoxUpdate()
     Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
     BoundingBox worldBox;
 
+    // Particle emitters dirty the bounds on every update, so accumulate the extents of the billboards directly instead of
+    // merging a bounding box per billboard
+#ifdef URHO3D_SSE
+    __m128 minimum = _mm_set1_ps(M_INFINITY);
+    __m128 maximum = _mm_set1_ps(-M_INFINITY);
+#else
+    Vector3 minimum(M_INFINITY, M_INFINITY, M_INFINITY);
+    Vector3 maximum(-M_INFINITY, -M_INFINITY, -M_INFINITY);
+#endif
+
     for (unsigned i = 0; i < billboards_.Size(); ++i)
     {
-        if (!billboards_[i].enabled_)
+        const Billboard& billboard = billboards_[i];
+        if (!billboard.enabled_)
             continue;
 
-        float size = INV_SQRT_TWO * (billboards_[i].size_.x_ * billboardScale.x_ + billboards_[i].size_.y_ * billboardScale.y_);
+        float size = INV_SQRT_TWO * (billboard.size_.x_ * billboardScale.x_ + billboard.size_.y_ * billboardScale.y_);
         if (fixedScreenSize_)
-            size *= billboards_[i].screenScaleFactor_;
-
-        Vector3 center = billboardTransform * billboards_[i].position_;
-        Vector3 edge = Vector3::ONE * size;
-        worldBox.Merge(BoundingBox(center - edge, center + edge));
+            size *= billboard.screenScaleFactor_;
+
+        Vector3 center = relative_ ? billboardTransform * billboard.position_ : billboard.position_;
+#ifdef URHO3D_SSE
+        __m128 centerVec = _mm_setr_ps(center.x_, center.y_, center.z_, 0.0f);
+        __m128 edge = _mm_set1_ps(size);
+        minimum = _mm_min_ps(minimum, _mm_sub_ps(centerVec, edge));
+        maximum = _mm_max_ps(maximum, _mm_add_ps(centerVec, edge));
+#else
+        minimum.x_ = Min(minimum.x_, center.x_ - size);
+        minimum.y_ = Min(minimum.y_, center.y_ - size);
+        minimum.z_ = Min(minimum.z_, center.z_ - size);
+        maximum.x_ = Max(maximum.x_, center.x_ + size);
+        maximum.y_ = Max(maximum.y_, center.y_ + size);
+        maximum.z_ = Max(maximum.z_, center.z_ + size);
+#endif
 
         ++enabledBillboards;
     }
 
+    if (enabledBillboards)
+    {
+#ifdef URHO3D_SSE
+        float minData[4];
+        float maxData[4];
+        _mm_storeu_ps(minData, minimum);
+        _mm_storeu_ps(maxData, maximum);
+        worldBox.Define(Vector3(minData), Vector3(maxData));
+#else
+        worldBox.Define(minimum, maximum);
+#endif
+    }
+
     // Always merge the node's own position to ensure particle emitter updates continue when the relative mode is switched
     worldBox.Merge(node_->GetWorldPosition());
 
@@ -595,6 +730,8 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
     Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
     Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    // Rewrite all vertices if the billboards have changed. Otherwise only the range where the sort order changed is written
+    bool fullUpdate = bufferDirty_ || vertexBuffer_->IsDataLost();
 
     // First check number of enabled billboards
     for (unsigned i = 0; i < numBillboards; ++i)
@@ -603,19 +740,22 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
             ++enabledBillboards;
     }
 
-    sortedBillboards_.Resize(enabledBillboards);
-    unsigned index = 0;
+    // If the same billboards are enabled as before, sort starting from the previous order, as it is likely nearly correct
+    bool keepOrder = sorted_ && sortedBillboards_.Size() == enabledBillboards;
+    for (unsigned i = 0; keepOrder && i < enabledBillboards; ++i)
+        keepOrder = sortedBillboards_[i]->enabled_;
 
-    // Then set initial sort order and distances
-    for (unsigned i = 0; i < numBillboards; ++i)
+    // Otherwise set initial sort order
+    if (!keepOrder)
     {
-        Billboard& billboard = billboards_[i];
-        if (billboard.enabled_)
+        sortedBillboards_.Resize(enabledBillboards);
+        unsigned index = 0;
+        for (unsigned i = 0; i < numBillboards; ++i)
         {
-            sortedBillboards_[index++] = &billboard;
-            if (sorted_)
-                billboard.sortDistance_ = frame.camera_->GetDistanceSquared(billboardTransform * billboards_[i].position_);
+            if (billboards_[i].enabled_)
+                sortedBillboards_[index++] = &billboards_[i];
         }
+        fullUpdate = true;
     }
 
     batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, enabledBillboards * 6, false);
@@ -625,143 +765,165 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     if (!enabledBillboards)
         return;
 
+    unsigned dirtyStart = 0;
+    unsigned dirtyEnd = enabledBillboards;
+
     if (sorted_)
     {
-        Sort(sortedBillboards_.Begin(), sortedBillboards_.End(), CompareBillboards);
+        for (unsigned i = 0; i < enabledBillboards; ++i)
+            sortedBillboards_[i]->sortDistance_ = frame.camera_->GetDistanceSquared(billboardTransform * sortedBillboards_[i]->position_);
+
+        SortBillboards(dirtyStart, dirtyEnd);
         Vector3 worldPos = node_->GetWorldPosition();
         // Store the "last sorted position" now
         previousOffset_ = (worldPos - frame.camera_->GetNode()->GetWorldPosition());
+
+        if (fullUpdate)
+        {
+            dirtyStart = 0;
+            dirtyEnd = enabledBillboards;
+        }
+        else if (dirtyStart >= dirtyEnd)
+            return;
     }
 
-    auto* dest = (float*)vertexBuffer_->Lock(0, enabledBillboards * 4, true);
+#ifdef URHO3D_D3D11
+    // Dynamic Direct3D 11 buffers can only be mapped with discard, so a changed range is written as a full update
+    dirtyStart = 0;
+    dirtyEnd = enabledBillboards;
+    fullUpdate = true;
+#endif
+
+    unsigned numDirty = dirtyEnd - dirtyStart;
+    auto* dest = (float*)vertexBuffer_->Lock(dirtyStart * 4, numDirty * 4, fullUpdate);
     if (!dest)
+    {
+        bufferDirty_ = true;
         return;
+    }
 
-    if (faceCameraMode_ != FC_DIRECTION)
-    {
-        for (unsigned i = 0; i < enabledBillboards; ++i)
-        {
-            Billboard& billboard = *sortedBillboards_[i];
+    BillboardVertexWriteData data;
+    data.start_ = &sortedBillboards_[0] + dirtyStart;
+    data.dest_ = dest;
+    data.scale_ = billboardScale;
+    data.fixedScreenSize_ = fixedScreenSize_;
+    data.direction_ = faceCameraMode_ == FC_DIRECTION;
 
-            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-            unsigned color = billboard.color_.ToUInt();
-            if (fixedScreenSize_)
-                size *= billboard.screenScaleFactor_;
+    // Divide large billboard sets among worker threads
+    auto* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = queue ? Min(queue->GetNumThreads() + 1, numDirty / MIN_BILLBOARDS_PER_WORK_ITEM) : 1;
 
-            float rotationMatrix[2][2];
-            SinCos(billboard.rotation_, rotationMatrix[0][1], rotationMatrix[0][0]);
-            rotationMatrix[1][0] = -rotationMatrix[0][1];
-            rotationMatrix[1][1] = rotationMatrix[0][0];
+    if (numWorkItems > 1)
+    {
+        unsigned billboardsPerItem = numDirty / numWorkItems;
+        Billboard** start = data.start_;
+        Billboard** end = start + numDirty;
 
-            dest[0] = billboard.position_.x_;
-            dest[1] = billboard.position_.y_;
-            dest[2] = billboard.position_.z_;
-            ((unsigned&)dest[3]) = color;
-            dest[4] = billboard.uv_.min_.x_;
-            dest[5] = billboard.uv_.min_.y_;
-            dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-            dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-
-            dest[8] = billboard.position_.x_;
-            dest[9] = billboard.position_.y_;
-            dest[10] = billboard.position_.z_;
-            ((unsigned&)dest[11]) = color;
-            dest[12] = billboard.uv_.max_.x_;
-            dest[13] = billboard.uv_.min_.y_;
-            dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-            dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-
-            dest[16] = billboard.position_.x_;
-            dest[17] = billboard.position_.y_;
-            dest[18] = billboard.position_.z_;
-            ((unsigned&)dest[19]) = color;
-            dest[20] = billboard.uv_.max_.x_;
-            dest[21] = billboard.uv_.max_.y_;
-            dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-            dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-            dest[24] = billboard.position_.x_;
-            dest[25] = billboard.position_.y_;
-            dest[26] = billboard.position_.z_;
-            ((unsigned&)dest[27]) = color;
-            dest[28] = billboard.uv_.min_.x_;
-            dest[29] = billboard.uv_.max_.y_;
-            dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-            dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-            dest += 32;
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = WriteBillboardVerticesWork;
+            item->aux_ = &data;
+            item->start_ = start;
+            item->end_ = i < numWorkItems - 1 ? start + billboardsPerItem : end;
+            queue->AddWorkItem(item);
+
+            start = reinterpret_cast<Billboard**>(item->end_);
         }
+
+        queue->Complete(M_MAX_UNSIGNED);
     }
     else
+        WriteBillboardVertices(data, data.start_, data.start_ + numDirty);
+
+    vertexBuffer_->Unlock();
+    vertexBuffer_->ClearDataLost();
+}
+
+void BillboardSet::SortBillboards(unsigned& dirtyStart, unsigned& dirtyEnd)
+{
+    unsigned numBillboards = sortedBillboards_.Size();
+    dirtyStart = numBillboards;
+    dirtyEnd = 0;
+
+    // When the camera moves smoothly the previous order needs few changes, so try an insertion sort first
+    unsigned maxMoves = numBillboards * INSERTION_SORT_MOVES_PER_BILLBOARD;
+    unsigned moves = 0;
+    for (unsigned i = 1; i < numBillboards; ++i)
     {
-        for (unsigned i = 0; i < enabledBillboards; ++i)
+        Billboard* billboard = sortedBillboards_[i];
+        unsigned j = i;
+        while (j > 0 && CompareBillboards(billboard, sortedBillboards_[j - 1]))
+        {
+            sortedBillboards_[j] = sortedBillboards_[j - 1];
+            --j;
+        }
+
+        if (j != i)
         {
-            Billboard& billboard = *sortedBillboards_[i];
+            sortedBillboards_[j] = billboard;
+            dirtyStart = Min(dirtyStart, j);
+            dirtyEnd = i + 1;
+            moves += i - j;
+            if (moves > maxMoves)
+                break;
+        }
+    }
 
-            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-            unsigned color = billboard.color_.ToUInt();
-            if (fixedScreenSize_)
-                size *= billboard.screenScaleFactor_;
+    if (moves <= maxMoves)
+        return;
 
-            float rot2D[2][2];
-            SinCos(billboard.rotation_, rot2D[0][1], rot2D[0][0]);
-            rot2D[1][0] = -rot2D[0][1];
-            rot2D[1][1] = rot2D[0][0];
+    // The order changed too much, sort fully
+    dirtyStart = 0;
+    dirtyEnd = numBillboards;
 
-            dest[0] = billboard.position_.x_;
-            dest[1] = billboard.position_.y_;
-            dest[2] = billboard.position_.z_;
-            dest[3] = billboard.direction_.x_;
-            dest[4] = billboard.direction_.y_;
-            dest[5] = billboard.direction_.z_;
-            ((unsigned&)dest[6]) = color;
-            dest[7] = billboard.uv_.min_.x_;
-            dest[8] = billboard.uv_.min_.y_;
-            dest[9] = -size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
-            dest[10] = -size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
-
-            dest[11] = billboard.position_.x_;
-            dest[12] = billboard.position_.y_;
-            dest[13] = billboard.position_.z_;
-            dest[14] = billboard.direction_.x_;
-            dest[15] = billboard.direction_.y_;
-            dest[16] = billboard.direction_.z_;
-            ((unsigned&)dest[17]) = color;
-            dest[18] = billboard.uv_.max_.x_;
-            dest[19] = billboard.uv_.min_.y_;
-            dest[20] = size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
-            dest[21] = size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
-
-            dest[22] = billboard.position_.x_;
-            dest[23] = billboard.position_.y_;
-            dest[24] = billboard.position_.z_;
-            dest[25] = billboard.direction_.x_;
-            dest[26] = billboard.direction_.y_;
-            dest[27] = billboard.direction_.z_;
-            ((unsigned&)dest[28]) = color;
-            dest[29] = billboard.uv_.max_.x_;
-            dest[30] = billboard.uv_.max_.y_;
-            dest[31] = size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
-            dest[32] = size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
-
-            dest[33] = billboard.position_.x_;
-            dest[34] = billboard.position_.y_;
-            dest[35] = billboard.position_.z_;
-            dest[36] = billboard.direction_.x_;
-            dest[37] = billboard.direction_.y_;
-            dest[38] = billboard.direction_.z_;
-            ((unsigned&)dest[39]) = color;
-            dest[40] = billboard.uv_.min_.x_;
-            dest[41] = billboard.uv_.max_.y_;
-            dest[42] = -size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
-            dest[43] = -size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
-
-            dest += 44;
+    if (numBillboards < MIN_RADIX_SORT_BILLBOARDS)
+    {
+        Sort(sortedBillboards_.Begin(), sortedBillboards_.End(), CompareBillboards);
+        return;
+    }
+
+    // Radix sort by distance. The key is in the high 32 bits and the billboard index in the low 32 bits
+    sortKeys_.Resize(numBillboards * 2);
+    unsigned long long* keys = &sortKeys_[0];
+    unsigned long long* temp = keys + numBillboards;
+    Billboard* base = &billboards_[0];
+
+    for (unsigned i = 0; i < numBillboards; ++i)
+    {
+        // Non-negative floats sort like unsigned integers. Invert for back-to-front order
+        unsigned distanceBits;
+        memcpy(&distanceBits, &sortedBillboards_[i]->sortDistance_, sizeof distanceBits);
+        keys[i] = ((unsigned long long)~distanceBits << 32) | (unsigned)(sortedBillboards_[i] - base);
+    }
+
+    for (unsigned shift = 32; shift < 64; shift += 8)
+    {
+        unsigned counts[256] = {0};
+        for (unsigned i = 0; i < numBillboards; ++i)
+            ++counts[(keys[i] >> shift) & 0xff];
+
+        // Skip the pass if all keys have the same digit
+        if (counts[(keys[0] >> shift) & 0xff] == numBillboards)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            unsigned count = counts[i];
+            counts[i] = offset;
+            offset += count;
         }
+
+        for (unsigned i = 0; i < numBillboards; ++i)
+            temp[counts[(keys[i] >> shift) & 0xff]++] = keys[i];
+
+        Swap(keys, temp);
     }
 
-    vertexBuffer_->Unlock();
-    vertexBuffer_->ClearDataLost();
+    for (unsigned i = 0; i < numBillboards; ++i)
+        sortedBillboards_[i] = base + (unsigned)keys[i];
 }
 
 void BillboardSet::MarkPositionsDirty()
@@ -770,6 +932,11 @@ void BillboardSet::MarkPositionsDirty()
     bufferDirty_ = true;
 }
 
+void BillboardSet::MarkVerticesDirty()
+{
+    bufferDirty_ = true;
+}
+
 void BillboardSet::CalculateFixedScreenSize(const FrameInfo& frame)
 {
     float invViewHeight = 1.0f / frame.viewSize_.y_;
@@ -92,7 +92,7 @@ public:
     /// Set whether billboards have fixed size on screen (measured in pixels) regardless of distance to camera. Default false.
     void SetFixedScreenSize(bool enable);
     /// Set how the billboards should rotate in relation to the camera. Default is to follow camera rotation on all axes (FC_ROTATE_XYZ.)
-    void SetFaceCameraMode(FaceCameraMode mode);
+    virtual void SetFaceCameraMode(FaceCameraMode mode);
     /// Set minimal angle between billboard normal and look-at direction.
     void SetMinAngle(float angle);
     /// Set animation LOD bias.
@@ -151,6 +151,8 @@ protected:
     void OnWorldBoundingBoxUpdate() override;
     /// Mark billboard vertex buffer to need an update.
     void MarkPositionsDirty();
+    /// Mark billboard vertex buffer to need an update without dirtying the bounding box. For subclasses that calculate their own bounds.
+    void MarkVerticesDirty();
 
     /// Billboards.
     PODVector<Billboard> billboards_;
@@ -176,6 +178,8 @@ private:
     void UpdateBufferSize();
     /// Rewrite billboard vertex buffer.
     void UpdateVertexBuffer(const FrameInfo& frame);
+    /// Sort billboards back to front and return the range whose order changed.
+    void SortBillboards(unsigned& dirtyStart, unsigned& dirtyEnd);
     /// Calculate billboard scale factors in fixed screen size mode.
     void CalculateFixedScreenSize(const FrameInfo& frame);
 
@@ -205,6 +209,8 @@ private:
     Vector3 previousOffset_;
     /// Billboard pointers for sorting.
     Vector<Billboard*> sortedBillboards_;
+    /// Radix sort keys and scratch space.
+    PODVector<unsigned long long> sortKeys_;
     /// Attribute buffer for network replication.
     mutable VectorBuffer attrBuffer_;
 };
@@ -22,6 +22,7 @@
 
 #include "../../Precompiled.h"
 
+#include "../../Core/Timer.h"
 #include "../../Graphics/Graphics.h"
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/Shader.h"
@@ -58,33 +59,14 @@ void ShaderVariation::OnDeviceLost()
 
 bool ShaderVariation::Create()
 {
-    Release();
-
-    if (!graphics_)
-        return false;
-
-    if (!owner_)
+    // Load or compile the bytecode now, unless already done in a worker thread
+    if (!prepared_)
     {
-        compilerOutput_ = "Owner shader has expired";
-        return false;
-    }
-
-    // Check for up-to-date bytecode on disk
-    String path, name, extension;
-    SplitPath(owner_->GetName(), path, name, extension);
-    extension = type_ == VS ? ".vs4" : ".ps4";
-
-    String binaryShaderName = graphics_->GetShaderCacheDir() + name + "_" + StringHash(defines_).ToString() + extension;
-
-    if (!LoadByteCode(binaryShaderName))
-    {
-        // Compile shader if don't have valid bytecode
-        if (!Compile())
+        Release();
+        if (!Prepare())
             return false;
-        // Save the bytecode after successful compile, but not if the source is from a package
-        if (owner_->GetTimeStamp())
-            SaveByteCode(binaryShaderName);
     }
+    prepared_ = false;
 
     // Then create shader from the bytecode
     ID3D11Device* device = graphics_->GetImpl()->GetDevice();
@@ -120,6 +102,44 @@ bool ShaderVariation::Create()
     return object_.ptr_ != nullptr;
 }
 
+bool ShaderVariation::Prepare()
+{
+    if (!graphics_)
+        return false;
+
+    if (!owner_)
+    {
+        compilerOutput_ = "Owner shader has expired";
+        return false;
+    }
+
+    // Check for bytecode on disk. The file is named by a hash of the source code, defines and shader model, so it is never stale
+    String path, name, extension;
+    SplitPath(owner_->GetName(), path, name, extension);
+    extension = type_ == VS ? ".vs4" : ".ps4";
+
+    String target = String(type_ == VS ? "D3D11 vs_4_0" : "D3D11 ps_4_0") + " MAXBONES=" + String(Graphics::GetMaxBones());
+    unsigned long long cacheKey = CalculateCacheKey(owner_->GetSourceCode(type_), defines_, target);
+    String binaryShaderName = graphics_->GetShaderCacheDir() + name + "_" + ToStringHex((unsigned)(cacheKey >> 32)) +
+        ToStringHex((unsigned)cacheKey) + extension;
+
+    HiresTimer compileTimer;
+    bool cacheHit = LoadByteCode(binaryShaderName);
+    if (!cacheHit)
+    {
+        // Compile shader if don't have valid bytecode
+        if (!Compile())
+            return false;
+        // Save the bytecode after successful compile, but not if the source is from a package
+        if (owner_->GetTimeStamp())
+            SaveByteCode(binaryShaderName);
+    }
+
+    graphics_->AddShaderCompileStats(cacheHit, compileTimer.GetUSec(false));
+    prepared_ = true;
+    return true;
+}
+
 void ShaderVariation::Release()
 {
     if (object_.ptr_)
@@ -152,6 +172,7 @@ void ShaderVariation::Release()
     parameters_.Clear();
     byteCode_.Clear();
     elementHash_ = 0;
+    prepared_ = false;
 }
 
 void ShaderVariation::SetDefines(const String& defines)
@@ -170,13 +191,6 @@ bool ShaderVariation::LoadByteCode(const String& binaryShaderName)
     if (!cache->Exists(binaryShaderName))
         return false;
 
-    FileSystem* fileSystem = owner_->GetSubsystem<FileSystem>();
-    unsigned sourceTimeStamp = owner_->GetTimeStamp();
-    // If source code is loaded from a package, its timestamp will be zero. Else check that binary is not older
-    // than source
-    if (sourceTimeStamp && fileSystem->GetLastModifiedTime(cache->GetResourceFileName(binaryShaderName)) < sourceTimeStamp)
-        return false;
-
     SharedPtr<File> file = cache->GetFile(binaryShaderName);
     if (!file || file->ReadFileID() != "USHD")
     {
@@ -31,6 +31,7 @@
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/DecalSet.h"
 #include "../Graphics/Graphics.h"
+#include "../Graphics/ImpostorGroup.h"
 #include "../Graphics/GraphicsImpl.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Octree.h"
@@ -40,6 +41,7 @@
 #include "../Graphics/Shader.h"
 #include "../Graphics/ShaderPrecache.h"
 #include "../Graphics/Skybox.h"
+#include "../Graphics/StaticBatcher.h"
 #include "../Graphics/StaticModelGroup.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Terrain.h"
@@ -293,6 +295,17 @@ void Graphics::SetShaderCacheDir(const String& path)
         shaderCacheDir_ = AddTrailingSlash(trimmedPath);
 }
 
+void Graphics::AddShaderCompileStats(bool cacheHit, long long compileTime)
+{
+    MutexLock lock(shaderStatsMutex_);
+
+    if (cacheHit)
+        ++shaderCacheHits_;
+    else
+        ++shaderCacheMisses_;
+    shaderCompileTime_ += compileTime;
+}
+
 void Graphics::AddGPUObject(GPUObject* object)
 {
     MutexLock lock(gpuObjectMutex_);
@@ -413,12 +426,14 @@ void RegisterGraphicsLibrary(Context* context)
     Light::RegisterObject(context);
     StaticModel::RegisterObject(context);
     StaticModelGroup::RegisterObject(context);
+    StaticBatcher::RegisterObject(context);
     Skybox::RegisterObject(context);
     AnimatedModel::RegisterObject(context);
     AnimationController::RegisterObject(context);
     BillboardSet::RegisterObject(context);
     ParticleEffect::RegisterObject(context);
     ParticleEmitter::RegisterObject(context);
+    ImpostorGroup::RegisterObject(context);
     RibbonTrail::RegisterObject(context);
     CustomGeometry::RegisterObject(context);
     DecalSet::RegisterObject(context);
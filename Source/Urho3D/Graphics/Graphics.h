@@ -490,6 +490,15 @@ public:
     /// Return shader cache directory, Direct3D only.
     const String& GetShaderCacheDir() const { return shaderCacheDir_; }
 
+    /// Return number of shader variations loaded from the bytecode cache.
+    unsigned GetNumShaderCacheHits() const { return shaderCacheHits_; }
+
+    /// Return number of shader variations compiled from source.
+    unsigned GetNumShaderCacheMisses() const { return shaderCacheMisses_; }
+
+    /// Return total time spent loading and compiling shader variations in microseconds.
+    long long GetShaderCompileTime() const { return shaderCompileTime_; }
+
     /// Return current rendertarget width and height.
     IntVector2 GetRenderTargetDimensions() const;
 
@@ -517,6 +526,8 @@ public:
     void CleanupScratchBuffers();
     /// Clean up shader parameters when a shader variation is released or destroyed.
     void CleanupShaderPrograms(ShaderVariation* variation);
+    /// Record shader variation load or compile statistics. Called by ShaderVariation, possibly from a worker thread.
+    void AddShaderCompileStats(bool cacheHit, long long compileTime);
     /// Clean up a render surface from all FBOs. Used only on OpenGL.
     void CleanupRenderSurface(RenderSurface* surface);
     /// Get or create a constant buffer. Will be shared between shaders if possible.
@@ -629,6 +640,8 @@ private:
 
     /// Mutex for accessing the GPU objects vector from several threads.
     Mutex gpuObjectMutex_;
+    /// Mutex for updating shader compile statistics from several threads.
+    Mutex shaderStatsMutex_;
     /// Implementation.
     GraphicsImpl* impl_;
     /// SDL window.
@@ -781,6 +794,12 @@ private:
     String shaderPath_;
     /// Cache directory for Direct3D binary shaders.
     String shaderCacheDir_;
+    /// Number of shader variations loaded from the bytecode cache.
+    unsigned shaderCacheHits_{};
+    /// Number of shader variations compiled from source.
+    unsigned shaderCacheMisses_{};
+    /// Time spent loading and compiling shader variations in microseconds.
+    long long shaderCompileTime_{};
     /// File extension for shaders.
     String shaderExtension_;
     /// Last used shader in shader variation query.
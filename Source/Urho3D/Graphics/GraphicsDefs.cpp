@@ -58,6 +58,7 @@ extern URHO3D_API const StringHash VSP_ZONE("Zone");
 extern URHO3D_API const StringHash VSP_LIGHTMATRICES("LightMatrices");
 extern URHO3D_API const StringHash VSP_SKINMATRICES("SkinMatrices");
 extern URHO3D_API const StringHash VSP_VERTEXLIGHTS("VertexLights");
+extern URHO3D_API const StringHash VSP_CLUSTERVIEWPROJ("ClusterViewProj");
 extern URHO3D_API const StringHash PSP_AMBIENTCOLOR("AmbientColor");
 extern URHO3D_API const StringHash PSP_CAMERAPOS("CameraPosPS");
 extern URHO3D_API const StringHash PSP_DELTATIME("DeltaTimePS");
@@ -89,6 +90,9 @@ extern URHO3D_API const StringHash PSP_LIGHTRAD("LightRad");
 extern URHO3D_API const StringHash PSP_LIGHTLENGTH("LightLength");
 extern URHO3D_API const StringHash PSP_ZONEMIN("ZoneMin");
 extern URHO3D_API const StringHash PSP_ZONEMAX("ZoneMax");
+extern URHO3D_API const StringHash PSP_CLUSTERPARAMS("ClusterParams");
+extern URHO3D_API const StringHash PSP_CLUSTERDEPTH("ClusterDepth");
+extern URHO3D_API const StringHash PSP_CLUSTERTEXPARAMS("ClusterTexParams");
 
 extern URHO3D_API const Vector3 DOT_SCALE(1 / 3.0f, 1 / 3.0f, 1 / 3.0f);
 
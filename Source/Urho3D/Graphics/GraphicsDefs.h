@@ -395,6 +395,7 @@ extern URHO3D_API const StringHash VSP_ZONE;
 extern URHO3D_API const StringHash VSP_LIGHTMATRICES;
 extern URHO3D_API const StringHash VSP_SKINMATRICES;
 extern URHO3D_API const StringHash VSP_VERTEXLIGHTS;
+extern URHO3D_API const StringHash VSP_CLUSTERVIEWPROJ;
 extern URHO3D_API const StringHash PSP_AMBIENTCOLOR;
 extern URHO3D_API const StringHash PSP_CAMERAPOS;
 extern URHO3D_API const StringHash PSP_DELTATIME;
@@ -426,6 +427,9 @@ extern URHO3D_API const StringHash PSP_LIGHTRAD;
 extern URHO3D_API const StringHash PSP_LIGHTLENGTH;
 extern URHO3D_API const StringHash PSP_ZONEMIN;
 extern URHO3D_API const StringHash PSP_ZONEMAX;
+extern URHO3D_API const StringHash PSP_CLUSTERPARAMS;
+extern URHO3D_API const StringHash PSP_CLUSTERDEPTH;
+extern URHO3D_API const StringHash PSP_CLUSTERTEXPARAMS;
 
 // Scale calculation from bounding box diagonal.
 extern URHO3D_API const Vector3 DOT_SCALE;
@@ -0,0 +1,634 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/ImpostorGroup.h"
+#include "../Graphics/Light.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Model.h"
+#include "../Graphics/Octree.h"
+#include "../Graphics/StaticModel.h"
+#include "../Graphics/Technique.h"
+#include "../Graphics/Texture2D.h"
+#include "../Graphics/Viewport.h"
+#include "../Graphics/Zone.h"
+#include "../IO/Log.h"
+#include "../Resource/ResourceCache.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+static const unsigned DEFAULT_NUM_FRAMES = 8;
+static const unsigned MAX_NUM_FRAMES = 32;
+static const int DEFAULT_FRAME_SIZE = 128;
+static const float DEFAULT_IMPOSTOR_DISTANCE = 100.0f;
+static const float DEFAULT_FADE_DISTANCE = 10.0f;
+
+static const StringVector instanceNodesStructureElementNames =
+{
+    "Instance Count",
+    "   NodeID"
+};
+
+/// Return octahedral coordinate of an atlas frame index.
+static float FrameToOctahedral(unsigned frame, unsigned numFrames)
+{
+    return numFrames > 1 ? (float)frame / (float)(numFrames - 1) * 2.0f - 1.0f : 0.0f;
+}
+
+/// Return nearest atlas frame index of an octahedral coordinate.
+static unsigned OctahedralToFrame(float coord, unsigned numFrames)
+{
+    return (unsigned)Clamp(RoundToInt((coord + 1.0f) * 0.5f * (float)(numFrames - 1)), 0, (int)numFrames - 1);
+}
+
+/// Map a unit direction to octahedral coordinates in the range -1 to 1. The upper hemisphere maps to the inner diamond.
+static Vector2 OctahedralEncode(const Vector3& direction)
+{
+    float sum = Abs(direction.x_) + Abs(direction.y_) + Abs(direction.z_);
+    if (sum < M_EPSILON)
+        return Vector2::ZERO;
+
+    Vector3 n = direction / sum;
+    if (n.y_ >= 0.0f)
+        return Vector2(n.x_, n.z_);
+    else
+        return Vector2((1.0f - Abs(n.z_)) * Sign(n.x_), (1.0f - Abs(n.x_)) * Sign(n.z_));
+}
+
+/// Map octahedral coordinates back to a unit direction.
+static Vector3 OctahedralDecode(float u, float v)
+{
+    Vector3 n(u, 1.0f - Abs(u) - Abs(v), v);
+    if (n.y_ < 0.0f)
+    {
+        n.x_ = (1.0f - Abs(v)) * Sign(u);
+        n.z_ = (1.0f - Abs(u)) * Sign(v);
+    }
+
+    return n.Normalized();
+}
+
+/// Return draw distance of an instance node's StaticModel, or zero if it has none.
+static float GetInstanceDrawDistance(Node* node)
+{
+    auto* staticModel = node->GetComponent<StaticModel>();
+    return staticModel ? staticModel->GetDrawDistance() : 0.0f;
+}
+
+ImpostorGroup::ImpostorGroup(Context* context) :
+    BillboardSet(context),
+    numFrames_(DEFAULT_NUM_FRAMES),
+    frameSize_(DEFAULT_FRAME_SIZE),
+    impostorDistance_(DEFAULT_IMPOSTOR_DISTANCE),
+    fadeDistance_(DEFAULT_FADE_DISTANCE),
+    numVisibleImpostors_(0),
+    bakeDirty_(false),
+    nodesDirty_(false),
+    nodeIDsDirty_(false)
+{
+    // Impostors are positioned in world space, sorted for correct blending and updated every frame
+    relative_ = false;
+    scaled_ = false;
+    sorted_ = true;
+    animationLodBias_ = 0.0f;
+
+    // Initialize the default node IDs attribute
+    UpdateNodeIDs();
+}
+
+ImpostorGroup::~ImpostorGroup() = default;
+
+void ImpostorGroup::RegisterObject(Context* context)
+{
+    context->RegisterFactory<ImpostorGroup>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Model", GetModelAttr, SetModelAttr, ResourceRef, ResourceRef(Model::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Model Material", GetModelMaterialsAttr, SetModelMaterialsAttr, ResourceRefList,
+        ResourceRefList(Material::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Frames", GetNumFrames, SetNumFrames, unsigned, DEFAULT_NUM_FRAMES, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Frame Size", GetFrameSize, SetFrameSize, int, DEFAULT_FRAME_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Impostor Distance", GetImpostorDistance, SetImpostorDistance, float, DEFAULT_IMPOSTOR_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Fade Distance", GetFadeDistance, SetFadeDistance, float, DEFAULT_FADE_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Sort By Distance", IsSorted, SetSorted, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Can Be Occluded", IsOccludee, SetOccludee, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
+    URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
+    URHO3D_ACCESSOR_ATTRIBUTE("Instance Nodes", GetNodeIDsAttr, SetNodeIDsAttr,
+        VariantVector, Variant::emptyVariantVector, AM_DEFAULT | AM_NODEIDVECTOR)
+        .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, instanceNodesStructureElementNames);
+}
+
+void ImpostorGroup::ApplyAttributes()
+{
+    if (!nodesDirty_)
+        return;
+
+    // Remove all old instance nodes before searching for new
+    for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+    {
+        Node* node = instanceNodes_[i];
+        if (node)
+        {
+            node->RemoveListener(this);
+            RestoreDrawDistance(i);
+        }
+    }
+
+    instanceNodes_.Clear();
+    originalDrawDistances_.Clear();
+
+    Scene* scene = GetScene();
+    if (scene)
+    {
+        // The first index stores the number of IDs redundantly. This is for editing
+        for (unsigned i = 1; i < nodeIDsAttr_.Size(); ++i)
+        {
+            Node* node = scene->GetNode(nodeIDsAttr_[i].GetUInt());
+            if (node)
+            {
+                WeakPtr<Node> instanceWeak(node);
+                node->AddListener(this);
+                instanceNodes_.Push(instanceWeak);
+                originalDrawDistances_.Push(GetInstanceDrawDistance(node));
+                ApplyDrawDistance(node);
+            }
+        }
+    }
+
+    SetNumBillboards(instanceNodes_.Size());
+    nodesDirty_ = false;
+}
+
+void ImpostorGroup::UpdateGeometry(const FrameInfo& frame)
+{
+    if (bakeDirty_)
+        Bake();
+    else if (atlas_ && atlas_->IsDataLost())
+    {
+        // Render the atlas again if the rendertarget contents were lost
+        RenderSurface* surface = atlas_->GetRenderSurface();
+        if (surface)
+            surface->QueueUpdate();
+        atlas_->ClearDataLost();
+    }
+
+    UpdateImpostors(frame.camera_->GetNode()->GetWorldPosition());
+    MarkVerticesDirty();
+
+    BillboardSet::UpdateGeometry(frame);
+}
+
+void ImpostorGroup::SetModel(Model* model)
+{
+    if (model == model_)
+        return;
+
+    model_ = model;
+    modelMaterials_.Resize(model ? model->GetNumGeometries() : 0);
+    bakeDirty_ = true;
+    OnMarkedDirty(GetNode());
+    MarkNetworkUpdate();
+}
+
+void ImpostorGroup::SetModelMaterial(Material* material)
+{
+    for (unsigned i = 0; i < modelMaterials_.Size(); ++i)
+        modelMaterials_[i] = material;
+
+    bakeDirty_ = true;
+    MarkNetworkUpdate();
+}
+
+bool ImpostorGroup::SetModelMaterial(unsigned index, Material* material)
+{
+    if (index >= modelMaterials_.Size())
+    {
+        URHO3D_LOGERROR("Material index out of bounds");
+        return false;
+    }
+
+    modelMaterials_[index] = material;
+    bakeDirty_ = true;
+    MarkNetworkUpdate();
+    return true;
+}
+
+void ImpostorGroup::SetNumFrames(unsigned frames)
+{
+    frames = Clamp(frames, 1U, MAX_NUM_FRAMES);
+    if (frames == numFrames_)
+        return;
+
+    numFrames_ = frames;
+    bakeDirty_ = true;
+    MarkNetworkUpdate();
+}
+
+void ImpostorGroup::SetFrameSize(int size)
+{
+    size = Max(size, 1);
+    if (size == frameSize_)
+        return;
+
+    frameSize_ = size;
+    bakeDirty_ = true;
+    MarkNetworkUpdate();
+}
+
+void ImpostorGroup::SetImpostorDistance(float distance)
+{
+    impostorDistance_ = Max(distance, 0.0f);
+
+    for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+        ApplyDrawDistance(instanceNodes_[i]);
+
+    MarkNetworkUpdate();
+}
+
+void ImpostorGroup::SetFadeDistance(float distance)
+{
+    fadeDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void ImpostorGroup::Bake()
+{
+    bakeDirty_ = false;
+
+    auto* graphics = GetSubsystem<Graphics>();
+    if (!model_ || !graphics || !graphics->IsInitialized())
+        return;
+
+    URHO3D_PROFILE(BakeImpostors);
+
+    int atlasSize = numFrames_ * frameSize_;
+    if (!atlas_)
+        atlas_ = new Texture2D(context_);
+    if (atlas_->GetWidth() != atlasSize || atlas_->GetHeight() != atlasSize)
+    {
+        if (!atlas_->SetSize(atlasSize, atlasSize, Graphics::GetRGBAFormat(), TEXTURE_RENDERTARGET))
+        {
+            URHO3D_LOGERROR("Failed to create impostor atlas");
+            return;
+        }
+    }
+
+    RenderSurface* surface = atlas_->GetRenderSurface();
+    const BoundingBox& box = model_->GetBoundingBox();
+    Vector3 center = box.Center();
+    float radius = Max(box.HalfSize().Length(), M_EPSILON);
+
+    // Build a scene with only the model, a transparent background and a fixed light
+    bakeScene_ = new Scene(context_);
+    bakeScene_->CreateComponent<Octree>();
+    auto* zone = bakeScene_->CreateComponent<Zone>();
+    zone->SetBoundingBox(BoundingBox(center - Vector3::ONE * radius * 4.0f, center + Vector3::ONE * radius * 4.0f));
+    zone->SetAmbientColor(Color(0.5f, 0.5f, 0.5f));
+    zone->SetFogColor(Color(0.0f, 0.0f, 0.0f, 0.0f));
+    zone->SetFogStart(radius * 8.0f);
+    zone->SetFogEnd(radius * 16.0f);
+
+    Node* lightNode = bakeScene_->CreateChild("Light");
+    lightNode->SetDirection(Vector3(0.5f, -1.0f, 0.5f));
+    auto* light = lightNode->CreateComponent<Light>();
+    light->SetLightType(LIGHT_DIRECTIONAL);
+
+    Node* modelNode = bakeScene_->CreateChild("Model");
+    auto* staticModel = modelNode->CreateComponent<StaticModel>();
+    staticModel->SetModel(model_);
+    for (unsigned i = 0; i < modelMaterials_.Size(); ++i)
+    {
+        if (modelMaterials_[i])
+            staticModel->SetMaterial(i, modelMaterials_[i]);
+    }
+
+    // Render each atlas frame through its own viewport, looking at the model from an octahedrally distributed direction
+    surface->SetUpdateMode(SURFACE_MANUALUPDATE);
+    surface->SetNumViewports(numFrames_ * numFrames_);
+
+    for (unsigned y = 0; y < numFrames_; ++y)
+    {
+        for (unsigned x = 0; x < numFrames_; ++x)
+        {
+            Vector3 direction = OctahedralDecode(FrameToOctahedral(x, numFrames_), FrameToOctahedral(y, numFrames_));
+            Node* cameraNode = bakeScene_->CreateChild("Camera");
+            cameraNode->SetPosition(center + direction * radius * 2.0f);
+            cameraNode->LookAt(center, Abs(direction.y_) > 0.99f ? Vector3::FORWARD : Vector3::UP);
+
+            auto* camera = cameraNode->CreateComponent<Camera>();
+            camera->SetOrthographic(true);
+            camera->SetOrthoSize(radius * 2.0f);
+            camera->SetAutoAspectRatio(false);
+            camera->SetAspectRatio(1.0f);
+            camera->SetFarClip(radius * 4.0f);
+
+            IntRect rect(x * frameSize_, y * frameSize_, (x + 1) * frameSize_, (y + 1) * frameSize_);
+            SharedPtr<Viewport> viewport(new Viewport(context_, bakeScene_, camera, rect));
+            surface->SetViewport(y * numFrames_ + x, viewport);
+        }
+    }
+
+    surface->QueueUpdate();
+
+    if (!GetMaterial())
+    {
+        auto* cache = GetSubsystem<ResourceCache>();
+        SharedPtr<Material> material(new Material(context_));
+        material->SetTechnique(0, cache->GetResource<Technique>("Techniques/DiffVColUnlitAlpha.xml"));
+        material->SetTexture(TU_DIFFUSE, atlas_);
+        SetMaterial(material);
+    }
+}
+
+unsigned ImpostorGroup::UpdateImpostors(const Vector3& cameraPosition)
+{
+    URHO3D_PROFILE(UpdateImpostors);
+
+    if (billboards_.Size() != instanceNodes_.Size())
+        SetNumBillboards(instanceNodes_.Size());
+
+    numVisibleImpostors_ = 0;
+    if (!model_)
+    {
+        for (unsigned i = 0; i < billboards_.Size(); ++i)
+            billboards_[i].enabled_ = false;
+        return 0;
+    }
+
+    const BoundingBox& box = model_->GetBoundingBox();
+    Vector3 center = box.Center();
+    float radius = box.HalfSize().Length();
+    float fadeStart = impostorDistance_ - fadeDistance_;
+    float frameScale = 1.0f / (float)numFrames_;
+
+    for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+    {
+        Billboard& billboard = billboards_[i];
+        Node* node = instanceNodes_[i];
+        if (!node || !node->IsEnabled())
+        {
+            billboard.enabled_ = false;
+            continue;
+        }
+
+        Vector3 worldCenter = node->GetWorldTransform() * center;
+        Vector3 offset = cameraPosition - worldCenter;
+        float distance = offset.Length();
+        if (distance < fadeStart)
+        {
+            billboard.enabled_ = false;
+            continue;
+        }
+
+        // Choose the atlas frame baked from the direction closest to the camera in the instance's local space
+        Vector2 oct = OctahedralEncode(node->GetWorldRotation().Inverse() * offset);
+        unsigned x = OctahedralToFrame(oct.x_, numFrames_);
+        unsigned y = OctahedralToFrame(oct.y_, numFrames_);
+        float alpha = fadeDistance_ > 0.0f ? Clamp((distance - fadeStart) / fadeDistance_, 0.0f, 1.0f) : 1.0f;
+        Vector3 scale = node->GetWorldScale();
+
+        billboard.enabled_ = true;
+        billboard.position_ = worldCenter;
+        billboard.size_ = Vector2::ONE * radius * Max(Max(scale.x_, scale.y_), scale.z_);
+        billboard.uv_ = Rect(x * frameScale, y * frameScale, (x + 1) * frameScale, (y + 1) * frameScale);
+        billboard.color_ = Color(1.0f, 1.0f, 1.0f, alpha);
+        billboard.rotation_ = 0.0f;
+        ++numVisibleImpostors_;
+    }
+
+    return numVisibleImpostors_;
+}
+
+void ImpostorGroup::AddInstanceNode(Node* node)
+{
+    if (!node)
+        return;
+
+    WeakPtr<Node> instanceWeak(node);
+    if (instanceNodes_.Contains(instanceWeak))
+        return;
+
+    // Add as a listener for the instance node, so that we know to dirty the bounding box when the node moves or is enabled/disabled
+    node->AddListener(this);
+    instanceNodes_.Push(instanceWeak);
+    originalDrawDistances_.Push(GetInstanceDrawDistance(node));
+    ApplyDrawDistance(node);
+    UpdateNumInstances();
+}
+
+void ImpostorGroup::RemoveInstanceNode(Node* node)
+{
+    if (!node)
+        return;
+
+    WeakPtr<Node> instanceWeak(node);
+    Vector<WeakPtr<Node> >::Iterator i = instanceNodes_.Find(instanceWeak);
+    if (i == instanceNodes_.End())
+        return;
+
+    node->RemoveListener(this);
+    unsigned index = (unsigned)(i - instanceNodes_.Begin());
+    RestoreDrawDistance(index);
+    instanceNodes_.Erase(i);
+    originalDrawDistances_.Erase(index);
+    UpdateNumInstances();
+}
+
+void ImpostorGroup::RemoveAllInstanceNodes()
+{
+    for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+    {
+        Node* node = instanceNodes_[i];
+        if (node)
+        {
+            node->RemoveListener(this);
+            RestoreDrawDistance(i);
+        }
+    }
+
+    instanceNodes_.Clear();
+    originalDrawDistances_.Clear();
+    UpdateNumInstances();
+}
+
+Material* ImpostorGroup::GetModelMaterial(unsigned index) const
+{
+    return index < modelMaterials_.Size() ? modelMaterials_[index] : nullptr;
+}
+
+Node* ImpostorGroup::GetInstanceNode(unsigned index) const
+{
+    return index < instanceNodes_.Size() ? instanceNodes_[index] : nullptr;
+}
+
+void ImpostorGroup::SetModelAttr(const ResourceRef& value)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    SetModel(cache->GetResource<Model>(value.name_));
+}
+
+void ImpostorGroup::SetModelMaterialsAttr(const ResourceRefList& value)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    for (unsigned i = 0; i < value.names_.Size(); ++i)
+        SetModelMaterial(i, cache->GetResource<Material>(value.names_[i]));
+}
+
+void ImpostorGroup::SetNodeIDsAttr(const VariantVector& value)
+{
+    // Just remember the node IDs. They need to go through the SceneResolver, and we actually find the nodes during
+    // ApplyAttributes()
+    if (value.Size())
+    {
+        nodeIDsAttr_.Clear();
+
+        unsigned index = 0;
+        unsigned numInstances = value[index++].GetUInt();
+        // Prevent crash on entering negative value in the editor
+        if (numInstances > M_MAX_INT)
+            numInstances = 0;
+
+        nodeIDsAttr_.Push(numInstances);
+        while (numInstances--)
+        {
+            // If vector contains less IDs than should, fill the rest with zeroes
+            if (index < value.Size())
+                nodeIDsAttr_.Push(value[index++].GetUInt());
+            else
+                nodeIDsAttr_.Push(0);
+        }
+    }
+    else
+    {
+        nodeIDsAttr_.Clear();
+        nodeIDsAttr_.Push(0);
+    }
+
+    nodesDirty_ = true;
+    nodeIDsDirty_ = false;
+}
+
+ResourceRef ImpostorGroup::GetModelAttr() const
+{
+    return GetResourceRef(model_, Model::GetTypeStatic());
+}
+
+const ResourceRefList& ImpostorGroup::GetModelMaterialsAttr() const
+{
+    modelMaterialsAttr_.names_.Resize(modelMaterials_.Size());
+    for (unsigned i = 0; i < modelMaterials_.Size(); ++i)
+        modelMaterialsAttr_.names_[i] = GetResourceName(modelMaterials_[i]);
+
+    return modelMaterialsAttr_;
+}
+
+const VariantVector& ImpostorGroup::GetNodeIDsAttr() const
+{
+    if (nodeIDsDirty_)
+        UpdateNodeIDs();
+
+    return nodeIDsAttr_;
+}
+
+void ImpostorGroup::OnNodeSetEnabled(Node* node)
+{
+    Drawable::OnMarkedDirty(node);
+}
+
+void ImpostorGroup::OnWorldBoundingBoxUpdate()
+{
+    // Cover all instances regardless of which are currently impostors, so that the group stays in view for the selection
+    BoundingBox worldBox;
+
+    if (model_)
+    {
+        const BoundingBox& box = model_->GetBoundingBox();
+        for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+        {
+            Node* node = instanceNodes_[i];
+            if (node && node->IsEnabled())
+                worldBox.Merge(box.Transformed(node->GetWorldTransform()));
+        }
+    }
+
+    if (!worldBox.Defined())
+        worldBox.Merge(node_->GetWorldPosition());
+
+    worldBoundingBox_ = worldBox;
+}
+
+void ImpostorGroup::UpdateNumInstances()
+{
+    SetNumBillboards(instanceNodes_.Size());
+    nodeIDsDirty_ = true;
+
+    OnMarkedDirty(GetNode());
+    MarkNetworkUpdate();
+}
+
+void ImpostorGroup::UpdateNodeIDs() const
+{
+    unsigned numInstances = instanceNodes_.Size();
+
+    nodeIDsAttr_.Clear();
+    nodeIDsAttr_.Push(numInstances);
+
+    for (unsigned i = 0; i < numInstances; ++i)
+    {
+        Node* node = instanceNodes_[i];
+        nodeIDsAttr_.Push(node ? node->GetID() : 0);
+    }
+
+    nodeIDsDirty_ = false;
+}
+
+void ImpostorGroup::ApplyDrawDistance(Node* node) const
+{
+    if (!node)
+        return;
+
+    auto* staticModel = node->GetComponent<StaticModel>();
+    if (staticModel)
+        staticModel->SetDrawDistance(impostorDistance_);
+}
+
+void ImpostorGroup::RestoreDrawDistance(unsigned index) const
+{
+    Node* node = instanceNodes_[index];
+    auto* staticModel = node ? node->GetComponent<StaticModel>() : nullptr;
+    if (staticModel)
+        staticModel->SetDrawDistance(originalDrawDistances_[index]);
+}
+
+}
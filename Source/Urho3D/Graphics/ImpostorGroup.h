@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/BillboardSet.h"
+
+namespace Urho3D
+{
+
+class Model;
+class Scene;
+class Texture2D;
+
+/// Renders distant instances of a model as camera-facing impostor billboards. The impostor atlas is baked at runtime from a grid of octahedrally distributed view directions.
+class URHO3D_API ImpostorGroup : public BillboardSet
+{
+    URHO3D_OBJECT(ImpostorGroup, BillboardSet);
+
+public:
+    /// Construct.
+    explicit ImpostorGroup(Context* context);
+    /// Destruct.
+    ~ImpostorGroup() override;
+    /// Register object factory. BillboardSet must be registered first.
+    static void RegisterObject(Context* context);
+
+    /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
+    void ApplyAttributes() override;
+    /// Prepare geometry for rendering. Called from a worker thread if possible (no GPU update.)
+    void UpdateGeometry(const FrameInfo& frame) override;
+
+    /// Set model to bake the impostors from.
+    void SetModel(Model* model);
+    /// Set material to use on all of the model's geometries when baking.
+    void SetModelMaterial(Material* material);
+    /// Set material to use on one of the model's geometries when baking. Return true if successful.
+    bool SetModelMaterial(unsigned index, Material* material);
+    /// Set number of atlas frames per side. Total number of view directions is the square of this.
+    void SetNumFrames(unsigned frames);
+    /// Set atlas frame size in pixels.
+    void SetFrameSize(int size);
+    /// Set distance at which the instances switch to impostors. Also applied as the draw distance of the instances' StaticModels.
+    void SetImpostorDistance(float distance);
+    /// Set distance before the impostor distance over which the impostors fade in.
+    void SetFadeDistance(float distance);
+    /// Queue the impostor atlas to be rendered. Called automatically when the model or atlas settings change.
+    void Bake();
+    /// Select impostors and their atlas frames for a camera position. Called automatically before rendering. Return number of visible impostors.
+    unsigned UpdateImpostors(const Vector3& cameraPosition);
+
+    /// Add an instance scene node. Its StaticModel, if any, will have its draw distance set to the impostor distance.
+    void AddInstanceNode(Node* node);
+    /// Remove an instance scene node.
+    void RemoveInstanceNode(Node* node);
+    /// Remove all instance scene nodes.
+    void RemoveAllInstanceNodes();
+
+    /// Return model.
+    Model* GetModel() const { return model_; }
+
+    /// Return model material by geometry index.
+    Material* GetModelMaterial(unsigned index = 0) const;
+
+    /// Return number of atlas frames per side.
+    unsigned GetNumFrames() const { return numFrames_; }
+
+    /// Return atlas frame size in pixels.
+    int GetFrameSize() const { return frameSize_; }
+
+    /// Return impostor distance.
+    float GetImpostorDistance() const { return impostorDistance_; }
+
+    /// Return fade distance.
+    float GetFadeDistance() const { return fadeDistance_; }
+
+    /// Return impostor atlas texture. Can be saved for offline use with GetImage().
+    Texture2D* GetImpostorTexture() const { return atlas_; }
+
+    /// Return number of instance nodes.
+    unsigned GetNumInstanceNodes() const { return instanceNodes_.Size(); }
+
+    /// Return instance node by index.
+    Node* GetInstanceNode(unsigned index) const;
+
+    /// Return number of impostors visible after the last selection.
+    unsigned GetNumVisibleImpostors() const { return numVisibleImpostors_; }
+
+    /// Set model attribute.
+    void SetModelAttr(const ResourceRef& value);
+    /// Set model materials attribute.
+    void SetModelMaterialsAttr(const ResourceRefList& value);
+    /// Set node IDs attribute.
+    void SetNodeIDsAttr(const VariantVector& value);
+    /// Return model attribute.
+    ResourceRef GetModelAttr() const;
+    /// Return model materials attribute.
+    const ResourceRefList& GetModelMaterialsAttr() const;
+    /// Return node IDs attribute.
+    const VariantVector& GetNodeIDsAttr() const;
+
+protected:
+    /// Handle scene node enabled status changing.
+    void OnNodeSetEnabled(Node* node) override;
+    /// Recalculate the world-space bounding box.
+    void OnWorldBoundingBoxUpdate() override;
+
+private:
+    /// Resize the billboards to match the instance nodes. Also mark node IDs dirty.
+    void UpdateNumInstances();
+    /// Update node IDs attribute from the actual nodes.
+    void UpdateNodeIDs() const;
+    /// Apply the impostor distance to an instance node's StaticModel.
+    void ApplyDrawDistance(Node* node) const;
+    /// Restore the draw distance an instance node's StaticModel had before it was added.
+    void RestoreDrawDistance(unsigned index) const;
+
+    /// Model.
+    SharedPtr<Model> model_;
+    /// Materials used for baking.
+    Vector<SharedPtr<Material> > modelMaterials_;
+    /// Impostor atlas texture.
+    SharedPtr<Texture2D> atlas_;
+    /// Scene used for baking the atlas.
+    SharedPtr<Scene> bakeScene_;
+    /// Instance nodes.
+    Vector<WeakPtr<Node> > instanceNodes_;
+    /// Draw distances of the instance nodes' StaticModels before the impostor distance was applied.
+    PODVector<float> originalDrawDistances_;
+    /// IDs of instance nodes for serialization.
+    mutable VariantVector nodeIDsAttr_;
+    /// Model materials attribute.
+    mutable ResourceRefList modelMaterialsAttr_;
+    /// Number of atlas frames per side.
+    unsigned numFrames_;
+    /// Atlas frame size in pixels.
+    int frameSize_;
+    /// Impostor distance.
+    float impostorDistance_;
+    /// Fade distance.
+    float fadeDistance_;
+    /// Number of impostors visible after the last selection.
+    unsigned numVisibleImpostors_;
+    /// Whether the atlas needs to be rebaked during ApplyAttributes.
+    bool bakeDirty_;
+    /// Whether node IDs have been set and nodes should be searched for during ApplyAttributes.
+    mutable bool nodesDirty_;
+    /// Whether nodes have been manipulated by the API and node ID attribute should be refreshed.
+    mutable bool nodeIDsDirty_;
+};
+
+}
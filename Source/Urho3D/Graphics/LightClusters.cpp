@@ -0,0 +1,382 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/Light.h"
+#include "../Graphics/LightClusters.h"
+#include "../Graphics/Texture2D.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const IntVector3 DEFAULT_CLUSTER_GRID(16, 8, 24);
+static const float MIN_CLUSTER_NEAR = 0.01f;
+
+void BinLightClustersWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* clusters = reinterpret_cast<LightClusters*>(item->aux_);
+    auto* start = reinterpret_cast<unsigned*>(item->start_);
+    auto* end = reinterpret_cast<unsigned*>(item->end_);
+    clusters->BinSlices(*start, *(end - 1));
+}
+
+LightClusters::LightClusters(Context* context) :
+    Object(context),
+    gridSize_(DEFAULT_CLUSTER_GRID),
+    depthScale_(0.0f),
+    depthBias_(0.0f),
+    numIndices_(0),
+    numOverflows_(0),
+    binTime_(0)
+{
+}
+
+LightClusters::~LightClusters() = default;
+
+void LightClusters::SetGridSize(const IntVector3& size)
+{
+    gridSize_.x_ = Clamp(size.x_, 1, 64);
+    gridSize_.y_ = Clamp(size.y_, 1, 64);
+    gridSize_.z_ = Clamp(size.z_, 1, 64);
+}
+
+void LightClusters::Update(Camera* camera, const PODVector<Light*>& lights)
+{
+    Bin(camera, lights);
+    Upload();
+}
+
+void LightClusters::Bin(Camera* camera, const PODVector<Light*>& lights)
+{
+    URHO3D_PROFILE(BinClusteredLights);
+
+    HiresTimer binTimer;
+
+    lights_ = lights;
+    view_ = camera->GetView();
+    projection_ = camera->GetProjection();
+
+    // The shaders look up the depth slice using view depth, so output it in place of the projected z
+    Matrix4 clusterProjection = projection_;
+    clusterProjection.m20_ = 0.0f;
+    clusterProjection.m21_ = 0.0f;
+    clusterProjection.m22_ = 1.0f;
+    clusterProjection.m23_ = 0.0f;
+    viewProj_ = clusterProjection * view_;
+
+    // Exponential depth slices: slice = log(z) * scale + bias
+    float nearClip = Max(camera->GetNearClip(), MIN_CLUSTER_NEAR);
+    float farClip = Max(camera->GetFarClip(), nearClip * 2.0f);
+    depthScale_ = (float)gridSize_.z_ / Ln(farClip / nearClip);
+    depthBias_ = -Ln(nearClip) * depthScale_;
+
+    sliceDepths_.Resize((unsigned)gridSize_.z_ + 1);
+    for (unsigned i = 0; i < sliceDepths_.Size(); ++i)
+        sliceDepths_[i] = nearClip * Pow(farClip / nearClip, (float)i / (float)gridSize_.z_);
+    // Let the last slice also contain everything beyond the far clip
+    sliceDepths_.Back() = M_INFINITY;
+
+    unsigned numClusters = GetNumClusters();
+    clusterCounts_.Resize(numClusters);
+    clusterLights_.Resize(numClusters * MAX_LIGHTS_PER_CLUSTER);
+    memset(&clusterCounts_[0], 0, numClusters * sizeof(unsigned));
+
+    // Calculate view space bounds for each light. Lights that are not in front of the near clip are left out of all slices
+    lightBounds_.Resize(lights_.Size());
+    for (unsigned i = 0; i < lights_.Size(); ++i)
+    {
+        Light* light = lights_[i];
+        ClusterLightBounds& bounds = lightBounds_[i];
+
+        if (light->GetLightType() == LIGHT_POINT)
+        {
+            bounds.center_ = view_ * light->GetNode()->GetWorldPosition();
+            bounds.radius_ = light->GetRange();
+            Vector3 extent(bounds.radius_, bounds.radius_, bounds.radius_);
+            bounds.min_ = bounds.center_ - extent;
+            bounds.max_ = bounds.center_ + extent;
+        }
+        else
+        {
+            BoundingBox viewBox(light->GetFrustum().Transformed(view_));
+            bounds.min_ = viewBox.min_;
+            bounds.max_ = viewBox.max_;
+            bounds.center_ = viewBox.Center();
+            bounds.radius_ = 0.0f;
+        }
+
+        if (bounds.max_.z_ < nearClip)
+        {
+            bounds.firstSlice_ = 0;
+            bounds.lastSlice_ = -1;
+        }
+        else
+        {
+            bounds.firstSlice_ = Clamp((int)(Ln(Max(bounds.min_.z_, nearClip)) * depthScale_ + depthBias_), 0, gridSize_.z_ - 1);
+            bounds.lastSlice_ = Clamp((int)(Ln(bounds.max_.z_) * depthScale_ + depthBias_), 0, gridSize_.z_ - 1);
+        }
+    }
+
+    // Bin the depth slices in parallel. Each slice writes only to its own clusters, so no synchronization is needed
+    slices_.Resize((unsigned)gridSize_.z_);
+    for (unsigned i = 0; i < slices_.Size(); ++i)
+        slices_[i] = i;
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = queue ? queue->GetNumThreads() + 1 : 1; // Worker threads + main thread
+    if (numWorkItems > 1 && lights_.Size())
+    {
+        unsigned slicesPerItem = (slices_.Size() + numWorkItems - 1) / numWorkItems;
+        PODVector<unsigned>::Iterator start = slices_.Begin();
+        while (start != slices_.End())
+        {
+            PODVector<unsigned>::Iterator end = slices_.End();
+            if ((unsigned)(end - start) > slicesPerItem)
+                end = start + slicesPerItem;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = BinLightClustersWork;
+            item->aux_ = this;
+            item->start_ = &(*start);
+            item->end_ = &(*end);
+            queue->AddWorkItem(item);
+
+            start = end;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else if (lights_.Size())
+        BinSlices(0, slices_.Size() - 1);
+
+    binTime_ = binTimer.GetUSec(false);
+}
+
+void LightClusters::BinSlices(unsigned firstSlice, unsigned lastSlice)
+{
+    unsigned clustersPerSlice = (unsigned)(gridSize_.x_ * gridSize_.y_);
+
+    for (unsigned i = 0; i < lightBounds_.Size(); ++i)
+    {
+        const ClusterLightBounds& bounds = lightBounds_[i];
+        int sliceStart = Max(bounds.firstSlice_, (int)firstSlice);
+        int sliceEnd = Min(bounds.lastSlice_, (int)lastSlice);
+
+        for (int z = sliceStart; z <= sliceEnd; ++z)
+        {
+            // Clip the light bounds to the slice
+            Vector3 min = bounds.min_;
+            Vector3 max = bounds.max_;
+            min.z_ = Max(min.z_, sliceDepths_[z]);
+            max.z_ = Min(max.z_, sliceDepths_[z + 1]);
+
+            // For point lights, shrink to the sphere's cross-section nearest to the center
+            if (bounds.radius_ > 0.0f)
+            {
+                float dz = bounds.center_.z_ < min.z_ ? min.z_ - bounds.center_.z_ :
+                    (bounds.center_.z_ > max.z_ ? bounds.center_.z_ - max.z_ : 0.0f);
+                float r = sqrtf(Max(bounds.radius_ * bounds.radius_ - dz * dz, 0.0f));
+                min.x_ = bounds.center_.x_ - r;
+                min.y_ = bounds.center_.y_ - r;
+                max.x_ = bounds.center_.x_ + r;
+                max.y_ = bounds.center_.y_ + r;
+            }
+
+            int minX, minY, maxX, maxY;
+            GetTileRange(min, max, minX, minY, maxX, maxY);
+
+            for (int y = minY; y <= maxY; ++y)
+            {
+                unsigned cluster = z * clustersPerSlice + y * gridSize_.x_ + minX;
+                for (int x = minX; x <= maxX; ++x, ++cluster)
+                {
+                    unsigned count = clusterCounts_[cluster]++;
+                    if (count < MAX_LIGHTS_PER_CLUSTER)
+                        clusterLights_[cluster * MAX_LIGHTS_PER_CLUSTER + count] = (unsigned short)i;
+                }
+            }
+        }
+    }
+}
+
+unsigned LightClusters::GetClusterIndex(const Vector3& position) const
+{
+    Vector4 clusterPos = viewProj_ * Vector4(position, 1.0f);
+    int x = Clamp((int)floorf((clusterPos.x_ / clusterPos.w_ * 0.5f + 0.5f) * gridSize_.x_), 0, gridSize_.x_ - 1);
+    int y = Clamp((int)floorf((clusterPos.y_ / clusterPos.w_ * 0.5f + 0.5f) * gridSize_.y_), 0, gridSize_.y_ - 1);
+    int z = Clamp((int)floorf(Ln(Max(clusterPos.z_, 0.0001f)) * depthScale_ + depthBias_), 0, gridSize_.z_ - 1);
+    return (unsigned)((z * gridSize_.y_ + y) * gridSize_.x_ + x);
+}
+
+Vector3 LightClusters::GetTextureParameter() const
+{
+    if (!texture_)
+        return Vector3::ZERO;
+
+    return Vector3((float)texture_->GetWidth(), 1.0f / (float)texture_->GetWidth(), 1.0f / (float)texture_->GetHeight());
+}
+
+void LightClusters::GetTileRange(const Vector3& min, const Vector3& max, int& minX, int& minY, int& maxX, int& maxY) const
+{
+    // All corners are in front of the camera, so the projected extremes are found at the corners
+    Vector2 rectMin(M_INFINITY, M_INFINITY);
+    Vector2 rectMax(-M_INFINITY, -M_INFINITY);
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Vector3 corner((i & 1) ? max.x_ : min.x_, (i & 2) ? max.y_ : min.y_, (i & 4) ? max.z_ : min.z_);
+        Vector3 projected = projection_ * corner;
+        rectMin.x_ = Min(rectMin.x_, projected.x_);
+        rectMin.y_ = Min(rectMin.y_, projected.y_);
+        rectMax.x_ = Max(rectMax.x_, projected.x_);
+        rectMax.y_ = Max(rectMax.y_, projected.y_);
+    }
+
+    minX = Clamp((int)floorf((rectMin.x_ * 0.5f + 0.5f) * gridSize_.x_), 0, gridSize_.x_ - 1);
+    maxX = Clamp((int)floorf((rectMax.x_ * 0.5f + 0.5f) * gridSize_.x_), 0, gridSize_.x_ - 1);
+    minY = Clamp((int)floorf((rectMin.y_ * 0.5f + 0.5f) * gridSize_.y_), 0, gridSize_.y_ - 1);
+    maxY = Clamp((int)floorf((rectMax.y_ * 0.5f + 0.5f) * gridSize_.y_), 0, gridSize_.y_ - 1);
+}
+
+void LightClusters::Upload()
+{
+    URHO3D_PROFILE(UploadClusteredLights);
+
+    // Texture layout, one float4 per texel:
+    // - cluster records (first index texel, light count)
+    // - light data, 3 texels each: (color, 1 / range), (-direction, spot cutoff), (position, 1 / (1 - spot cutoff))
+    // - light index texels (first light data texel, specular intensity)
+    unsigned numClusters = GetNumClusters();
+    unsigned lightStart = numClusters;
+    unsigned indexStart = lightStart + lights_.Size() * 3;
+
+    numIndices_ = 0;
+    numOverflows_ = 0;
+    for (unsigned i = 0; i < numClusters; ++i)
+    {
+        if (clusterCounts_[i] > MAX_LIGHTS_PER_CLUSTER)
+        {
+            ++numOverflows_;
+            clusterCounts_[i] = MAX_LIGHTS_PER_CLUSTER;
+        }
+        numIndices_ += clusterCounts_[i];
+    }
+
+    unsigned numTexels = indexStart + numIndices_;
+    unsigned width = CLUSTER_TEXTURE_WIDTH;
+    unsigned height = (numTexels + width - 1) / width;
+    // Round height up to reduce texture reallocations when the light count fluctuates
+    height = NextPowerOfTwo(height);
+
+    textureData_.Resize(width * height * 4);
+    float* dest = &textureData_[0];
+    unsigned index = indexStart;
+
+    for (unsigned i = 0; i < numClusters; ++i)
+    {
+        *dest++ = (float)index;
+        *dest++ = (float)clusterCounts_[i];
+        *dest++ = 0.0f;
+        *dest++ = 0.0f;
+        index += clusterCounts_[i];
+    }
+
+    for (unsigned i = 0; i < lights_.Size(); ++i)
+    {
+        Light* light = lights_[i];
+        Node* lightNode = light->GetNode();
+
+        float invRange = 1.0f / Max(light->GetRange(), M_EPSILON);
+        Vector3 direction = Vector3::ZERO;
+        float cutoff = -1.0f;
+        float invCutoff = 1.0f;
+        if (light->GetLightType() == LIGHT_SPOT)
+        {
+            direction = -lightNode->GetWorldDirection();
+            cutoff = Cos(light->GetFov() * 0.5f);
+            invCutoff = 1.0f / (1.0f - cutoff);
+        }
+
+        // Fade the light color if both fade & draw distance defined, like vertex lights
+        float fade = 1.0f;
+        float fadeEnd = light->GetDrawDistance();
+        float fadeStart = light->GetFadeDistance();
+        if (fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+            fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+        Color color = light->GetEffectiveColor() * fade;
+        Vector3 position = lightNode->GetWorldPosition();
+
+        *dest++ = color.r_;
+        *dest++ = color.g_;
+        *dest++ = color.b_;
+        *dest++ = invRange;
+        *dest++ = direction.x_;
+        *dest++ = direction.y_;
+        *dest++ = direction.z_;
+        *dest++ = cutoff;
+        *dest++ = position.x_;
+        *dest++ = position.y_;
+        *dest++ = position.z_;
+        *dest++ = invCutoff;
+    }
+
+    for (unsigned i = 0; i < numClusters; ++i)
+    {
+        const unsigned short* lightIndices = &clusterLights_[i * MAX_LIGHTS_PER_CLUSTER];
+        for (unsigned j = 0; j < clusterCounts_[i]; ++j)
+        {
+            unsigned short lightIndex = lightIndices[j];
+            *dest++ = (float)(lightStart + lightIndex * 3);
+            *dest++ = lights_[lightIndex]->GetSpecularIntensity();
+            *dest++ = 0.0f;
+            *dest++ = 0.0f;
+        }
+    }
+
+    if (!texture_)
+    {
+        texture_ = new Texture2D(context_);
+        texture_->SetNumLevels(1);
+        texture_->SetFilterMode(FILTER_NEAREST);
+        texture_->SetAddressMode(COORD_U, ADDRESS_CLAMP);
+        texture_->SetAddressMode(COORD_V, ADDRESS_CLAMP);
+    }
+    if (texture_->GetWidth() != (int)width || texture_->GetHeight() != (int)height)
+        texture_->SetSize(width, height, Graphics::GetRGBAFloat32Format(), TEXTURE_DYNAMIC);
+
+    // Only the used rows need to be uploaded
+    unsigned usedHeight = (numTexels + width - 1) / width;
+    texture_->SetData(0, 0, 0, width, usedHeight, &textureData_[0]);
+}
+
+}
@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Math/Matrix3x4.h"
+
+namespace Urho3D
+{
+
+class Camera;
+class Light;
+class Texture2D;
+
+/// Maximum number of lights stored per cluster. Must match MAXCLUSTERLIGHTS in the shaders.
+static const unsigned MAX_LIGHTS_PER_CLUSTER = 32;
+/// Width of the cluster data texture in texels.
+static const unsigned CLUSTER_TEXTURE_WIDTH = 1024;
+
+/// View space bounds of a clustered light, calculated before binning.
+struct ClusterLightBounds
+{
+    /// View space bounding box minimum.
+    Vector3 min_;
+    /// View space bounding box maximum.
+    Vector3 max_;
+    /// View space center for point lights.
+    Vector3 center_;
+    /// Range for point lights, zero for spot lights.
+    float radius_;
+    /// First depth slice.
+    int firstSlice_;
+    /// Last depth slice.
+    int lastSlice_;
+};
+
+/// %Light binning into a view frustum aligned 3D grid (froxels) for clustered forward lighting. The resulting light lists are uploaded to a floating point texture, so that the base pass can apply all the lights of a pixel in one draw.
+class URHO3D_API LightClusters : public Object
+{
+    URHO3D_OBJECT(LightClusters, Object);
+
+public:
+    /// Construct.
+    explicit LightClusters(Context* context);
+    /// Destruct.
+    ~LightClusters() override;
+
+    /// Set grid size. Depth slices are distributed exponentially between the camera near and far clip.
+    void SetGridSize(const IntVector3& size);
+    /// Bin lights for a camera and upload the results. Uses the work queue for binning the depth slices in parallel.
+    void Update(Camera* camera, const PODVector<Light*>& lights);
+    /// Bin lights for a camera without uploading. Used by Update() and for benchmarking the binning on its own.
+    void Bin(Camera* camera, const PODVector<Light*>& lights);
+    /// Bin the depth slices in the given range. Called by worker threads.
+    void BinSlices(unsigned firstSlice, unsigned lastSlice);
+
+    /// Return grid size.
+    const IntVector3& GetGridSize() const { return gridSize_; }
+    /// Return number of clusters.
+    unsigned GetNumClusters() const { return (unsigned)(gridSize_.x_ * gridSize_.y_ * gridSize_.z_); }
+    /// Return number of lights in the last update.
+    unsigned GetNumLights() const { return lights_.Size(); }
+    /// Return number of light indices (sum of per-cluster light counts) in the last update.
+    unsigned GetNumLightIndices() const { return numIndices_; }
+    /// Return number of clusters that hit the light count limit in the last update.
+    unsigned GetNumOverflowClusters() const { return numOverflows_; }
+    /// Return time taken by the last binning in microseconds.
+    long long GetBinTime() const { return binTime_; }
+    /// Return the cluster that contains a world space position in the last binning, using the same lookup as the shaders.
+    unsigned GetClusterIndex(const Vector3& position) const;
+    /// Return number of lights in a cluster in the last binning, up to MAX_LIGHTS_PER_CLUSTER.
+    unsigned GetClusterNumLights(unsigned index) const { return Min(clusterCounts_[index], MAX_LIGHTS_PER_CLUSTER); }
+    /// Return a light of a cluster in the last binning.
+    Light* GetClusterLight(unsigned index, unsigned lightIndex) const { return lights_[clusterLights_[index * MAX_LIGHTS_PER_CLUSTER + lightIndex]]; }
+    /// Return the cluster data texture.
+    Texture2D* GetTexture() const { return texture_; }
+    /// Return the view-projection matrix for the cluster lookup. Outputs view depth in z.
+    const Matrix4& GetViewProj() const { return viewProj_; }
+    /// Return grid size shader parameter.
+    Vector4 GetGridParameter() const { return Vector4((float)gridSize_.x_, (float)gridSize_.y_, (float)gridSize_.z_, 0.0f); }
+    /// Return depth slice scale and bias shader parameter.
+    Vector2 GetDepthParameter() const { return Vector2(depthScale_, depthBias_); }
+    /// Return texture size shader parameter.
+    Vector3 GetTextureParameter() const;
+
+private:
+    /// Return tile range covered by a view space box.
+    void GetTileRange(const Vector3& min, const Vector3& max, int& minX, int& minY, int& maxX, int& maxY) const;
+    /// Write the light lists into the texture.
+    void Upload();
+
+    /// Grid size.
+    IntVector3 gridSize_;
+    /// Lights from the last update.
+    PODVector<Light*> lights_;
+    /// Light bounds from the last update.
+    PODVector<ClusterLightBounds> lightBounds_;
+    /// Slice indices for dividing work.
+    PODVector<unsigned> slices_;
+    /// Depth of each slice boundary.
+    PODVector<float> sliceDepths_;
+    /// Light counts per cluster.
+    PODVector<unsigned> clusterCounts_;
+    /// Light indices per cluster, MAX_LIGHTS_PER_CLUSTER reserved for each.
+    PODVector<unsigned short> clusterLights_;
+    /// Texture upload staging data.
+    PODVector<float> textureData_;
+    /// Cluster data texture.
+    SharedPtr<Texture2D> texture_;
+    /// Camera view matrix.
+    Matrix3x4 view_;
+    /// Camera projection matrix.
+    Matrix4 projection_;
+    /// Camera view-projection matrix.
+    Matrix4 viewProj_;
+    /// Depth slice scale.
+    float depthScale_;
+    /// Depth slice bias.
+    float depthBias_;
+    /// Number of light indices.
+    unsigned numIndices_;
+    /// Number of overflowing clusters.
+    unsigned numOverflows_;
+    /// Last binning time in microseconds.
+    long long binTime_;
+};
+
+}
@@ -0,0 +1,485 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/HashMap.h"
+#include "../Container/Sort.h"
+#include "../Graphics/MeshOptimization.h"
+#include "../Math/BoundingBox.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned VERTEX_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+/// Quadric error metric: symmetric 4x4 matrix that measures the sum of squared distances to a set of planes.
+struct Quadric
+{
+    /// Construct as zero.
+    Quadric()
+    {
+        for (double& value : values_)
+            value = 0.0;
+    }
+
+    /// Add a plane.
+    void AddPlane(const Vector3& normal, float d)
+    {
+        double a = normal.x_, b = normal.y_, c = normal.z_;
+        values_[0] += a * a; values_[1] += a * b; values_[2] += a * c; values_[3] += a * d;
+        values_[4] += b * b; values_[5] += b * c; values_[6] += b * d;
+        values_[7] += c * c; values_[8] += c * d;
+        values_[9] += (double)d * d;
+    }
+
+    /// Add another quadric.
+    void Add(const Quadric& rhs)
+    {
+        for (unsigned i = 0; i < 10; ++i)
+            values_[i] += rhs.values_[i];
+    }
+
+    /// Return the error of a position.
+    float Evaluate(const Vector3& position) const
+    {
+        double x = position.x_, y = position.y_, z = position.z_;
+        double error = values_[0] * x * x + 2.0 * values_[1] * x * y + 2.0 * values_[2] * x * z + 2.0 * values_[3] * x +
+            values_[4] * y * y + 2.0 * values_[5] * y * z + 2.0 * values_[6] * y + values_[7] * z * z + 2.0 * values_[8] * z +
+            values_[9];
+        return (float)Max(error, 0.0);
+    }
+
+    /// Matrix values: upper triangle in row-major order.
+    double values_[10];
+};
+
+/// Edge collapse candidate.
+struct EdgeCollapse
+{
+    /// Vertex to remove.
+    unsigned from_;
+    /// Vertex to move onto.
+    unsigned to_;
+    /// Error caused by the collapse.
+    float cost_;
+};
+
+static bool CompareEdgeCollapses(const EdgeCollapse& lhs, const EdgeCollapse& rhs)
+{
+    return lhs.cost_ < rhs.cost_;
+}
+
+static float GetVertexCacheScore(int cachePosition, unsigned numActiveTriangles)
+{
+    // Vertices without remaining triangles are never selected
+    if (!numActiveTriangles)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score so that strips are not favored too much
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) / (float)(VERTEX_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+
+    // Boost vertices with few triangles left, so that lone triangles are not left behind
+    return score + VALENCE_BOOST_SCALE * powf((float)numActiveTriangles, -VALENCE_BOOST_POWER);
+}
+
+unsigned SimplifyMesh(PODVector<unsigned>& dest, const unsigned* indices, unsigned indexCount, const void* vertexData,
+    unsigned vertexSize, unsigned positionOffset, unsigned vertexCount, unsigned targetIndexCount, float maxError)
+{
+    dest.Resize(indexCount);
+    for (unsigned i = 0; i < indexCount; ++i)
+        dest[i] = indices[i];
+
+    if (indexCount < 3 || targetIndexCount >= indexCount)
+        return indexCount;
+
+    const auto* bytes = static_cast<const unsigned char*>(vertexData);
+    auto GetPosition = [bytes, vertexSize, positionOffset](unsigned vertex) -> const Vector3& {
+        return *reinterpret_cast<const Vector3*>(bytes + vertex * vertexSize + positionOffset);
+    };
+
+    // Map vertices that share a position to the first of them, so that texture seams can be detected and kept
+    PODVector<unsigned> remap(vertexCount);
+    PODVector<bool> locked(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        remap[i] = M_MAX_UNSIGNED;
+        locked[i] = false;
+    }
+
+    HashMap<Vector3, unsigned> positions;
+    BoundingBox box;
+    for (unsigned i = 0; i < indexCount; ++i)
+    {
+        unsigned vertex = dest[i];
+        if (remap[vertex] != M_MAX_UNSIGNED)
+            continue;
+
+        const Vector3& position = GetPosition(vertex);
+        HashMap<Vector3, unsigned>::Iterator j = positions.Find(position);
+        if (j == positions.End())
+        {
+            positions[position] = vertex;
+            remap[vertex] = vertex;
+            box.Merge(position);
+        }
+        else
+        {
+            remap[vertex] = j->second_;
+            locked[j->second_] = true;
+        }
+    }
+    PODVector<bool> seams = locked;
+
+    float maxDistance = maxError * box.Size().Length();
+    float maxCost = maxDistance * maxDistance;
+
+    // Accumulate the planes of the triangles around each vertex
+    Vector<Quadric> quadrics(vertexCount);
+    for (unsigned i = 0; i < indexCount; i += 3)
+    {
+        unsigned v0 = remap[dest[i]], v1 = remap[dest[i + 1]], v2 = remap[dest[i + 2]];
+        const Vector3& p0 = GetPosition(v0);
+        Vector3 normal = (GetPosition(v1) - p0).CrossProduct(GetPosition(v2) - p0);
+        if (normal.Length() < M_EPSILON)
+            continue;
+        normal.Normalize();
+        float d = -normal.DotProduct(p0);
+        quadrics[v0].AddPlane(normal, d);
+        quadrics[v1].AddPlane(normal, d);
+        quadrics[v2].AddPlane(normal, d);
+    }
+
+    unsigned numIndices = indexCount;
+    PODVector<unsigned long long> edges;
+    PODVector<unsigned> triangleOffsets(vertexCount + 1);
+    PODVector<unsigned> vertexTriangles;
+    PODVector<EdgeCollapse> collapses;
+    PODVector<bool> removed;
+    PODVector<bool> touched(vertexCount);
+
+    // Each pass collapses independent edges in order of increasing error
+    while (numIndices > targetIndexCount)
+    {
+        unsigned numTriangles = numIndices / 3;
+
+        // Lock the vertices of border edges, which are used by only one triangle
+        locked = seams;
+        edges.Clear();
+        for (unsigned i = 0; i < numIndices; ++i)
+        {
+            unsigned a = remap[dest[i]];
+            unsigned b = remap[dest[i - i % 3 + (i + 1) % 3]];
+            edges.Push(a < b ? ((unsigned long long)a << 32u) | b : ((unsigned long long)b << 32u) | a);
+        }
+        Sort(edges.Begin(), edges.End());
+        for (unsigned i = 0; i < edges.Size();)
+        {
+            unsigned j = i + 1;
+            while (j < edges.Size() && edges[j] == edges[i])
+                ++j;
+            if (j - i == 1)
+            {
+                locked[(unsigned)(edges[i] >> 32u)] = true;
+                locked[(unsigned)(edges[i] & M_MAX_UNSIGNED)] = true;
+            }
+            i = j;
+        }
+
+        // Build the triangle lists of each vertex
+        for (unsigned i = 0; i <= vertexCount; ++i)
+            triangleOffsets[i] = 0;
+        for (unsigned i = 0; i < numIndices; ++i)
+            ++triangleOffsets[remap[dest[i]] + 1];
+        for (unsigned i = 0; i < vertexCount; ++i)
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        vertexTriangles.Resize(numIndices);
+        for (unsigned i = 0; i < numIndices; ++i)
+        {
+            unsigned vertex = remap[dest[i]];
+            vertexTriangles[triangleOffsets[vertex]++] = i / 3;
+        }
+        for (unsigned i = vertexCount; i > 0; --i)
+            triangleOffsets[i] = triangleOffsets[i - 1];
+        triangleOffsets[0] = 0;
+
+        collapses.Clear();
+        for (unsigned i = 0; i < numIndices; ++i)
+        {
+            unsigned a = remap[dest[i]];
+            unsigned b = remap[dest[i - i % 3 + (i + 1) % 3]];
+            if (!locked[a])
+                collapses.Push({a, b, quadrics[a].Evaluate(GetPosition(b))});
+            if (!locked[b])
+                collapses.Push({b, a, quadrics[b].Evaluate(GetPosition(a))});
+        }
+        Sort(collapses.Begin(), collapses.End(), CompareEdgeCollapses);
+
+        removed.Resize(numTriangles);
+        for (unsigned i = 0; i < numTriangles; ++i)
+            removed[i] = false;
+        for (unsigned i = 0; i < vertexCount; ++i)
+            touched[i] = false;
+
+        unsigned numCollapses = 0;
+        for (unsigned i = 0; i < collapses.Size() && numIndices > targetIndexCount; ++i)
+        {
+            const EdgeCollapse& collapse = collapses[i];
+            if (collapse.cost_ > maxCost)
+                break;
+            if (touched[collapse.from_] || touched[collapse.to_])
+                continue;
+
+            // The removed vertex is not on a seam, but the target may be: it must then be the same vertex in all triangles
+            unsigned target = M_MAX_UNSIGNED;
+            bool valid = true;
+            const Vector3& fromPosition = GetPosition(collapse.from_);
+            const Vector3& toPosition = GetPosition(collapse.to_);
+            for (unsigned j = triangleOffsets[collapse.from_]; j < triangleOffsets[collapse.from_ + 1] && valid; ++j)
+            {
+                unsigned triangle = vertexTriangles[j];
+                if (removed[triangle])
+                    continue;
+
+                unsigned* corners = &dest[triangle * 3];
+                bool hasTarget = false;
+                for (unsigned k = 0; k < 3; ++k)
+                {
+                    if (remap[corners[k]] == collapse.to_)
+                    {
+                        if (target != M_MAX_UNSIGNED && target != corners[k])
+                            valid = false;
+                        target = corners[k];
+                        hasTarget = true;
+                    }
+                }
+
+                // Triangles that are not removed by the collapse must not flip
+                if (!hasTarget)
+                {
+                    Vector3 p[3];
+                    for (unsigned k = 0; k < 3; ++k)
+                        p[k] = GetPosition(corners[k]);
+                    Vector3 oldNormal = (p[1] - p[0]).CrossProduct(p[2] - p[0]);
+                    for (unsigned k = 0; k < 3; ++k)
+                    {
+                        if (p[k] == fromPosition)
+                            p[k] = toPosition;
+                    }
+                    Vector3 newNormal = (p[1] - p[0]).CrossProduct(p[2] - p[0]);
+                    if (oldNormal.DotProduct(newNormal) <= 0.0f)
+                        valid = false;
+                }
+            }
+            if (!valid || target == M_MAX_UNSIGNED)
+                continue;
+
+            for (unsigned j = triangleOffsets[collapse.from_]; j < triangleOffsets[collapse.from_ + 1]; ++j)
+            {
+                unsigned triangle = vertexTriangles[j];
+                if (removed[triangle])
+                    continue;
+
+                unsigned* corners = &dest[triangle * 3];
+                bool degenerate = false;
+                for (unsigned k = 0; k < 3; ++k)
+                {
+                    if (corners[k] == collapse.from_)
+                        corners[k] = target;
+                    else if (remap[corners[k]] == collapse.to_)
+                        degenerate = true;
+                }
+                if (degenerate)
+                {
+                    removed[triangle] = true;
+                    numIndices -= 3;
+                }
+            }
+
+            quadrics[collapse.to_].Add(quadrics[collapse.from_]);
+            touched[collapse.from_] = true;
+            touched[collapse.to_] = true;
+            ++numCollapses;
+        }
+
+        // Compact the remaining triangles
+        unsigned destIndex = 0;
+        for (unsigned i = 0; i < numTriangles; ++i)
+        {
+            if (removed[i])
+                continue;
+            for (unsigned k = 0; k < 3; ++k)
+                dest[destIndex++] = dest[i * 3 + k];
+        }
+        dest.Resize(destIndex);
+        numIndices = destIndex;
+
+        if (!numCollapses)
+            break;
+    }
+
+    return numIndices;
+}
+
+void OptimizeVertexCache(unsigned* indices, unsigned indexCount, unsigned vertexCount)
+{
+    unsigned numTriangles = indexCount / 3;
+    if (numTriangles < 2)
+        return;
+
+    // Build the triangle lists of each vertex
+    PODVector<unsigned> triangleOffsets(vertexCount + 1);
+    PODVector<unsigned> numActiveTriangles(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+        numActiveTriangles[i] = 0;
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        ++numActiveTriangles[indices[i]];
+    triangleOffsets[0] = 0;
+    for (unsigned i = 0; i < vertexCount; ++i)
+        triangleOffsets[i + 1] = triangleOffsets[i] + numActiveTriangles[i];
+
+    PODVector<unsigned> vertexTriangles(numTriangles * 3);
+    PODVector<unsigned> fill(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+        fill[i] = triangleOffsets[i];
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        vertexTriangles[fill[indices[i]]++] = i / 3;
+
+    PODVector<int> cachePositions(vertexCount);
+    PODVector<float> vertexScores(vertexCount);
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        cachePositions[i] = -1;
+        vertexScores[i] = GetVertexCacheScore(-1, numActiveTriangles[i]);
+    }
+
+    PODVector<float> triangleScores(numTriangles);
+    PODVector<bool> emitted(numTriangles);
+    for (unsigned i = 0; i < numTriangles; ++i)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+        emitted[i] = false;
+    }
+
+    PODVector<unsigned> result(numTriangles * 3);
+    PODVector<unsigned> cache;
+    PODVector<unsigned> newCache;
+    unsigned nextTriangle = 0;
+
+    for (unsigned i = 0; i < numTriangles; ++i)
+    {
+        // Choose the best triangle using the vertices in cache, or the next unemitted one if none
+        unsigned best = M_MAX_UNSIGNED;
+        float bestScore = -1.0f;
+        for (unsigned j = 0; j < cache.Size(); ++j)
+        {
+            unsigned vertex = cache[j];
+            for (unsigned k = triangleOffsets[vertex]; k < triangleOffsets[vertex] + numActiveTriangles[vertex]; ++k)
+            {
+                unsigned triangle = vertexTriangles[k];
+                if (triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    best = triangle;
+                }
+            }
+        }
+        if (best == M_MAX_UNSIGNED)
+        {
+            while (emitted[nextTriangle])
+                ++nextTriangle;
+            best = nextTriangle;
+        }
+
+        emitted[best] = true;
+        const unsigned* corners = &indices[best * 3];
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            unsigned vertex = corners[k];
+            result[i * 3 + k] = vertex;
+
+            // Remove the triangle from the vertex's active triangles
+            unsigned start = triangleOffsets[vertex];
+            unsigned end = start + numActiveTriangles[vertex];
+            for (unsigned l = start; l < end; ++l)
+            {
+                if (vertexTriangles[l] == best)
+                {
+                    vertexTriangles[l] = vertexTriangles[end - 1];
+                    --numActiveTriangles[vertex];
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache
+        newCache.Clear();
+        for (unsigned k = 0; k < 3; ++k)
+            newCache.Push(corners[k]);
+        for (unsigned j = 0; j < cache.Size(); ++j)
+        {
+            if (cache[j] != corners[0] && cache[j] != corners[1] && cache[j] != corners[2])
+                newCache.Push(cache[j]);
+        }
+
+        for (unsigned j = 0; j < newCache.Size(); ++j)
+        {
+            unsigned vertex = newCache[j];
+            cachePositions[vertex] = j < VERTEX_CACHE_SIZE ? (int)j : -1;
+            vertexScores[vertex] = GetVertexCacheScore(cachePositions[vertex], numActiveTriangles[vertex]);
+        }
+
+        // Update the scores of the triangles whose vertex scores changed
+        for (unsigned j = 0; j < newCache.Size(); ++j)
+        {
+            unsigned vertex = newCache[j];
+            for (unsigned k = triangleOffsets[vertex]; k < triangleOffsets[vertex] + numActiveTriangles[vertex]; ++k)
+            {
+                unsigned triangle = vertexTriangles[k];
+                triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] +
+                    vertexScores[indices[triangle * 3 + 2]];
+            }
+        }
+
+        if (newCache.Size() > VERTEX_CACHE_SIZE)
+            newCache.Resize(VERTEX_CACHE_SIZE);
+        cache.Swap(newCache);
+    }
+
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        indices[i] = result[i];
+}
+
+}
@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+
+#include "../Container/Vector.h"
+
+namespace Urho3D
+{
+
+/// Simplify an indexed triangle list by quadric error edge collapses until the target index count is reached or the error would exceed the maximum. The error is relative to the mesh bounding box size. Vertices are collapsed onto existing vertices, so the result indexes the same vertex data. Border and texture seam vertices are not moved. Return number of indices written to destination.
+URHO3D_API unsigned SimplifyMesh(PODVector<unsigned>& dest, const unsigned* indices, unsigned indexCount, const void* vertexData,
+    unsigned vertexSize, unsigned positionOffset, unsigned vertexCount, unsigned targetIndexCount, float maxError);
+
+/// Reorder the triangles of an indexed triangle list in place for better post-transform vertex cache use.
+URHO3D_API void OptimizeVertexCache(unsigned* indices, unsigned indexCount, unsigned vertexCount);
+
+}
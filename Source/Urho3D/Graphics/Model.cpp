@@ -26,6 +26,7 @@
 #include "../Core/Profiler.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
+#include "../Graphics/MeshOptimization.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/VertexBuffer.h"
@@ -60,6 +61,27 @@ unsigned LookupIndexBuffer(IndexBuffer* buffer, const Vector<SharedPtr<IndexBuff
     return 0;
 }
 
+static void ReadIndices(PODVector<unsigned>& dest, const unsigned char* data, unsigned indexSize, unsigned start, unsigned count)
+{
+    dest.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        dest[i] = indexSize == sizeof(unsigned) ? reinterpret_cast<const unsigned*>(data)[start + i] :
+            reinterpret_cast<const unsigned short*>(data)[start + i];
+    }
+}
+
+static void WriteIndices(unsigned char* data, const PODVector<unsigned>& indices, unsigned indexSize, unsigned start)
+{
+    for (unsigned i = 0; i < indices.Size(); ++i)
+    {
+        if (indexSize == sizeof(unsigned))
+            reinterpret_cast<unsigned*>(data)[start + i] = indices[i];
+        else
+            reinterpret_cast<unsigned short*>(data)[start + i] = (unsigned short)indices[i];
+    }
+}
+
 Model::Model(Context* context) :
     ResourceWithMetadata(context)
 {
@@ -733,6 +755,121 @@ SharedPtr<Model> Model::Clone(const String& cloneName) const
     return ret;
 }
 
+bool Model::GenerateLodLevels(unsigned numLevels, float reduction, float maxError, float lodDistanceStep, bool replaceExisting)
+{
+    URHO3D_PROFILE(GenerateModelLodLevels);
+
+    reduction = Clamp(reduction, 0.0f, 1.0f);
+    bool success = true;
+    unsigned memoryUse = GetMemoryUse();
+    PODVector<unsigned> indices;
+
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        Geometry* geometry = GetGeometry(i, 0);
+        // Keep authored LOD levels unless asked to replace them
+        if (!geometry || (geometries_[i].Size() > 1 && !replaceExisting))
+            continue;
+
+        const unsigned char* vertexData;
+        const unsigned char* indexData;
+        unsigned vertexSize;
+        unsigned indexSize;
+        const PODVector<VertexElement>* elements;
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+
+        unsigned positionOffset = elements ? VertexBuffer::GetElementOffset(*elements, TYPE_VECTOR3, SEM_POSITION) : M_MAX_UNSIGNED;
+        if (!vertexData || !indexData || positionOffset == M_MAX_UNSIGNED || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+        {
+            URHO3D_LOGERROR("Can not generate LOD levels for geometry " + String(i) + " of model " + GetName() +
+                ", shadowed indexed triangle list data needed");
+            success = false;
+            continue;
+        }
+
+        unsigned vertexCount = geometry->GetVertexStart() + geometry->GetVertexCount();
+        ReadIndices(indices, indexData, indexSize, geometry->GetIndexStart(), geometry->GetIndexCount());
+
+        // Simplify each level from the previous one, until the error becomes too large
+        Vector<PODVector<unsigned> > levels;
+        unsigned totalIndices = 0;
+        for (unsigned j = 0; j < numLevels; ++j)
+        {
+            const PODVector<unsigned>& source = j ? levels.Back() : indices;
+            auto targetIndices = (unsigned)(source.Size() * reduction) / 3 * 3;
+            PODVector<unsigned> simplified;
+            SimplifyMesh(simplified, source.Buffer(), source.Size(), vertexData, vertexSize, positionOffset, vertexCount,
+                targetIndices, maxError);
+            if (simplified.Empty() || simplified.Size() >= source.Size())
+                break;
+
+            totalIndices += simplified.Size();
+            levels.Push(simplified);
+        }
+
+        geometries_[i].Resize(1);
+        if (levels.Empty())
+            continue;
+
+        // Store all levels of the geometry in one new index buffer, sharing the vertex buffers of the first level
+        SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+        indexBuffer->SetShadowed(true);
+        indexBuffer->SetSize(totalIndices, indexSize == sizeof(unsigned));
+        PODVector<unsigned char> lodIndexData(totalIndices * indexSize);
+        unsigned indexStart = 0;
+
+        for (unsigned j = 0; j < levels.Size(); ++j)
+        {
+            WriteIndices(lodIndexData.Buffer(), levels[j], indexSize, indexStart);
+
+            SharedPtr<Geometry> lodGeometry(new Geometry(context_));
+            lodGeometry->SetNumVertexBuffers(geometry->GetNumVertexBuffers());
+            for (unsigned k = 0; k < geometry->GetNumVertexBuffers(); ++k)
+                lodGeometry->SetVertexBuffer(k, geometry->GetVertexBuffer(k));
+            lodGeometry->SetIndexBuffer(indexBuffer);
+            lodGeometry->SetDrawRange(TRIANGLE_LIST, indexStart, levels[j].Size(), geometry->GetVertexStart(),
+                geometry->GetVertexCount());
+            lodGeometry->SetLodDistance(lodDistanceStep * (j + 1));
+            geometries_[i].Push(lodGeometry);
+
+            indexStart += levels[j].Size();
+        }
+
+        indexBuffer->SetData(lodIndexData.Buffer());
+        indexBuffers_.Push(indexBuffer);
+        memoryUse += sizeof(IndexBuffer) + totalIndices * indexSize + levels.Size() * sizeof(Geometry);
+    }
+
+    SetMemoryUse(memoryUse);
+    return success;
+}
+
+void Model::OptimizeVertexCache()
+{
+    URHO3D_PROFILE(OptimizeModelVertexCache);
+
+    PODVector<unsigned> indices;
+
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        for (unsigned j = 0; j < geometries_[i].Size(); ++j)
+        {
+            Geometry* geometry = geometries_[i][j];
+            IndexBuffer* indexBuffer = geometry ? geometry->GetIndexBuffer() : nullptr;
+            if (!indexBuffer || !indexBuffer->GetShadowData() || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+                continue;
+
+            unsigned indexSize = indexBuffer->GetIndexSize();
+            ReadIndices(indices, indexBuffer->GetShadowData(), indexSize, geometry->GetIndexStart(), geometry->GetIndexCount());
+            ::Urho3D::OptimizeVertexCache(indices.Buffer(), indices.Size(), geometry->GetVertexStart() + geometry->GetVertexCount());
+
+            PODVector<unsigned char> data(indices.Size() * indexSize);
+            WriteIndices(data.Buffer(), indices, indexSize, 0);
+            indexBuffer->SetDataRange(data.Buffer(), geometry->GetIndexStart(), geometry->GetIndexCount());
+        }
+    }
+}
+
 unsigned Model::GetNumGeometryLodLevels(unsigned index) const
 {
     return index < geometries_.Size() ? geometries_[index].Size() : 0;
@@ -147,6 +147,10 @@ public:
     void SetMorphs(const Vector<ModelMorph>& morphs);
     /// Clone the model. The geometry data is deep-copied and can be modified in the clone without affecting the original.
     SharedPtr<Model> Clone(const String& cloneName = String::EMPTY) const;
+    /// Generate LOD levels by mesh simplification for geometries that only have one LOD level, or for all geometries, replacing the existing levels after the first, if replaceExisting is true. Each level has the triangle count of the previous multiplied by the reduction factor, unless the simplification error relative to the model size would exceed the maximum. Requires shadowed vertex and index buffers. Return true if successful.
+    bool GenerateLodLevels(unsigned numLevels, float reduction = 0.5f, float maxError = 0.02f, float lodDistanceStep = 20.0f, bool replaceExisting = false);
+    /// Reorder the triangles of all geometries and LOD levels for better vertex cache use. Requires shadowed index buffers.
+    void OptimizeVertexCache();
 
     /// Return bounding box.
     const BoundingBox& GetBoundingBox() const { return boundingBox_; }
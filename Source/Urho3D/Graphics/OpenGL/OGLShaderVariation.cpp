@@ -22,6 +22,7 @@
 
 #include "../../Precompiled.h"
 
+#include "../../Core/Timer.h"
 #include "../../Graphics/Graphics.h"
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/Shader.h"
@@ -82,22 +83,62 @@ void ShaderVariation::Release()
     }
 
     compilerOutput_.Clear();
+    preparedSource_.Clear();
+    prepared_ = false;
 }
 
 bool ShaderVariation::Create()
 {
-    Release();
-
-    if (!owner_)
+    // Preprocess now, unless already done in a worker thread
+    if (!prepared_)
     {
-        compilerOutput_ = "Owner shader has expired";
-        return false;
+        Release();
+        if (!Prepare())
+            return false;
     }
+    prepared_ = false;
 
     object_.name_ = glCreateShader(type_ == VS ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
     if (!object_.name_)
     {
         compilerOutput_ = "Could not create shader object";
+        preparedSource_.Clear();
+        return false;
+    }
+
+    HiresTimer compileTimer;
+    const char* shaderCStr = preparedSource_.CString();
+    glShaderSource(object_.name_, 1, &shaderCStr, nullptr);
+    glCompileShader(object_.name_);
+    // The source is no longer needed
+    preparedSource_.Clear();
+
+    int compiled, length;
+    glGetShaderiv(object_.name_, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        glGetShaderiv(object_.name_, GL_INFO_LOG_LENGTH, &length);
+        compilerOutput_.Resize((unsigned)length);
+        int outLength;
+        glGetShaderInfoLog(object_.name_, length, &outLength, &compilerOutput_[0]);
+        glDeleteShader(object_.name_);
+        object_.name_ = 0;
+    }
+    else
+        compilerOutput_.Clear();
+
+    // GLSL shaders are always compiled by the driver, so there are no cache hits
+    if (graphics_)
+        graphics_->AddShaderCompileStats(false, compileTimer.GetUSec(false));
+
+    return object_.name_ != 0;
+}
+
+bool ShaderVariation::Prepare()
+{
+    if (!owner_)
+    {
+        compilerOutput_ = "Owner shader has expired";
         return false;
     }
 
@@ -166,25 +207,9 @@ bool ShaderVariation::Create()
     else
         shaderCode += originalShaderCode;
 
-    const char* shaderCStr = shaderCode.CString();
-    glShaderSource(object_.name_, 1, &shaderCStr, nullptr);
-    glCompileShader(object_.name_);
-
-    int compiled, length;
-    glGetShaderiv(object_.name_, GL_COMPILE_STATUS, &compiled);
-    if (!compiled)
-    {
-        glGetShaderiv(object_.name_, GL_INFO_LOG_LENGTH, &length);
-        compilerOutput_.Resize((unsigned)length);
-        int outLength;
-        glGetShaderInfoLog(object_.name_, length, &outLength, &compilerOutput_[0]);
-        glDeleteShader(object_.name_);
-        object_.name_ = 0;
-    }
-    else
-        compilerOutput_.Clear();
-
-    return object_.name_ != 0;
+    preparedSource_.Swap(shaderCode);
+    prepared_ = true;
+    return true;
 }
 
 void ShaderVariation::SetDefines(const String& defines)
@@ -165,91 +165,94 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         }
     }
 
-    // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * effect_->GetConstantForce();
+    // Update existing particles. Effect parameters are resolved once outside the loop
+    const float timeStep = lastTimeStep_;
+    const Vector3& constantForce = effect_->GetConstantForce();
     // If billboards are not relative, apply scaling to the position update
-    Vector3 scaleVector = Vector3::ONE;
+    Vector3 positionScale = Vector3::ONE * timeStep;
     if (scaled_ && !relative_)
-        scaleVector = node_->GetWorldScale();
+        positionScale *= node_->GetWorldScale();
+    // Constant force in the billboards' space, multiplied by the timestep
+    Vector3 velocityAdd = constantForce * timeStep;
+    if (relative_ && constantForce != Vector3::ZERO)
+        velocityAdd = node_->GetWorldRotation().Inverse() * velocityAdd;
+    // Damping applied to the new velocity is a multiplication: v - timeStep * damping * v
+    float dampingFactor = 1.0f - timeStep * effect_->GetDampingForce();
+    float sizeAdd = timeStep * effect_->GetSizeAdd();
+    float sizeMul = effect_->GetSizeMul();
+    bool updateSize = sizeAdd != 0.0f || sizeMul != 1.0f;
+    float sizeMulStep = (timeStep * (sizeMul - 1.0f)) + 1.0f;
+    bool updateDirection = faceCameraMode_ == FC_DIRECTION;
+    const Vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    const Vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+    unsigned numColorFrames = colorFrames.Size();
+    unsigned numTextureFrames = textureFrames.Size();
 
     for (unsigned i = 0; i < particles_.Size(); ++i)
     {
         Particle& particle = particles_[i];
         Billboard& billboard = billboards_[i];
 
-        if (billboard.enabled_)
-        {
-            needCommit = true;
+        if (!billboard.enabled_)
+            continue;
 
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
+        needCommit = true;
 
-            // Velocity & position
-            const Vector3& constantForce = effect_->GetConstantForce();
-            if (constantForce != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce;
-            }
+        // Time to live
+        if (particle.timer_ >= particle.timeToLive_)
+        {
+            billboard.enabled_ = false;
+            continue;
+        }
+        particle.timer_ += timeStep;
 
-            float dampingForce = effect_->GetDampingForce();
-            if (dampingForce != 0.0f)
-            {
-                Vector3 force = -dampingForce * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
+        // Velocity & position
+        particle.velocity_ = (particle.velocity_ + velocityAdd) * dampingFactor;
+        billboard.position_ += particle.velocity_ * positionScale;
+        // Direction is only needed when rendering direction-aligned billboards
+        if (updateDirection)
             billboard.direction_ = particle.velocity_.Normalized();
 
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
+        // Rotation
+        billboard.rotation_ += timeStep * particle.rotationSpeed_;
 
-            // Scaling
-            float sizeAdd = effect_->GetSizeAdd();
-            float sizeMul = effect_->GetSizeMul();
-            if (sizeAdd != 0.0f || sizeMul != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd;
-                if (particle.scale_ < 0.0f)
-                    particle.scale_ = 0.0f;
-                if (sizeMul != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
+        // Scaling
+        if (updateSize)
+        {
+            particle.scale_ += sizeAdd;
+            if (particle.scale_ < 0.0f)
+                particle.scale_ = 0.0f;
+            particle.scale_ *= sizeMulStep;
+            billboard.size_ = particle.size_ * particle.scale_;
+        }
 
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            const Vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-            if (index < colorFrames_.Size())
+        // Color interpolation
+        unsigned& index = particle.colorIndex_;
+        if (index < numColorFrames)
+        {
+            if (index < numColorFrames - 1 && particle.timer_ >= colorFrames[index + 1].time_)
+                ++index;
+
+            if (index < numColorFrames - 1)
             {
-                if (index < colorFrames_.Size() - 1)
-                {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
-                }
-                if (index < colorFrames_.Size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
+                const ColorFrame& frame = colorFrames[index];
+                const ColorFrame& next = colorFrames[index + 1];
+                float timeInterval = next.time_ - frame.time_;
+                float t = timeInterval > 0.0f ? (particle.timer_ - frame.time_) / timeInterval : 1.0f;
+                billboard.color_ = frame.color_.Lerp(next.color_, t);
             }
+            else
+                billboard.color_ = colorFrames[index].color_;
+        }
 
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-            if (textureFrames_.Size() && texIndex < textureFrames_.Size() - 1)
+        // Texture animation
+        unsigned& texIndex = particle.texIndex_;
+        if (numTextureFrames && texIndex < numTextureFrames - 1)
+        {
+            if (particle.timer_ >= textureFrames[texIndex + 1].time_)
             {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
-                {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
-                    ++texIndex;
-                }
+                billboard.uv_ = textureFrames[texIndex + 1].uv_;
+                ++texIndex;
             }
         }
     }
@@ -280,6 +283,22 @@ void ParticleEmitter::SetEffect(ParticleEffect* effect)
     MarkNetworkUpdate();
 }
 
+void ParticleEmitter::SetFaceCameraMode(FaceCameraMode mode)
+{
+    BillboardSet::SetFaceCameraMode(mode);
+
+    // Directions are only updated while rendering direction-aligned billboards, so refresh them from the velocities
+    if (mode == FC_DIRECTION)
+    {
+        for (unsigned i = 0; i < particles_.Size() && i < billboards_.Size(); ++i)
+        {
+            if (billboards_[i].enabled_)
+                billboards_[i].direction_ = particles_[i].velocity_.Normalized();
+        }
+        Commit();
+    }
+}
+
 void ParticleEmitter::SetNumParticles(unsigned num)
 {
     // Prevent negative value being assigned from the editor
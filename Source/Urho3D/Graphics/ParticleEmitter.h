@@ -70,6 +70,8 @@ public:
 
     /// Set particle effect.
     void SetEffect(ParticleEffect* effect);
+    /// Set how the billboards should rotate in relation to the camera. Refreshes the particle directions when switching to direction-aligned billboards.
+    void SetFaceCameraMode(FaceCameraMode mode) override;
     /// Set maximum number of particles.
     void SetNumParticles(unsigned num);
     /// Set whether should be emitting. If the state was changed, also resets the emission period timer.
@@ -40,6 +40,7 @@
 #include "../Graphics/Technique.h"
 #include "../Graphics/Texture2D.h"
 #include "../Graphics/TextureCube.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../Graphics/View.h"
 #include "../Graphics/Zone.h"
@@ -339,6 +340,15 @@ void Renderer::SetTextureQuality(int quality)
     }
 }
 
+void Renderer::SetTextureStreaming(bool enable)
+{
+    if (enable != textureStreamer_.NotNull())
+    {
+        textureStreamer_ = enable ? new TextureStreamer(context_) : nullptr;
+        ReloadTextures();
+    }
+}
+
 void Renderer::SetMaterialQuality(int quality)
 {
     quality = Clamp(quality, QUALITY_LOW, QUALITY_MAX);
@@ -456,6 +466,13 @@ void Renderer::SetMaxShadowMaps(int shadowMaps)
     }
 }
 
+void Renderer::SetShadowMapCaching(bool enable)
+{
+    shadowMapCaching_ = enable;
+    if (!shadowMapCaching_)
+        shadowMapCache_.Clear();
+}
+
 void Renderer::SetDynamicInstancing(bool enable)
 {
     if (!instancingBuffer_)
@@ -627,6 +644,41 @@ unsigned Renderer::GetNumShadowMaps(bool allViews) const
     return numShadowMaps;
 }
 
+unsigned Renderer::GetNumRenderedShadowSplits(bool allViews) const
+{
+    return GetNumShadowSplits(allViews, false);
+}
+
+unsigned Renderer::GetNumCachedShadowSplits(bool allViews) const
+{
+    return GetNumShadowSplits(allViews, true);
+}
+
+unsigned Renderer::GetNumShadowSplits(bool allViews, bool cached) const
+{
+    unsigned numSplits = 0;
+    unsigned lastView = allViews ? views_.Size() : 1;
+
+    for (unsigned i = 0; i < lastView; ++i)
+    {
+        View* view = GetActualView(views_[i]);
+        if (!view)
+            continue;
+
+        const Vector<LightBatchQueue>& lightQueues = view->GetLightQueues();
+        for (Vector<LightBatchQueue>::ConstIterator i = lightQueues.Begin(); i != lightQueues.End(); ++i)
+        {
+            for (unsigned j = 0; j < i->shadowSplits_.Size(); ++j)
+            {
+                if (i->shadowSplits_[j].cached_ == cached)
+                    ++numSplits;
+            }
+        }
+    }
+
+    return numSplits;
+}
+
 unsigned Renderer::GetNumOccluders(bool allViews) const
 {
     unsigned numOccluders = 0;
@@ -664,6 +716,10 @@ void Renderer::Update(float timeStep)
     numOcclusionBuffers_ = 0;
     updatedOctrees_.Clear();
 
+    // Apply finished texture streaming loads and start new ones based on the previous frame's views
+    if (textureStreamer_)
+        textureStreamer_->Update(frame_.frameNumber_);
+
     // Reload shaders now if needed
     if (shadersDirty_)
         LoadShaders();
@@ -889,6 +945,29 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         height *= 3;
     }
 
+    // When caching, the light gets a persistent shadow map of its own. A filter modifies the whole map, so can not cache then
+    if (shadowMapCaching_ && !shadowMapFilter_)
+    {
+        ShadowMapCacheEntry& entry = shadowMapCache_[MakePair(light, camera)];
+        if (entry.light_ != light || entry.width_ != width || entry.height_ != height || !entry.shadowMap_ ||
+            entry.shadowMap_->IsDataLost())
+        {
+            entry.light_ = light;
+            entry.width_ = width;
+            entry.height_ = height;
+            entry.shadowMap_ = CreateShadowMap(width, height);
+            entry.splitHashes_.Clear();
+        }
+
+        if (entry.shadowMap_)
+        {
+            entry.shadowMap_->ResetUseTimer();
+            return entry.shadowMap_;
+        }
+        // If failed to create, fall back to the shared shadow maps
+        shadowMapCache_.Erase(MakePair(light, camera));
+    }
+
     int searchKey = (width << 16) | height;
     if (shadowMaps_.Contains(searchKey))
     {
@@ -909,6 +988,39 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         }
     }
 
+    SharedPtr<Texture2D> newShadowMap = CreateShadowMap(width, height);
+    shadowMaps_[searchKey].Push(newShadowMap);
+    if (!reuseShadowMaps_)
+        shadowMapAllocations_[searchKey].Push(light);
+
+    return newShadowMap;
+}
+
+bool Renderer::CheckShadowMapCache(Light* light, Camera* camera, Texture2D* shadowMap, unsigned split, unsigned long long hash)
+{
+    unsigned long long* splitHash = GetShadowMapCacheHash(light, camera, shadowMap, split);
+    if (!splitHash)
+        return false;
+
+    if (hash && *splitHash == hash)
+        return true;
+
+    // The split will be rendered or left stale this frame, so invalidate until it has been rendered again
+    *splitHash = 0;
+    return false;
+}
+
+void Renderer::StoreShadowMapCache(Light* light, Camera* camera, Texture2D* shadowMap, unsigned split, unsigned long long hash)
+{
+    unsigned long long* splitHash = GetShadowMapCacheHash(light, camera, shadowMap, split);
+    if (splitHash)
+        *splitHash = hash;
+}
+
+SharedPtr<Texture2D> Renderer::CreateShadowMap(int width, int height)
+{
+    int searchKey = (width << 16) | height;
+
     // Find format and usage of the shadow map
     unsigned shadowMapFormat = 0;
     TextureUsage shadowMapUsage = TEXTURE_DEPTHSTENCIL;
@@ -982,14 +1094,10 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         }
     }
 
-    // If failed to set size, store a null pointer so that we will not retry
+    // If failed to set size, return a null pointer so that we will not retry
     if (!retries)
         newShadowMap.Reset();
 
-    shadowMaps_[searchKey].Push(newShadowMap);
-    if (!reuseShadowMaps_)
-        shadowMapAllocations_[searchKey].Push(light);
-
     return newShadowMap;
 }
 
@@ -1530,8 +1638,32 @@ void Renderer::PrepareViewRender()
     lightStencilValue_ = 1;
 }
 
+unsigned long long* Renderer::GetShadowMapCacheHash(Light* light, Camera* camera, Texture2D* shadowMap, unsigned split)
+{
+    HashMap<Pair<Light*, Camera*>, ShadowMapCacheEntry>::Iterator i = shadowMapCache_.Find(MakePair(light, camera));
+    if (i == shadowMapCache_.End() || i->second_.shadowMap_ != shadowMap)
+        return nullptr;
+
+    PODVector<unsigned long long>& splitHashes = i->second_.splitHashes_;
+    while (splitHashes.Size() <= split)
+        splitHashes.Push(0);
+
+    return &splitHashes[split];
+}
+
 void Renderer::RemoveUnusedBuffers()
 {
+    for (HashMap<Pair<Light*, Camera*>, ShadowMapCacheEntry>::Iterator i = shadowMapCache_.Begin(); i != shadowMapCache_.End();)
+    {
+        HashMap<Pair<Light*, Camera*>, ShadowMapCacheEntry>::Iterator current = i++;
+        ShadowMapCacheEntry& entry = current->second_;
+        if (entry.light_.Expired() || !entry.shadowMap_ || entry.shadowMap_->GetUseTimer() > MAX_BUFFER_AGE)
+        {
+            URHO3D_LOGDEBUG("Removed unused cached shadow map");
+            shadowMapCache_.Erase(current);
+        }
+    }
+
     for (unsigned i = occlusionBuffers_.Size() - 1; i < occlusionBuffers_.Size(); --i)
     {
         if (occlusionBuffers_[i]->GetUseTimer() > MAX_BUFFER_AGE)
@@ -1900,6 +2032,7 @@ void Renderer::ResetShadowMaps()
     shadowMaps_.Clear();
     shadowMapAllocations_.Clear();
     colorShadowMaps_.Clear();
+    shadowMapCache_.Clear();
 }
 
 void Renderer::ResetBuffers()
@@ -50,6 +50,7 @@ class Technique;
 class Texture;
 class Texture2D;
 class TextureCube;
+class TextureStreamer;
 class View;
 class Zone;
 struct BatchQueue;
@@ -57,6 +58,21 @@ struct BatchQueue;
 static const int SHADOW_MIN_PIXELS = 64;
 static const int INSTANCING_BUFFER_DEFAULT_SIZE = 1024;
 
+/// Persistent shadow map of a light, with the state of each split at the time it was last rendered.
+struct ShadowMapCacheEntry
+{
+    /// Light.
+    WeakPtr<Light> light_;
+    /// Shadow map.
+    SharedPtr<Texture2D> shadowMap_;
+    /// Requested shadow map width.
+    int width_{};
+    /// Requested shadow map height.
+    int height_{};
+    /// Hashes of the shadow camera and casters of each split. Zero means the split must be rendered.
+    PODVector<unsigned long long> splitHashes_;
+};
+
 /// Light vertex shader variations.
 enum LightVSVariation
 {
@@ -202,6 +218,8 @@ public:
     void SetTextureFilterMode(TextureFilterMode mode);
     /// Set texture quality level. See the QUALITY constants in GraphicsDefs.h.
     void SetTextureQuality(int quality);
+    /// Set texture streaming on/off. When on, 2D textures loaded from images keep resident only the mip levels needed by their on-screen size, within the streamer's memory budget. Toggling reloads textures. Default false.
+    void SetTextureStreaming(bool enable);
     /// Set material quality level. See the QUALITY constants in GraphicsDefs.h.
     void SetMaterialQuality(int quality);
     /// Set shadows on/off.
@@ -222,6 +240,8 @@ public:
     void SetReuseShadowMaps(bool enable);
     /// Set maximum number of shadow maps created for one resolution. Only has effect if reuse of shadow maps is disabled.
     void SetMaxShadowMaps(int shadowMaps);
+    /// Set shadow map caching. When on, each shadowed light keeps its shadow map between frames and only re-renders the splits whose shadow camera or casters have changed. Has no effect while a shadow map filter (such as blurred VSM) is in use. Default false.
+    void SetShadowMapCaching(bool enable);
     /// Set dynamic instancing on/off. When on (default), drawables using the same static-type geometry and material will be automatically combined to an instanced draw call.
     void SetDynamicInstancing(bool enable);
     /// Set number of extra instancing buffer elements. Default is 0. Extra 4-vectors are available through TEXCOORD7 and further.
@@ -280,6 +300,12 @@ public:
     /// Return texture quality level.
     int GetTextureQuality() const { return textureQuality_; }
 
+    /// Return whether texture streaming is enabled.
+    bool GetTextureStreaming() const { return textureStreamer_.NotNull(); }
+
+    /// Return texture streamer, or null if texture streaming is disabled.
+    TextureStreamer* GetTextureStreamer() const { return textureStreamer_; }
+
     /// Return material quality level.
     int GetMaterialQuality() const { return materialQuality_; }
 
@@ -304,6 +330,9 @@ public:
     /// Return maximum number of shadow maps per resolution.
     int GetMaxShadowMaps() const { return maxShadowMaps_; }
 
+    /// Return whether shadow map caching is enabled.
+    bool GetShadowMapCaching() const { return shadowMapCaching_; }
+
     /// Return whether dynamic instancing is in use.
     bool GetDynamicInstancing() const { return dynamicInstancing_; }
 
@@ -352,6 +381,10 @@ public:
     unsigned GetNumLights(bool allViews = false) const;
     /// Return number of shadow maps rendered.
     unsigned GetNumShadowMaps(bool allViews = false) const;
+    /// Return number of shadow map splits rendered.
+    unsigned GetNumRenderedShadowSplits(bool allViews = false) const;
+    /// Return number of shadow map splits reused from the shadow map cache.
+    unsigned GetNumCachedShadowSplits(bool allViews = false) const;
     /// Return number of occluders rendered.
     unsigned GetNumOccluders(bool allViews = false) const;
 
@@ -396,6 +429,10 @@ public:
     Geometry* GetQuadGeometry();
     /// Allocate a shadow map. If shadow map reuse is disabled, a different map is returned each time.
     Texture2D* GetShadowMap(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight);
+    /// Return whether a split of a cached shadow map was last rendered with the same hash. If not, the split stays invalid until stored again.
+    bool CheckShadowMapCache(Light* light, Camera* camera, Texture2D* shadowMap, unsigned split, unsigned long long hash);
+    /// Store the hash of a cached shadow map split after rendering it. A zero hash leaves the split invalid.
+    void StoreShadowMapCache(Light* light, Camera* camera, Texture2D* shadowMap, unsigned split, unsigned long long hash);
     /// Allocate a rendertarget or depth-stencil texture for deferred rendering or postprocessing. Should only be called during actual rendering, not before.
     Texture* GetScreenBuffer
         (int width, int height, unsigned format, int multiSample, bool autoResolve, bool cubemap, bool filtered, bool srgb, unsigned persistentKey = 0);
@@ -433,6 +470,8 @@ private:
     void Initialize();
     /// Reload shaders.
     void LoadShaders();
+    /// Return number of shadow map splits that were either cached or rendered in the previous frame.
+    unsigned GetNumShadowSplits(bool allViews, bool cached) const;
     /// Reload shaders for a material pass. The related batch queue is provided in case it has extra shader compilation defines.
     void LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >& vertexShaders, Vector<SharedPtr<ShaderVariation> >& pixelShaders, const BatchQueue& queue);
     /// Release shaders used in materials.
@@ -449,6 +488,10 @@ private:
     void UpdateQueuedViewport(unsigned index);
     /// Prepare for rendering of a new view.
     void PrepareViewRender();
+    /// Create a shadow map texture in the current shadow quality format. Return null if failed.
+    SharedPtr<Texture2D> CreateShadowMap(int width, int height);
+    /// Return the hash of a cached shadow map split for modification, or null if the shadow map is not cached.
+    unsigned long long* GetShadowMapCacheHash(Light* light, Camera* camera, Texture2D* shadowMap, unsigned split);
     /// Remove unused occlusion and screen buffers.
     void RemoveUnusedBuffers();
     /// Reset shadow map allocation counts.
@@ -494,6 +537,8 @@ private:
     SharedPtr<TextureCube> faceSelectCubeMap_;
     /// Indirection cube map for shadowed pointlights.
     SharedPtr<TextureCube> indirectionCubeMap_;
+    /// Texture streamer.
+    SharedPtr<TextureStreamer> textureStreamer_;
     /// Reusable scene nodes with shadow camera components.
     Vector<SharedPtr<Node> > shadowCameraNodes_;
     /// Reusable occlusion buffers.
@@ -504,6 +549,8 @@ private:
     HashMap<int, SharedPtr<Texture2D> > colorShadowMaps_;
     /// Shadow map allocations by resolution.
     HashMap<int, PODVector<Light*> > shadowMapAllocations_;
+    /// Cached shadow maps by light and culling camera.
+    HashMap<Pair<Light*, Camera*>, ShadowMapCacheEntry> shadowMapCache_;
     /// Instance of shadow map filter
     Object* shadowMapFilterInstance_{};
     /// Function pointer of shadow map filter
@@ -590,6 +637,8 @@ private:
     bool drawShadows_{true};
     /// Shadow map reuse flag.
     bool reuseShadowMaps_{true};
+    /// Shadow map caching flag.
+    bool shadowMapCaching_{};
     /// Dynamic instancing flag.
     bool dynamicInstancing_{true};
     /// Number of extra instancing data elements.
@@ -83,10 +83,6 @@ void Shader::RegisterObject(Context* context)
 
 bool Shader::BeginLoad(Deserializer& source)
 {
-    auto* graphics = GetSubsystem<Graphics>();
-    if (!graphics)
-        return false;
-
     // Load the shader source code and resolve any includes
     timeStamp_ = 0;
     String shaderCode;
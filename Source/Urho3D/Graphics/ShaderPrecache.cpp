@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsImpl.h"
 #include "../Graphics/ShaderPrecache.h"
@@ -35,6 +36,15 @@
 namespace Urho3D
 {
 
+static void PrepareShadersWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    auto** start = reinterpret_cast<ShaderVariation**>(item->start_);
+    auto** end = reinterpret_cast<ShaderVariation**>(item->end_);
+
+    while (start != end)
+        (*start++)->Prepare();
+}
+
 ShaderPrecache::ShaderPrecache(Context* context, const String& fileName) :
     Object(context),
     fileName_(fileName),
@@ -111,6 +121,11 @@ void ShaderPrecache::LoadShaders(Graphics* graphics, Deserializer& source)
     XMLFile xmlFile(graphics->GetContext());
     xmlFile.Load(source);
 
+    // Collect the combinations first. Querying the variations loads the shader source code
+    Vector<Pair<ShaderVariation*, ShaderVariation*> > combinations;
+    PODVector<ShaderVariation*> variations;
+    HashSet<ShaderVariation*> variationSet;
+
     XMLElement shader = xmlFile.GetRoot().GetChild("shader");
     while (shader)
     {
@@ -132,13 +147,55 @@ void ShaderPrecache::LoadShaders(Graphics* graphics, Deserializer& source)
 
         ShaderVariation* vs = graphics->GetShader(VS, shader.GetAttribute("vs"), vsDefines);
         ShaderVariation* ps = graphics->GetShader(PS, shader.GetAttribute("ps"), psDefines);
-        // Set the shaders active to actually compile them
-        graphics->SetShaders(vs, ps);
+        combinations.Push(MakePair(vs, ps));
+
+        ShaderVariation* pair[] = {vs, ps};
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            // Prepare only variations that have not been created or attempted yet
+            ShaderVariation* variation = pair[i];
+            if (variation && !variation->GetGPUObject() && !variation->IsPrepared() && variation->GetCompilerOutput().Empty() &&
+                !variationSet.Contains(variation))
+            {
+                variationSet.Insert(variation);
+                variations.Push(variation);
+            }
+        }
 
         shader = shader.GetNext("shader");
     }
 
+    // Preprocess the source code and load or compile the bytecode in worker threads. This does not touch the GPU
+    auto* queue = graphics->GetSubsystem<WorkQueue>();
+    if (queue && variations.Size())
+    {
+        unsigned numWorkItems = Min(queue->GetNumThreads() + 1, variations.Size());
+        unsigned variationsPerItem = variations.Size() / numWorkItems;
+        ShaderVariation** start = &variations[0];
+        ShaderVariation** end = start + variations.Size();
+
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = PrepareShadersWork;
+            item->start_ = start;
+            item->end_ = i < numWorkItems - 1 ? start + variationsPerItem : end;
+            queue->AddWorkItem(item);
+
+            start = reinterpret_cast<ShaderVariation**>(item->end_);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+
+    // Then set the shaders active in the main thread to create the GPU objects and link them
+    for (unsigned i = 0; i < combinations.Size(); ++i)
+        graphics->SetShaders(combinations[i].first_, combinations[i].second_);
+
     URHO3D_LOGDEBUG("End precaching shaders");
+    URHO3D_LOGINFO("Shader cache hits " + String(graphics->GetNumShaderCacheHits()) + ", misses " +
+        String(graphics->GetNumShaderCacheMisses()) + ", compile time " + String(graphics->GetShaderCompileTime() / 1000) + " ms");
 }
 
 }
@@ -77,4 +77,23 @@ Shader* ShaderVariation::GetOwner() const
     return owner_;
 }
 
+unsigned long long ShaderVariation::CalculateCacheKey(const String& sourceCode, const String& defines, const String& target)
+{
+    // 64-bit FNV-1a over the strings, including their terminating zeros as separators
+    unsigned long long hash = 14695981039346656037ULL;
+    const String* strings[] = {&sourceCode, &defines, &target};
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        const char* data = strings[i]->CString();
+        for (unsigned j = 0; j <= strings[i]->Length(); ++j)
+        {
+            hash ^= (unsigned char)data[j];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
 }
@@ -93,6 +93,8 @@ public:
 
     /// Compile the shader. Return true if successful.
     bool Create();
+    /// Preprocess the source code and load or compile the bytecode where the graphics API allows, without creating the GPU object. May be called from a worker thread. Return true if successful.
+    bool Prepare();
     /// Set name.
     void SetName(const String& name);
     /// Set defines.
@@ -131,12 +133,18 @@ public:
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
 
+    /// Return whether has been prepared for creation.
+    bool IsPrepared() const { return prepared_; }
+
     /// Return constant buffer data sizes.
     const unsigned* GetConstantBufferSizes() const { return &constantBufferSizes_[0]; }
 
     /// Return defines with the CLIPPLANE define appended. Used internally on Direct3D11 only, will be empty on other APIs.
     const String& GetDefinesClipPlane() { return definesClipPlane_; }
 
+    /// Calculate the shader cache key from source code, defines and a graphics API / shader model identifier.
+    static unsigned long long CalculateCacheKey(const String& sourceCode, const String& defines, const String& target);
+
     /// D3D11 vertex semantic names. Used internally.
     static const char* elementSemanticNames[];
 
@@ -174,6 +182,10 @@ private:
     String definesClipPlane_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// Preprocessed source code waiting to be compiled. Used only on OpenGL.
+    String preparedSource_;
+    /// Prepared for creation flag.
+    bool prepared_{};
 };
 
 }
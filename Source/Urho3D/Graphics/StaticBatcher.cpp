@@ -0,0 +1,455 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Graphics/Geometry.h"
+#include "../Graphics/IndexBuffer.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Model.h"
+#include "../Graphics/StaticBatcher.h"
+#include "../Graphics/StaticModel.h"
+#include "../Graphics/VertexBuffer.h"
+#include "../IO/Log.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+/// Drawable settings and spatial cluster that must match for models to be merged.
+struct StaticBatchKey
+{
+    /// Test for equality with another key.
+    bool operator ==(const StaticBatchKey& rhs) const
+    {
+        return cell_ == rhs.cell_ && viewMask_ == rhs.viewMask_ && lightMask_ == rhs.lightMask_ &&
+            shadowMask_ == rhs.shadowMask_ && zoneMask_ == rhs.zoneMask_ && maxLights_ == rhs.maxLights_ &&
+            drawDistance_ == rhs.drawDistance_ && shadowDistance_ == rhs.shadowDistance_ &&
+            castShadows_ == rhs.castShadows_ && occluder_ == rhs.occluder_ && occludee_ == rhs.occludee_;
+    }
+
+    /// Return hash value for HashMap.
+    unsigned ToHash() const { return cell_.ToHash() ^ (viewMask_ * 31) ^ (lightMask_ * 17) ^ (castShadows_ ? 1u : 0u); }
+
+    /// Cluster cell.
+    IntVector3 cell_;
+    /// View mask.
+    unsigned viewMask_;
+    /// Light mask.
+    unsigned lightMask_;
+    /// Shadow mask.
+    unsigned shadowMask_;
+    /// Zone mask.
+    unsigned zoneMask_;
+    /// Maximum per-pixel lights.
+    unsigned maxLights_;
+    /// Draw distance.
+    float drawDistance_;
+    /// Shadow distance.
+    float shadowDistance_;
+    /// Shadowcaster flag.
+    bool castShadows_;
+    /// Occluder flag.
+    bool occluder_;
+    /// Occludee flag.
+    bool occludee_;
+};
+
+/// Source geometry to be merged.
+struct StaticBatchSource
+{
+    /// Geometry.
+    Geometry* geometry_;
+    /// Material.
+    Material* material_;
+    /// Index of the vertex layout.
+    unsigned layout_;
+    /// Transform into the batcher node's space.
+    Matrix3x4 transform_;
+};
+
+static bool CompareStaticBatchSources(const StaticBatchSource& lhs, const StaticBatchSource& rhs)
+{
+    if (lhs.layout_ != rhs.layout_)
+        return lhs.layout_ < rhs.layout_;
+    return lhs.material_ < rhs.material_;
+}
+
+/// Return whether a geometry can be merged.
+static bool IsMergeable(Geometry* geometry)
+{
+    if (!geometry || geometry->GetPrimitiveType() != TRIANGLE_LIST || geometry->GetNumVertexBuffers() != 1 ||
+        !geometry->GetIndexBuffer() || !geometry->GetIndexCount())
+        return false;
+
+    const unsigned char* vertexData;
+    const unsigned char* indexData;
+    unsigned vertexSize;
+    unsigned indexSize;
+    const PODVector<VertexElement>* elements;
+    geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elements);
+
+    return vertexData && indexData && elements &&
+        VertexBuffer::HasElement(*elements, TYPE_VECTOR3, SEM_POSITION) &&
+        !VertexBuffer::HasElement(*elements, TYPE_UBYTE4, SEM_BLENDINDICES);
+}
+
+/// Copy vertices of a geometry while transforming positions, normals and tangents.
+static void TransformVertices(unsigned char* dest, const unsigned char* src, unsigned count, unsigned vertexSize,
+    const PODVector<VertexElement>& elements, const Matrix3x4& transform, bool mirrored, BoundingBox& box)
+{
+    unsigned positionOffset = VertexBuffer::GetElementOffset(elements, TYPE_VECTOR3, SEM_POSITION);
+    unsigned normalOffset = VertexBuffer::GetElementOffset(elements, TYPE_VECTOR3, SEM_NORMAL);
+    unsigned tangentOffset = VertexBuffer::GetElementOffset(elements, TYPE_VECTOR4, SEM_TANGENT);
+    Matrix3 rotation = transform.ToMatrix3();
+    Matrix3 normalMatrix = rotation.Inverse().Transpose();
+
+    memcpy(dest, src, count * vertexSize);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned char* vertex = dest + i * vertexSize;
+
+        auto& position = *reinterpret_cast<Vector3*>(vertex + positionOffset);
+        position = transform * position;
+        box.Merge(position);
+
+        if (normalOffset != M_MAX_UNSIGNED)
+        {
+            auto& normal = *reinterpret_cast<Vector3*>(vertex + normalOffset);
+            normal = (normalMatrix * normal).Normalized();
+        }
+        if (tangentOffset != M_MAX_UNSIGNED)
+        {
+            auto& tangent = *reinterpret_cast<Vector4*>(vertex + tangentOffset);
+            Vector3 direction = (rotation * Vector3(tangent.x_, tangent.y_, tangent.z_)).Normalized();
+            tangent = Vector4(direction, mirrored ? -tangent.w_ : tangent.w_);
+        }
+    }
+}
+
+StaticBatcher::StaticBatcher(Context* context) :
+    Component(context)
+{
+}
+
+StaticBatcher::~StaticBatcher() = default;
+
+void StaticBatcher::RegisterObject(Context* context)
+{
+    context->RegisterFactory<StaticBatcher>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cluster Size", GetClusterSize, SetClusterSize, float, DEFAULT_STATIC_BATCH_CLUSTER_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Build On Load", GetBuildOnLoad, SetBuildOnLoad, bool, false, AM_DEFAULT);
+}
+
+void StaticBatcher::ApplyAttributes()
+{
+    if (buildOnLoad_ && !IsBuilt() && IsEnabledEffective())
+        Build();
+}
+
+void StaticBatcher::SetClusterSize(float size)
+{
+    clusterSize_ = Max(size, M_EPSILON);
+    MarkNetworkUpdate();
+}
+
+void StaticBatcher::SetBuildOnLoad(bool enable)
+{
+    buildOnLoad_ = enable;
+    MarkNetworkUpdate();
+}
+
+bool StaticBatcher::Build()
+{
+    URHO3D_PROFILE(BuildStaticBatches);
+
+    Clear();
+
+    if (!node_)
+    {
+        URHO3D_LOGERROR("Can not build static batches before being assigned to a scene node");
+        return false;
+    }
+
+    PODVector<StaticModel*> models;
+    node_->GetComponents<StaticModel>(models, true);
+
+    Matrix3x4 inverseWorld = node_->GetWorldTransform().Inverse();
+    Vector<PODVector<VertexElement> > layouts;
+    HashMap<StaticBatchKey, Vector<StaticBatchSource> > clusters;
+    HashMap<StaticBatchKey, StaticModel*> clusterSettings;
+
+    for (PODVector<StaticModel*>::ConstIterator i = models.Begin(); i != models.End(); ++i)
+    {
+        StaticModel* staticModel = *i;
+        Model* model = staticModel->GetModel();
+        if (!staticModel->IsEnabledEffective() || !model)
+            continue;
+
+        // All geometries must be mergeable, as the source model will be disabled. Models with LOD levels are left as is
+        bool mergeable = true;
+        for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
+        {
+            if (model->GetNumGeometryLodLevels(j) != 1 || !IsMergeable(model->GetGeometry(j, 0)))
+            {
+                mergeable = false;
+                break;
+            }
+        }
+        if (!mergeable || !model->GetNumGeometries())
+            continue;
+
+        Matrix3x4 transform = inverseWorld * staticModel->GetNode()->GetWorldTransform();
+        Vector3 center = transform * model->GetBoundingBox().Center();
+
+        StaticBatchKey key;
+        key.cell_ = IntVector3(FloorToInt(center.x_ / clusterSize_), FloorToInt(center.y_ / clusterSize_),
+            FloorToInt(center.z_ / clusterSize_));
+        key.viewMask_ = staticModel->GetViewMask();
+        key.lightMask_ = staticModel->GetLightMask();
+        key.shadowMask_ = staticModel->GetShadowMask();
+        key.zoneMask_ = staticModel->GetZoneMask();
+        key.maxLights_ = staticModel->GetMaxLights();
+        key.drawDistance_ = staticModel->GetDrawDistance();
+        key.shadowDistance_ = staticModel->GetShadowDistance();
+        key.castShadows_ = staticModel->GetCastShadows();
+        key.occluder_ = staticModel->IsOccluder();
+        key.occludee_ = staticModel->IsOccludee();
+
+        Vector<StaticBatchSource>& sources = clusters[key];
+        if (!clusterSettings.Contains(key))
+            clusterSettings[key] = staticModel;
+
+        for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
+        {
+            StaticBatchSource source;
+            source.geometry_ = model->GetGeometry(j, 0);
+            source.material_ = staticModel->GetMaterial(j);
+            source.transform_ = transform;
+
+            const PODVector<VertexElement>& elements = source.geometry_->GetVertexBuffer(0)->GetElements();
+            source.layout_ = layouts.IndexOf(elements);
+            if (source.layout_ == layouts.Size())
+                layouts.Push(elements);
+
+            sources.Push(source);
+        }
+
+        sourceModels_.Push(WeakPtr<StaticModel>(staticModel));
+        numSourceBatches_ += model->GetNumGeometries();
+    }
+
+    for (HashMap<StaticBatchKey, Vector<StaticBatchSource> >::Iterator i = clusters.Begin(); i != clusters.End(); ++i)
+    {
+        Vector<StaticBatchSource>& sources = i->second_;
+        Sort(sources.Begin(), sources.End(), CompareStaticBatchSources);
+
+        SharedPtr<Model> model(new Model(context_));
+        Vector<SharedPtr<VertexBuffer> > vertexBuffers;
+        Vector<SharedPtr<IndexBuffer> > indexBuffers;
+        PODVector<Material*> materials;
+        BoundingBox modelBox;
+
+        // Each vertex layout gets its own vertex and index buffer, and each material a draw range within them
+        unsigned layoutStart = 0;
+        while (layoutStart < sources.Size())
+        {
+            unsigned layoutEnd = layoutStart;
+            unsigned numVertices = 0;
+            unsigned numIndices = 0;
+            while (layoutEnd < sources.Size() && sources[layoutEnd].layout_ == sources[layoutStart].layout_)
+            {
+                numVertices += sources[layoutEnd].geometry_->GetVertexCount();
+                numIndices += sources[layoutEnd].geometry_->GetIndexCount();
+                ++layoutEnd;
+            }
+
+            const PODVector<VertexElement>& elements = layouts[sources[layoutStart].layout_];
+            unsigned vertexSize = VertexBuffer::GetVertexSize(elements);
+            bool largeIndices = numVertices > 65535;
+            unsigned indexSize = largeIndices ? sizeof(unsigned) : sizeof(unsigned short);
+            SharedArrayPtr<unsigned char> vertexData(new unsigned char[numVertices * vertexSize]);
+            SharedArrayPtr<unsigned char> indexData(new unsigned char[numIndices * indexSize]);
+
+            SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+            SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+            vertexBuffer->SetShadowed(true);
+            indexBuffer->SetShadowed(true);
+
+            unsigned vertexStart = 0;
+            unsigned indexStart = 0;
+            unsigned rangeStart = layoutStart;
+            while (rangeStart < layoutEnd)
+            {
+                unsigned rangeVertexStart = vertexStart;
+                unsigned rangeIndexStart = indexStart;
+                BoundingBox rangeBox;
+                Material* material = sources[rangeStart].material_;
+
+                unsigned j = rangeStart;
+                for (; j < layoutEnd && sources[j].material_ == material; ++j)
+                {
+                    const StaticBatchSource& source = sources[j];
+                    const unsigned char* srcVertexData;
+                    const unsigned char* srcIndexData;
+                    unsigned srcVertexSize;
+                    unsigned srcIndexSize;
+                    const PODVector<VertexElement>* srcElements;
+                    source.geometry_->GetRawData(srcVertexData, srcVertexSize, srcIndexData, srcIndexSize, srcElements);
+
+                    const Matrix3 rotation = source.transform_.ToMatrix3();
+                    float determinant = rotation.m00_ * (rotation.m11_ * rotation.m22_ - rotation.m12_ * rotation.m21_) -
+                        rotation.m01_ * (rotation.m10_ * rotation.m22_ - rotation.m12_ * rotation.m20_) +
+                        rotation.m02_ * (rotation.m10_ * rotation.m21_ - rotation.m11_ * rotation.m20_);
+                    bool mirrored = determinant < 0.0f;
+
+                    unsigned srcVertexStart = source.geometry_->GetVertexStart();
+                    unsigned srcVertexCount = source.geometry_->GetVertexCount();
+                    unsigned srcIndexStart = source.geometry_->GetIndexStart();
+                    unsigned srcIndexCount = source.geometry_->GetIndexCount();
+
+                    TransformVertices(&vertexData[vertexStart * vertexSize], srcVertexData + srcVertexStart * srcVertexSize,
+                        srcVertexCount, vertexSize, elements, source.transform_, mirrored, rangeBox);
+
+                    // Rebase the indices to the merged vertices, and flip the winding order of mirrored instances
+                    for (unsigned k = 0; k < srcIndexCount; ++k)
+                    {
+                        unsigned srcIndex = k;
+                        if (mirrored)
+                            srcIndex = k - k % 3 + 2 - k % 3;
+                        unsigned index = srcIndexSize == sizeof(unsigned) ?
+                            reinterpret_cast<const unsigned*>(srcIndexData)[srcIndexStart + srcIndex] :
+                            reinterpret_cast<const unsigned short*>(srcIndexData)[srcIndexStart + srcIndex];
+                        index = index - srcVertexStart + vertexStart;
+                        if (largeIndices)
+                            reinterpret_cast<unsigned*>(indexData.Get())[indexStart + k] = index;
+                        else
+                            reinterpret_cast<unsigned short*>(indexData.Get())[indexStart + k] = (unsigned short)index;
+                    }
+
+                    vertexStart += srcVertexCount;
+                    indexStart += srcIndexCount;
+                }
+
+                SharedPtr<Geometry> geometry(new Geometry(context_));
+                geometry->SetVertexBuffer(0, vertexBuffer);
+                geometry->SetIndexBuffer(indexBuffer);
+                geometry->SetDrawRange(TRIANGLE_LIST, rangeIndexStart, indexStart - rangeIndexStart, rangeVertexStart,
+                    vertexStart - rangeVertexStart, false);
+
+                unsigned geometryIndex = materials.Size();
+                model->SetNumGeometries(geometryIndex + 1);
+                model->SetNumGeometryLodLevels(geometryIndex, 1);
+                model->SetGeometry(geometryIndex, 0, geometry);
+                model->SetGeometryCenter(geometryIndex, rangeBox.Center());
+                materials.Push(material);
+                modelBox.Merge(rangeBox);
+
+                rangeStart = j;
+            }
+
+            vertexBuffer->SetSize(numVertices, elements);
+            vertexBuffer->SetData(vertexData.Get());
+            indexBuffer->SetSize(numIndices, largeIndices);
+            indexBuffer->SetData(indexData.Get());
+            vertexBuffers.Push(vertexBuffer);
+            indexBuffers.Push(indexBuffer);
+
+            layoutStart = layoutEnd;
+        }
+
+        PODVector<unsigned> morphRangeStarts(vertexBuffers.Size());
+        PODVector<unsigned> morphRangeCounts(vertexBuffers.Size());
+        for (unsigned j = 0; j < vertexBuffers.Size(); ++j)
+            morphRangeStarts[j] = morphRangeCounts[j] = 0;
+        model->SetVertexBuffers(vertexBuffers, morphRangeStarts, morphRangeCounts);
+        model->SetIndexBuffers(indexBuffers);
+        model->SetBoundingBox(modelBox);
+
+        // The merged vertices are in the batcher node's space, so the cluster node uses an identity transform
+        StaticModel* settings = clusterSettings[i->first_];
+        Node* batchNode = node_->CreateTemporaryChild("StaticBatch", LOCAL);
+        auto* batchModel = batchNode->CreateComponent<StaticModel>(LOCAL);
+        batchModel->SetModel(model);
+        for (unsigned j = 0; j < materials.Size(); ++j)
+            batchModel->SetMaterial(j, materials[j]);
+        batchModel->SetViewMask(settings->GetViewMask());
+        batchModel->SetLightMask(settings->GetLightMask());
+        batchModel->SetShadowMask(settings->GetShadowMask());
+        batchModel->SetZoneMask(settings->GetZoneMask());
+        batchModel->SetMaxLights(settings->GetMaxLights());
+        batchModel->SetDrawDistance(settings->GetDrawDistance());
+        batchModel->SetShadowDistance(settings->GetShadowDistance());
+        batchModel->SetCastShadows(settings->GetCastShadows());
+        batchModel->SetOccluder(settings->IsOccluder());
+        batchModel->SetOccludee(settings->IsOccludee());
+
+        batchNodes_.Push(WeakPtr<Node>(batchNode));
+        numBatches_ += materials.Size();
+    }
+
+    // Disable the source models only after merging, as their state was needed above
+    for (unsigned i = 0; i < sourceModels_.Size(); ++i)
+        sourceModels_[i]->SetEnabled(false);
+
+    URHO3D_LOGINFOF("Merged %u static models with %u draw calls into %u clusters with %u draw calls", sourceModels_.Size(),
+        numSourceBatches_, batchNodes_.Size(), numBatches_);
+    return true;
+}
+
+void StaticBatcher::Clear()
+{
+    for (unsigned i = 0; i < batchNodes_.Size(); ++i)
+    {
+        if (batchNodes_[i])
+            batchNodes_[i]->Remove();
+    }
+
+    for (unsigned i = 0; i < sourceModels_.Size(); ++i)
+    {
+        if (sourceModels_[i])
+            sourceModels_[i]->SetEnabled(true);
+    }
+
+    batchNodes_.Clear();
+    sourceModels_.Clear();
+    numSourceBatches_ = 0;
+    numBatches_ = 0;
+}
+
+void StaticBatcher::OnNodeSet(Node* node)
+{
+    // Restore the source models when removed from the scene node
+    if (!node)
+        Clear();
+}
+
+}
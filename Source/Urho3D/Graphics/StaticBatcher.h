@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class StaticModel;
+
+static const float DEFAULT_STATIC_BATCH_CLUSTER_SIZE = 32.0f;
+
+/// %Component that merges the static models of its scene node and child nodes into combined geometry. Models sharing drawable settings and a material are combined per spatial cluster, so that they render with fewer draw calls while still being culled by the octree.
+class URHO3D_API StaticBatcher : public Component
+{
+    URHO3D_OBJECT(StaticBatcher, Component);
+
+public:
+    /// Construct.
+    explicit StaticBatcher(Context* context);
+    /// Destruct.
+    ~StaticBatcher() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Apply attribute changes that can not be applied immediately. Builds the batches if build on load is enabled.
+    void ApplyAttributes() override;
+
+    /// Set cluster size in the scene node's space. Models whose bounding box centers fall into the same cluster cell are merged.
+    void SetClusterSize(float size);
+    /// Set whether to build automatically after scene load.
+    void SetBuildOnLoad(bool enable);
+    /// Merge the enabled static models of the scene node and child nodes. The source models are disabled. Return true if successful.
+    bool Build();
+    /// Remove the merged geometry and re-enable the source models. Should be called before saving the scene.
+    void Clear();
+
+    /// Return cluster size.
+    float GetClusterSize() const { return clusterSize_; }
+
+    /// Return whether builds automatically after scene load.
+    bool GetBuildOnLoad() const { return buildOnLoad_; }
+
+    /// Return whether the batches have been built.
+    bool IsBuilt() const { return !batchNodes_.Empty(); }
+
+    /// Return number of source models merged.
+    unsigned GetNumSourceModels() const { return sourceModels_.Size(); }
+
+    /// Return number of source draw calls (geometries) merged.
+    unsigned GetNumSourceBatches() const { return numSourceBatches_; }
+
+    /// Return number of clusters created.
+    unsigned GetNumClusters() const { return batchNodes_.Size(); }
+
+    /// Return number of draw calls (geometries) in the clusters.
+    unsigned GetNumBatches() const { return numBatches_; }
+
+protected:
+    /// Handle scene node being assigned at creation.
+    void OnNodeSet(Node* node) override;
+
+private:
+    /// Source models that have been disabled.
+    Vector<WeakPtr<StaticModel> > sourceModels_;
+    /// Scene nodes of the merged clusters.
+    Vector<WeakPtr<Node> > batchNodes_;
+    /// Cluster size.
+    float clusterSize_{DEFAULT_STATIC_BATCH_CLUSTER_SIZE};
+    /// Number of source draw calls.
+    unsigned numSourceBatches_{};
+    /// Number of draw calls after merging.
+    unsigned numBatches_{};
+    /// Build on load flag.
+    bool buildOnLoad_{};
+};
+
+}
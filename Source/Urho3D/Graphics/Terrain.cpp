@@ -24,8 +24,12 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Camera.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../Graphics/Geometry.h"
+#include "../Graphics/GraphicsEvents.h"
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Octree.h"
@@ -48,7 +52,8 @@ extern const char* GEOMETRY_CATEGORY;
 
 static const Vector3 DEFAULT_SPACING(1.0f, 0.25f, 1.0f);
 static const unsigned MIN_LOD_LEVELS = 1;
-static const unsigned MAX_LOD_LEVELS = 4;
+static const unsigned MAX_LOD_LEVELS = 6;
+static const unsigned DEFAULT_LOD_LEVELS = 4;
 static const int DEFAULT_PATCH_SIZE = 32;
 static const int MIN_PATCH_SIZE = 4;
 static const int MAX_PATCH_SIZE = 128;
@@ -56,6 +61,38 @@ static const unsigned STITCH_NORTH = 1;
 static const unsigned STITCH_SOUTH = 2;
 static const unsigned STITCH_WEST = 4;
 static const unsigned STITCH_EAST = 8;
+static const float STREAMING_RELEASE_FACTOR = 1.25f;
+
+/// CPU-side data of a terrain patch, built in worker threads before upload.
+struct TerrainPatchBuildData
+{
+    /// Patch.
+    TerrainPatch* patch_;
+    /// Whether to build vertex data. If false, only the bounding box and LOD errors are calculated.
+    bool createGeometry_;
+    /// Vertex buffer data.
+    SharedArrayPtr<unsigned char> vertexData_;
+    /// Positions for CPU-side raycasts and decals.
+    SharedArrayPtr<unsigned char> cpuVertexData_;
+    /// Positions for occlusion rendering.
+    SharedArrayPtr<unsigned char> occlusionVertexData_;
+    /// Local-space bounding box.
+    BoundingBox box_;
+};
+
+void BuildTerrainPatchWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* terrain = reinterpret_cast<Terrain*>(item->aux_);
+    auto* start = reinterpret_cast<TerrainPatchBuildData*>(item->start_);
+    auto* end = reinterpret_cast<TerrainPatchBuildData*>(item->end_);
+
+    while (start != end)
+    {
+        terrain->BuildPatchData(*start);
+        terrain->CalculateLodErrors(start->patch_);
+        ++start;
+    }
+}
 
 inline void GrowUpdateRegion(IntRect& updateRegion, int x, int y)
 {
@@ -90,7 +127,7 @@ Terrain::Terrain(Context* context) :
     patchSize_(DEFAULT_PATCH_SIZE),
     lastPatchSize_(0),
     numLodLevels_(1),
-    maxLodLevels_(MAX_LOD_LEVELS),
+    maxLodLevels_(DEFAULT_LOD_LEVELS),
     occlusionLodLevel_(M_MAX_UNSIGNED),
     smoothing_(false),
     visible_(true),
@@ -103,6 +140,7 @@ Terrain::Terrain(Context* context) :
     zoneMask_(DEFAULT_ZONEMASK),
     drawDistance_(0.0f),
     shadowDistance_(0.0f),
+    streamingDistance_(0.0f),
     lodBias_(1.0f),
     maxLights_(0),
     northID_(0),
@@ -132,13 +170,14 @@ void Terrain::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE_EX("East Neighbor NodeID", unsigned, eastID_, MarkNeighborsDirty, 0, AM_DEFAULT | AM_NODEID);
     URHO3D_ATTRIBUTE_EX("Vertex Spacing", Vector3, spacing_, MarkTerrainDirty, DEFAULT_SPACING, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Patch Size", GetPatchSize, SetPatchSizeAttr, int, DEFAULT_PATCH_SIZE, AM_DEFAULT);
-    URHO3D_ACCESSOR_ATTRIBUTE("Max LOD Levels", GetMaxLodLevels, SetMaxLodLevelsAttr, unsigned, MAX_LOD_LEVELS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max LOD Levels", GetMaxLodLevels, SetMaxLodLevelsAttr, unsigned, DEFAULT_LOD_LEVELS, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Smooth Height Map", bool, smoothing_, MarkTerrainDirty, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Is Occluder", IsOccluder, SetOccluder, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Can Be Occluded", IsOccludee, SetOccludee, bool, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Cast Shadows", GetCastShadows, SetCastShadows, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Streaming Distance", GetStreamingDistance, SetStreamingDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Max Lights", GetMaxLights, SetMaxLights, unsigned, 0, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("View Mask", GetViewMask, SetViewMask, unsigned, DEFAULT_VIEWMASK, AM_DEFAULT);
@@ -380,10 +419,49 @@ void Terrain::SetNeighbors(Terrain* north, Terrain* south, Terrain* west, Terrai
 void Terrain::SetDrawDistance(float distance)
 {
     drawDistance_ = distance;
+    float patchDrawDistance = GetPatchDrawDistance();
     for (unsigned i = 0; i < patches_.Size(); ++i)
     {
         if (patches_[i])
-            patches_[i]->SetDrawDistance(distance);
+            patches_[i]->SetDrawDistance(patchDrawDistance);
+    }
+
+    MarkNetworkUpdate();
+}
+
+void Terrain::SetStreamingDistance(float distance)
+{
+    distance = Max(distance, 0.0f);
+    if (distance == streamingDistance_)
+        return;
+
+    bool wasStreaming = streamingDistance_ > 0.0f;
+    streamingDistance_ = distance;
+
+    float patchDrawDistance = GetPatchDrawDistance();
+    for (unsigned i = 0; i < patches_.Size(); ++i)
+    {
+        if (patches_[i])
+            patches_[i]->SetDrawDistance(patchDrawDistance);
+    }
+
+    if (streamingDistance_ > 0.0f)
+    {
+        if (!wasStreaming)
+            SubscribeToEvent(E_BEGINVIEWUPDATE, URHO3D_HANDLER(Terrain, HandleBeginViewUpdate));
+    }
+    else if (wasStreaming)
+    {
+        UnsubscribeFromEvent(E_BEGINVIEWUPDATE);
+
+        // Recreate all vertex buffers that were streamed out
+        PODVector<TerrainPatch*> releasedPatches;
+        for (unsigned i = 0; i < patches_.Size(); ++i)
+        {
+            if (patches_[i] && !patches_[i]->IsResident())
+                releasedPatches.Push(patches_[i]);
+        }
+        BuildPatches(releasedPatches, PODVector<bool>(releasedPatches.Size(), true));
     }
 
     MarkNetworkUpdate();
@@ -652,109 +730,194 @@ void Terrain::CreatePatchGeometry(TerrainPatch* patch)
 {
     URHO3D_PROFILE(CreatePatchGeometry);
 
-    auto row = (unsigned)(patchSize_ + 1);
-    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
-    Geometry* geometry = patch->GetGeometry();
-    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
-    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
+    TerrainPatchBuildData data;
+    data.patch_ = patch;
+    data.createGeometry_ = true;
+    BuildPatchData(data);
+    UploadPatchData(data);
+}
+
+void Terrain::BuildPatches(const PODVector<TerrainPatch*>& patches, const PODVector<bool>& createGeometry)
+{
+    if (patches.Empty())
+        return;
+
+    URHO3D_PROFILE(BuildPatches);
+
+    Vector<TerrainPatchBuildData> buildData(patches.Size());
+    for (unsigned i = 0; i < patches.Size(); ++i)
+    {
+        buildData[i].patch_ = patches[i];
+        buildData[i].createGeometry_ = createGeometry[i];
+    }
+
+    // Divide the patches among worker threads. The work queue completes the items in the main thread if there are no workers
+    auto* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = queue ? queue->GetNumThreads() + 1 : 1;
+    unsigned patchesPerItem = Max(buildData.Size() / numWorkItems, 1U);
+
+    if (queue && buildData.Size() > 1)
+    {
+        TerrainPatchBuildData* start = &buildData[0];
+        TerrainPatchBuildData* end = start + buildData.Size();
+
+        for (unsigned i = 0; i < numWorkItems && start != end; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = BuildTerrainPatchWork;
+            item->aux_ = this;
+            item->start_ = start;
+            item->end_ = (i < numWorkItems - 1 && (unsigned)(end - start) > patchesPerItem) ? start + patchesPerItem : end;
+            queue->AddWorkItem(item);
+
+            start = reinterpret_cast<TerrainPatchBuildData*>(item->end_);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < buildData.Size(); ++i)
+        {
+            BuildPatchData(buildData[i]);
+            CalculateLodErrors(buildData[i].patch_);
+        }
+    }
+
+    // Upload in the main thread
+    for (unsigned i = 0; i < buildData.Size(); ++i)
+        UploadPatchData(buildData[i]);
+}
+
+void Terrain::BuildPatchData(TerrainPatchBuildData& data) const
+{
+    const IntVector2& coords = data.patch_->GetCoordinates();
+    BoundingBox& box = data.box_;
+    box.Clear();
 
-    if (vertexBuffer->GetVertexCount() != row * row)
-        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+    auto row = (unsigned)(patchSize_ + 1);
+    // Position, normal, texture coordinate and tangent
+    const unsigned vertexFloats = 3 + 3 + 2 + 4;
 
-    SharedArrayPtr<unsigned char> cpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
-    SharedArrayPtr<unsigned char> occlusionCpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
+    // The CPU-side positions are always built, as raycasts, occlusion and navigation geometry collection use them.
+    // Only the vertex buffer data is streamed
+    if (data.createGeometry_)
+        data.vertexData_ = new unsigned char[row * row * vertexFloats * sizeof(float)];
+    data.cpuVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
+    data.occlusionVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
 
-    auto* vertexData = (float*)vertexBuffer->Lock(0, vertexBuffer->GetVertexCount());
-    auto* positionData = (float*)cpuVertexData.Get();
-    auto* occlusionData = (float*)occlusionCpuVertexData.Get();
-    BoundingBox box;
+    auto* vertexData = (float*)data.vertexData_.Get();
+    auto* positionData = (float*)data.cpuVertexData_.Get();
+    auto* occlusionData = (float*)data.occlusionVertexData_.Get();
 
     unsigned occlusionLevel = occlusionLodLevel_;
     if (occlusionLevel > numLodLevels_ - 1)
         occlusionLevel = numLodLevels_ - 1;
 
-    if (vertexData)
-    {
-        const IntVector2& coords = patch->GetCoordinates();
-        int lodExpand = (1 << (occlusionLevel)) - 1;
-        int halfLodExpand = (1 << (occlusionLevel)) / 2;
+    int lodExpand = (1 << (occlusionLevel)) - 1;
+    int halfLodExpand = (1 << (occlusionLevel)) / 2;
 
-        for (int z = 0; z <= patchSize_; ++z)
+    for (int z = 0; z <= patchSize_; ++z)
+    {
+        for (int x = 0; x <= patchSize_; ++x)
         {
-            for (int x = 0; x <= patchSize_; ++x)
+            int xPos = coords.x_ * patchSize_ + x;
+            int zPos = coords.y_ * patchSize_ + z;
+
+            // Position
+            Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
+            *positionData++ = position.x_;
+            *positionData++ = position.y_;
+            *positionData++ = position.z_;
+
+            box.Merge(position);
+
+            // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
+            // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
+            float minHeight = position.y_;
+            if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
             {
-                int xPos = coords.x_ * patchSize_ + x;
-                int zPos = coords.y_ * patchSize_ + z;
-
-                // Position
-                Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
-                *vertexData++ = position.x_;
-                *vertexData++ = position.y_;
-                *vertexData++ = position.z_;
-                *positionData++ = position.x_;
-                *positionData++ = position.y_;
-                *positionData++ = position.z_;
-
-                box.Merge(position);
-
-                // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
-                // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
-                float minHeight = position.y_;
-                if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
+                int minX = Max(xPos - halfLodExpand, 0);
+                int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
+                int minZ = Max(zPos - halfLodExpand, 0);
+                int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
+                for (int nZ = minZ; nZ <= maxZ; ++nZ)
                 {
-                    int minX = Max(xPos - halfLodExpand, 0);
-                    int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
-                    int minZ = Max(zPos - halfLodExpand, 0);
-                    int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
-                    for (int nZ = minZ; nZ <= maxZ; ++nZ)
-                    {
-                        for (int nX = minX; nX <= maxX; ++nX)
-                            minHeight = Min(minHeight, GetRawHeight(nX, nZ));
-                    }
+                    for (int nX = minX; nX <= maxX; ++nX)
+                        minHeight = Min(minHeight, GetRawHeight(nX, nZ));
                 }
-                *occlusionData++ = position.x_;
-                *occlusionData++ = minHeight;
-                *occlusionData++ = position.z_;
-
-                // Normal
-                Vector3 normal = GetRawNormal(xPos, zPos);
-                *vertexData++ = normal.x_;
-                *vertexData++ = normal.y_;
-                *vertexData++ = normal.z_;
-
-                // Texture coordinate
-                Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
-                *vertexData++ = texCoord.x_;
-                *vertexData++ = texCoord.y_;
-
-                // Tangent
-                Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
-                *vertexData++ = xyz.x_;
-                *vertexData++ = xyz.y_;
-                *vertexData++ = xyz.z_;
-                *vertexData++ = 1.0f;
             }
+            *occlusionData++ = position.x_;
+            *occlusionData++ = minHeight;
+            *occlusionData++ = position.z_;
+
+            if (!vertexData)
+                continue;
+
+            *vertexData++ = position.x_;
+            *vertexData++ = position.y_;
+            *vertexData++ = position.z_;
+
+            // Normal
+            Vector3 normal = GetRawNormal(xPos, zPos);
+            *vertexData++ = normal.x_;
+            *vertexData++ = normal.y_;
+            *vertexData++ = normal.z_;
+
+            // Texture coordinate
+            Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
+            *vertexData++ = texCoord.x_;
+            *vertexData++ = texCoord.y_;
+
+            // Tangent
+            Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
+            *vertexData++ = xyz.x_;
+            *vertexData++ = xyz.y_;
+            *vertexData++ = xyz.z_;
+            *vertexData++ = 1.0f;
         }
+    }
+}
+
+void Terrain::UploadPatchData(TerrainPatchBuildData& data)
+{
+    TerrainPatch* patch = data.patch_;
+    patch->SetBoundingBox(data.box_);
 
-        vertexBuffer->Unlock();
+    auto row = (unsigned)(patchSize_ + 1);
+    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
+    Geometry* geometry = patch->GetGeometry();
+    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
+    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
+
+    if (data.createGeometry_)
+    {
+        if (vertexBuffer->GetVertexCount() != row * row)
+            vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+
+        vertexBuffer->SetData(data.vertexData_.Get());
         vertexBuffer->ClearDataLost();
     }
-
-    patch->SetBoundingBox(box);
+    else
+        patch->ReleaseVertexBuffer();
 
     if (drawRanges_.Size())
     {
+        unsigned occlusionLevel = occlusionLodLevel_;
+        if (occlusionLevel > numLodLevels_ - 1)
+            occlusionLevel = numLodLevels_ - 1;
         unsigned occlusionDrawRange = occlusionLevel << 4;
 
         geometry->SetIndexBuffer(indexBuffer_);
         geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
-        geometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
+        geometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
         maxLodGeometry->SetIndexBuffer(indexBuffer_);
         maxLodGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
-        maxLodGeometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
+        maxLodGeometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
         occlusionGeometry->SetIndexBuffer(indexBuffer_);
         occlusionGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[occlusionDrawRange].first_, drawRanges_[occlusionDrawRange].second_, false);
-        occlusionGeometry->SetRawVertexData(occlusionCpuVertexData, MASK_POSITION);
+        occlusionGeometry->SetRawVertexData(data.occlusionVertexData_, MASK_POSITION);
     }
 
     patch->ResetLod();
@@ -762,6 +925,10 @@ void Terrain::CreatePatchGeometry(TerrainPatch* patch)
 
 void Terrain::UpdatePatchLod(TerrainPatch* patch)
 {
+    // Streamed out patches are not rendered
+    if (!patch->IsResident())
+        return;
+
     Geometry* geometry = patch->GetGeometry();
 
     // All LOD levels except the coarsest have 16 versions for stitching
@@ -1054,7 +1221,7 @@ void Terrain::CreateGeometry()
                         // Copy initial drawable parameters
                         patch->SetEnabled(enabled);
                         patch->SetMaterial(material_);
-                        patch->SetDrawDistance(drawDistance_);
+                        patch->SetDrawDistance(GetPatchDrawDistance());
                         patch->SetShadowDistance(shadowDistance_);
                         patch->SetLodBias(lodBias_);
                         patch->SetViewMask(viewMask_);
@@ -1109,20 +1276,29 @@ void Terrain::CreateGeometry()
             }
         }
 
+        // When streaming, only patches that already had a vertex buffer get one now. The rest are created on demand
+        PODVector<TerrainPatch*> buildPatches;
+        PODVector<bool> createGeometry;
         for (unsigned i = 0; i < patches_.Size(); ++i)
         {
             TerrainPatch* patch = patches_[i];
 
             if (dirtyPatches[i])
             {
-                CreatePatchGeometry(patch);
-                CalculateLodErrors(patch);
+                buildPatches.Push(patch);
+                createGeometry.Push(streamingDistance_ <= 0.0f || (!updateAll && patch->IsResident()));
             }
 
             SetPatchNeighbors(patch);
         }
+
+        BuildPatches(buildPatches, createGeometry);
     }
 
+    patchStreamFrames_.Resize(patches_.Size());
+    for (unsigned i = 0; i < patchStreamFrames_.Size(); ++i)
+        patchStreamFrames_[i] = 0;
+
     // Send event only if new geometry was generated, or the old was cleared
     if (patches_.Size() || prevNumPatches)
     {
@@ -1404,6 +1580,63 @@ void Terrain::CalculateLodErrors(TerrainPatch* patch)
     }
 }
 
+void Terrain::UpdateStreaming(Camera* camera)
+{
+    URHO3D_PROFILE(UpdateTerrainStreaming);
+
+    unsigned frameNumber = GetSubsystem<Time>()->GetFrameNumber();
+    PODVector<TerrainPatch*> createPatches;
+    PODVector<TerrainPatch*> releasePatches;
+
+    for (unsigned i = 0; i < patches_.Size(); ++i)
+    {
+        TerrainPatch* patch = patches_[i];
+        if (!patch)
+            continue;
+
+        // Use the same distance as draw distance culling, so that any patch passing the culling has geometry
+        float distance = camera->GetDistance(patch->GetWorldBoundingBox().Center());
+        if (distance <= streamingDistance_)
+        {
+            patchStreamFrames_[i] = frameNumber;
+            if (!patch->IsResident())
+                createPatches.Push(patch);
+        }
+        // Release with some hysteresis, and only if no view has needed the patch during this or the previous frame
+        else if (patch->IsResident() && distance > streamingDistance_ * STREAMING_RELEASE_FACTOR &&
+            patchStreamFrames_[i] + 1 < frameNumber)
+            releasePatches.Push(patch);
+    }
+
+    BuildPatches(createPatches, PODVector<bool>(createPatches.Size(), true));
+
+    for (unsigned i = 0; i < releasePatches.Size(); ++i)
+    {
+        releasePatches[i]->ReleaseVertexBuffer();
+        releasePatches[i]->ResetLod();
+    }
+}
+
+float Terrain::GetPatchDrawDistance() const
+{
+    if (streamingDistance_ <= 0.0f)
+        return drawDistance_;
+    else
+        return drawDistance_ > 0.0f ? Min(drawDistance_, streamingDistance_) : streamingDistance_;
+}
+
+unsigned Terrain::GetNumResidentPatches() const
+{
+    unsigned numResident = 0;
+    for (unsigned i = 0; i < patches_.Size(); ++i)
+    {
+        if (patches_[i] && patches_[i]->IsResident())
+            ++numResident;
+    }
+
+    return numResident;
+}
+
 void Terrain::SetPatchNeighbors(TerrainPatch* patch)
 {
     if (!patch)
@@ -1443,6 +1676,18 @@ void Terrain::HandleHeightMapReloadFinished(StringHash /*eventType*/, VariantMap
     CreateGeometry();
 }
 
+void Terrain::HandleBeginViewUpdate(StringHash /*eventType*/, VariantMap& eventData)
+{
+    using namespace BeginViewUpdate;
+
+    if (streamingDistance_ <= 0.0f || !IsEnabledEffective() || eventData[P_SCENE].GetPtr() != GetScene())
+        return;
+
+    auto* camera = static_cast<Camera*>(eventData[P_CAMERA].GetPtr());
+    if (camera)
+        UpdateStreaming(camera);
+}
+
 void Terrain::HandleNeighborTerrainCreated(StringHash /*eventType*/, VariantMap& eventData)
 {
     UpdateEdgePatchNeighbors();
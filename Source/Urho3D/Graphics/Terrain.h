@@ -28,17 +28,22 @@
 namespace Urho3D
 {
 
+class Camera;
 class Image;
 class IndexBuffer;
 class Material;
 class Node;
 class TerrainPatch;
+struct TerrainPatchBuildData;
+struct WorkItem;
 
 /// Heightmap terrain component.
 class URHO3D_API Terrain : public Component
 {
     URHO3D_OBJECT(Terrain, Component);
 
+    friend void BuildTerrainPatchWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     explicit Terrain(Context* context);
@@ -56,7 +61,7 @@ public:
     void SetPatchSize(int size);
     /// Set vertex (XZ) and height (Y) spacing.
     void SetSpacing(const Vector3& spacing);
-    /// Set maximum number of LOD levels for terrain patches. This can be between 1-4.
+    /// Set maximum number of LOD levels for terrain patches. This can be between 1-6, limited by the patch size.
     void SetMaxLodLevels(unsigned levels);
     /// Set LOD level used for terrain patch occlusion. By default (M_MAX_UNSIGNED) the coarsest. Since the LOD level used needs to be fixed, using finer LOD levels may result in false positive occlusion in cases where the actual rendered geometry is coarser, so use with caution.
     void SetOcclusionLodLevel(unsigned level);
@@ -78,6 +83,8 @@ public:
     void SetNeighbors(Terrain* north, Terrain* south, Terrain* west, Terrain* east);
     /// Set draw distance for patches.
     void SetDrawDistance(float distance);
+    /// Set distance from the camera within which patch vertex buffers are kept. Patches are also not drawn beyond it. CPU-side positions used for raycasts, occlusion and navigation are always kept. 0 (default) keeps all vertex buffers.
+    void SetStreamingDistance(float distance);
     /// Set shadow draw distance for patches.
     void SetShadowDistance(float distance);
     /// Set LOD bias for patches. Affects which terrain LOD to display.
@@ -113,7 +120,7 @@ public:
     /// Return heightmap size in patches.
     const IntVector2& GetNumPatches() const { return numPatches_; }
 
-    /// Return maximum number of LOD levels for terrain patches. This can be between 1-4.
+    /// Return maximum number of LOD levels for terrain patches. This can be between 1-6.
     unsigned GetMaxLodLevels() const { return maxLodLevels_; }
 
     /// Return LOD level used for occlusion.
@@ -162,6 +169,12 @@ public:
     /// Return shadow draw distance.
     float GetShadowDistance() const { return shadowDistance_; }
 
+    /// Return geometry streaming distance.
+    float GetStreamingDistance() const { return streamingDistance_; }
+
+    /// Return number of patches with vertex buffer data.
+    unsigned GetNumResidentPatches() const;
+
     /// Return LOD bias.
     float GetLodBias() const { return lodBias_; }
 
@@ -216,6 +229,16 @@ private:
     void CreateGeometry();
     /// Create index data shared by all patches.
     void CreateIndexData();
+    /// Build patch geometry, bounding boxes and LOD errors, using worker threads if available. Patches whose geometry is not requested are released.
+    void BuildPatches(const PODVector<TerrainPatch*>& patches, const PODVector<bool>& createGeometry);
+    /// Calculate patch vertex data and bounding box. Called from a worker thread.
+    void BuildPatchData(TerrainPatchBuildData& data) const;
+    /// Upload built patch data to the patch.
+    void UploadPatchData(TerrainPatchBuildData& data);
+    /// Create and release patch geometry according to distance from a camera.
+    void UpdateStreaming(Camera* camera);
+    /// Return the draw distance applied to the patches.
+    float GetPatchDrawDistance() const;
     /// Return an uninterpolated terrain height value, clamping to edges.
     float GetRawHeight(int x, int z) const;
     /// Return a source terrain height value, clamping to edges. The source data is used for smoothing.
@@ -232,6 +255,8 @@ private:
     bool SetHeightMapInternal(Image* image, bool recreateNow);
     /// Handle heightmap image reload finished.
     void HandleHeightMapReloadFinished(StringHash eventType, VariantMap& eventData);
+    /// Handle beginning of a view update. Stream patch geometry for the view's camera.
+    void HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle neighbor terrain geometry being created. Update the edge patch neighbors as necessary.
     void HandleNeighborTerrainCreated(StringHash eventType, VariantMap& eventData);
     /// Update edge patch neighbors when neighbor terrain(s) change or are recreated.
@@ -309,6 +334,10 @@ private:
     float drawDistance_;
     /// Shadow distance.
     float shadowDistance_;
+    /// Geometry streaming distance.
+    float streamingDistance_;
+    /// Frame number when each patch was last within the streaming distance of a view.
+    PODVector<unsigned> patchStreamFrames_;
     /// LOD bias.
     float lodBias_;
     /// Maximum lights.
@@ -125,6 +125,8 @@ void TerrainPatch::UpdateBatches(const FrameInfo& frame)
 
     batches_[0].distance_ = distance_;
     batches_[0].worldTransform_ = &worldTransform;
+    // Nothing is rendered when the vertex buffer has been streamed out, in case the patch is still found visible
+    batches_[0].geometry_ = IsResident() ? geometry_.Get() : nullptr;
 
     unsigned newLodLevel = 0;
     for (unsigned i = 0; i < lodErrors_.Size(); ++i)
@@ -245,6 +247,11 @@ void TerrainPatch::ResetLod()
     lodLevel_ = 0;
 }
 
+void TerrainPatch::ReleaseVertexBuffer()
+{
+    vertexBuffer_->SetSize(0, vertexBuffer_->GetElementMask());
+}
+
 Geometry* TerrainPatch::GetGeometry() const
 {
     return geometry_;
@@ -270,6 +277,11 @@ Terrain* TerrainPatch::GetOwner() const
     return owner_;
 }
 
+bool TerrainPatch::IsResident() const
+{
+    return vertexBuffer_->GetVertexCount() != 0;
+}
+
 void TerrainPatch::OnWorldBoundingBoxUpdate()
 {
     worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
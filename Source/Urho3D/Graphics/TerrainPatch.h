@@ -73,6 +73,8 @@ public:
     void SetCoordinates(const IntVector2& coordinates);
     /// Reset to LOD level 0.
     void ResetLod();
+    /// Release the vertex buffer data, keeping the CPU-side geometry, bounding box and LOD errors. Used when streaming terrain geometry.
+    void ReleaseVertexBuffer();
 
     /// Return visible geometry.
     Geometry* GetGeometry() const;
@@ -84,6 +86,8 @@ public:
     VertexBuffer* GetVertexBuffer() const;
     /// Return owner terrain.
     Terrain* GetOwner() const;
+    /// Return whether the vertex buffer data exists.
+    bool IsResident() const;
 
     /// Return north neighbor patch.
     TerrainPatch* GetNorthPatch() const { return north_; }
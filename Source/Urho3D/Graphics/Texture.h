@@ -68,6 +68,8 @@ public:
     void SetBackupTexture(Texture* texture);
     /// Set mip levels to skip on a quality setting when loading. Ensures higher quality levels do not skip more.
     void SetMipsToSkip(int quality, int toSkip);
+    /// Set additional mip levels to skip when loading from an image, used by texture streaming. Takes effect on the next SetData() from an image.
+    void SetStreamingMipsToSkip(unsigned toSkip) { streamingMipsToSkip_ = toSkip; }
 
     /// Return API-specific texture format.
     unsigned GetFormat() const { return format_; }
@@ -122,6 +124,8 @@ public:
 
     /// Return mip levels to skip on a quality setting when loading.
     int GetMipsToSkip(int quality) const;
+    /// Return additional mip levels skipped by texture streaming.
+    unsigned GetStreamingMipsToSkip() const { return streamingMipsToSkip_; }
     /// Return mip level width, or 0 if level does not exist.
     int GetLevelWidth(unsigned level) const;
     /// Return mip level width, or 0 if level does not exist.
@@ -229,6 +233,8 @@ protected:
     unsigned anisotropy_{};
     /// Mip levels to skip when loading per texture quality setting.
     unsigned mipsToSkip_[MAX_TEXTURE_QUALITY_LEVELS]{2, 1, 0};
+    /// Additional mip levels to skip when loading, controlled by texture streaming.
+    unsigned streamingMipsToSkip_{};
     /// Border color.
     Color borderColor_;
     /// Multisampling level.
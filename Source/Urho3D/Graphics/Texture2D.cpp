@@ -29,6 +29,7 @@
 #include "../Graphics/GraphicsImpl.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture2D.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
@@ -101,6 +102,12 @@ bool Texture2D::EndLoad()
     CheckTextureBudget(GetTypeStatic());
 
     SetParameters(loadParameters_);
+
+    // If streaming, the streamer decides the mip levels to load
+    auto* renderer = GetSubsystem<Renderer>();
+    if (renderer && renderer->GetTextureStreamer())
+        renderer->GetTextureStreamer()->AddTexture(this, loadImage_);
+
     bool success = SetData(loadImage_);
 
     loadImage_.Reset();
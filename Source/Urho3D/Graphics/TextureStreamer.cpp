@@ -0,0 +1,314 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Renderer.h"
+#include "../Graphics/Texture2D.h"
+#include "../Graphics/TextureStreamer.h"
+#include "../IO/File.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+#include "../Resource/ResourceCache.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Smallest texture size that streaming will drop mip levels to.
+static const int MIN_STREAMING_SIZE = 64;
+
+static void LoadTextureWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    auto* load = reinterpret_cast<TextureStreamingLoad*>(item->aux_);
+    auto* cache = load->image_->GetSubsystem<ResourceCache>();
+
+    SharedPtr<File> file = cache->GetFile(load->name_, false);
+    if (file && load->image_->BeginLoad(*file))
+    {
+        load->image_->PrecalculateLevels();
+        load->success_ = true;
+    }
+}
+
+static bool CompareStreamingPriority(StreamingTexture* lhs, StreamingTexture* rhs)
+{
+    return lhs->priority_ < rhs->priority_;
+}
+
+TextureStreamer::TextureStreamer(Context* context) :
+    Object(context)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+
+    for (unsigned i = 0; i < pendingLoads_.Size(); ++i)
+    {
+        WorkItem* item = pendingLoads_[i]->item_;
+        if (!queue || !queue->RemoveWorkItem(pendingLoads_[i]->item_))
+        {
+            while (!item->completed_)
+                Time::Sleep(0);
+        }
+    }
+
+    // Further loads of the textures use only the quality setting
+    for (HashMap<Texture2D*, StreamingTexture>::Iterator i = textures_.Begin(); i != textures_.End(); ++i)
+    {
+        if (i->second_.texture_)
+            i->second_.texture_->SetStreamingMipsToSkip(0);
+    }
+}
+
+void TextureStreamer::SetBudget(unsigned long long budget)
+{
+    budget_ = budget;
+}
+
+void TextureStreamer::AddTexture(Texture2D* texture, Image* image)
+{
+    if (!texture || !image)
+        return;
+
+    auto* renderer = GetSubsystem<Renderer>();
+    unsigned qualitySkip = (unsigned)texture->GetMipsToSkip(renderer ? renderer->GetTextureQuality() : QUALITY_HIGH);
+    int width = image->GetWidth();
+    int height = image->GetHeight();
+
+    unsigned levels;
+    if (image->IsCompressed())
+        levels = image->GetNumCompressedLevels();
+    else
+    {
+        levels = 1;
+        for (int size = Max(width, height); size > 1; size >>= 1)
+            ++levels;
+    }
+
+    StreamingTexture& entry = textures_[texture];
+    if (entry.texture_.Get() != texture)
+    {
+        entry = StreamingTexture();
+        entry.texture_ = texture;
+        entry.currentSkip_ = initialMipsToSkip_;
+    }
+
+    entry.fullWidth_ = Max(width >> qualitySkip, 1);
+    entry.fullHeight_ = Max(height >> qualitySkip, 1);
+    entry.maxSkip_ = 0;
+    while (qualitySkip + entry.maxSkip_ + 1 < levels && (Min(width, height) >> (qualitySkip + entry.maxSkip_ + 1)) >= MIN_STREAMING_SIZE)
+        ++entry.maxSkip_;
+    entry.currentSkip_ = Min(entry.currentSkip_, entry.maxSkip_);
+
+    texture->SetStreamingMipsToSkip(entry.currentSkip_);
+}
+
+void TextureStreamer::RequestTexture(Texture2D* texture, float screenSize)
+{
+    HashMap<Texture2D*, StreamingTexture>::Iterator i = textures_.Find(texture);
+    if (i == textures_.End())
+        return;
+
+    StreamingTexture& entry = i->second_;
+    int fullSize = Max(entry.fullWidth_, entry.fullHeight_);
+    unsigned skip = 0;
+    while (skip < entry.maxSkip_ && (float)(fullSize >> (skip + 1)) >= screenSize)
+        ++skip;
+
+    entry.requestedSkip_ = Min(entry.requestedSkip_, skip);
+    entry.priority_ = Max(entry.priority_, screenSize);
+    entry.lastRequestFrame_ = frameNumber_;
+    entry.requested_ = true;
+}
+
+void TextureStreamer::Update(unsigned frameNumber)
+{
+    URHO3D_PROFILE(UpdateTextureStreaming);
+
+    ApplyLoads();
+
+    PODVector<StreamingTexture*> entries;
+    unsigned long long memoryUse = 0;
+
+    for (HashMap<Texture2D*, StreamingTexture>::Iterator i = textures_.Begin(); i != textures_.End();)
+    {
+        StreamingTexture& entry = i->second_;
+        Texture2D* texture = entry.texture_;
+        // Texture may have been freed, or its address reused by a texture that is not streamed
+        if (!texture || texture != i->first_)
+        {
+            i = textures_.Erase(i);
+            continue;
+        }
+
+        entry.fullMemory_ = (unsigned long long)texture->GetMemoryUse() << (2 * entry.currentSkip_);
+        if (!entry.requested_)
+        {
+            memoryUse += texture->GetMemoryUse();
+            ++i;
+            continue;
+        }
+
+        // Keep the current levels if one level too many is resident to avoid reloading on small distance changes
+        if (entry.requestedSkip_ != M_MAX_UNSIGNED)
+            entry.targetSkip_ = entry.requestedSkip_ == entry.currentSkip_ + 1 ? entry.currentSkip_ : entry.requestedSkip_;
+        else if (frameNumber - entry.lastRequestFrame_ > evictFrames_)
+            entry.targetSkip_ = entry.maxSkip_;
+        else
+            entry.targetSkip_ = entry.currentSkip_;
+
+        memoryUse += entry.fullMemory_ >> (2 * entry.targetSkip_);
+        entries.Push(&entry);
+        ++i;
+    }
+
+    // Enforce the budget by dropping one level at a time from the least important textures first
+    Sort(entries.Begin(), entries.End(), CompareStreamingPriority);
+    bool reduced = true;
+    while (memoryUse > budget_ && reduced)
+    {
+        reduced = false;
+        for (unsigned i = 0; i < entries.Size() && memoryUse > budget_; ++i)
+        {
+            StreamingTexture& entry = *entries[i];
+            if (entry.targetSkip_ < entry.maxSkip_)
+            {
+                unsigned long long oldMemory = entry.fullMemory_ >> (2 * entry.targetSkip_);
+                ++entry.targetSkip_;
+                memoryUse -= oldMemory - (entry.fullMemory_ >> (2 * entry.targetSkip_));
+                reduced = true;
+            }
+        }
+    }
+
+    // Start loads, downgrades first to free memory, then upgrades of the most important textures
+    for (unsigned i = 0; i < entries.Size() && pendingLoads_.Size() < maxPendingLoads_; ++i)
+    {
+        StreamingTexture& entry = *entries[i];
+        if (!entry.loading_ && entry.targetSkip_ > entry.currentSkip_)
+            StartLoad(entry, entry.targetSkip_);
+    }
+    for (unsigned i = entries.Size() - 1; i < entries.Size() && pendingLoads_.Size() < maxPendingLoads_; --i)
+    {
+        StreamingTexture& entry = *entries[i];
+        if (!entry.loading_ && entry.targetSkip_ < entry.currentSkip_)
+            StartLoad(entry, entry.targetSkip_);
+    }
+
+    // Begin collecting requests for the new frame
+    for (unsigned i = 0; i < entries.Size(); ++i)
+    {
+        entries[i]->requestedSkip_ = M_MAX_UNSIGNED;
+        entries[i]->priority_ = 0.0f;
+    }
+
+    frameNumber_ = frameNumber;
+}
+
+unsigned TextureStreamer::GetNumFullResolution() const
+{
+    unsigned num = 0;
+    for (HashMap<Texture2D*, StreamingTexture>::ConstIterator i = textures_.Begin(); i != textures_.End(); ++i)
+    {
+        if (!i->second_.currentSkip_)
+            ++num;
+    }
+    return num;
+}
+
+unsigned long long TextureStreamer::GetMemoryUse() const
+{
+    unsigned long long memoryUse = 0;
+    for (HashMap<Texture2D*, StreamingTexture>::ConstIterator i = textures_.Begin(); i != textures_.End(); ++i)
+    {
+        if (i->second_.texture_)
+            memoryUse += i->second_.texture_->GetMemoryUse();
+    }
+    return memoryUse;
+}
+
+void TextureStreamer::ApplyLoads()
+{
+    for (unsigned i = pendingLoads_.Size() - 1; i < pendingLoads_.Size(); --i)
+    {
+        TextureStreamingLoad* load = pendingLoads_[i];
+        if (!load->item_->completed_)
+            continue;
+
+        Texture2D* texture = load->texture_;
+        if (texture)
+        {
+            HashMap<Texture2D*, StreamingTexture>::Iterator j = textures_.Find(texture);
+            if (j != textures_.End() && j->second_.texture_.Get() == texture)
+            {
+                StreamingTexture& entry = j->second_;
+                entry.loading_ = false;
+
+                texture->SetStreamingMipsToSkip(load->skip_);
+                if (load->success_ && texture->SetData(load->image_))
+                    entry.currentSkip_ = load->skip_;
+                else
+                {
+                    // Stop streaming the texture so that the load is not retried each frame
+                    URHO3D_LOGWARNING("Failed to stream texture " + load->name_ + ", keeping current mip levels");
+                    texture->SetStreamingMipsToSkip(entry.currentSkip_);
+                    textures_.Erase(j);
+                }
+            }
+        }
+
+        pendingLoads_.Erase(i);
+    }
+}
+
+void TextureStreamer::StartLoad(StreamingTexture& entry, unsigned skip)
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (!queue)
+        return;
+
+    SharedPtr<TextureStreamingLoad> load(new TextureStreamingLoad());
+    load->texture_ = entry.texture_;
+    load->name_ = entry.texture_->GetName();
+    load->skip_ = skip;
+    load->image_ = new Image(context_);
+
+    // Not taken from the pool so that completion can be polled on later frames. Low priority, so that the
+    // frame's own work is completed first
+    load->item_ = new WorkItem();
+    load->item_->workFunction_ = LoadTextureWork;
+    load->item_->aux_ = load.Get();
+    load->item_->priority_ = 0;
+    queue->AddWorkItem(load->item_);
+
+    entry.loading_ = true;
+    pendingLoads_.Push(load);
+}
+
+}
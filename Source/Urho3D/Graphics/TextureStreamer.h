@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+class Image;
+class Texture2D;
+struct WorkItem;
+
+/// Streaming state of one texture.
+struct StreamingTexture
+{
+    /// Texture.
+    WeakPtr<Texture2D> texture_;
+    /// Estimated memory use at full resolution.
+    unsigned long long fullMemory_{};
+    /// Width at full resolution.
+    int fullWidth_{};
+    /// Height at full resolution.
+    int fullHeight_{};
+    /// Currently resident mip levels skipped.
+    unsigned currentSkip_{};
+    /// Mip levels to skip requested by the views this frame.
+    unsigned requestedSkip_{M_MAX_UNSIGNED};
+    /// Mip levels to skip decided on this frame.
+    unsigned targetSkip_{};
+    /// Maximum mip levels that can be skipped.
+    unsigned maxSkip_{};
+    /// Largest screen size in pixels this frame, used as priority.
+    float priority_{};
+    /// Frame number of last request.
+    unsigned lastRequestFrame_{};
+    /// Whether a view has requested the texture. Textures used only outside views, for example in the UI, are not managed.
+    bool requested_{};
+    /// Whether a load is in progress.
+    bool loading_{};
+};
+
+/// Mip level reload processed in a worker thread.
+struct TextureStreamingLoad : public RefCounted
+{
+    /// Texture.
+    WeakPtr<Texture2D> texture_;
+    /// Resource name of the texture image.
+    String name_;
+    /// Mip levels to skip.
+    unsigned skip_{};
+    /// Image to load into.
+    SharedPtr<Image> image_;
+    /// Whether the image was loaded successfully.
+    bool success_{};
+    /// Work item.
+    SharedPtr<WorkItem> item_;
+};
+
+/// Texture streaming. Keeps only the mip levels that the views need resident, within a memory budget. Owned by Renderer when texture streaming is enabled.
+class URHO3D_API TextureStreamer : public Object
+{
+    URHO3D_OBJECT(TextureStreamer, Object);
+
+public:
+    /// Construct.
+    explicit TextureStreamer(Context* context);
+    /// Destruct. Wait for loads in progress.
+    ~TextureStreamer() override;
+
+    /// Set memory budget in bytes for streamed textures. Default 256 MB.
+    void SetBudget(unsigned long long budget);
+    /// Set mip levels to skip on the initial load, before a view has requested the texture. Also affects textures not drawn by views, such as UI textures. Default 0.
+    void SetInitialMipsToSkip(unsigned skip) { initialMipsToSkip_ = skip; }
+    /// Set maximum number of loads in progress at once. Default 4.
+    void SetMaxPendingLoads(unsigned loads) { maxPendingLoads_ = Max(loads, 1U); }
+    /// Set number of frames after which an unseen texture is dropped to its lowest resident level. Default 60.
+    void SetEvictFrames(unsigned frames) { evictFrames_ = frames; }
+
+    /// Register a texture for streaming and set the mip levels to skip when it is loaded from the image. Called by Texture2D.
+    void AddTexture(Texture2D* texture, Image* image);
+    /// Request mip levels for a texture drawn at a screen size in pixels. Called by View.
+    void RequestTexture(Texture2D* texture, float screenSize);
+    /// Apply finished loads, enforce the budget and start new loads. Called by Renderer at the start of the frame.
+    void Update(unsigned frameNumber);
+
+    /// Return memory budget in bytes.
+    unsigned long long GetBudget() const { return budget_; }
+    /// Return mip levels to skip on the initial load.
+    unsigned GetInitialMipsToSkip() const { return initialMipsToSkip_; }
+    /// Return maximum number of loads in progress at once.
+    unsigned GetMaxPendingLoads() const { return maxPendingLoads_; }
+    /// Return number of frames after which an unseen texture is dropped to its lowest resident level.
+    unsigned GetEvictFrames() const { return evictFrames_; }
+    /// Return number of streamed textures.
+    unsigned GetNumTextures() const { return textures_.Size(); }
+    /// Return number of streamed textures resident at full resolution.
+    unsigned GetNumFullResolution() const;
+    /// Return number of loads in progress.
+    unsigned GetNumPendingLoads() const { return pendingLoads_.Size(); }
+    /// Return estimated memory use of streamed textures in bytes.
+    unsigned long long GetMemoryUse() const;
+
+private:
+    /// Apply finished loads.
+    void ApplyLoads();
+    /// Start a load at a new mip level.
+    void StartLoad(StreamingTexture& entry, unsigned skip);
+
+    /// Streamed textures.
+    HashMap<Texture2D*, StreamingTexture> textures_;
+    /// Loads in progress.
+    Vector<SharedPtr<TextureStreamingLoad> > pendingLoads_;
+    /// Memory budget in bytes.
+    unsigned long long budget_{256 * 1024 * 1024};
+    /// Mip levels to skip on the initial load.
+    unsigned initialMipsToSkip_{};
+    /// Maximum number of loads in progress at once.
+    unsigned maxPendingLoads_{4};
+    /// Frames after which an unseen texture is evicted.
+    unsigned evictFrames_{60};
+    /// Current frame number.
+    unsigned frameNumber_{};
+};
+
+}
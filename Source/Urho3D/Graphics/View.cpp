@@ -30,6 +30,7 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsEvents.h"
 #include "../Graphics/GraphicsImpl.h"
+#include "../Graphics/LightClusters.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/OcclusionBuffer.h"
 #include "../Graphics/Octree.h"
@@ -42,6 +43,7 @@
 #include "../Graphics/Texture2DArray.h"
 #include "../Graphics/Texture3D.h"
 #include "../Graphics/TextureCube.h"
+#include "../Graphics/TextureStreamer.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../Graphics/View.h"
 #include "../IO/FileSystem.h"
@@ -157,6 +159,21 @@ public:
     OcclusionBuffer* buffer_;
 };
 
+/// Initial value of shadow map split hashes (64-bit FNV-1a offset basis.)
+static const unsigned long long SHADOW_HASH_BASIS = 14695981039346656037ULL;
+
+/// Combine data into a shadow map split hash, one 32-bit word at a time.
+static inline void CombineShadowHash(unsigned long long& hash, const void* data, unsigned size)
+{
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (unsigned i = 0; i + sizeof(unsigned) <= size; i += sizeof(unsigned))
+    {
+        unsigned word;
+        memcpy(&word, bytes + i, sizeof word);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+}
+
 void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
 {
     auto* view = reinterpret_cast<View*>(item->aux_);
@@ -290,6 +307,8 @@ View::View(Context* context) :
     sceneResults_.Resize(numThreads);
 }
 
+View::~View() = default;
+
 bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
 {
     sourceView_ = nullptr;
@@ -342,6 +361,7 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             deferred_ = sourceView_->deferred_;
             deferredAmbient_ = sourceView_->deferredAmbient_;
             useLitBase_ = sourceView_->useLitBase_;
+            clusteredLights_ = sourceView_->clusteredLights_;
             hasScenePasses_ = sourceView_->hasScenePasses_;
             noStencil_ = sourceView_->noStencil_;
             lightVolumeCommand_ = sourceView_->lightVolumeCommand_;
@@ -367,6 +387,7 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
     deferred_ = false;
     deferredAmbient_ = false;
     useLitBase_ = false;
+    clusteredLights_ = false;
     hasScenePasses_ = false;
     noStencil_ = false;
     lightVolumeCommand_ = nullptr;
@@ -397,6 +418,24 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
 #endif
 #endif
 
+#ifdef DESKTOP_GRAPHICS
+    // Check for clustered forward lighting, which needs to be known before setting up the scene pass shader defines.
+    // Light volumes take care of per-pixel lights in deferred rendering, so it is not used together with them
+    for (unsigned i = 0; i < renderPath_->commands_.Size(); ++i)
+    {
+        const RenderPathCommand& command = renderPath_->commands_[i];
+        if (!command.enabled_)
+            continue;
+        if (command.type_ == CMD_LIGHTVOLUMES)
+        {
+            clusteredLights_ = false;
+            break;
+        }
+        if (command.type_ == CMD_SCENEPASS && command.clusteredLights_)
+            clusteredLights_ = true;
+    }
+#endif
+
     // Make sure that all necessary batch queues exist
     for (unsigned i = 0; i < renderPath_->commands_.Size(); ++i)
     {
@@ -492,6 +531,10 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
         }
     }
 
+    // Clustered lights are applied in the base pass, so it must not be replaced by the litbase pass
+    if (clusteredLights_)
+        useLitBase_ = false;
+
     drawShadows_ = renderer_->GetDrawShadows();
     materialQuality_ = renderer_->GetMaterialQuality();
     maxOccluderTriangles_ = renderer_->GetMaxOccluderTriangles();
@@ -555,6 +598,8 @@ void View::Update(const FrameInfo& frame)
 
     GetDrawables();
     GetBatches();
+    if (cullCamera_ && renderer_->GetTextureStreamer())
+        RequestStreamingTextures(renderer_->GetTextureStreamer());
     renderer_->StorePreparedView(this, cullCamera_);
 
     SendViewEvent(E_ENDVIEWUPDATE);
@@ -747,6 +792,17 @@ void View::SetCameraShaderParameters(Camera* camera)
 
     graphics_->SetShaderParameter(VSP_VIEWPROJ, projection * camera->GetView());
 
+    // Light clusters are always looked up using the camera they were binned with
+    View* actualView = sourceView_ ? sourceView_ : this;
+    if (actualView->clusteredLights_ && actualView->lightClusters_)
+    {
+        LightClusters* clusters = actualView->lightClusters_;
+        graphics_->SetShaderParameter(VSP_CLUSTERVIEWPROJ, clusters->GetViewProj());
+        graphics_->SetShaderParameter(PSP_CLUSTERPARAMS, clusters->GetGridParameter());
+        graphics_->SetShaderParameter(PSP_CLUSTERDEPTH, clusters->GetDepthParameter());
+        graphics_->SetShaderParameter(PSP_CLUSTERTEXPARAMS, clusters->GetTextureParameter());
+    }
+
     // If in a scene pass and the command defines shader parameters, set them now
     if (passCommand_)
         SetCommandShaderParameters(*passCommand_);
@@ -964,6 +1020,13 @@ void View::GetBatches()
     ProcessLights();
     GetLightBatches();
     GetBaseBatches();
+
+    if (clusteredLights_)
+    {
+        if (!lightClusters_)
+            lightClusters_ = new LightClusters(context_);
+        lightClusters_->Update(cullCamera_, clusterLights_);
+    }
 }
 
 void View::ProcessLights()
@@ -1000,12 +1063,13 @@ void View::GetLightBatches()
     {
         URHO3D_PROFILE(GetLightBatches);
 
-        // Preallocate light queues: per-pixel lights which have lit geometries
+        // Preallocate light queues: per-pixel lights which have lit geometries, except those which go to light clusters
         unsigned numLightQueues = 0;
         unsigned usedLightQueues = 0;
+        clusterLights_.Clear();
         for (Vector<LightQueryResult>::ConstIterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
         {
-            if (!i->light_->GetPerVertex() && i->litGeometries_.Size())
+            if (!i->light_->GetPerVertex() && i->litGeometries_.Size() && !IsClusteredLight(*i))
                 ++numLightQueues;
         }
 
@@ -1023,8 +1087,14 @@ void View::GetLightBatches()
 
             Light* light = query.light_;
 
+            // Clustered light: will be binned after all lights have been processed
+            if (IsClusteredLight(query))
+            {
+                clusterLights_.Push(light);
+                light->SetLightQueue(nullptr);
+            }
             // Per-pixel light
-            if (!light->GetPerVertex())
+            else if (!light->GetPerVertex())
             {
                 unsigned shadowSplits = query.numSplits_;
 
@@ -1072,6 +1142,18 @@ void View::GetLightBatches()
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
                     FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
 
+                    // When shadow maps are cached, hash the shadow camera and casters to see whether the split has changed
+                    bool cacheSplit = renderer_->GetShadowMapCaching();
+                    unsigned long long splitHash = SHADOW_HASH_BASIS;
+                    if (cacheSplit)
+                    {
+                        const BiasParameters& bias = light->GetShadowBias();
+                        CombineShadowHash(splitHash, shadowCamera->GetView().Data(), sizeof(Matrix3x4));
+                        CombineShadowHash(splitHash, shadowCamera->GetProjection().Data(), sizeof(Matrix4));
+                        CombineShadowHash(splitHash, &shadowQueue.shadowViewport_, sizeof(IntRect));
+                        CombineShadowHash(splitHash, &bias, sizeof(BiasParameters));
+                    }
+
                     // Loop through shadow casters
                     for (PODVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
                          k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
@@ -1103,6 +1185,31 @@ void View::GetLightBatches()
                             if (!pass)
                                 continue;
 
+                            // Skinned or otherwise deforming casters can not be detected from their transforms, so always render
+                            if (cacheSplit)
+                            {
+                                if (srcBatch.geometryType_ == GEOM_SKINNED || drawable->GetUpdateGeometryType() != UPDATE_NONE)
+                                    cacheSplit = false;
+                                else
+                                {
+                                    const void* pointers[] = {drawable, srcBatch.geometry_, srcBatch.material_, pass};
+                                    CombineShadowHash(splitHash, pointers, sizeof pointers);
+                                    // Material parameters, textures and rasterizer state may change without replacing the material
+                                    if (srcBatch.material_)
+                                    {
+                                        const Material* material = srcBatch.material_;
+                                        const void* diffuse = material->GetTexture(TU_DIFFUSE);
+                                        unsigned state[] = {material->GetShaderParameterHash(), material->GetShadowCullMode(),
+                                            material->GetFillMode()};
+                                        CombineShadowHash(splitHash, &diffuse, sizeof diffuse);
+                                        CombineShadowHash(splitHash, state, sizeof state);
+                                        CombineShadowHash(splitHash, &material->GetDepthBias(), sizeof(BiasParameters));
+                                    }
+                                    CombineShadowHash(splitHash, srcBatch.worldTransform_,
+                                        srcBatch.numWorldTransforms_ * sizeof(Matrix3x4));
+                                }
+                            }
+
                             Batch destBatch(srcBatch);
                             destBatch.pass_ = pass;
                             destBatch.zone_ = nullptr;
@@ -1110,6 +1217,10 @@ void View::GetLightBatches()
                             AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
                         }
                     }
+
+                    shadowQueue.cacheHash_ = cacheSplit ? splitHash : 0;
+                    shadowQueue.cached_ = renderer_->CheckShadowMapCache(light, cullCamera_, lightQueue.shadowMap_, j,
+                        shadowQueue.cacheHash_);
                 }
 
                 // Process lit geometries
@@ -1269,6 +1380,39 @@ void View::GetBaseBatches()
     }
 }
 
+void View::RequestStreamingTextures(TextureStreamer* streamer)
+{
+    URHO3D_PROFILE(RequestStreamingTextures);
+
+    // Pixels per world unit at unit distance (perspective) or at any distance (orthographic)
+    float pixelScale = (float)viewSize_.y_ / (2.0f * cullCamera_->GetHalfViewSize());
+    bool orthographic = cullCamera_->IsOrthographic();
+
+    for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        const Vector3 size = drawable->GetWorldBoundingBox().Size();
+        float screenSize = (size.x_ + size.y_ + size.z_) * (1.0f / 3.0f) * pixelScale;
+        if (!orthographic)
+            screenSize /= Max(drawable->GetDistance(), M_EPSILON);
+
+        const Vector<SourceBatch>& batches = drawable->GetBatches();
+        for (unsigned j = 0; j < batches.Size(); ++j)
+        {
+            Material* material = batches[j].material_;
+            if (!material)
+                continue;
+
+            const HashMap<TextureUnit, SharedPtr<Texture> >& textures = material->GetTextures();
+            for (HashMap<TextureUnit, SharedPtr<Texture> >::ConstIterator k = textures.Begin(); k != textures.End(); ++k)
+            {
+                if (k->second_ && k->second_->GetType() == Texture2D::GetTypeStatic())
+                    streamer->RequestTexture(static_cast<Texture2D*>(k->second_.Get()), screenSize);
+            }
+        }
+    }
+}
+
 void View::UpdateGeometries()
 {
     // Update geometries in the source view if necessary (prepare order may differ from render order)
@@ -1579,6 +1723,10 @@ void View::ExecuteRenderPathCommands()
                         bool allowDepthWrite = SetTextures(command);
                         graphics_->SetClipPlane(camera_->GetUseClipping(), camera_->GetClipPlane(), camera_->GetView(),
                             camera_->GetGPUProjection());
+#ifdef DESKTOP_GRAPHICS
+                        if (command.clusteredLights_ && actualView->clusteredLights_ && actualView->lightClusters_)
+                            graphics_->SetTexture(TU_LIGHTBUFFER, actualView->lightClusters_->GetTexture());
+#endif
 
                         if (command.shaderParameters_.Size())
                         {
@@ -2285,6 +2433,7 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered
     PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
     query.litGeometries_.Clear();
+    query.limitedGeometries_ = false;
 
     switch (type)
     {
@@ -2301,11 +2450,7 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
             FrustumOctreeQuery octreeQuery(tempDrawables, light->GetFrustum(), DRAWABLE_GEOMETRY,
                 cullCamera_->GetViewMask());
             octree_->GetDrawables(octreeQuery);
-            for (unsigned i = 0; i < tempDrawables.Size(); ++i)
-            {
-                if (tempDrawables[i]->IsInView(frame_) && (GetLightMask(tempDrawables[i]) & lightMask))
-                    query.litGeometries_.Push(tempDrawables[i]);
-            }
+            GetLitGeometries(query, tempDrawables);
         }
         break;
 
@@ -2314,11 +2459,7 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
             SphereOctreeQuery octreeQuery(tempDrawables, Sphere(light->GetNode()->GetWorldPosition(), light->GetRange()),
                 DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
             octree_->GetDrawables(octreeQuery);
-            for (unsigned i = 0; i < tempDrawables.Size(); ++i)
-            {
-                if (tempDrawables[i]->IsInView(frame_) && (GetLightMask(tempDrawables[i]) & lightMask))
-                    query.litGeometries_.Push(tempDrawables[i]);
-            }
+            GetLitGeometries(query, tempDrawables);
         }
         break;
     }
@@ -2874,6 +3015,11 @@ void View::SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& com
 {
     String vsDefines = command.vertexShaderDefines_.Trimmed();
     String psDefines = command.pixelShaderDefines_.Trimmed();
+    if (clusteredLights_ && command.clusteredLights_)
+    {
+        vsDefines = (vsDefines + " CLUSTERED").Trimmed();
+        psDefines = (psDefines + " CLUSTERED").Trimmed();
+    }
     if (vsDefines.Length() || psDefines.Length())
     {
         queue.hasExtraDefines_ = true;
@@ -2992,6 +3138,40 @@ void View::PrepareInstancingBuffer()
     instancingBuffer->Unlock();
 }
 
+void View::GetLitGeometries(LightQueryResult& query, const PODVector<Drawable*>& drawables)
+{
+    unsigned lightMask = query.light_->GetLightMask();
+
+    for (unsigned i = 0; i < drawables.Size(); ++i)
+    {
+        Drawable* drawable = drawables[i];
+        if (!drawable->IsInView(frame_))
+            continue;
+
+        // Clustered lights can not be masked or limited per object, so remember if any geometry in range needs that
+        if (GetLightMask(drawable) & lightMask)
+        {
+            query.litGeometries_.Push(drawable);
+            if (drawable->GetMaxLights())
+                query.limitedGeometries_ = true;
+        }
+        else
+            query.limitedGeometries_ = true;
+    }
+}
+
+bool View::IsClusteredLight(const LightQueryResult& query) const
+{
+    if (!clusteredLights_)
+        return false;
+
+    // Directional, shadowed and negative lights, lights with custom ramp or shape textures, and lights that are masked
+    // from or limited by some of the geometries in range stay in the forward light loop
+    Light* light = query.light_;
+    return !light->GetPerVertex() && light->GetLightType() != LIGHT_DIRECTIONAL && !query.numSplits_ && !light->IsNegative() &&
+        !light->GetRampTexture() && !light->GetShapeTexture() && !query.limitedGeometries_;
+}
+
 void View::SetupLightVolumeBatch(Batch& batch)
 {
     Light* light = batch.lightQueue_->light_;
@@ -3044,8 +3224,18 @@ void View::SetupLightVolumeBatch(Batch& batch)
 bool View::NeedRenderShadowMap(const LightBatchQueue& queue)
 {
     // Must have a shadow map, and either forward or deferred lit batches
-    return queue.shadowMap_ && (!queue.litBatches_.IsEmpty() || !queue.litBaseBatches_.IsEmpty() ||
-        !queue.volumeBatches_.Empty());
+    if (!queue.shadowMap_ || (queue.litBatches_.IsEmpty() && queue.litBaseBatches_.IsEmpty() &&
+        queue.volumeBatches_.Empty()))
+        return false;
+
+    // Nothing to render if all splits are still valid in the shadow map cache
+    for (unsigned i = 0; i < queue.shadowSplits_.Size(); ++i)
+    {
+        if (!queue.shadowSplits_[i].cached_)
+            return true;
+    }
+
+    return false;
 }
 
 void View::RenderShadowMap(const LightBatchQueue& queue)
@@ -3062,6 +3252,15 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
     // Set shadow depth bias
     BiasParameters parameters = queue.light_->GetShadowBias();
 
+    // If some splits are valid in the shadow map cache, clear and render only the others
+    bool partialUpdate = false;
+    for (unsigned i = 0; i < queue.shadowSplits_.Size(); ++i)
+    {
+        if (queue.shadowSplits_[i].cached_)
+            partialUpdate = true;
+    }
+    unsigned clearFlags;
+
     // The shadow map is a depth stencil texture
     if (shadowMap->GetUsage() == TEXTURE_DEPTHSTENCIL)
     {
@@ -3071,8 +3270,7 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
         // Disable other render targets
         for (unsigned i = 1; i < MAX_RENDERTARGETS; ++i)
             graphics_->SetRenderTarget(i, (RenderSurface*) nullptr);
-        graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
-        graphics_->Clear(CLEAR_DEPTH);
+        clearFlags = CLEAR_DEPTH;
     }
     else // if the shadow map is a color rendertarget
     {
@@ -3083,16 +3281,29 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
             graphics_->SetRenderTarget(i, (RenderSurface*) nullptr);
         graphics_->SetDepthStencil(renderer_->GetDepthStencil(shadowMap->GetWidth(), shadowMap->GetHeight(),
             shadowMap->GetMultiSample(), shadowMap->GetAutoResolve()));
-        graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
-        graphics_->Clear(CLEAR_DEPTH | CLEAR_COLOR, Color::WHITE);
+        clearFlags = CLEAR_DEPTH | CLEAR_COLOR;
 
         parameters = BiasParameters(0.0f, 0.0f);
     }
 
+    if (!partialUpdate)
+    {
+        graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
+        graphics_->Clear(clearFlags, Color::WHITE);
+    }
+
     // Render each of the splits
     for (unsigned i = 0; i < queue.shadowSplits_.Size(); ++i)
     {
         const ShadowBatchQueue& shadowQueue = queue.shadowSplits_[i];
+        if (shadowQueue.cached_)
+            continue;
+
+        if (partialUpdate)
+        {
+            graphics_->SetViewport(shadowQueue.shadowViewport_);
+            graphics_->Clear(clearFlags, Color::WHITE);
+        }
 
         float multiplier = 1.0f;
         // For directional light cascade splits, adjust depth bias according to the far clip ratio of the splits
@@ -3119,6 +3330,8 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
             graphics_->SetViewport(shadowQueue.shadowViewport_);
             shadowQueue.shadowBatches_.Draw(this, shadowQueue.shadowCamera_, false, false, true);
         }
+
+        renderer_->StoreShadowMapCache(queue.light_, cullCamera_, shadowMap, i, shadowQueue.cacheHash_);
     }
 
     // Scale filter blur amount to shadow map viewport size so that different shadow map resolutions don't behave differently
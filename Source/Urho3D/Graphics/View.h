@@ -36,6 +36,7 @@ namespace Urho3D
 class Camera;
 class DebugRenderer;
 class Light;
+class LightClusters;
 class Drawable;
 class Graphics;
 class OcclusionBuffer;
@@ -46,6 +47,7 @@ class RenderSurface;
 class Technique;
 class Texture;
 class Texture2D;
+class TextureStreamer;
 class Viewport;
 class Zone;
 struct RenderPathCommand;
@@ -74,6 +76,8 @@ struct LightQueryResult
     float shadowFarSplits_[MAX_LIGHT_SPLITS];
     /// Shadow map split count.
     unsigned numSplits_;
+    /// Whether geometries in range are excluded by the light mask or limit their lights. Such lights are not clustered.
+    bool limitedGeometries_;
 };
 
 /// Scene render pass info.
@@ -118,7 +122,7 @@ public:
     /// Construct.
     explicit View(Context* context);
     /// Destruct.
-    ~View() override = default;
+    ~View() override;
 
     /// Define with rendertarget and viewport. Return true if successful.
     bool Define(RenderSurface* renderTarget, Viewport* viewport);
@@ -171,6 +175,12 @@ public:
     /// Return light batch queues.
     const Vector<LightBatchQueue>& GetLightQueues() const { return lightQueues_; }
 
+    /// Return light clusters. Null if the renderpath does not use clustered lighting.
+    LightClusters* GetLightClusters() const { return clusteredLights_ ? lightClusters_.Get() : nullptr; }
+
+    /// Return lights that were binned to clusters instead of being rendered in the forward light loop.
+    const PODVector<Light*>& GetClusteredLights() const { return clusterLights_; }
+
     /// Return the last used software occlusion buffer.
     OcclusionBuffer* GetOcclusionBuffer() const { return occlusionBuffer_; }
 
@@ -200,6 +210,8 @@ private:
     void GetDrawables();
     /// Construct batches from the drawable objects.
     void GetBatches();
+    /// Request mip levels for the textures of visible geometries from the texture streamer.
+    void RequestStreamingTextures(TextureStreamer* streamer);
     /// Get lit geometries and shadowcasters for visible lights.
     void ProcessLights();
     /// Get batches from lit geometries and shadowcasters.
@@ -267,6 +279,10 @@ private:
     void PrepareInstancingBuffer();
     /// Set up a light volume rendering batch.
     void SetupLightVolumeBatch(Batch& batch);
+    /// Collect the geometries in range of a point or spot light that match its light mask.
+    void GetLitGeometries(LightQueryResult& query, const PODVector<Drawable*>& drawables);
+    /// Return whether a processed light should be binned to light clusters instead of getting a per-pixel light queue.
+    bool IsClusteredLight(const LightQueryResult& query) const;
     /// Check whether a light queue needs shadow rendering.
     bool NeedRenderShadowMap(const LightBatchQueue& queue);
     /// Render a shadow map.
@@ -376,6 +392,8 @@ private:
     bool deferredAmbient_{};
     /// Forward light base pass optimization flag. If in use, combine the base pass and first light for all opaque objects.
     bool useLitBase_{};
+    /// Clustered forward lighting flag. If in use, unshadowed point and spot lights are applied in the scene passes that request them.
+    bool clusteredLights_{};
     /// Has scene passes flag. If no scene passes, view can be defined without a valid scene or camera to only perform quad rendering.
     bool hasScenePasses_{};
     /// Whether is using a custom readable depth texture without a stencil channel.
@@ -415,6 +433,10 @@ private:
     Vector<LightBatchQueue> lightQueues_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
+    /// Lights binned to light clusters instead of the per-pixel light queues.
+    PODVector<Light*> clusterLights_;
+    /// Light clusters for clustered forward lighting. Allocated if necessary.
+    SharedPtr<LightClusters> lightClusters_;
     /// Batch queues by pass index.
     HashMap<unsigned, BatchQueue> batchQueues_;
     /// Index of the GBuffer pass.
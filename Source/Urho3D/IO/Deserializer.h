@@ -50,6 +50,8 @@ public:
     virtual unsigned GetChecksum();
     /// Return whether the end of stream has been reached.
     virtual bool IsEof() const { return position_ >= size_; }
+    /// Return pointer to the whole stream data if it resides in memory and can be read without copying, or null if not.
+    virtual const unsigned char* GetMemoryView() const { return nullptr; }
 
     /// Set position relative to current position. Return actual new position.
     unsigned SeekRelative(int delta);
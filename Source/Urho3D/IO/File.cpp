@@ -72,6 +72,7 @@ File::File(Context* context) :
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
+    mappedData_(nullptr),
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
@@ -89,6 +90,7 @@ File::File(Context* context, const String& fileName, FileMode mode) :
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
+    mappedData_(nullptr),
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
@@ -107,6 +109,7 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
+    mappedData_(nullptr),
     readBufferOffset_(0),
     readBufferSize_(0),
     offset_(0),
@@ -137,6 +140,25 @@ bool File::Open(PackageFile* package, const String& fileName)
     if (!entry)
         return false;
 
+    // Read uncompressed entries directly from the memory mapping without opening a file handle
+    if (package->IsMemoryMapped() && entry->codec_ == PACKAGE_CODEC_NONE)
+    {
+        Close();
+
+        package_ = package;
+        mappedData_ = package->GetMappedData(*entry);
+        fileName_ = fileName;
+        mode_ = FILE_READ;
+        position_ = 0;
+        offset_ = entry->offset_;
+        checksum_ = entry->checksum_;
+        size_ = entry->size_;
+        compressed_ = false;
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
+        return true;
+    }
+
     bool success = OpenInternal(package->GetName(), FILE_READ, true);
     if (!success)
     {
@@ -148,7 +170,7 @@ bool File::Open(PackageFile* package, const String& fileName)
     offset_ = entry->offset_;
     checksum_ = entry->checksum_;
     size_ = entry->size_;
-    compressed_ = package->IsCompressed();
+    compressed_ = entry->codec_ != PACKAGE_CODEC_NONE;
 
     // Seek to beginning of package entry's file data
     SeekInternal(offset_);
@@ -174,6 +196,13 @@ unsigned File::Read(void* dest, unsigned size)
     if (!size)
         return 0;
 
+    if (mappedData_)
+    {
+        memcpy(dest, mappedData_ + position_, size);
+        position_ += size;
+        return size;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_ && !compressed_)
     {
@@ -282,6 +311,12 @@ unsigned File::Seek(unsigned position)
     if (mode_ == FILE_READ && position > size_)
         position = size_;
 
+    if (mappedData_)
+    {
+        position_ = position;
+        return position_;
+    }
+
     if (compressed_)
     {
         // Start over from the beginning
@@ -394,6 +429,16 @@ void File::Close()
     readBuffer_.Reset();
     inputBuffer_.Reset();
 
+    if (mappedData_)
+    {
+        mappedData_ = nullptr;
+        package_.Reset();
+        position_ = 0;
+        size_ = 0;
+        offset_ = 0;
+        checksum_ = 0;
+    }
+
     if (handle_)
     {
         fclose((FILE*)handle_);
@@ -419,9 +464,9 @@ void File::SetName(const String& name)
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || assetHandle_ != 0 || mappedData_ != 0;
 #else
-    return handle_ != nullptr;
+    return handle_ != nullptr || mappedData_ != nullptr;
 #endif
 }
 
@@ -83,6 +83,8 @@ public:
 
     /// Return a checksum of the file contents using the SDBM hash algorithm.
     unsigned GetChecksum() override;
+    /// Return pointer to the file data if opened from a memory-mapped package file, or null otherwise.
+    const unsigned char* GetMemoryView() const override { return mappedData_; }
 
     /// Open a filesystem file. Return true if successful.
     bool Open(const String& fileName, FileMode mode = FILE_READ);
@@ -101,6 +103,9 @@ public:
     /// Return whether is open.
     bool IsOpen() const;
 
+    /// Return whether the file is read from a memory-mapped package file.
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+
     /// Return the file handle.
     void* GetHandle() const { return handle_; }
 
@@ -125,6 +130,10 @@ private:
     /// SDL RWops context for Android asset loading.
     SDL_RWops* assetHandle_;
 #endif
+    /// Package file the memory-mapped data belongs to. Holds the mapping alive while the file is open.
+    SharedPtr<PackageFile> package_;
+    /// Memory-mapped file data, null when reading through the file handle.
+    const unsigned char* mappedData_;
     /// Read buffer for Android asset or compressed file loading.
     SharedArrayPtr<unsigned char> readBuffer_;
     /// Decompression input buffer for compressed file loading.
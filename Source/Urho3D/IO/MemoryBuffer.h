@@ -46,6 +46,8 @@ public:
     unsigned Seek(unsigned position) override;
     /// Write bytes to the memory area.
     unsigned Write(const void* data, unsigned size) override;
+    /// Return the memory area for zero-copy reading.
+    const unsigned char* GetMemoryView() const override { return buffer_; }
 
     /// Return memory area.
     unsigned char* GetData() { return buffer_; }
@@ -22,36 +22,65 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/PackageFile.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace Urho3D
 {
 
 PackageFile::PackageFile(Context* context) :
     Object(context),
+    numFiles_(0),
+    version_(0),
+    bucketSeed_(0),
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
-    compressed_(false)
+    mappedData_(nullptr),
+    mappedSize_(0),
+    entriesCollected_(false),
+    compressed_(false),
+    memoryMapping_(true)
 {
 }
 
 PackageFile::PackageFile(Context* context, const String& fileName, unsigned startOffset) :
     Object(context),
+    numFiles_(0),
+    version_(0),
+    bucketSeed_(0),
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
-    compressed_(false)
+    mappedData_(nullptr),
+    mappedSize_(0),
+    entriesCollected_(false),
+    compressed_(false),
+    memoryMapping_(true)
 {
     Open(fileName, startOffset);
 }
 
-PackageFile::~PackageFile() = default;
+PackageFile::~PackageFile()
+{
+    UnmapFile();
+}
 
 bool PackageFile::Open(const String& fileName, unsigned startOffset)
 {
+    UnmapFile();
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -59,10 +88,11 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     // Check ID, then read the directory
     file->Seek(startOffset);
     String id = file->ReadFileID();
-    if (id != "UPAK" && id != "ULZ4")
+    if (id != "UPAK" && id != "ULZ4" && id != "UPK2")
     {
         // If start offset has not been explicitly specified, also try to read package size from the end of file
-        // to know how much we must rewind to find the package start
+        // to know how much we must rewind to find the package start. The original format stores it as 32-bit and
+        // version 2 as 64-bit
         if (!startOffset)
         {
             unsigned fileSize = file->GetSize();
@@ -74,9 +104,20 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
                 file->Seek(startOffset);
                 id = file->ReadFileID();
             }
+            else if (fileSize >= sizeof(unsigned long long))
+            {
+                file->Seek((unsigned)(fileSize - sizeof(unsigned long long)));
+                unsigned long long packageSize = file->ReadUInt64();
+                if (packageSize && packageSize <= fileSize)
+                {
+                    startOffset = fileSize - (unsigned)packageSize;
+                    file->Seek(startOffset);
+                    id = file->ReadFileID();
+                }
+            }
         }
 
-        if (id != "UPAK" && id != "ULZ4")
+        if (id != "UPAK" && id != "ULZ4" && id != "UPK2")
         {
             URHO3D_LOGERROR(fileName + " is not a valid package file");
             return false;
@@ -86,54 +127,211 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     fileName_ = fileName;
     nameHash_ = fileName_;
     totalSize_ = file->GetSize();
-    compressed_ = id == "ULZ4";
+    totalDataSize_ = 0;
+    entries_.Clear();
+    entriesCollected_.store(false, std::memory_order_relaxed);
+    directory_.Clear();
+    hashSeeds_.Clear();
+    nameOffsets_.Clear();
+    nameTable_.Clear();
 
-    unsigned numFiles = file->ReadUInt();
-    checksum_ = file->ReadUInt();
+    bool success;
+    if (id == "UPK2")
+    {
+        version_ = 2;
+        success = ReadDirectory(*file, startOffset);
+    }
+    else
+    {
+        version_ = 1;
+        compressed_ = id == "ULZ4";
+        success = ReadEntries(*file, startOffset);
+    }
+    if (!success)
+        return false;
+
+    // Compressed entries are decompressed block by block, so mapping a package with only compressed entries
+    // would not avoid any copies
+    if (memoryMapping_ && (version_ == 2 || !compressed_))
+        MapFile();
 
-    for (unsigned i = 0; i < numFiles; ++i)
+    return true;
+}
+
+bool PackageFile::ReadEntries(File& file, unsigned startOffset)
+{
+    numFiles_ = file.ReadUInt();
+    checksum_ = file.ReadUInt();
+
+    // Each entry takes at least a name terminator, offset, size and checksum. Check the count against the file size so
+    // that a corrupt header can not make the reading loop run on past the end
+    if (numFiles_ > (totalSize_ - file.GetPosition()) / (1 + 3 * sizeof(unsigned)))
+    {
+        URHO3D_LOGERROR("Invalid number of files in package file " + fileName_);
+        return false;
+    }
+
+    PODVector<unsigned> offsets;
+    for (unsigned i = 0; i < numFiles_; ++i)
     {
-        String entryName = file->ReadString();
+        String entryName = file.ReadString();
         PackageEntry newEntry{};
-        newEntry.offset_ = file->ReadUInt() + startOffset;
-        totalDataSize_ += (newEntry.size_ = file->ReadUInt());
-        newEntry.checksum_ = file->ReadUInt();
+        newEntry.offset_ = file.ReadUInt() + startOffset;
+        totalDataSize_ += (newEntry.size_ = file.ReadUInt());
+        newEntry.checksum_ = file.ReadUInt();
+        newEntry.codec_ = compressed_ ? PACKAGE_CODEC_LZ4HC : PACKAGE_CODEC_NONE;
         if (!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_)
         {
             URHO3D_LOGERROR("File entry " + entryName + " outside package file");
             return false;
         }
         else
+        {
             entries_[entryName] = newEntry;
+            offsets.Push(newEntry.offset_);
+        }
+    }
+
+    // The stored sizes are not in the original format. Derive them from the offsets of the following entries;
+    // the data of the last entry is followed by the package size
+    Sort(offsets.Begin(), offsets.End());
+    unsigned dataEnd = totalSize_ - sizeof(unsigned);
+    for (HashMap<String, PackageEntry>::Iterator i = entries_.Begin(); i != entries_.End(); ++i)
+    {
+        PODVector<unsigned>::ConstIterator next = UpperBound(offsets.Begin(), offsets.End(), i->second_.offset_);
+        i->second_.storedSize_ = (next != offsets.End() ? *next : dataEnd) - i->second_.offset_;
     }
 
     return true;
 }
 
-bool PackageFile::Exists(const String& fileName) const
+bool PackageFile::ReadDirectory(File& file, unsigned startOffset)
 {
-    bool found = entries_.Find(fileName) != entries_.End();
+    numFiles_ = file.ReadUInt();
+    checksum_ = file.ReadUInt();
+    bucketSeed_ = file.ReadUInt();
+    unsigned long long directoryOffset = file.ReadUInt64() + startOffset;
+    compressed_ = false;
 
-#ifdef _WIN32
-    // On Windows perform a fallback case-insensitive search
-    if (!found)
+    // The engine streams are 32-bit, so larger package files can not be read yet even though the format allows them
+    if (directoryOffset > M_MAX_UNSIGNED)
+    {
+        URHO3D_LOGERROR("Package files over 4 GB are not supported: " + fileName_);
+        return false;
+    }
+    if (directoryOffset >= totalSize_)
+    {
+        URHO3D_LOGERROR("Directory outside package file " + fileName_);
+        return false;
+    }
+
+    // Each file takes a hash seed and a fixed size entry in the directory. Check the count against the directory size
+    // before allocating, so that a corrupt header can not cause a huge allocation
+    const unsigned directoryEntrySize = sizeof(int) + 3 * sizeof(unsigned long long) + 3 * sizeof(unsigned);
+    if (numFiles_ > (totalSize_ - (unsigned)directoryOffset) / directoryEntrySize)
+    {
+        URHO3D_LOGERROR("Invalid number of files in package file " + fileName_);
+        return false;
+    }
+
+    // The directory is laid out so that it can be read with a few bulk reads without parsing file names:
+    // perfect hash seeds, fixed size entries in hash order, then the name table
+    file.Seek((unsigned)directoryOffset);
+    hashSeeds_.Resize(numFiles_);
+    if (numFiles_ && file.Read(&hashSeeds_[0], numFiles_ * sizeof(int)) != numFiles_ * sizeof(int))
+    {
+        URHO3D_LOGERROR("Could not read directory of package file " + fileName_);
+        return false;
+    }
+
+    directory_.Resize(numFiles_);
+    nameOffsets_.Resize(numFiles_);
+    for (unsigned i = 0; i < numFiles_; ++i)
     {
-        for (HashMap<String, PackageEntry>::ConstIterator i = entries_.Begin(); i != entries_.End(); ++i)
+        PackageEntry& entry = directory_[i];
+        unsigned long long offset = file.ReadUInt64() + startOffset;
+        unsigned long long size = file.ReadUInt64();
+        unsigned long long storedSize = file.ReadUInt64();
+        entry.checksum_ = file.ReadUInt();
+        nameOffsets_[i] = file.ReadUInt();
+        unsigned codec = file.ReadUInt();
+
+        if (offset > M_MAX_UNSIGNED || storedSize > M_MAX_UNSIGNED)
         {
-            if (!i->first_.Compare(fileName, false))
-            {
-                found = true;
-                break;
-            }
+            URHO3D_LOGERROR("Package files over 4 GB are not supported: " + fileName_);
+            return false;
+        }
+
+        // Uncompressed entries are read directly from the stored data, including through the memory mapping, so their
+        // size must match the stored size exactly
+        if (offset + storedSize > totalSize_ || size > M_MAX_UNSIGNED || codec >= MAX_PACKAGE_CODECS ||
+            (codec == PACKAGE_CODEC_NONE && size != storedSize))
+        {
+            URHO3D_LOGERROR("Invalid file entry in package file " + fileName_);
+            return false;
+        }
+
+        entry.offset_ = (unsigned)offset;
+        entry.size_ = (unsigned)size;
+        entry.storedSize_ = (unsigned)storedSize;
+        entry.codec_ = (PackageCodec)codec;
+        totalDataSize_ += entry.size_;
+        if (entry.codec_ != PACKAGE_CODEC_NONE)
+            compressed_ = true;
+    }
+
+    unsigned nameTableSize = file.ReadUInt();
+    nameTable_.Resize(nameTableSize);
+    if ((numFiles_ && !nameTableSize) ||
+        (nameTableSize && (file.Read(&nameTable_[0], nameTableSize) != nameTableSize || nameTable_.Back() != 0)))
+    {
+        URHO3D_LOGERROR("Could not read directory of package file " + fileName_);
+        return false;
+    }
+
+    // Name offsets must point to the start of a name inside the table, which is known to end with a terminator
+    for (unsigned i = 0; i < numFiles_; ++i)
+    {
+        unsigned nameOffset = nameOffsets_[i];
+        if (nameOffset >= nameTable_.Size() || (nameOffset && nameTable_[nameOffset - 1] != 0) || !nameTable_[nameOffset] ||
+            (hashSeeds_[i] < 0 && (unsigned)(-hashSeeds_[i] - 1) >= numFiles_))
+        {
+            URHO3D_LOGERROR("Invalid directory in package file " + fileName_);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const HashMap<String, PackageEntry>& PackageFile::GetEntries() const
+{
+    // Lookups in a version 2 package use the perfect hash directory, so the entries are only collected by name when
+    // they are all requested. Several threads may load from the same package, so the collection is guarded
+    if (version_ == 2 && !entriesCollected_.load(std::memory_order_acquire))
+    {
+        MutexLock lock(entriesMutex_);
+        if (!entriesCollected_.load(std::memory_order_relaxed))
+        {
+            for (unsigned i = 0; i < numFiles_; ++i)
+                entries_[String(&nameTable_[nameOffsets_[i]])] = directory_[i];
+            entriesCollected_.store(true, std::memory_order_release);
         }
     }
-#endif
 
-    return found;
+    return entries_;
+}
+
+bool PackageFile::Exists(const String& fileName) const
+{
+    return GetEntry(fileName) != nullptr;
 }
 
 const PackageEntry* PackageFile::GetEntry(const String& fileName) const
 {
+    if (version_ == 2)
+        return FindDirectoryEntry(fileName);
+
     HashMap<String, PackageEntry>::ConstIterator i = entries_.Find(fileName);
     if (i != entries_.End())
         return &i->second_;
@@ -153,4 +351,155 @@ const PackageEntry* PackageFile::GetEntry(const String& fileName) const
     return nullptr;
 }
 
+unsigned PackageFile::HashEntryName(const char* name, unsigned seed)
+{
+    // FNV-1a with the seed mixed into the offset basis, followed by a finalizer for better distribution of the low bits
+    unsigned hash = 2166136261u ^ (seed * 0x9e3779b9u);
+    while (*name)
+    {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+const PackageEntry* PackageFile::FindDirectoryEntry(const String& fileName) const
+{
+    if (!numFiles_)
+        return nullptr;
+
+    int seed = hashSeeds_[HashEntryName(fileName.CString(), bucketSeed_) % numFiles_];
+    unsigned index = seed < 0 ? (unsigned)(-seed - 1) : HashEntryName(fileName.CString(), (unsigned)seed) % numFiles_;
+    if (!strcmp(&nameTable_[nameOffsets_[index]], fileName.CString()))
+        return &directory_[index];
+
+#ifdef _WIN32
+    // On Windows perform a fallback case-insensitive search
+    for (unsigned i = 0; i < numFiles_; ++i)
+    {
+        if (!String::Compare(&nameTable_[nameOffsets_[i]], fileName.CString(), false))
+            return &directory_[i];
+    }
+#endif
+
+    return nullptr;
+}
+
+bool PackageFile::VerifyChecksums()
+{
+    // The package checksum runs over the file data in the order it was written, so process the entries by offset
+    const HashMap<String, PackageEntry>& entries = GetEntries();
+    Vector<Pair<unsigned, String> > sortedEntries;
+    for (HashMap<String, PackageEntry>::ConstIterator i = entries.Begin(); i != entries.End(); ++i)
+        sortedEntries.Push(MakePair(i->second_.offset_, i->first_));
+    Sort(sortedEntries.Begin(), sortedEntries.End());
+
+    unsigned char buffer[65536];
+    unsigned checksum = 0;
+
+    for (Vector<Pair<unsigned, String> >::ConstIterator i = sortedEntries.Begin(); i != sortedEntries.End(); ++i)
+    {
+        File file(context_, this, i->second_);
+        if (!file.IsOpen())
+            return false;
+
+        unsigned entryChecksum = 0;
+        unsigned sizeLeft = file.GetSize();
+        while (sizeLeft)
+        {
+            unsigned readSize = Min(sizeLeft, (unsigned)sizeof buffer);
+            if (file.Read(buffer, readSize) != readSize)
+                return false;
+
+            for (unsigned j = 0; j < readSize; ++j)
+            {
+                checksum = SDBMHash(checksum, buffer[j]);
+                entryChecksum = SDBMHash(entryChecksum, buffer[j]);
+            }
+            sizeLeft -= readSize;
+        }
+
+        if (entryChecksum != GetEntry(i->second_)->checksum_)
+        {
+            URHO3D_LOGERROR("Checksum mismatch for file entry " + i->second_ + " in package file " + fileName_);
+            return false;
+        }
+    }
+
+    if (checksum != checksum_)
+    {
+        URHO3D_LOGERROR("Checksum mismatch for package file " + fileName_);
+        return false;
+    }
+
+    return true;
+}
+
+bool PackageFile::MapFile()
+{
+#ifdef __ANDROID__
+    // Android asset files can only be accessed through SDL RWops
+    if (URHO3D_IS_ASSET(fileName_))
+        return false;
+#endif
+
+    if (!totalSize_)
+        return false;
+
+#if defined(__EMSCRIPTEN__)
+    return false;
+#else
+#ifdef _WIN32
+    HANDLE file = CreateFileW(GetWideNativePath(fileName_).CString(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // The view keeps the mapping alive, so the handles can be closed right away
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, totalSize_);
+    CloseHandle(mapping);
+    if (!data)
+        return false;
+#else
+    int fd = open(GetNativePath(fileName_).CString(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    void* data = mmap(nullptr, totalSize_, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after closing the descriptor
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+#endif
+
+    mappedData_ = (unsigned char*)data;
+    mappedSize_ = totalSize_;
+    URHO3D_LOGDEBUG("Memory-mapped package file " + fileName_);
+    return true;
+#endif
+}
+
+void PackageFile::UnmapFile()
+{
+    if (!mappedData_)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mappedData_);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(mappedData_, mappedSize_);
+#endif
+
+    mappedData_ = nullptr;
+    mappedSize_ = 0;
+}
+
 }
@@ -22,11 +22,31 @@
 
 #pragma once
 
+#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
+class File;
+
+/// Compression codec of a package file entry.
+enum PackageCodec
+{
+    /// Stored uncompressed.
+    PACKAGE_CODEC_NONE = 0,
+    /// Blocks compressed with fast LZ4.
+    PACKAGE_CODEC_LZ4,
+    /// Blocks compressed with high compression LZ4. Decompresses the same as fast LZ4.
+    PACKAGE_CODEC_LZ4HC,
+    MAX_PACKAGE_CODECS
+};
+
+/// Alignment of uncompressed file data in version 2 package files, so that it can be accessed in place through a memory mapping.
+static const unsigned PACKAGE_ENTRY_ALIGNMENT = 4096;
+
 /// %File entry within the package file.
 struct PackageEntry
 {
@@ -36,9 +56,13 @@ struct PackageEntry
     unsigned size_;
     /// File checksum.
     unsigned checksum_;
+    /// Size of the data stored in the package file. Differs from the file size when compressed.
+    unsigned storedSize_;
+    /// Compression codec.
+    PackageCodec codec_;
 };
 
-/// Stores files of a directory tree sequentially for convenient access.
+/// Stores files of a directory tree sequentially for convenient access. Reads both the original (UPAK/ULZ4) format and the version 2 (UPK2) format, which has 64-bit offsets, per-file compression codecs, aligned file data and a perfect hash directory.
 class URHO3D_API PackageFile : public Object
 {
     URHO3D_OBJECT(PackageFile, Object);
@@ -53,13 +77,16 @@ public:
 
     /// Open the package file. Return true if successful.
     bool Open(const String& fileName, unsigned startOffset = 0);
+    /// Set whether uncompressed package files are memory-mapped when opened. Default true. Must be set before Open().
+    void SetMemoryMapping(bool enable) { memoryMapping_ = enable; }
     /// Check if a file exists within the package file. This will be case-insensitive on Windows and case-sensitive on other platforms.
     bool Exists(const String& fileName) const;
     /// Return the file entry corresponding to the name, or null if not found. This will be case-insensitive on Windows and case-sensitive on other platforms.
     const PackageEntry* GetEntry(const String& fileName) const;
-
-    /// Return all file entries.
-    const HashMap<String, PackageEntry>& GetEntries() const { return entries_; }
+    /// Return all file entries. For version 2 package files, these are collected from the directory on first call.
+    const HashMap<String, PackageEntry>& GetEntries() const;
+    /// Recalculate the checksums of all file entries and the whole package from the file data and compare them to the stored checksums. Reads the whole package. Return true if all match.
+    bool VerifyChecksums();
 
     /// Return the package file name.
     const String& GetName() const { return fileName_; }
@@ -68,7 +95,10 @@ public:
     StringHash GetNameHash() const { return nameHash_; }
 
     /// Return number of files.
-    unsigned GetNumFiles() const { return entries_.Size(); }
+    unsigned GetNumFiles() const { return numFiles_; }
+
+    /// Return package file format version, 1 or 2.
+    unsigned GetVersion() const { return version_; }
 
     /// Return total size of the package file.
     unsigned GetTotalSize() const { return totalSize_; }
@@ -79,27 +109,75 @@ public:
     /// Return checksum of the package file contents.
     unsigned GetChecksum() const { return checksum_; }
 
-    /// Return whether the files are compressed.
+    /// Return whether any of the files are compressed.
     bool IsCompressed() const { return compressed_; }
 
+    /// Return whether memory mapping is enabled for uncompressed package files.
+    bool GetMemoryMapping() const { return memoryMapping_; }
+
+    /// Return whether the package file is memory-mapped.
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+
+    /// Return pointer to the data of a file entry within the memory mapping, or null if not memory-mapped.
+    const unsigned char* GetMappedData(const PackageEntry& entry) const { return mappedData_ ? mappedData_ + entry.offset_ : nullptr; }
+
     /// Return list of file names in the package.
-    const Vector<String> GetEntryNames() const { return entries_.Keys(); }
+    const Vector<String> GetEntryNames() const { return GetEntries().Keys(); }
+
+    /// Hash a file name for the perfect hash directory of version 2 package files.
+    static unsigned HashEntryName(const char* name, unsigned seed);
 
 private:
-    /// File entries.
-    HashMap<String, PackageEntry> entries_;
+    /// Read the file entries of an original format package file. Return true if successful.
+    bool ReadEntries(File& file, unsigned startOffset);
+    /// Read the directory of a version 2 package file. Return true if successful.
+    bool ReadDirectory(File& file, unsigned startOffset);
+    /// Find a file entry from the version 2 directory.
+    const PackageEntry* FindDirectoryEntry(const String& fileName) const;
+
+    /// Map the whole package file to memory. Return true if successful.
+    bool MapFile();
+    /// Release the memory mapping.
+    void UnmapFile();
+
+    /// File entries. Collected on demand for a version 2 package file.
+    mutable HashMap<String, PackageEntry> entries_;
+    /// Mutex for collecting the file entries of a version 2 package file, which may be requested from several threads.
+    mutable Mutex entriesMutex_;
+    /// Whether the file entries of a version 2 package file have been collected.
+    mutable std::atomic<bool> entriesCollected_;
+    /// File entries of a version 2 package file in perfect hash order.
+    PODVector<PackageEntry> directory_;
+    /// Perfect hash seeds of a version 2 package file. Negative values index the directory directly.
+    PODVector<int> hashSeeds_;
+    /// File name offsets to the name table of a version 2 package file.
+    PODVector<unsigned> nameOffsets_;
+    /// Null-terminated file names of a version 2 package file.
+    PODVector<char> nameTable_;
     /// File name.
     String fileName_;
     /// Package file name hash.
     StringHash nameHash_;
+    /// Number of files.
+    unsigned numFiles_;
+    /// Package file format version.
+    unsigned version_;
+    /// Bucket hash seed of the version 2 perfect hash directory.
+    unsigned bucketSeed_;
     /// Package file total size.
     unsigned totalSize_;
     /// Total data size in the package using each entry's actual size if it is a compressed package file.
     unsigned totalDataSize_;
     /// Package file checksum.
     unsigned checksum_;
+    /// Memory-mapped file data.
+    unsigned char* mappedData_;
+    /// Size of the memory mapping.
+    unsigned mappedSize_;
     /// Compressed flag.
     bool compressed_;
+    /// Memory mapping enabled flag.
+    bool memoryMapping_;
 };
 
 }
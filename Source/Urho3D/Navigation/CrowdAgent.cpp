@@ -263,7 +263,7 @@ void CrowdAgent::UpdateParameters(unsigned scope)
             params.obstacleAvoidanceType = (unsigned char)obstacleAvoidanceType_;
         }
 
-        crowdManager_->GetCrowd()->updateAgentParameters(agentCrowdId_, &params);
+        crowdManager_->GetAgentCrowd(this)->updateAgentParameters(agentCrowdId_, &params);
     }
 }
 
@@ -337,7 +337,7 @@ void CrowdAgent::SetTargetPosition(const Vector3& position)
         {
             dtPolyRef nearestRef;
             Vector3 nearestPos = crowdManager_->FindNearestPoint(position, queryFilterType_, &nearestRef);
-            crowdManager_->GetCrowd()->requestMoveTarget(agentCrowdId_, nearestRef, nearestPos.Data());
+            crowdManager_->GetAgentCrowd(this)->requestMoveTarget(agentCrowdId_, nearestRef, nearestPos.Data());
         }
     }
 }
@@ -351,7 +351,7 @@ void CrowdAgent::SetTargetVelocity(const Vector3& velocity)
         MarkNetworkUpdate();
 
         if (IsInCrowd())
-            crowdManager_->GetCrowd()->requestMoveVelocity(agentCrowdId_, velocity.Data());
+            crowdManager_->GetAgentCrowd(this)->requestMoveVelocity(agentCrowdId_, velocity.Data());
     }
 }
 
@@ -363,7 +363,7 @@ void CrowdAgent::ResetTarget()
         MarkNetworkUpdate();
 
         if (IsInCrowd())
-            crowdManager_->GetCrowd()->resetMoveTarget(agentCrowdId_);
+            crowdManager_->GetAgentCrowd(this)->resetMoveTarget(agentCrowdId_);
     }
 }
 
@@ -644,7 +644,7 @@ void CrowdAgent::OnMarkedDirty(Node* node)
 
 const dtCrowdAgent* CrowdAgent::GetDetourCrowdAgent() const
 {
-    return IsInCrowd() ? crowdManager_->GetDetourCrowdAgent(agentCrowdId_) : nullptr;
+    return IsInCrowd() ? crowdManager_->GetAgentCrowd(this)->getAgent(agentCrowdId_) : nullptr;
 }
 
 void CrowdAgent::HandleNavigationTileAdded(StringHash eventType, VariantMap& eventData)
@@ -202,6 +202,8 @@ private:
     WeakPtr<CrowdManager> crowdManager_;
     /// Crowd manager reference to this agent.
     int agentCrowdId_;
+    /// Crowd partition simulating this agent, or null when the crowd is not partitioned.
+    CrowdPartition* crowdPartition_{};
     /// Requested target position.
     Vector3 targetPosition_;
     /// Requested target velocity.
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../Navigation/CrowdAgent.h"
@@ -34,6 +35,7 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#include <Detour/DetourCommon.h>
 #include <DetourCrowd/DetourCrowd.h>
 
 #include "../DebugNew.h"
@@ -69,11 +71,92 @@ static const StringVector obstacleAvoidanceTypesStructureElementNames =
     "   Adaptive Depth"
 };
 
+/// Ghost agent mirroring an agent owned by a neighbouring region of a partitioned crowd.
+struct CrowdGhostAgent
+{
+    /// Detour agent ID in the region's crowd.
+    int agentId_{-1};
+    /// Whether the ghost was updated on this frame.
+    bool updated_{};
+};
+
+/// Region of a partitioned crowd, simulated by its own Detour crowd.
+struct CrowdPartition : public RefCounted
+{
+    /// Construct.
+    explicit CrowdPartition(const IntVector2& index) :
+        index_(index)
+    {
+    }
+
+    /// Destruct. Free the Detour crowd.
+    ~CrowdPartition() override
+    {
+        dtFreeCrowd(crowd_);
+        crowd_ = nullptr;
+    }
+
+    /// Region index.
+    IntVector2 index_;
+    /// Detour crowd simulating the region.
+    dtCrowd* crowd_{};
+    /// Agents owned by the region.
+    PODVector<CrowdAgent*> agents_;
+    /// Ghost agents by the agents they mirror.
+    HashMap<CrowdAgent*, CrowdGhostAgent> ghosts_;
+};
+
 void CrowdAgentUpdateCallback(dtCrowdAgent* ag, float dt)
 {
     static_cast<CrowdAgent*>(ag->params.userData)->OnCrowdUpdate(ag, dt);
 }
 
+static void UpdateCrowdWork(const WorkItem* item, unsigned threadIndex)
+{
+    static_cast<dtCrowd*>(item->start_)->update(*static_cast<float*>(item->aux_), nullptr);
+}
+
+static void DrawCrowdDebugGeometry(DebugRenderer* debug, dtCrowd* crowd, bool depthTest)
+{
+    // Current position-to-target line
+    for (int i = 0; i < crowd->getAgentCount(); i++)
+    {
+        const dtCrowdAgent* ag = crowd->getAgent(i);
+        // Skip also the ghost agents of a partitioned crowd, which have no crowd agent component
+        if (!ag->active || !ag->params.userData)
+            continue;
+
+        // Draw CrowdAgent shape (from its radius & height)
+        auto* crowdAgent = static_cast<CrowdAgent*>(ag->params.userData);
+        crowdAgent->DrawDebugGeometry(debug, depthTest);
+
+        // Draw move target if any
+        if (crowdAgent->GetTargetState() == CA_TARGET_NONE || crowdAgent->GetTargetState() == CA_TARGET_VELOCITY)
+            continue;
+
+        Color color(0.6f, 0.2f, 0.2f, 1.0f);
+
+        // Draw line to target
+        Vector3 pos1(ag->npos[0], ag->npos[1], ag->npos[2]);
+        Vector3 pos2;
+        for (int i = 0; i < ag->ncorners; ++i)
+        {
+            pos2.x_ = ag->cornerVerts[i * 3];
+            pos2.y_ = ag->cornerVerts[i * 3 + 1];
+            pos2.z_ = ag->cornerVerts[i * 3 + 2];
+            debug->AddLine(pos1, pos2, color, depthTest);
+            pos1 = pos2;
+        }
+        pos2.x_ = ag->targetPos[0];
+        pos2.y_ = ag->targetPos[1];
+        pos2.z_ = ag->targetPos[2];
+        debug->AddLine(pos1, pos2, color, depthTest);
+
+        // Draw target circle
+        debug->AddSphere(Sphere(pos2, 0.5f), color, depthTest);
+    }
+}
+
 CrowdManager::CrowdManager(Context* context) :
     Component(context),
     maxAgents_(DEFAULT_MAX_AGENTS),
@@ -87,6 +170,7 @@ CrowdManager::CrowdManager(Context* context) :
 
 CrowdManager::~CrowdManager()
 {
+    RemovePartitions();
     dtFreeCrowd(crowd_);
     crowd_ = nullptr;
 }
@@ -98,6 +182,7 @@ void CrowdManager::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Max Agents", unsigned, maxAgents_, DEFAULT_MAX_AGENTS, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Max Agent Radius", float, maxAgentRadius_, DEFAULT_MAX_AGENT_RADIUS, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Navigation Mesh", unsigned, navigationMeshId_, 0, AM_DEFAULT | AM_COMPONENTID);
+    URHO3D_ACCESSOR_ATTRIBUTE("Partition Size", GetPartitionSize, SetPartitionSize, float, 0.0f, AM_DEFAULT);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Filter Types", GetQueryFilterTypesAttr, SetQueryFilterTypesAttr,
         VariantVector, Variant::emptyVariantVector, AM_DEFAULT)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, filterTypesStructureElementNames);
@@ -135,42 +220,13 @@ void CrowdManager::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
 {
     if (debug && crowd_)
     {
-        // Current position-to-target line
-        for (int i = 0; i < crowd_->getAgentCount(); i++)
+        if (partitionSize_ > 0.f)
         {
-            const dtCrowdAgent* ag = crowd_->getAgent(i);
-            if (!ag->active)
-                continue;
-
-            // Draw CrowdAgent shape (from its radius & height)
-            auto* crowdAgent = static_cast<CrowdAgent*>(ag->params.userData);
-            crowdAgent->DrawDebugGeometry(debug, depthTest);
-
-            // Draw move target if any
-            if (crowdAgent->GetTargetState() == CA_TARGET_NONE || crowdAgent->GetTargetState() == CA_TARGET_VELOCITY)
-                continue;
-
-            Color color(0.6f, 0.2f, 0.2f, 1.0f);
-
-            // Draw line to target
-            Vector3 pos1(ag->npos[0], ag->npos[1], ag->npos[2]);
-            Vector3 pos2;
-            for (int i = 0; i < ag->ncorners; ++i)
-            {
-                pos2.x_ = ag->cornerVerts[i * 3];
-                pos2.y_ = ag->cornerVerts[i * 3 + 1];
-                pos2.z_ = ag->cornerVerts[i * 3 + 2];
-                debug->AddLine(pos1, pos2, color, depthTest);
-                pos1 = pos2;
-            }
-            pos2.x_ = ag->targetPos[0];
-            pos2.y_ = ag->targetPos[1];
-            pos2.z_ = ag->targetPos[2];
-            debug->AddLine(pos1, pos2, color, depthTest);
-
-            // Draw target circle
-            debug->AddSphere(Sphere(pos2, 0.5f), color, depthTest);
+            for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+                DrawCrowdDebugGeometry(debug, i->second_->crowd_, depthTest);
         }
+        else
+            DrawCrowdDebugGeometry(debug, crowd_, depthTest);
     }
 }
 
@@ -253,6 +309,17 @@ void CrowdManager::SetMaxAgentRadius(float maxAgentRadius)
     }
 }
 
+void CrowdManager::SetPartitionSize(float size)
+{
+    size = Max(size, 0.f);
+    if (size != partitionSize_)
+    {
+        partitionSize_ = size;
+        CreateCrowd();
+        MarkNetworkUpdate();
+    }
+}
+
 void CrowdManager::SetNavigationMesh(NavigationMesh* navMesh)
 {
     UnsubscribeFromEvent(E_COMPONENTADDED);
@@ -306,6 +373,8 @@ void CrowdManager::SetQueryFilterTypesAttr(const VariantVector& value)
         }
         ++queryFilterType;
     }
+
+    partitionConfigDirty_ = true;
 }
 
 void CrowdManager::SetIncludeFlags(unsigned queryFilterType, unsigned short flags)
@@ -316,6 +385,7 @@ void CrowdManager::SetIncludeFlags(unsigned queryFilterType, unsigned short flag
         filter->setIncludeFlags(flags);
         if (numQueryFilterTypes_ < queryFilterType + 1)
             numQueryFilterTypes_ = queryFilterType + 1;
+        partitionConfigDirty_ = true;
         MarkNetworkUpdate();
     }
 }
@@ -328,6 +398,7 @@ void CrowdManager::SetExcludeFlags(unsigned queryFilterType, unsigned short flag
         filter->setExcludeFlags(flags);
         if (numQueryFilterTypes_ < queryFilterType + 1)
             numQueryFilterTypes_ = queryFilterType + 1;
+        partitionConfigDirty_ = true;
         MarkNetworkUpdate();
     }
 }
@@ -342,6 +413,7 @@ void CrowdManager::SetAreaCost(unsigned queryFilterType, unsigned areaID, float
             numQueryFilterTypes_ = queryFilterType + 1;
         if (numAreas_[queryFilterType] < areaID + 1)
             numAreas_[queryFilterType] = areaID + 1;
+        partitionConfigDirty_ = true;
         MarkNetworkUpdate();
     }
 }
@@ -374,6 +446,8 @@ void CrowdManager::SetObstacleAvoidanceTypesAttr(const VariantVector& value)
         }
         ++obstacleAvoidanceType;
     }
+
+    partitionConfigDirty_ = true;
 }
 
 void CrowdManager::SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, const CrowdObstacleAvoidanceParams& params)
@@ -383,6 +457,7 @@ void CrowdManager::SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, co
         crowd_->setObstacleAvoidanceParams(obstacleAvoidanceType, reinterpret_cast<const dtObstacleAvoidanceParams*>(&params));
         if (numObstacleAvoidanceTypes_ < obstacleAvoidanceType + 1)
             numObstacleAvoidanceTypes_ = obstacleAvoidanceType + 1;
+        partitionConfigDirty_ = true;
         MarkNetworkUpdate();
     }
 }
@@ -408,6 +483,12 @@ void CrowdManager::FindPath(PODVector<Vector3>& dest, const Vector3& start, cons
         navigationMesh_->FindPath(dest, start, end, Vector3(crowd_->getQueryExtents()), crowd_->getFilter(queryFilterType));
 }
 
+unsigned CrowdManager::FindPathAsync(const Vector3& start, const Vector3& end, int queryFilterType, unsigned priority)
+{
+    return crowd_ && navigationMesh_ ? navigationMesh_->FindPathAsync(start, end, priority, Vector3(crowd_->getQueryExtents()),
+        crowd_->getFilter(queryFilterType)) : 0;
+}
+
 Vector3 CrowdManager::GetRandomPoint(int queryFilterType, dtPolyRef* randomRef)
 {
     if (randomRef)
@@ -445,6 +526,11 @@ Vector3 CrowdManager::Raycast(const Vector3& start, const Vector3& end, int quer
             : end;
 }
 
+unsigned CrowdManager::GetNumPartitions() const
+{
+    return partitions_.Size();
+}
+
 unsigned CrowdManager::GetNumAreas(unsigned queryFilterType) const
 {
     return queryFilterType < numQueryFilterTypes_ ? numAreas_[queryFilterType] : 0;
@@ -570,11 +656,15 @@ bool CrowdManager::CreateCrowd()
     if (!navigationMesh_ || !navigationMesh_->InitializeQuery())
         return false;
 
-    // Preserve the existing crowd configuration before recreating it
+    // Preserve the existing crowd configuration and agents before recreating it. The partitions are recreated as the agents are
+    // added back
     VariantVector queryFilterTypeConfiguration, obstacleAvoidanceTypeConfiguration;
+    PODVector<CrowdAgent*> agents;
     bool recreate = crowd_ != nullptr;
     if (recreate)
     {
+        agents = GetAgents();
+        RemovePartitions();
         queryFilterTypeConfiguration = GetQueryFilterTypesAttr();
         obstacleAvoidanceTypeConfiguration = GetObstacleAvoidanceTypesAttr();
         dtFreeCrowd(crowd_);
@@ -597,7 +687,6 @@ bool CrowdManager::CreateCrowd()
         SetObstacleAvoidanceTypesAttr(obstacleAvoidanceTypeConfiguration);
 
         // Re-add the existing crowd agents
-        PODVector<CrowdAgent*> agents = GetAgents();
         for (unsigned i = 0; i < agents.Size(); ++i)
         {
             // Keep adding until the crowd cannot take it anymore
@@ -624,6 +713,21 @@ int CrowdManager::AddAgent(CrowdAgent* agent, const Vector3& pos)
         agent->height_ = navigationMesh_->GetAgentHeight();
     // dtCrowd::addAgent() requires the query filter type to find the nearest position on navmesh as the initial agent's position
     params.queryFilterType = (unsigned char)agent->GetQueryFilterType();
+    if (partitionSize_ > 0.f)
+    {
+        if (agent->crowdPartition_)
+            RemoveAgent(agent);
+        CrowdPartition* partition = GetOrCreatePartition(GetPartitionIndex(pos.Data()));
+        if (!partition)
+            return -1;
+        int agentId = partition->crowd_->addAgent(pos.Data(), &params);
+        if (agentId != -1)
+        {
+            partition->agents_.Push(agent);
+            agent->crowdPartition_ = partition;
+        }
+        return agentId;
+    }
     return crowd_->addAgent(pos.Data(), &params);
 }
 
@@ -631,10 +735,16 @@ void CrowdManager::RemoveAgent(CrowdAgent* agent)
 {
     if (!crowd_ || !agent)
         return;
-    dtCrowdAgent* agt = crowd_->getEditableAgent(agent->GetAgentCrowdId());
+    dtCrowd* crowd = GetAgentCrowd(agent);
+    dtCrowdAgent* agt = crowd->getEditableAgent(agent->GetAgentCrowdId());
     if (agt)
         agt->params.userData = nullptr;
-    crowd_->removeAgent(agent->GetAgentCrowdId());
+    crowd->removeAgent(agent->GetAgentCrowdId());
+    if (agent->crowdPartition_)
+    {
+        agent->crowdPartition_->agents_.Remove(agent);
+        agent->crowdPartition_ = nullptr;
+    }
 }
 
 void CrowdManager::OnSceneSet(Scene* scene)
@@ -679,7 +789,10 @@ void CrowdManager::Update(float delta)
 {
     assert(crowd_ && navigationMesh_);
     URHO3D_PROFILE(UpdateCrowd);
-    crowd_->update(delta, nullptr);
+    if (partitionSize_ > 0.f)
+        UpdatePartitions(delta);
+    else
+        crowd_->update(delta, nullptr);
 }
 
 const dtCrowdAgent* CrowdManager::GetDetourCrowdAgent(int agent) const
@@ -687,6 +800,11 @@ const dtCrowdAgent* CrowdManager::GetDetourCrowdAgent(int agent) const
     return crowd_ ? crowd_->getAgent(agent) : nullptr;
 }
 
+dtCrowd* CrowdManager::GetAgentCrowd(const CrowdAgent* agent) const
+{
+    return agent->crowdPartition_ ? agent->crowdPartition_->crowd_ : crowd_;
+}
+
 const dtQueryFilter* CrowdManager::GetDetourQueryFilter(unsigned queryFilterType) const
 {
     return crowd_ ? crowd_->getFilter(queryFilterType) : nullptr;
@@ -739,4 +857,293 @@ void CrowdManager::HandleComponentAdded(StringHash eventType, VariantMap& eventD
     }
 }
 
+void CrowdManager::UpdatePartitions(float delta)
+{
+    if (partitionConfigDirty_)
+    {
+        for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+            ApplyPartitionConfiguration(i->second_->crowd_);
+        partitionConfigDirty_ = false;
+    }
+
+    // Hand the agents that have moved out of their region over to the region they are in. Allow them to stray by the maximum
+    // agent radius to avoid moving back and forth at the border
+    const float hysteresis = maxAgentRadius_;
+    float maxQueryRange = 0.f;
+    {
+        URHO3D_PROFILE(HandOffCrowdAgents);
+
+        PODVector<CrowdAgent*> handoffs;
+        for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+        {
+            CrowdPartition* partition = i->second_;
+            const float minX = partition->index_.x_ * partitionSize_ - hysteresis;
+            const float minZ = partition->index_.y_ * partitionSize_ - hysteresis;
+            const float maxX = minX + partitionSize_ + 2.f * hysteresis;
+            const float maxZ = minZ + partitionSize_ + 2.f * hysteresis;
+
+            for (unsigned j = 0; j < partition->agents_.Size(); ++j)
+            {
+                const dtCrowdAgent* ag = partition->crowd_->getAgent(partition->agents_[j]->agentCrowdId_);
+                maxQueryRange = Max(maxQueryRange, ag->params.collisionQueryRange);
+                // An agent on an off-mesh connection is animated by its current crowd until it has landed
+                if (ag->state == DT_CROWDAGENT_STATE_OFFMESH)
+                    continue;
+                if (ag->npos[0] < minX || ag->npos[0] > maxX || ag->npos[2] < minZ || ag->npos[2] > maxZ)
+                    handoffs.Push(partition->agents_[j]);
+            }
+        }
+
+        for (unsigned i = 0; i < handoffs.Size(); ++i)
+        {
+            CrowdAgent* agent = handoffs[i];
+            const dtCrowdAgent* ag = GetAgentCrowd(agent)->getAgent(agent->agentCrowdId_);
+            CrowdPartition* partition = GetOrCreatePartition(GetPartitionIndex(ag->npos));
+            // If the region is full, the agent stays in its current region
+            if (partition)
+                MoveAgentToPartition(agent, partition);
+        }
+
+        for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::Iterator i = partitions_.Begin(); i != partitions_.End();)
+        {
+            if (i->second_->agents_.Empty())
+                i = partitions_.Erase(i);
+            else
+                ++i;
+        }
+    }
+
+    {
+        URHO3D_PROFILE(UpdateGhostCrowdAgents);
+
+        // Neighbours are searched within the query range, from an agent that may be outside its region by the hysteresis
+        for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+            UpdateGhostAgents(i->second_, maxQueryRange + hysteresis);
+    }
+
+    // Update the regions in parallel. Detour crowd only reads the navigation mesh, and each crowd has its own query object
+    {
+        URHO3D_PROFILE(UpdateCrowdPartitions);
+
+        auto* queue = GetSubsystem<WorkQueue>();
+        if (queue && queue->GetNumThreads() && partitions_.Size() > 1)
+        {
+            for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = UpdateCrowdWork;
+                item->start_ = i->second_->crowd_;
+                item->aux_ = &delta;
+                queue->AddWorkItem(item);
+            }
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+        else
+        {
+            for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+                i->second_->crowd_->update(delta, nullptr);
+        }
+    }
+
+    // The partition crowds have no update callback, so notify the moved agents on the main thread afterwards. Ghost agents have
+    // no user data
+    for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+    {
+        dtCrowd* crowd = i->second_->crowd_;
+        for (int j = 0; j < crowd->getAgentCount(); ++j)
+        {
+            dtCrowdAgent* ag = crowd->getEditableAgent(j);
+            if (ag->active && ag->params.userData && ag->state == DT_CROWDAGENT_STATE_WALKING)
+                CrowdAgentUpdateCallback(ag, delta);
+        }
+    }
+}
+
+IntVector2 CrowdManager::GetPartitionIndex(const float* position) const
+{
+    return IntVector2(FloorToInt(position[0] / partitionSize_), FloorToInt(position[2] / partitionSize_));
+}
+
+CrowdPartition* CrowdManager::GetOrCreatePartition(const IntVector2& index)
+{
+    HashMap<IntVector2, SharedPtr<CrowdPartition> >::Iterator i = partitions_.Find(index);
+    if (i != partitions_.End())
+        return i->second_;
+
+    SharedPtr<CrowdPartition> partition(new CrowdPartition(index));
+    partition->crowd_ = dtAllocCrowd();
+    if (!partition->crowd_->init(maxAgents_, maxAgentRadius_, navigationMesh_->navMesh_, nullptr))
+    {
+        URHO3D_LOGERROR("Could not initialize DetourCrowd");
+        return nullptr;
+    }
+    ApplyPartitionConfiguration(partition->crowd_);
+
+    partitions_[index] = partition;
+    return partition;
+}
+
+bool CrowdManager::MoveAgentToPartition(CrowdAgent* agent, CrowdPartition* partition)
+{
+    CrowdPartition* oldPartition = agent->crowdPartition_;
+    dtCrowdAgent* src = oldPartition->crowd_->getEditableAgent(agent->agentCrowdId_);
+    int agentId = partition->crowd_->addAgent(src->npos, &src->params);
+    if (agentId == -1)
+        return false;
+
+    // Carry over the movement state and a valid path corridor, so that the agent does not need to replan. A path request still
+    // pending in the old crowd is made again
+    dtCrowdAgent* dest = partition->crowd_->getEditableAgent(agentId);
+    dest->corridor.reset(src->corridor.getFirstPoly(), src->npos);
+    dtVcopy(dest->npos, src->npos);
+    dtVcopy(dest->vel, src->vel);
+    dtVcopy(dest->dvel, src->dvel);
+    dtVcopy(dest->nvel, src->nvel);
+    dest->desiredSpeed = src->desiredSpeed;
+    dest->state = src->state;
+    dest->partial = src->partial;
+    dest->topologyOptTime = src->topologyOptTime;
+    dest->targetReplanTime = src->targetReplanTime;
+
+    switch (src->targetState)
+    {
+    case DT_CROWDAGENT_TARGET_REQUESTING:
+    case DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE:
+    case DT_CROWDAGENT_TARGET_WAITING_FOR_PATH:
+        partition->crowd_->requestMoveTarget(agentId, src->targetRef, src->targetPos);
+        break;
+
+    case DT_CROWDAGENT_TARGET_VALID:
+        dest->corridor.setCorridor(src->corridor.getTarget(), src->corridor.getPath(), src->corridor.getPathCount());
+        // Fall through
+
+    default:
+        dest->targetState = src->targetState;
+        dest->targetRef = src->targetRef;
+        dtVcopy(dest->targetPos, src->targetPos);
+        dest->targetReplan = src->targetReplan;
+        break;
+    }
+
+    src->params.userData = nullptr;
+    oldPartition->crowd_->removeAgent(agent->agentCrowdId_);
+    oldPartition->agents_.Remove(agent);
+
+    partition->agents_.Push(agent);
+    agent->crowdPartition_ = partition;
+    agent->agentCrowdId_ = agentId;
+    return true;
+}
+
+void CrowdManager::UpdateGhostAgents(CrowdPartition* partition, float margin)
+{
+    dtCrowd* crowd = partition->crowd_;
+    const float minX = partition->index_.x_ * partitionSize_;
+    const float minZ = partition->index_.y_ * partitionSize_;
+    const float maxX = minX + partitionSize_;
+    const float maxZ = minZ + partitionSize_;
+    // The owning region of an agent may be further away than the agent itself by the handoff hysteresis
+    const int range = CeilToInt((margin + maxAgentRadius_) / partitionSize_);
+    bool full = false;
+
+    for (int y = -range; y <= range; ++y)
+    {
+        for (int x = -range; x <= range; ++x)
+        {
+            if (!x && !y)
+                continue;
+            HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Find(partition->index_ + IntVector2(x, y));
+            if (i == partitions_.End())
+                continue;
+
+            CrowdPartition* neighbour = i->second_;
+            for (unsigned j = 0; j < neighbour->agents_.Size(); ++j)
+            {
+                CrowdAgent* agent = neighbour->agents_[j];
+                const dtCrowdAgent* src = neighbour->crowd_->getAgent(agent->agentCrowdId_);
+                const float dx = Max(Max(minX - src->npos[0], src->npos[0] - maxX), 0.f);
+                const float dz = Max(Max(minZ - src->npos[2], src->npos[2] - maxZ), 0.f);
+                if (dx * dx + dz * dz > margin * margin)
+                    continue;
+
+                HashMap<CrowdAgent*, CrowdGhostAgent>::Iterator k = partition->ghosts_.Find(agent);
+                if (k == partition->ghosts_.End())
+                {
+                    // Once the crowd is full, skip adding ghosts until some are removed
+                    if (full)
+                        continue;
+
+                    // The ghost only acts as a neighbour: it does not steer, accelerate or get pushed
+                    dtCrowdAgentParams params = src->params;
+                    params.userData = nullptr;
+                    params.updateFlags = 0;
+                    params.maxAcceleration = 0.f;
+                    params.separationWeight = 0.f;
+                    params.collisionQueryRange = params.radius;
+                    int ghostId = crowd->addAgent(src->npos, &params);
+                    if (ghostId == -1)
+                    {
+                        full = true;
+                        continue;
+                    }
+                    k = partition->ghosts_.Insert(MakePair(agent, CrowdGhostAgent()));
+                    k->second_.agentId_ = ghostId;
+                }
+
+                CrowdGhostAgent& ghostAgent = k->second_;
+                ghostAgent.updated_ = true;
+
+                dtCrowdAgent* ghost = crowd->getEditableAgent(ghostAgent.agentId_);
+                ghost->corridor.reset(src->corridor.getFirstPoly(), src->npos);
+                dtVcopy(ghost->npos, src->npos);
+                dtVcopy(ghost->vel, src->vel);
+                dtVcopy(ghost->dvel, src->dvel);
+                dtVcopy(ghost->nvel, src->nvel);
+                ghost->desiredSpeed = src->desiredSpeed;
+                ghost->state = src->state;
+                ghost->params.radius = src->params.radius;
+                ghost->params.height = src->params.height;
+            }
+        }
+    }
+
+    // Remove the ghosts of the agents that are no longer near the region
+    for (HashMap<CrowdAgent*, CrowdGhostAgent>::Iterator i = partition->ghosts_.Begin(); i != partition->ghosts_.End();)
+    {
+        if (i->second_.updated_)
+        {
+            i->second_.updated_ = false;
+            ++i;
+        }
+        else
+        {
+            crowd->removeAgent(i->second_.agentId_);
+            i = partition->ghosts_.Erase(i);
+        }
+    }
+}
+
+void CrowdManager::ApplyPartitionConfiguration(dtCrowd* crowd) const
+{
+    for (int i = 0; i < DT_CROWD_MAX_QUERY_FILTER_TYPE; ++i)
+        *crowd->getEditableFilter(i) = *crowd_->getFilter(i);
+    for (int i = 0; i < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS; ++i)
+        crowd->setObstacleAvoidanceParams(i, crowd_->getObstacleAvoidanceParams(i));
+}
+
+void CrowdManager::RemovePartitions()
+{
+    for (HashMap<IntVector2, SharedPtr<CrowdPartition> >::ConstIterator i = partitions_.Begin(); i != partitions_.End(); ++i)
+    {
+        const PODVector<CrowdAgent*>& agents = i->second_->agents_;
+        for (unsigned j = 0; j < agents.Size(); ++j)
+        {
+            agents[j]->crowdPartition_ = nullptr;
+            agents[j]->agentCrowdId_ = -1;
+        }
+    }
+    partitions_.Clear();
+}
+
 }
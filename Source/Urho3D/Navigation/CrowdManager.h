@@ -39,6 +39,7 @@ namespace Urho3D
 
 class CrowdAgent;
 class NavigationMesh;
+struct CrowdPartition;
 
 /// Parameter structure for obstacle avoidance params (copied from DetourObstacleAvoidance.h in order to hide Detour header from Urho3D library users).
 struct CrowdObstacleAvoidanceParams
@@ -87,6 +88,8 @@ public:
     void SetMaxAgents(unsigned maxAgents);
     /// Set the maximum radius of any agent.
     void SetMaxAgentRadius(float maxAgentRadius);
+    /// Set the size of the square regions the crowd is partitioned into. Each region is simulated by its own Detour crowd, and the regions are updated in parallel. Zero (default) disables partitioning.
+    void SetPartitionSize(float size);
     /// Assigns the navigation mesh for the crowd.
     void SetNavigationMesh(NavigationMesh* navMesh);
     /// Set all the query filter types configured in the crowd based on the corresponding attribute.
@@ -110,6 +113,8 @@ public:
     Vector3 MoveAlongSurface(const Vector3& start, const Vector3& end, int queryFilterType, int maxVisited = 3);
     /// Find a path between world space points using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. Return non-empty list of points if successful.
     void FindPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end, int queryFilterType);
+    /// Queue a path query on the navigation mesh using the crowd initialized query extent and the specified query filter type. The result is sent by the navigation mesh with the E_NAVIGATION_PATH_RESULT event. Return the query ID, or 0 if there is no navigation mesh.
+    unsigned FindPathAsync(const Vector3& start, const Vector3& end, int queryFilterType, unsigned priority = 0);
     /// Return a random point on the navigation mesh using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type.
     Vector3 GetRandomPoint(int queryFilterType, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -125,6 +130,12 @@ public:
     /// Get the maximum radius of any agent.
     float GetMaxAgentRadius() const { return maxAgentRadius_; }
 
+    /// Get the size of the crowd partition regions.
+    float GetPartitionSize() const { return partitionSize_; }
+
+    /// Get the number of crowd partition regions that currently have agents.
+    unsigned GetNumPartitions() const;
+
     /// Get the Navigation mesh assigned to the crowd.
     NavigationMesh* GetNavigationMesh() const { return navigationMesh_; }
 
@@ -170,6 +181,8 @@ protected:
 
     /// Get the internal detour crowd component.
     dtCrowd* GetCrowd() const { return crowd_; }
+    /// Get the internal detour crowd component that simulates the agent.
+    dtCrowd* GetAgentCrowd(const CrowdAgent* agent) const;
 
 private:
     /// Handle the scene subsystem update event.
@@ -178,6 +191,20 @@ private:
     void HandleNavMeshChanged(StringHash eventType, VariantMap& eventData);
     /// Handle component added in the scene to check for late addition of the navmesh.
     void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
+    /// Update the partitioned crowd simulation.
+    void UpdatePartitions(float delta);
+    /// Return the partition region index of a world position.
+    IntVector2 GetPartitionIndex(const float* position) const;
+    /// Return the partition of a region, creating it if necessary. Return null if the Detour crowd could not be initialized.
+    CrowdPartition* GetOrCreatePartition(const IntVector2& index);
+    /// Move an agent to another partition, preserving its movement state. Return true if successful.
+    bool MoveAgentToPartition(CrowdAgent* agent, CrowdPartition* partition);
+    /// Mirror agents of the neighbouring partitions that are within the margin of the partition's region as ghost agents.
+    void UpdateGhostAgents(CrowdPartition* partition, float margin);
+    /// Copy the query filter and obstacle avoidance configuration to a partition's Detour crowd.
+    void ApplyPartitionConfiguration(dtCrowd* crowd) const;
+    /// Detach the agents from all partitions and remove the partitions.
+    void RemovePartitions();
 
     /// Internal Detour crowd object.
     dtCrowd* crowd_{};
@@ -195,6 +222,12 @@ private:
     PODVector<unsigned> numAreas_;
     /// Number of obstacle avoidance types configured in the crowd. Limit to DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS.
     unsigned numObstacleAvoidanceTypes_{};
+    /// Size of the partition regions. Zero when the crowd is not partitioned.
+    float partitionSize_{};
+    /// Crowd partitions by region index.
+    HashMap<IntVector2, SharedPtr<CrowdPartition> > partitions_;
+    /// Flag for the query filter or obstacle avoidance configuration having changed since it was copied to the partitions.
+    bool partitionConfigDirty_{};
 };
 
 }
@@ -348,6 +348,7 @@ bool DynamicNavigationMesh::Build()
 
     Vector<NavigationGeometryInfo> geometryList;
     CollectGeometries(geometryList);
+    SetBuiltGeometry(geometryList);
 
     if (geometryList.Empty())
         return true; // Nothing to do
@@ -456,6 +457,9 @@ bool DynamicNavigationMesh::Build()
 
         URHO3D_LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
 
+        if (GetPathClusterSize())
+            BuildPathClusters();
+
         // Send a notification event to concerned parties that we've been fully rebuilt
         {
             using namespace NavigationMeshRebuilt;
@@ -538,6 +542,33 @@ bool DynamicNavigationMesh::Build(const IntVector2& from, const IntVector2& to)
     return true;
 }
 
+bool DynamicNavigationMesh::BuildChangedTiles()
+{
+    URHO3D_PROFILE(BuildChangedNavigationMeshTiles);
+
+    if (!node_)
+        return false;
+
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Navigation mesh must first be built fully before changed tiles can be rebuilt");
+        return false;
+    }
+
+    Vector<NavigationGeometryInfo> geometryList;
+    CollectGeometries(geometryList);
+
+    PODVector<IntVector2> tiles;
+    GetChangedTiles(tiles, geometryList);
+
+    unsigned numTiles = 0;
+    for (unsigned i = 0; i < tiles.Size(); ++i)
+        numTiles += BuildTiles(geometryList, tiles[i], tiles[i]);
+
+    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " changed tiles of the navigation mesh");
+    return true;
+}
+
 PODVector<unsigned char> DynamicNavigationMesh::GetTileData(const IntVector2& tile) const
 {
     VectorBuffer ret;
@@ -725,7 +756,8 @@ void DynamicNavigationMesh::SetNavigationDataAttr(const PODVector<unsigned char>
 PODVector<unsigned char> DynamicNavigationMesh::GetNavigationDataAttr() const
 {
     VectorBuffer ret;
-    if (navMesh_ && tileCache_)
+    // When streaming, the tiles are in the tile file instead of the scene
+    if (navMesh_ && tileCache_ && !IsStreaming())
     {
         ret.WriteBoundingBox(boundingBox_);
         ret.WriteInt(numTilesX_);
@@ -800,6 +832,7 @@ bool DynamicNavigationMesh::ReadTiles(Deserializer& source, bool silent)
         tileCache_->buildNavMeshTilesAt(tileQueue_[i].x_, tileQueue_[i].y_, navMesh_);
 
     tileCache_->update(0, navMesh_);
+    pathClustersDirty_ = true;
 
     // Send event
     if (!silent)
@@ -1032,6 +1065,7 @@ unsigned DynamicNavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geome
             }
         }
     }
+    pathClustersDirty_ = true;
 
     return numTiles;
 }
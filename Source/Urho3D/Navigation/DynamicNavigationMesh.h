@@ -62,6 +62,8 @@ public:
     bool Build(const BoundingBox& boundingBox) override;
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     bool Build(const IntVector2& from, const IntVector2& to) override;
+    /// Rebuild only the tiles overlapped by navigable geometry that changed since the last full or changed tiles build. Return true if successful.
+    bool BuildChangedTiles() override;
     /// Return tile data.
     PODVector<unsigned char> GetTileData(const IntVector2& tile) const override;
     /// Return whether the Obstacle is touching the given tile.
@@ -66,6 +66,17 @@ URHO3D_EVENT(E_NAVIGATION_ALL_TILES_REMOVED, NavigationAllTilesRemoved)
     URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
 }
 
+/// Asynchronous path query has finished.
+URHO3D_EVENT(E_NAVIGATION_PATH_RESULT, NavigationPathResult)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_ID, ID); // unsigned
+    URHO3D_PARAM(P_SUCCESS, Success); // bool
+    URHO3D_PARAM(P_PATH, Path); // VariantVector of Vector3
+    URHO3D_PARAM(P_LATENCY, Latency); // float
+}
+
 /// Crowd agent formation.
 URHO3D_EVENT(E_CROWD_AGENT_FORMATION, CrowdAgentFormation)
 {
@@ -22,8 +22,12 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../Core/Context.h"
+#include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -31,6 +35,7 @@
 #include "../Graphics/StaticModel.h"
 #include "../Graphics/TerrainPatch.h"
 #include "../Graphics/VertexBuffer.h"
+#include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Navigation/CrowdAgent.h"
@@ -45,7 +50,9 @@
 #ifdef URHO3D_PHYSICS
 #include "../Physics/CollisionShape.h"
 #endif
+#include "../Resource/ResourceCache.h"
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -82,6 +89,18 @@ static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
 
 static const int MAX_POLYS = 2048;
+/// Number of tiles prepared per work queue thread at a time when building in parallel.
+static const unsigned TILES_PER_THREAD = 4;
+static const unsigned DEFAULT_PATH_ITERATION_BUDGET = 4096;
+static const unsigned DEFAULT_MAX_ACTIVE_PATH_QUERIES = 16;
+/// Number of times an asynchronous path query is started over when the navigation mesh changes under it.
+static const unsigned MAX_PATH_QUERY_RESTARTS = 2;
+static const int DEFAULT_STREAMING_DISTANCE = 2;
+static const unsigned DEFAULT_MAX_STREAMED_TILES = 64;
+/// Maximum number of tiles read from the tile file at the same time.
+static const unsigned MAX_STREAMED_TILE_READS = 8;
+/// Maximum number of tile layers at the same tile index.
+static const int MAX_TILE_LAYERS = 255;
 
 
 /// Temporary data for finding a path.
@@ -97,12 +116,612 @@ struct FindPathData
     unsigned char pathFlags_[MAX_POLYS]{};
 };
 
+/// Detour query with its own path buffers, used by one asynchronous path query at a time.
+struct NavigationPathSlot
+{
+    /// Destruct.
+    ~NavigationPathSlot() { dtFreeNavMeshQuery(query_); }
+
+    /// Detour navigation mesh query.
+    dtNavMeshQuery* query_{};
+    /// Path buffers.
+    FindPathData data_;
+};
+
+/// Asynchronous path query.
+struct NavigationPathQuery : public RefCounted
+{
+    /// Query ID.
+    unsigned id_{};
+    /// Priority.
+    unsigned priority_{};
+    /// Start point in navigation mesh space.
+    Vector3 start_;
+    /// End point in navigation mesh space.
+    Vector3 end_;
+    /// Search extents.
+    Vector3 extents_;
+    /// Query filter.
+    dtQueryFilter filter_;
+    /// Detour query in use while the query is in progress.
+    NavigationPathSlot* slot_{};
+    /// End polygon.
+    dtPolyRef endRef_{};
+    /// Whether the sliced search has been initialized.
+    bool started_{};
+    /// Whether the query has finished.
+    bool finished_{};
+    /// Number of times started over.
+    unsigned restarts_{};
+    /// A* iterations allowed on this update.
+    unsigned iterationBudget_{};
+    /// A* iterations used on this update.
+    unsigned iterations_{};
+    /// Resulting path in navigation mesh space.
+    PODVector<Vector3> path_;
+    /// Time since the query was queued.
+    HiresTimer timer_;
+};
+
+/// Queue of asynchronous path queries.
+struct NavigationPathQueue
+{
+    /// Destruct.
+    ~NavigationPathQueue() { ReleaseSlots(); }
+
+    /// Free the Detour queries, and put the queries in progress back to wait for the next navigation mesh.
+    void ReleaseSlots()
+    {
+        for (unsigned i = 0; i < active_.Size(); ++i)
+        {
+            NavigationPathQuery* query = active_[i];
+            delete query->slot_;
+            query->slot_ = nullptr;
+            query->started_ = false;
+            query->restarts_ = 0;
+        }
+        pending_.Insert(0, active_);
+        active_.Clear();
+
+        for (unsigned i = 0; i < freeSlots_.Size(); ++i)
+            delete freeSlots_[i];
+        freeSlots_.Clear();
+    }
+
+    /// Queries waiting to start, sorted by priority.
+    Vector<SharedPtr<NavigationPathQuery> > pending_;
+    /// Queries in progress.
+    Vector<SharedPtr<NavigationPathQuery> > active_;
+    /// Detour queries not in use.
+    PODVector<NavigationPathSlot*> freeSlots_;
+    /// Next query ID.
+    unsigned nextId_{1};
+    /// A* iterations per update.
+    unsigned iterationBudget_{DEFAULT_PATH_ITERATION_BUDGET};
+    /// Maximum number of queries in progress.
+    unsigned maxActive_{DEFAULT_MAX_ACTIVE_PATH_QUERIES};
+    /// Sum of the latencies of the completed queries.
+    double totalLatency_{};
+    /// Statistics.
+    NavigationPathStats stats_;
+};
+
+/// Advance an asynchronous path query. Safe to call from worker threads, as each query has its own Detour query.
+static void AdvancePathQuery(NavigationPathQuery* query)
+{
+    dtNavMeshQuery* navMeshQuery = query->slot_->query_;
+    FindPathData& data = query->slot_->data_;
+    query->iterations_ = 0;
+
+    if (!query->started_)
+    {
+        dtPolyRef startRef = 0;
+        navMeshQuery->findNearestPoly(&query->start_.x_, &query->extents_.x_, &query->filter_, &startRef, nullptr);
+        navMeshQuery->findNearestPoly(&query->end_.x_, &query->extents_.x_, &query->filter_, &query->endRef_, nullptr);
+
+        if (!startRef || !query->endRef_ || dtStatusFailed(navMeshQuery->initSlicedFindPath(startRef, query->endRef_,
+            &query->start_.x_, &query->end_.x_, &query->filter_)))
+        {
+            query->finished_ = true;
+            return;
+        }
+
+        query->started_ = true;
+    }
+
+    int iterations = 0;
+    dtStatus status = navMeshQuery->updateSlicedFindPath((int)query->iterationBudget_, &iterations);
+    query->iterations_ = (unsigned)iterations;
+    if (dtStatusInProgress(status))
+        return;
+
+    if (dtStatusFailed(status))
+    {
+        // The polygons on the search path have been removed by a tile rebuild. Start over, unless it keeps happening
+        if (query->restarts_++ < MAX_PATH_QUERY_RESTARTS)
+            query->started_ = false;
+        else
+            query->finished_ = true;
+        return;
+    }
+
+    int numPolys = 0;
+    navMeshQuery->finalizeSlicedFindPath(data.polys_, &numPolys, MAX_POLYS);
+
+    if (numPolys)
+    {
+        Vector3 actualEnd = query->end_;
+
+        // If full path was not found, clamp end point to the end polygon
+        if (data.polys_[numPolys - 1] != query->endRef_)
+            navMeshQuery->closestPointOnPoly(data.polys_[numPolys - 1], &query->end_.x_, &actualEnd.x_, nullptr);
+
+        int numPathPoints = 0;
+        navMeshQuery->findStraightPath(&query->start_.x_, &actualEnd.x_, data.polys_, numPolys, &data.pathPoints_[0].x_,
+            data.pathFlags_, data.pathPolys_, &numPathPoints, MAX_POLYS);
+
+        query->path_.Resize((unsigned)numPathPoints);
+        for (int i = 0; i < numPathPoints; ++i)
+            query->path_[i] = data.pathPoints_[i];
+    }
+
+    query->finished_ = true;
+}
+
+/// Work function for advancing an asynchronous path query.
+static void AdvancePathQueryWork(const WorkItem* item, unsigned threadIndex)
+{
+    AdvancePathQuery(reinterpret_cast<NavigationPathQuery*>(item->start_));
+}
+
+/// Navigation mesh tile being built.
+struct NavigationTileBuild
+{
+    /// Destruct. Free the tile data if it was not added to the navigation mesh.
+    ~NavigationTileBuild() { dtFree(navData_); }
+
+    /// Navigation mesh.
+    NavigationMesh* mesh_{};
+    /// Tile index.
+    IntVector2 tile_;
+    /// Tile bounding box.
+    BoundingBox boundingBox_;
+    /// Recast configuration.
+    rcConfig cfg_;
+    /// Geometry and Recast intermediate data.
+    SimpleNavBuildData build_;
+    /// Detour tile data, null if the tile is empty.
+    unsigned char* navData_{};
+    /// Detour tile data size.
+    int navDataSize_{};
+    /// Whether the build was successful.
+    bool success_{};
+    /// Build time in microseconds.
+    long long buildTime_{};
+};
+
+/// Location of a tile in a tile file.
+struct NavigationTileEntry
+{
+    /// Offset from the start of the tile data.
+    unsigned offset_{};
+    /// Size in bytes.
+    unsigned size_{};
+};
+
+/// Tile being read from a tile file on the work queue.
+struct NavigationTileRead : public RefCounted
+{
+    /// Tile index.
+    IntVector2 tile_;
+    /// Location in the tile file.
+    NavigationTileEntry entry_;
+    /// Work item reading the tile.
+    SharedPtr<WorkItem> item_;
+    /// Tile data, empty if the read failed.
+    PODVector<unsigned char> data_;
+    /// Whether the read has finished.
+    volatile bool finished_{};
+};
+
+/// Tile streaming state.
+struct NavigationTileStream
+{
+    /// Tile file name.
+    String fileName_;
+    /// Open tile file.
+    SharedPtr<File> file_;
+    /// Mutex for reading the tile file on the work queue threads.
+    Mutex fileMutex_;
+    /// File position of the tile data.
+    unsigned dataStart_{};
+    /// Tiles in the tile file.
+    HashMap<IntVector2, NavigationTileEntry> directory_;
+    /// Tile reads in progress.
+    Vector<SharedPtr<NavigationTileRead> > reads_;
+    /// Streamed in tiles.
+    HashSet<IntVector2> tiles_;
+    /// Nodes around which the tiles are streamed in.
+    Vector<WeakPtr<Node> > observers_;
+    /// Distance in tiles around the observers within which the tiles are streamed in.
+    int distance_{DEFAULT_STREAMING_DISTANCE};
+    /// Maximum number of streamed in tiles.
+    unsigned maxTiles_{DEFAULT_MAX_STREAMED_TILES};
+};
+
+/// Read a tile from the tile file. Safe to call from worker threads, as the file access is serialized.
+static void ReadStreamedTileWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* read = reinterpret_cast<NavigationTileRead*>(item->start_);
+    auto* stream = reinterpret_cast<NavigationTileStream*>(item->aux_);
+
+    {
+        MutexLock lock(stream->fileMutex_);
+        unsigned position = stream->dataStart_ + read->entry_.offset_;
+        read->data_.Resize(read->entry_.size_);
+        if (stream->file_->Seek(position) != position || stream->file_->Read(&read->data_[0], read->entry_.size_) != read->entry_.size_)
+            read->data_.Clear();
+    }
+
+    read->finished_ = true;
+}
+
+/// Return the distance in tiles from a tile to the nearest of the center tiles.
+static int GetTileDistance(const IntVector2& tile, const PODVector<IntVector2>& centers)
+{
+    int distance = M_MAX_INT;
+    for (unsigned i = 0; i < centers.Size(); ++i)
+        distance = Min(distance, Max(Abs(tile.x_ - centers[i].x_), Abs(tile.y_ - centers[i].y_)));
+    return distance;
+}
+
+/// Edge of a graph used in hierarchical path queries.
+struct NavigationGraphEdge
+{
+    /// Node at the other end.
+    unsigned target_;
+    /// Path cost.
+    float cost_;
+};
+
+/// Edge between portals of a path cluster.
+struct NavigationPortalEdge
+{
+    /// Portal at the other end.
+    unsigned target_;
+    /// Cluster the edge runs through.
+    unsigned cluster_;
+    /// Path cost.
+    float cost_;
+};
+
+/// Item in the open list of a graph search.
+struct NavigationSearchItem
+{
+    /// Path cost to the node.
+    float cost_;
+    /// Node.
+    unsigned node_;
+};
+
+/// Connection between neighbouring path clusters, placed where a polygon link crosses the cluster border.
+struct NavigationPortal
+{
+    /// Position on the cluster border in navigation mesh space.
+    Vector3 position_;
+    /// Polygon on each side of the border.
+    dtPolyRef polys_[2];
+    /// Cluster on each side of the border.
+    unsigned clusters_[2];
+};
+
+/// Polygons of a path cluster as a compact graph.
+struct NavigationClusterGraph
+{
+    /// Node indices of the polygons.
+    HashMap<dtPolyRef, unsigned> nodes_;
+    /// Polygon centers.
+    PODVector<Vector3> centers_;
+    /// Polygon area costs.
+    PODVector<float> areaCosts_;
+    /// Index of the first edge of each node, followed by the total number of edges.
+    PODVector<unsigned> firstEdges_;
+    /// Edges to the neighbouring polygons within the cluster.
+    PODVector<NavigationGraphEdge> edges_;
+};
+
+/// Path clusters and the portal graph between them.
+struct NavigationPathClusters
+{
+    /// Cluster size in tiles.
+    int clusterSize_{};
+    /// Number of clusters in X direction.
+    int numClustersX_{};
+    /// Portals.
+    PODVector<NavigationPortal> portals_;
+    /// Portals of each cluster.
+    Vector<PODVector<unsigned> > clusterPortals_;
+    /// Edges from each portal to the other portals of the same clusters.
+    Vector<PODVector<NavigationPortalEdge> > portalEdges_;
+    /// Statistics.
+    NavigationClusterStats stats_;
+};
+
+/// Path cluster whose portals are being connected on the work queue.
+struct NavigationClusterBuild
+{
+    /// Navigation mesh.
+    const dtNavMesh* navMesh_{};
+    /// Query filter for the area costs.
+    const dtQueryFilter* filter_{};
+    /// Path clusters.
+    const NavigationPathClusters* clusters_{};
+    /// Cluster index.
+    unsigned cluster_{};
+    /// Resulting edges as source portal and edge pairs.
+    Vector<Pair<unsigned, NavigationPortalEdge> > edges_;
+};
+
+/// Add an item to a binary min-heap.
+static void PushSearchItem(PODVector<NavigationSearchItem>& heap, float cost, unsigned node)
+{
+    unsigned i = heap.Size();
+    heap.Resize(i + 1);
+    while (i > 0)
+    {
+        unsigned parent = (i - 1) / 2;
+        if (heap[parent].cost_ <= cost)
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i].cost_ = cost;
+    heap[i].node_ = node;
+}
+
+/// Remove and return the item with the lowest cost from a binary min-heap.
+static NavigationSearchItem PopSearchItem(PODVector<NavigationSearchItem>& heap)
+{
+    NavigationSearchItem top = heap[0];
+    NavigationSearchItem last = heap.Back();
+    heap.Pop();
+
+    unsigned i = 0;
+    const unsigned size = heap.Size();
+    while (size)
+    {
+        unsigned child = i * 2 + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && heap[child + 1].cost_ < heap[child].cost_)
+            ++child;
+        if (last.cost_ <= heap[child].cost_)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (size)
+        heap[i] = last;
+
+    return top;
+}
+
+/// Return whether a polygon passes the flags of a query filter. Same test as dtQueryFilter::passFilter, which is not exported.
+static bool PassFilter(const dtQueryFilter* filter, const dtPoly* poly)
+{
+    return (poly->flags & filter->getIncludeFlags()) != 0 && (poly->flags & filter->getExcludeFlags()) == 0;
+}
+
+/// Return the center of a polygon.
+static Vector3 GetPolyCenter(const dtMeshTile* tile, const dtPoly* poly)
+{
+    Vector3 center;
+    for (unsigned i = 0; i < poly->vertCount; ++i)
+        center += *reinterpret_cast<const Vector3*>(&tile->verts[poly->verts[i] * 3]);
+    return center / (float)poly->vertCount;
+}
+
+/// Return the path cluster of a polygon.
+static unsigned GetPolyCluster(const dtNavMesh* navMesh, const NavigationPathClusters& clusters, dtPolyRef ref)
+{
+    const dtMeshTile* tile = nullptr;
+    const dtPoly* poly = nullptr;
+    navMesh->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+    return (unsigned)(tile->header->y / clusters.clusterSize_ * clusters.numClustersX_ + tile->header->x / clusters.clusterSize_);
+}
+
+/// Collect the polygons of a path cluster and the links between them. Safe to call from worker threads.
+static void BuildClusterGraph(NavigationClusterGraph& graph, const dtNavMesh* navMesh, const dtQueryFilter* filter,
+    const NavigationPathClusters& clusters, unsigned cluster)
+{
+    graph.nodes_.Clear();
+    graph.centers_.Clear();
+    graph.areaCosts_.Clear();
+    graph.firstEdges_.Clear();
+    graph.edges_.Clear();
+
+    const int beginX = (int)(cluster % clusters.numClustersX_) * clusters.clusterSize_;
+    const int beginZ = (int)(cluster / clusters.numClustersX_) * clusters.clusterSize_;
+    const dtMeshTile* tiles[MAX_TILE_LAYERS];
+    PODVector<const dtMeshTile*> polyTiles;
+    PODVector<const dtPoly*> polys;
+
+    for (int z = beginZ; z < beginZ + clusters.clusterSize_; ++z)
+    {
+        for (int x = beginX; x < beginX + clusters.clusterSize_; ++x)
+        {
+            const int numTiles = navMesh->getTilesAt(x, z, tiles, MAX_TILE_LAYERS);
+            for (int i = 0; i < numTiles; ++i)
+            {
+                const dtMeshTile* tile = tiles[i];
+                const dtPolyRef base = navMesh->getPolyRefBase(tile);
+                for (int j = 0; j < tile->header->polyCount; ++j)
+                {
+                    const dtPoly* poly = &tile->polys[j];
+                    const dtPolyRef ref = base | (dtPolyRef)j;
+                    if (!PassFilter(filter, poly))
+                        continue;
+
+                    graph.nodes_[ref] = polys.Size();
+                    graph.centers_.Push(GetPolyCenter(tile, poly));
+                    graph.areaCosts_.Push(filter->getAreaCost(poly->getArea()));
+                    polyTiles.Push(tile);
+                    polys.Push(poly);
+                }
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < polys.Size(); ++i)
+    {
+        graph.firstEdges_.Push(graph.edges_.Size());
+
+        const dtMeshTile* tile = polyTiles[i];
+        for (unsigned j = polys[i]->firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+        {
+            HashMap<dtPolyRef, unsigned>::ConstIterator k = graph.nodes_.Find(tile->links[j].ref);
+            if (k == graph.nodes_.End())
+                continue;
+
+            NavigationGraphEdge edge;
+            edge.target_ = k->second_;
+            edge.cost_ = (graph.centers_[k->second_] - graph.centers_[i]).Length() * graph.areaCosts_[i];
+            graph.edges_.Push(edge);
+        }
+    }
+    graph.firstEdges_.Push(graph.edges_.Size());
+}
+
+/// Find the path costs from a position on a polygon to the polygons of its path cluster.
+static void SearchClusterGraph(PODVector<float>& costs, const NavigationClusterGraph& graph, unsigned start, float startCost)
+{
+    costs.Resize(graph.centers_.Size());
+    for (unsigned i = 0; i < costs.Size(); ++i)
+        costs[i] = M_INFINITY;
+
+    PODVector<NavigationSearchItem> open;
+    costs[start] = startCost;
+    PushSearchItem(open, startCost, start);
+
+    while (open.Size())
+    {
+        NavigationSearchItem item = PopSearchItem(open);
+        if (item.cost_ > costs[item.node_])
+            continue;
+
+        for (unsigned i = graph.firstEdges_[item.node_]; i < graph.firstEdges_[item.node_ + 1]; ++i)
+        {
+            const NavigationGraphEdge& edge = graph.edges_[i];
+            float cost = item.cost_ + edge.cost_;
+            if (cost < costs[edge.target_])
+            {
+                costs[edge.target_] = cost;
+                PushSearchItem(open, cost, edge.target_);
+            }
+        }
+    }
+}
+
+/// Find the path costs from a position on a polygon to the portals of its path cluster, indexed by portal. Return false if the
+/// polygon is not part of the cluster.
+static bool SearchClusterPortals(PODVector<float>& portalCosts, const NavigationClusterGraph& graph,
+    const NavigationPathClusters& clusters, unsigned cluster, dtPolyRef ref, const Vector3& position)
+{
+    HashMap<dtPolyRef, unsigned>::ConstIterator i = graph.nodes_.Find(ref);
+    if (i == graph.nodes_.End())
+        return false;
+
+    PODVector<float> costs;
+    SearchClusterGraph(costs, graph, i->second_, (position - graph.centers_[i->second_]).Length() * graph.areaCosts_[i->second_]);
+
+    portalCosts.Resize(clusters.portals_.Size());
+    for (unsigned j = 0; j < portalCosts.Size(); ++j)
+        portalCosts[j] = M_INFINITY;
+
+    const PODVector<unsigned>& portals = clusters.clusterPortals_[cluster];
+    for (unsigned j = 0; j < portals.Size(); ++j)
+    {
+        const NavigationPortal& portal = clusters.portals_[portals[j]];
+        HashMap<dtPolyRef, unsigned>::ConstIterator k = graph.nodes_.Find(portal.polys_[portal.clusters_[0] == cluster ? 0 : 1]);
+        if (k != graph.nodes_.End() && costs[k->second_] < M_INFINITY)
+        {
+            portalCosts[portals[j]] = costs[k->second_] + (portal.position_ - graph.centers_[k->second_]).Length() *
+                graph.areaCosts_[k->second_];
+        }
+    }
+
+    return true;
+}
+
+/// Connect the portals of a path cluster to each other. Safe to call from worker threads.
+static void ConnectClusterPortals(NavigationClusterBuild& build)
+{
+    const NavigationPathClusters& clusters = *build.clusters_;
+    NavigationClusterGraph graph;
+    BuildClusterGraph(graph, build.navMesh_, build.filter_, clusters, build.cluster_);
+
+    const PODVector<unsigned>& portals = clusters.clusterPortals_[build.cluster_];
+    PODVector<float> portalCosts;
+    for (unsigned i = 0; i < portals.Size(); ++i)
+    {
+        const NavigationPortal& portal = clusters.portals_[portals[i]];
+        if (!SearchClusterPortals(portalCosts, graph, clusters, build.cluster_, portal.polys_[portal.clusters_[0] == build.cluster_ ?
+            0 : 1], portal.position_))
+            continue;
+
+        for (unsigned j = 0; j < portals.Size(); ++j)
+        {
+            if (j == i || portalCosts[portals[j]] == M_INFINITY)
+                continue;
+
+            NavigationPortalEdge edge;
+            edge.target_ = portals[j];
+            edge.cluster_ = build.cluster_;
+            edge.cost_ = portalCosts[portals[j]];
+            build.edges_.Push(MakePair(portals[i], edge));
+        }
+    }
+}
+
+/// Connect the portals of a path cluster on the work queue.
+static void ConnectClusterPortalsWork(const WorkItem* item, unsigned threadIndex)
+{
+    ConnectClusterPortals(*reinterpret_cast<NavigationClusterBuild*>(item->start_));
+}
+
+/// Order border crossings by the clusters they connect, then along the border.
+static bool CompareBorderCrossings(const NavigationPortal& lhs, const NavigationPortal& rhs)
+{
+    if (lhs.clusters_[0] != rhs.clusters_[0])
+        return lhs.clusters_[0] < rhs.clusters_[0];
+    if (lhs.clusters_[1] != rhs.clusters_[1])
+        return lhs.clusters_[1] < rhs.clusters_[1];
+    return lhs.position_.x_ + lhs.position_.z_ < rhs.position_.x_ + rhs.position_.z_;
+}
+
+/// Find a polygon path between two polygons and append it to a polygon corridor. Return false if the path is partial.
+static bool AppendPathSegment(PODVector<dtPolyRef>& dest, dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+    const Vector3& start, const Vector3& end, const dtQueryFilter* filter, dtPolyRef* polys, int maxPolys)
+{
+    int numPolys = 0;
+    query->findPath(startRef, endRef, &start.x_, &end.x_, filter, polys, &numPolys, maxPolys);
+    if (!numPolys || polys[numPolys - 1] != endRef)
+        return false;
+
+    for (int i = dest.Size() && dest.Back() == polys[0] ? 1 : 0; i < numPolys; ++i)
+        dest.Push(polys[i]);
+    return true;
+}
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(nullptr),
     navMeshQuery_(nullptr),
     queryFilter_(new dtQueryFilter()),
     pathData_(new FindPathData()),
+    pathQueue_(new NavigationPathQueue()),
+    tileStream_(new NavigationTileStream()),
+    pathClusters_(new NavigationPathClusters()),
     tileSize_(DEFAULT_TILE_SIZE),
     cellSize_(DEFAULT_CELL_SIZE),
     cellHeight_(DEFAULT_CELL_HEIGHT),
@@ -122,12 +741,15 @@ NavigationMesh::NavigationMesh(Context* context) :
     partitionType_(NAVMESH_PARTITION_WATERSHED),
     keepInterResults_(false),
     drawOffMeshConnections_(false),
-    drawNavAreas_(false)
+    drawNavAreas_(false),
+    threadedBuild_(true),
+    pathClustersDirty_(true)
 {
 }
 
 NavigationMesh::~NavigationMesh()
 {
+    StopStreaming();
     ReleaseNavigationMesh();
 }
 
@@ -153,10 +775,16 @@ void NavigationMesh::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Bounding Box Padding", GetPadding, SetPadding, Vector3, Vector3::ONE, AM_DEFAULT);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Navigation Data", GetNavigationDataAttr, SetNavigationDataAttr, PODVector<unsigned char>,
         Variant::emptyBuffer, AM_FILE | AM_NOEDIT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Streaming Distance", GetStreamingDistance, SetStreamingDistance, int, DEFAULT_STREAMING_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Streamed Tiles", GetMaxStreamedTiles, SetMaxStreamedTiles, unsigned, DEFAULT_MAX_STREAMED_TILES,
+        AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Streaming File", GetStreamingFile, SetStreamingFile, String, String::EMPTY, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Path Cluster Size", GetPathClusterSize, SetPathClusterSize, int, 0, AM_DEFAULT);
     URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Partition Type", GetPartitionType, SetPartitionType, NavmeshPartitionType, navmeshPartitionTypeNames,
         NAVMESH_PARTITION_WATERSHED, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw OffMeshConnections", GetDrawOffMeshConnections, SetDrawOffMeshConnections, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw NavAreas", GetDrawNavAreas, SetDrawNavAreas, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Threaded Build", GetThreadedBuild, SetThreadedBuild, bool, true, AM_DEFAULT);
 }
 
 void NavigationMesh::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -396,6 +1024,7 @@ bool NavigationMesh::Build()
 
     Vector<NavigationGeometryInfo> geometryList;
     CollectGeometries(geometryList);
+    SetBuiltGeometry(geometryList);
 
     if (geometryList.Empty())
         return true; // Nothing to do
@@ -447,7 +1076,11 @@ bool NavigationMesh::Build()
         // Build each tile
         unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, GetNumTiles() - IntVector2::ONE);
 
-        URHO3D_LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
+        URHO3D_LOGDEBUGF("Built navigation mesh with %u tiles in %f ms, longest tile %f ms", numTiles,
+            buildStats_.totalTime_ / 1000.0, buildStats_.maxTileTime_ / 1000.0);
+
+        if (GetPathClusterSize())
+            BuildPathClusters();
 
         // Send a notification event to concerned parties that we've been fully rebuilt
         {
@@ -521,6 +1154,30 @@ bool NavigationMesh::Build(const IntVector2& from, const IntVector2& to)
     return true;
 }
 
+bool NavigationMesh::BuildChangedTiles()
+{
+    URHO3D_PROFILE(BuildChangedNavigationMeshTiles);
+
+    if (!node_)
+        return false;
+
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Navigation mesh must first be built fully before changed tiles can be rebuilt");
+        return false;
+    }
+
+    Vector<NavigationGeometryInfo> geometryList;
+    CollectGeometries(geometryList);
+
+    PODVector<IntVector2> tiles;
+    GetChangedTiles(tiles, geometryList);
+    unsigned numTiles = BuildTiles(geometryList, tiles);
+
+    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " changed tiles of the navigation mesh");
+    return true;
+}
+
 PODVector<unsigned char> NavigationMesh::GetTileData(const IntVector2& tile) const
 {
     VectorBuffer ret;
@@ -575,6 +1232,7 @@ void NavigationMesh::RemoveTile(const IntVector2& tile)
         return;
 
     navMesh_->removeTile(tileRef, nullptr, nullptr);
+    pathClustersDirty_ = true;
 
     // Send event
     using namespace NavigationTileRemoved;
@@ -595,6 +1253,7 @@ void NavigationMesh::RemoveAllTiles()
         if (tile->header)
             navMesh_->removeTile(navMesh_->getTileRef(tile), nullptr, nullptr);
     }
+    pathClustersDirty_ = true;
 
     // Send event
     using namespace NavigationAllTilesRemoved;
@@ -651,10 +1310,10 @@ Vector3 NavigationMesh::MoveAlongSurface(const Vector3& start, const Vector3& en
 }
 
 void NavigationMesh::FindPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end, const Vector3& extents,
-    const dtQueryFilter* filter)
+    const dtQueryFilter* filter, bool hierarchical)
 {
     PODVector<NavigationPathPoint> navPathPoints;
-    FindPath(navPathPoints, start, end, extents, filter);
+    FindPath(navPathPoints, start, end, extents, filter, hierarchical);
 
     dest.Clear();
     for (unsigned i = 0; i < navPathPoints.Size(); ++i)
@@ -662,7 +1321,7 @@ void NavigationMesh::FindPath(PODVector<Vector3>& dest, const Vector3& start, co
 }
 
 void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end,
-    const Vector3& extents, const dtQueryFilter* filter)
+    const Vector3& extents, const dtQueryFilter* filter, bool hierarchical)
 {
     URHO3D_PROFILE(FindPath);
     dest.Clear();
@@ -688,19 +1347,29 @@ void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, const Vector
 
     int numPolys = 0;
     int numPathPoints = 0;
+    const dtPolyRef* polys = pathData_->polys_;
+    PODVector<dtPolyRef> clusterPath;
 
-    navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData_->polys_, &numPolys,
-        MAX_POLYS);
+    if (hierarchical && FindClusterPath(clusterPath, startRef, endRef, localStart, localEnd, queryFilter))
+    {
+        polys = &clusterPath[0];
+        numPolys = clusterPath.Size();
+    }
+    else
+    {
+        navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData_->polys_, &numPolys,
+            MAX_POLYS);
+    }
     if (!numPolys)
         return;
 
     Vector3 actualLocalEnd = localEnd;
 
     // If full path was not found, clamp end point to the end polygon
-    if (pathData_->polys_[numPolys - 1] != endRef)
-        navMeshQuery_->closestPointOnPoly(pathData_->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, nullptr);
+    if (polys[numPolys - 1] != endRef)
+        navMeshQuery_->closestPointOnPoly(polys[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, nullptr);
 
-    navMeshQuery_->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData_->polys_, numPolys,
+    navMeshQuery_->findStraightPath(&localStart.x_, &actualLocalEnd.x_, polys, numPolys,
         &pathData_->pathPoints_[0].x_, pathData_->pathFlags_, pathData_->pathPolys_, &numPathPoints, MAX_POLYS);
 
     // Transform path result back to world space
@@ -737,55 +1406,637 @@ void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, const Vector
     }
 }
 
-Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
+unsigned NavigationMesh::FindPathAsync(const Vector3& start, const Vector3& end, unsigned priority, const Vector3& extents,
+    const dtQueryFilter* filter)
 {
-    if (!InitializeQuery())
-        return Vector3::ZERO;
-
-    dtPolyRef polyRef;
-    Vector3 point(Vector3::ZERO);
+    NavigationPathQueue& queue = *pathQueue_;
 
-    navMeshQuery_->findRandomPoint(filter ? filter : queryFilter_.Get(), Random, randomRef ? randomRef : &polyRef, &point.x_);
+    SharedPtr<NavigationPathQuery> query(new NavigationPathQuery());
+    query->id_ = queue.nextId_++;
+    if (!queue.nextId_)
+        queue.nextId_ = 1;
+    query->priority_ = priority;
+    query->extents_ = extents;
+    query->filter_ = filter ? *filter : *queryFilter_;
 
-    return node_->GetWorldTransform() * point;
-}
+    // Navigation data is in local space. Transform path points from world to local
+    Matrix3x4 inverse = node_ ? node_->GetWorldTransform().Inverse() : Matrix3x4::IDENTITY;
+    query->start_ = inverse * start;
+    query->end_ = inverse * end;
 
-Vector3 NavigationMesh::GetRandomPointInCircle(const Vector3& center, float radius, const Vector3& extents,
-    const dtQueryFilter* filter, dtPolyRef* randomRef)
-{
-    if (randomRef)
-        *randomRef = 0;
+    // Keep the pending queries sorted by descending priority, and in queuing order within the same priority
+    unsigned index = queue.pending_.Size();
+    while (index > 0 && queue.pending_[index - 1]->priority_ < priority)
+        --index;
+    queue.pending_.Insert(index, query);
+    queue.stats_.numPending_ = queue.pending_.Size();
 
-    if (!InitializeQuery())
-        return center;
+    Scene* scene = GetScene();
+    if (scene && !HasSubscribedToEvent(scene, E_SCENEPOSTUPDATE))
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandleScenePostUpdate));
 
-    const Matrix3x4& transform = node_->GetWorldTransform();
-    Matrix3x4 inverse = transform.Inverse();
-    Vector3 localCenter = inverse * center;
+    return query->id_;
+}
 
-    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.Get();
-    dtPolyRef startRef;
-    navMeshQuery_->findNearestPoly(&localCenter.x_, &extents.x_, queryFilter, &startRef, nullptr);
-    if (!startRef)
-        return center;
+bool NavigationMesh::CancelPathQuery(unsigned id)
+{
+    NavigationPathQueue& queue = *pathQueue_;
 
-    dtPolyRef polyRef;
-    if (!randomRef)
-        randomRef = &polyRef;
-    Vector3 point(localCenter);
+    for (unsigned i = 0; i < queue.pending_.Size(); ++i)
+    {
+        if (queue.pending_[i]->id_ == id)
+        {
+            queue.pending_.Erase(i);
+            queue.stats_.numPending_ = queue.pending_.Size();
+            return true;
+        }
+    }
 
-    navMeshQuery_->findRandomPointAroundCircle(startRef, &localCenter.x_, radius, queryFilter, Random, randomRef, &point.x_);
+    for (unsigned i = 0; i < queue.active_.Size(); ++i)
+    {
+        if (queue.active_[i]->id_ == id)
+        {
+            queue.freeSlots_.Push(queue.active_[i]->slot_);
+            queue.active_.Erase(i);
+            queue.stats_.numActive_ = queue.active_.Size();
+            return true;
+        }
+    }
 
-    return transform * point;
+    return false;
 }
 
-float NavigationMesh::GetDistanceToWall(const Vector3& point, float radius, const Vector3& extents, const dtQueryFilter* filter,
-    Vector3* hitPos, Vector3* hitNormal)
+void NavigationMesh::UpdatePathQueries()
 {
-    if (hitPos)
-        *hitPos = Vector3::ZERO;
-    if (hitNormal)
-        *hitNormal = Vector3::DOWN;
+    URHO3D_PROFILE(UpdatePathQueries);
+
+    NavigationPathQueue& queue = *pathQueue_;
+    queue.stats_.iterations_ = 0;
+
+    if (queue.pending_.Empty() && queue.active_.Empty())
+        return;
+
+    if (!InitializeQuery())
+    {
+        SendPathResults(true);
+        return;
+    }
+
+    // Start the highest priority queries. Each query in progress needs its own Detour query, as it holds the sliced search state
+    while (queue.active_.Size() < queue.maxActive_ && !queue.pending_.Empty())
+    {
+        if (queue.freeSlots_.Empty())
+        {
+            auto* slot = new NavigationPathSlot();
+            slot->query_ = dtAllocNavMeshQuery();
+            if (!slot->query_ || dtStatusFailed(slot->query_->init(navMesh_, MAX_POLYS)))
+            {
+                URHO3D_LOGERROR("Could not init navigation mesh query");
+                delete slot;
+                break;
+            }
+            queue.freeSlots_.Push(slot);
+        }
+
+        SharedPtr<NavigationPathQuery> query = queue.pending_.Front();
+        queue.pending_.Erase(0);
+        query->slot_ = queue.freeSlots_.Back();
+        queue.freeSlots_.Pop();
+        queue.active_.Push(query);
+    }
+
+    // Share the iteration budget between the queries in progress and advance them in parallel
+    unsigned iterationBudget = Max(queue.iterationBudget_ / Max(queue.active_.Size(), 1U), 1U);
+    for (unsigned i = 0; i < queue.active_.Size(); ++i)
+        queue.active_[i]->iterationBudget_ = iterationBudget;
+
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    if (workQueue && workQueue->GetNumThreads() && queue.active_.Size() > 1)
+    {
+        for (unsigned i = 0; i < queue.active_.Size(); ++i)
+        {
+            SharedPtr<WorkItem> item = workQueue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = AdvancePathQueryWork;
+            item->start_ = queue.active_[i].Get();
+            workQueue->AddWorkItem(item);
+        }
+        workQueue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < queue.active_.Size(); ++i)
+            AdvancePathQuery(queue.active_[i]);
+    }
+
+    for (unsigned i = 0; i < queue.active_.Size(); ++i)
+        queue.stats_.iterations_ += queue.active_[i]->iterations_;
+
+    SendPathResults(false);
+}
+
+void NavigationMesh::SetPathIterationBudget(unsigned iterations)
+{
+    pathQueue_->iterationBudget_ = Max(iterations, 1U);
+}
+
+void NavigationMesh::SetMaxActivePathQueries(unsigned num)
+{
+    pathQueue_->maxActive_ = Max(num, 1U);
+}
+
+unsigned NavigationMesh::GetPathIterationBudget() const
+{
+    return pathQueue_->iterationBudget_;
+}
+
+unsigned NavigationMesh::GetMaxActivePathQueries() const
+{
+    return pathQueue_->maxActive_;
+}
+
+const NavigationPathStats& NavigationMesh::GetPathStats() const
+{
+    return pathQueue_->stats_;
+}
+
+bool NavigationMesh::SaveStreamingData(Serializer& dest) const
+{
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Navigation mesh not built, can not save streaming data");
+        return false;
+    }
+    if (IsStreaming())
+    {
+        URHO3D_LOGERROR("Can not save streaming data while streaming, as only part of the tiles are loaded");
+        return false;
+    }
+
+    // Collect the tile data first, as the directory is written before it
+    Vector<Pair<IntVector2, PODVector<unsigned char> > > tiles;
+    for (int z = 0; z < numTilesZ_; ++z)
+    {
+        for (int x = 0; x < numTilesX_; ++x)
+        {
+            const IntVector2 tile(x, z);
+            PODVector<unsigned char> tileData = GetTileData(tile);
+            if (!tileData.Empty())
+                tiles.Push(MakePair(tile, tileData));
+        }
+    }
+
+    dest.WriteFileID("UNVT");
+    dest.WriteBoundingBox(boundingBox_);
+    dest.WriteInt(tileSize_);
+    dest.WriteFloat(cellSize_);
+    dest.WriteUInt(tiles.Size());
+
+    unsigned offset = 0;
+    for (unsigned i = 0; i < tiles.Size(); ++i)
+    {
+        dest.WriteIntVector2(tiles[i].first_);
+        dest.WriteUInt(offset);
+        dest.WriteUInt(tiles[i].second_.Size());
+        offset += tiles[i].second_.Size();
+    }
+
+    for (unsigned i = 0; i < tiles.Size(); ++i)
+    {
+        if (dest.Write(&tiles[i].second_[0], tiles[i].second_.Size()) != tiles[i].second_.Size())
+        {
+            URHO3D_LOGERROR("Failed to write navigation mesh streaming data");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void NavigationMesh::SetStreamingFile(const String& fileName)
+{
+    StopStreaming();
+
+    tileStream_->fileName_ = fileName;
+    if (!fileName.Empty())
+        StartStreaming();
+
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::AddStreamingObserver(Node* node)
+{
+    WeakPtr<Node> observer(node);
+    if (node && !tileStream_->observers_.Contains(observer))
+        tileStream_->observers_.Push(observer);
+}
+
+void NavigationMesh::RemoveStreamingObserver(Node* node)
+{
+    tileStream_->observers_.Remove(WeakPtr<Node>(node));
+}
+
+void NavigationMesh::SetStreamingDistance(int distance)
+{
+    tileStream_->distance_ = Max(distance, 0);
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::SetMaxStreamedTiles(unsigned num)
+{
+    NavigationTileStream& stream = *tileStream_;
+    num = Max(num, 1U);
+    if (num == stream.maxTiles_)
+        return;
+
+    stream.maxTiles_ = num;
+
+    // The navigation mesh is allocated for the maximum number of tiles, so start streaming over
+    if (stream.file_)
+    {
+        StopStreaming();
+        StartStreaming();
+    }
+
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::UpdateStreaming()
+{
+    NavigationTileStream& stream = *tileStream_;
+    if (!stream.file_ || !navMesh_)
+        return;
+
+    URHO3D_PROFILE(UpdateNavigationStreaming);
+
+    // Find the tiles the observers are on
+    PODVector<IntVector2> centers;
+    for (unsigned i = 0; i < stream.observers_.Size();)
+    {
+        if (Node* observer = stream.observers_[i])
+        {
+            centers.Push(GetTileIndex(observer->GetWorldPosition()));
+            ++i;
+        }
+        else
+            stream.observers_.Erase(i);
+    }
+
+    // Tiles are streamed out only one tile beyond the streaming distance, so that an observer moving back and forth over a tile
+    // border does not stream the same tiles in and out
+    const int maxDistance = stream.distance_ + 1;
+    PODVector<IntVector2> addedTiles;
+    PODVector<IntVector2> removedTiles;
+    Vector<SharedPtr<NavigationTileRead> > finishedReads;
+    for (unsigned i = 0; i < stream.reads_.Size();)
+    {
+        if (stream.reads_[i]->finished_)
+        {
+            finishedReads.Push(stream.reads_[i]);
+            stream.reads_.Erase(i);
+        }
+        else
+            ++i;
+    }
+    for (HashSet<IntVector2>::Iterator i = stream.tiles_.Begin(); i != stream.tiles_.End();)
+    {
+        if (GetTileDistance(*i, centers) > maxDistance)
+        {
+            removedTiles.Push(*i);
+            i = stream.tiles_.Erase(i);
+        }
+        else
+            ++i;
+    }
+
+    // The tile events may remove this component, or stop streaming
+    WeakPtr<NavigationMesh> self(this);
+
+    for (unsigned i = 0; i < removedTiles.Size(); ++i)
+    {
+        RemoveTile(removedTiles[i]);
+        if (self.Expired() || !stream.file_)
+            return;
+    }
+
+    // Add the tiles that have been read, unless the observers have already moved away from them
+    for (unsigned i = 0; i < finishedReads.Size(); ++i)
+    {
+        NavigationTileRead* read = finishedReads[i];
+        if (read->data_.Empty())
+            URHO3D_LOGERROR("Failed to read navigation mesh tile " + read->tile_.ToString() + " from " + stream.fileName_);
+        else if (GetTileDistance(read->tile_, centers) <= maxDistance && !HasTile(read->tile_))
+        {
+            stream.tiles_.Insert(read->tile_);
+            AddTile(read->data_);
+            if (self.Expired() || !stream.file_)
+                return;
+        }
+    }
+
+    if (stream.tiles_.Size() + stream.reads_.Size() >= stream.maxTiles_ || stream.reads_.Size() >= MAX_STREAMED_TILE_READS)
+        return;
+
+    // Find the missing tiles within the streaming distance, grouped by distance so that the nearest tiles are read first
+    HashSet<IntVector2> queuedTiles;
+    for (unsigned i = 0; i < stream.reads_.Size(); ++i)
+        queuedTiles.Insert(stream.reads_[i]->tile_);
+
+    Vector<PODVector<IntVector2> > missingTiles((unsigned)stream.distance_ + 1);
+    for (unsigned i = 0; i < centers.Size(); ++i)
+    {
+        const IntVector2 beginTile = VectorMax(IntVector2::ZERO, centers[i] - IntVector2::ONE * stream.distance_);
+        const IntVector2 endTile = VectorMin(centers[i] + IntVector2::ONE * stream.distance_, GetNumTiles() - IntVector2::ONE);
+        for (int z = beginTile.y_; z <= endTile.y_; ++z)
+        {
+            for (int x = beginTile.x_; x <= endTile.x_; ++x)
+            {
+                const IntVector2 tile(x, z);
+                if (stream.tiles_.Contains(tile) || queuedTiles.Contains(tile) || !stream.directory_.Contains(tile))
+                    continue;
+                queuedTiles.Insert(tile);
+                missingTiles[GetTileDistance(tile, centers)].Push(tile);
+            }
+        }
+    }
+
+    // Read the tiles on the work queue threads, within the maximum number of tiles and reads in progress
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    for (unsigned i = 0; i < missingTiles.Size(); ++i)
+    {
+        for (unsigned j = 0; j < missingTiles[i].Size(); ++j)
+        {
+            if (stream.tiles_.Size() + stream.reads_.Size() >= stream.maxTiles_ || stream.reads_.Size() >= MAX_STREAMED_TILE_READS)
+                return;
+
+            SharedPtr<NavigationTileRead> read(new NavigationTileRead());
+            read->tile_ = missingTiles[i][j];
+            read->entry_ = stream.directory_[read->tile_];
+            stream.reads_.Push(read);
+
+            if (workQueue)
+            {
+                read->item_ = workQueue->GetFreeItem();
+                read->item_->priority_ = 0;
+                read->item_->workFunction_ = ReadStreamedTileWork;
+                read->item_->start_ = read.Get();
+                read->item_->aux_ = &stream;
+                workQueue->AddWorkItem(read->item_);
+            }
+            else
+            {
+                WorkItem item;
+                item.start_ = read.Get();
+                item.aux_ = &stream;
+                ReadStreamedTileWork(&item, 0);
+            }
+        }
+    }
+}
+
+const String& NavigationMesh::GetStreamingFile() const
+{
+    return tileStream_->fileName_;
+}
+
+int NavigationMesh::GetStreamingDistance() const
+{
+    return tileStream_->distance_;
+}
+
+unsigned NavigationMesh::GetMaxStreamedTiles() const
+{
+    return tileStream_->maxTiles_;
+}
+
+bool NavigationMesh::IsStreaming() const
+{
+    return tileStream_->file_.NotNull();
+}
+
+unsigned NavigationMesh::GetNumStreamedTiles() const
+{
+    return tileStream_->tiles_.Size();
+}
+
+void NavigationMesh::SetPathClusterSize(int size)
+{
+    pathClusters_->clusterSize_ = Max(size, 0);
+    pathClustersDirty_ = true;
+    MarkNetworkUpdate();
+}
+
+int NavigationMesh::GetPathClusterSize() const
+{
+    return pathClusters_->clusterSize_;
+}
+
+void NavigationMesh::BuildPathClusters()
+{
+    URHO3D_PROFILE(BuildPathClusters);
+
+    NavigationPathClusters& clusters = *pathClusters_;
+    clusters.numClustersX_ = 0;
+    clusters.portals_.Clear();
+    clusters.clusterPortals_.Clear();
+    clusters.portalEdges_.Clear();
+    clusters.stats_ = NavigationClusterStats();
+    pathClustersDirty_ = false;
+
+    if (!navMesh_ || clusters.clusterSize_ <= 0)
+        return;
+
+    HiresTimer timer;
+    const dtNavMesh* navMesh = navMesh_;
+    const dtQueryFilter* filter = queryFilter_.Get();
+
+    // Size the cluster grid by the tiles present, as tiles may also have been read or streamed in
+    int maxX = 0;
+    int maxZ = 0;
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (tile->header)
+        {
+            maxX = Max(maxX, tile->header->x);
+            maxZ = Max(maxZ, tile->header->y);
+        }
+    }
+    clusters.numClustersX_ = maxX / clusters.clusterSize_ + 1;
+    clusters.clusterPortals_.Resize((unsigned)(clusters.numClustersX_ * (maxZ / clusters.clusterSize_ + 1)));
+
+    // Collect the polygon links crossing the cluster borders
+    PODVector<NavigationPortal> crossings;
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile->header)
+            continue;
+
+        const dtPolyRef base = navMesh->getPolyRefBase(tile);
+        const unsigned cluster = GetPolyCluster(navMesh, clusters, base);
+        for (int j = 0; j < tile->header->polyCount; ++j)
+        {
+            const dtPoly* poly = &tile->polys[j];
+            const dtPolyRef ref = base | (dtPolyRef)j;
+            if (!PassFilter(filter, poly))
+                continue;
+
+            for (unsigned k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+            {
+                const dtLink& link = tile->links[k];
+                const dtMeshTile* neighbourTile = nullptr;
+                const dtPoly* neighbourPoly = nullptr;
+                navMesh->getTileAndPolyByRefUnsafe(link.ref, &neighbourTile, &neighbourPoly);
+                const unsigned neighbourCluster = GetPolyCluster(navMesh, clusters, link.ref);
+                // Each border is crossed from the lower cluster index, which also removes the links in the other direction
+                if (cluster >= neighbourCluster || !PassFilter(filter, neighbourPoly))
+                    continue;
+
+                NavigationPortal crossing;
+                if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION || neighbourPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+                    crossing.position_ = (GetPolyCenter(tile, poly) + GetPolyCenter(neighbourTile, neighbourPoly)) * 0.5f;
+                else
+                {
+                    const auto* v0 = reinterpret_cast<const Vector3*>(&tile->verts[poly->verts[link.edge] * 3]);
+                    const auto* v1 = reinterpret_cast<const Vector3*>(&tile->verts[poly->verts[(link.edge + 1) % poly->vertCount] * 3]);
+                    // Links across tile borders may cover only a part of the polygon edge
+                    float t = link.side != 0xff ? (link.bmin + link.bmax) * 0.5f / 255.0f : 0.5f;
+                    crossing.position_ = v0->Lerp(*v1, t);
+                }
+                crossing.polys_[0] = ref;
+                crossing.polys_[1] = link.ref;
+                crossing.clusters_[0] = cluster;
+                crossing.clusters_[1] = neighbourCluster;
+                crossings.Push(crossing);
+            }
+        }
+    }
+
+    // Merge adjacent crossings of the same border into portals, split where the border is blocked or after a tile's length
+    Sort(crossings.Begin(), crossings.End(), CompareBorderCrossings);
+    const float maxGap = 2.0f * agentRadius_ + 4.0f * cellSize_;
+    const float maxLength = (float)tileSize_ * cellSize_;
+    unsigned runStart = 0;
+    for (unsigned i = 1; i <= crossings.Size(); ++i)
+    {
+        if (i < crossings.Size() && crossings[i].clusters_[0] == crossings[runStart].clusters_[0] &&
+            crossings[i].clusters_[1] == crossings[runStart].clusters_[1] &&
+            (crossings[i].position_ - crossings[i - 1].position_).Length() <= maxGap &&
+            (crossings[i].position_ - crossings[runStart].position_).Length() <= maxLength)
+            continue;
+
+        const NavigationPortal& portal = crossings[(runStart + i - 1) / 2];
+        clusters.clusterPortals_[portal.clusters_[0]].Push(clusters.portals_.Size());
+        clusters.clusterPortals_[portal.clusters_[1]].Push(clusters.portals_.Size());
+        clusters.portals_.Push(portal);
+        runStart = i;
+    }
+
+    // Connect the portals within each cluster, in parallel when allowed
+    Vector<NavigationClusterBuild> clusterBuilds;
+    for (unsigned i = 0; i < clusters.clusterPortals_.Size(); ++i)
+    {
+        if (clusters.clusterPortals_[i].Size() < 2)
+            continue;
+
+        NavigationClusterBuild& build = *clusterBuilds.Insert(clusterBuilds.End(), NavigationClusterBuild());
+        build.navMesh_ = navMesh;
+        build.filter_ = filter;
+        build.clusters_ = &clusters;
+        build.cluster_ = i;
+    }
+
+    auto* queue = threadedBuild_ ? GetSubsystem<WorkQueue>() : nullptr;
+    if (queue && queue->GetNumThreads() && clusterBuilds.Size() > 1)
+    {
+        for (unsigned i = 0; i < clusterBuilds.Size(); ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = ConnectClusterPortalsWork;
+            item->start_ = &clusterBuilds[i];
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < clusterBuilds.Size(); ++i)
+            ConnectClusterPortals(clusterBuilds[i]);
+    }
+
+    clusters.portalEdges_.Resize(clusters.portals_.Size());
+    for (unsigned i = 0; i < clusterBuilds.Size(); ++i)
+    {
+        const Vector<Pair<unsigned, NavigationPortalEdge> >& edges = clusterBuilds[i].edges_;
+        for (unsigned j = 0; j < edges.Size(); ++j)
+            clusters.portalEdges_[edges[j].first_].Push(edges[j].second_);
+        clusters.stats_.numEdges_ += edges.Size();
+    }
+
+    clusters.stats_.numClusters_ = clusters.clusterPortals_.Size();
+    clusters.stats_.numPortals_ = clusters.portals_.Size();
+    clusters.stats_.buildTime_ = timer.GetUSec(false);
+
+    URHO3D_LOGDEBUGF("Built %u path clusters with %u portals and %u edges in %f ms", clusters.stats_.numClusters_,
+        clusters.stats_.numPortals_, clusters.stats_.numEdges_, clusters.stats_.buildTime_ / 1000.0);
+}
+
+const NavigationClusterStats& NavigationMesh::GetPathClusterStats() const
+{
+    return pathClusters_->stats_;
+}
+
+Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
+{
+    if (!InitializeQuery())
+        return Vector3::ZERO;
+
+    dtPolyRef polyRef;
+    Vector3 point(Vector3::ZERO);
+
+    navMeshQuery_->findRandomPoint(filter ? filter : queryFilter_.Get(), Random, randomRef ? randomRef : &polyRef, &point.x_);
+
+    return node_->GetWorldTransform() * point;
+}
+
+Vector3 NavigationMesh::GetRandomPointInCircle(const Vector3& center, float radius, const Vector3& extents,
+    const dtQueryFilter* filter, dtPolyRef* randomRef)
+{
+    if (randomRef)
+        *randomRef = 0;
+
+    if (!InitializeQuery())
+        return center;
+
+    const Matrix3x4& transform = node_->GetWorldTransform();
+    Matrix3x4 inverse = transform.Inverse();
+    Vector3 localCenter = inverse * center;
+
+    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.Get();
+    dtPolyRef startRef;
+    navMeshQuery_->findNearestPoly(&localCenter.x_, &extents.x_, queryFilter, &startRef, nullptr);
+    if (!startRef)
+        return center;
+
+    dtPolyRef polyRef;
+    if (!randomRef)
+        randomRef = &polyRef;
+    Vector3 point(localCenter);
+
+    navMeshQuery_->findRandomPointAroundCircle(startRef, &localCenter.x_, radius, queryFilter, Random, randomRef, &point.x_);
+
+    return transform * point;
+}
+
+float NavigationMesh::GetDistanceToWall(const Vector3& point, float radius, const Vector3& extents, const dtQueryFilter* filter,
+    Vector3* hitPos, Vector3* hitNormal)
+{
+    if (hitPos)
+        *hitPos = Vector3::ZERO;
+    if (hitNormal)
+        *hitNormal = Vector3::DOWN;
 
     if (!InitializeQuery())
         return radius;
@@ -928,7 +2179,8 @@ PODVector<unsigned char> NavigationMesh::GetNavigationDataAttr() const
 {
     VectorBuffer ret;
 
-    if (navMesh_)
+    // When streaming, the tiles are in the tile file instead of the scene
+    if (navMesh_ && !IsStreaming())
     {
         ret.WriteBoundingBox(boundingBox_);
         ret.WriteInt(numTilesX_);
@@ -1088,109 +2340,112 @@ void NavigationMesh::GetTileGeometry(NavBuildData* build, Vector<NavigationGeome
 
     for (unsigned i = 0; i < geometryList.Size(); ++i)
     {
-        if (box.IsInsideFast(geometryList[i].boundingBox_) != OUTSIDE)
+        if (box.IsInsideFast(geometryList[i].boundingBox_) != OUTSIDE)
+            AddTileGeometry(build, geometryList[i], inverse);
+    }
+}
+
+void NavigationMesh::AddTileGeometry(NavBuildData* build, const NavigationGeometryInfo& info, const Matrix3x4& inverse)
+{
+    const Matrix3x4& transform = info.transform_;
+
+    if (info.component_->GetType() == OffMeshConnection::GetTypeStatic())
+    {
+        auto* connection = static_cast<OffMeshConnection*>(info.component_);
+        Vector3 start = inverse * connection->GetNode()->GetWorldPosition();
+        Vector3 end = inverse * connection->GetEndPoint()->GetWorldPosition();
+
+        build->offMeshVertices_.Push(start);
+        build->offMeshVertices_.Push(end);
+        build->offMeshRadii_.Push(connection->GetRadius());
+        build->offMeshFlags_.Push((unsigned short)connection->GetMask());
+        build->offMeshAreas_.Push((unsigned char)connection->GetAreaID());
+        build->offMeshDir_.Push((unsigned char)(connection->IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0));
+        return;
+    }
+    else if (info.component_->GetType() == NavArea::GetTypeStatic())
+    {
+        auto* area = static_cast<NavArea*>(info.component_);
+        NavAreaStub stub;
+        stub.areaID_ = (unsigned char)area->GetAreaID();
+        stub.bounds_ = area->GetWorldBoundingBox();
+        build->navAreas_.Push(stub);
+        return;
+    }
+
+#ifdef URHO3D_PHYSICS
+    auto* shape = dynamic_cast<CollisionShape*>(info.component_);
+    if (shape)
+    {
+        switch (shape->GetShapeType())
         {
-            const Matrix3x4& transform = geometryList[i].transform_;
-
-            if (geometryList[i].component_->GetType() == OffMeshConnection::GetTypeStatic())
-            {
-                auto* connection = static_cast<OffMeshConnection*>(geometryList[i].component_);
-                Vector3 start = inverse * connection->GetNode()->GetWorldPosition();
-                Vector3 end = inverse * connection->GetEndPoint()->GetWorldPosition();
-
-                build->offMeshVertices_.Push(start);
-                build->offMeshVertices_.Push(end);
-                build->offMeshRadii_.Push(connection->GetRadius());
-                build->offMeshFlags_.Push((unsigned short)connection->GetMask());
-                build->offMeshAreas_.Push((unsigned char)connection->GetAreaID());
-                build->offMeshDir_.Push((unsigned char)(connection->IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0));
-                continue;
-            }
-            else if (geometryList[i].component_->GetType() == NavArea::GetTypeStatic())
+        case SHAPE_TRIANGLEMESH:
             {
-                auto* area = static_cast<NavArea*>(geometryList[i].component_);
-                NavAreaStub stub;
-                stub.areaID_ = (unsigned char)area->GetAreaID();
-                stub.bounds_ = area->GetWorldBoundingBox();
-                build->navAreas_.Push(stub);
-                continue;
+                Model* model = shape->GetModel();
+                if (!model)
+                    return;
+
+                unsigned lodLevel = shape->GetLodLevel();
+                for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
+                    AddTriMeshGeometry(build, model->GetGeometry(j, lodLevel), transform);
             }
+            break;
 
-#ifdef URHO3D_PHYSICS
-            auto* shape = dynamic_cast<CollisionShape*>(geometryList[i].component_);
-            if (shape)
+        case SHAPE_CONVEXHULL:
             {
-                switch (shape->GetShapeType())
-                {
-                case SHAPE_TRIANGLEMESH:
-                    {
-                        Model* model = shape->GetModel();
-                        if (!model)
-                            continue;
-
-                        unsigned lodLevel = shape->GetLodLevel();
-                        for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
-                            AddTriMeshGeometry(build, model->GetGeometry(j, lodLevel), transform);
-                    }
-                    break;
+                auto* data = static_cast<ConvexData*>(shape->GetGeometryData());
+                if (!data)
+                    return;
 
-                case SHAPE_CONVEXHULL:
-                    {
-                        auto* data = static_cast<ConvexData*>(shape->GetGeometryData());
-                        if (!data)
-                            continue;
-
-                        unsigned numVertices = data->vertexCount_;
-                        unsigned numIndices = data->indexCount_;
-                        unsigned destVertexStart = build->vertices_.Size();
+                unsigned numVertices = data->vertexCount_;
+                unsigned numIndices = data->indexCount_;
+                unsigned destVertexStart = build->vertices_.Size();
 
-                        for (unsigned j = 0; j < numVertices; ++j)
-                            build->vertices_.Push(transform * data->vertexData_[j]);
+                for (unsigned j = 0; j < numVertices; ++j)
+                    build->vertices_.Push(transform * data->vertexData_[j]);
 
-                        for (unsigned j = 0; j < numIndices; ++j)
-                            build->indices_.Push(data->indexData_[j] + destVertexStart);
-                    }
-                    break;
+                for (unsigned j = 0; j < numIndices; ++j)
+                    build->indices_.Push(data->indexData_[j] + destVertexStart);
+            }
+            break;
 
-                case SHAPE_BOX:
-                    {
-                        unsigned destVertexStart = build->vertices_.Size();
-
-                        build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, 0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, -0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, 0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, 0.5f, 0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, -0.5f, 0.5f));
-                        build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, 0.5f));
-
-                        const unsigned indices[] = {
-                            0, 1, 2, 0, 2, 3, 1, 5, 6, 1, 6, 2, 4, 5, 1, 4, 1, 0, 5, 4, 7, 5, 7, 6,
-                            4, 0, 3, 4, 3, 7, 1, 0, 4, 1, 4, 5
-                        };
-
-                        for (unsigned index : indices)
-                            build->indices_.Push(index + destVertexStart);
-                    }
-                    break;
+        case SHAPE_BOX:
+            {
+                unsigned destVertexStart = build->vertices_.Size();
+
+                build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, 0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, -0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, 0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, 0.5f, 0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, -0.5f, 0.5f));
+                build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, 0.5f));
+
+                const unsigned indices[] = {
+                    0, 1, 2, 0, 2, 3, 1, 5, 6, 1, 6, 2, 4, 5, 1, 4, 1, 0, 5, 4, 7, 5, 7, 6,
+                    4, 0, 3, 4, 3, 7, 1, 0, 4, 1, 4, 5
+                };
+
+                for (unsigned index : indices)
+                    build->indices_.Push(index + destVertexStart);
+            }
+            break;
 
-                default:
-                    break;
-                }
+        default:
+            break;
+        }
 
-                continue;
-            }
+        return;
+    }
 #endif
-            auto* drawable = dynamic_cast<Drawable*>(geometryList[i].component_);
-            if (drawable)
-            {
-                const Vector<SourceBatch>& batches = drawable->GetBatches();
+    auto* drawable = dynamic_cast<Drawable*>(info.component_);
+    if (drawable)
+    {
+        const Vector<SourceBatch>& batches = drawable->GetBatches();
 
-                for (unsigned j = 0; j < batches.Size(); ++j)
-                    AddTriMeshGeometry(build, drawable->GetLodGeometry(j, geometryList[i].lodLevel_), transform);
-            }
-        }
+        for (unsigned j = 0; j < batches.Size(); ++j)
+            AddTriMeshGeometry(build, drawable->GetLodGeometry(j, info.lodLevel_), transform);
     }
 }
 
@@ -1285,6 +2540,7 @@ bool NavigationMesh::ReadTile(Deserializer& source, bool silent)
         dtFree(navData);
         return false;
     }
+    pathClustersDirty_ = true;
 
     // Send event
     if (!silent)
@@ -1303,14 +2559,225 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
 {
     URHO3D_PROFILE(BuildNavigationMeshTile);
 
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
+    NavigationTileBuild tileBuild;
+    tileBuild.tile_ = IntVector2(x, z);
+    PrepareTileBuild(tileBuild, geometryList, nullptr);
+    tileBuild.success_ = RasterizeTile(tileBuild);
+    return AddBuiltTile(tileBuild);
+}
+
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+{
+    PODVector<IntVector2> tiles;
+
+    for (int z = from.y_; z <= to.y_; ++z)
+    {
+        for (int x = from.x_; x <= to.x_; ++x)
+            tiles.Push(IntVector2(x, z));
+    }
+
+    return BuildTiles(geometryList, tiles);
+}
+
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const PODVector<IntVector2>& tiles)
+{
+    URHO3D_PROFILE(BuildNavigationMeshTiles);
+
+    HiresTimer totalTimer;
+    buildStats_ = NavigationBuildStats();
+
+    if (tiles.Empty())
+        return 0;
+
+    // Sort the geometries to the tiles once instead of testing each geometry against each tile. The lists are indexed within
+    // the rectangle containing all the tiles, and have one tile of slack, as the exact test is made when collecting the geometry
+    IntVector2 minTile = tiles[0];
+    IntVector2 maxTile = tiles[0];
+    for (unsigned i = 1; i < tiles.Size(); ++i)
+    {
+        minTile.x_ = Min(minTile.x_, tiles[i].x_);
+        minTile.y_ = Min(minTile.y_, tiles[i].y_);
+        maxTile.x_ = Max(maxTile.x_, tiles[i].x_);
+        maxTile.y_ = Max(maxTile.y_, tiles[i].y_);
+    }
+
+    int rectWidth = maxTile.x_ - minTile.x_ + 1;
+    Vector<PODVector<unsigned> > tileGeometries((unsigned)(rectWidth * (maxTile.y_ - minTile.y_ + 1)));
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+    float border = (float)(CeilToInt(agentRadius_ / cellSize_) + 3) * cellSize_;
+
+    for (unsigned i = 0; i < geometryList.Size(); ++i)
+    {
+        const BoundingBox& box = geometryList[i].boundingBox_;
+        int sx = Max(FloorToInt((box.min_.x_ - border - boundingBox_.min_.x_) / tileEdgeLength) - 1, minTile.x_);
+        int sz = Max(FloorToInt((box.min_.z_ - border - boundingBox_.min_.z_) / tileEdgeLength) - 1, minTile.y_);
+        int ex = Min(FloorToInt((box.max_.x_ + border - boundingBox_.min_.x_) / tileEdgeLength) + 1, maxTile.x_);
+        int ez = Min(FloorToInt((box.max_.z_ + border - boundingBox_.min_.z_) / tileEdgeLength) + 1, maxTile.y_);
+
+        for (int z = sz; z <= ez; ++z)
+        {
+            for (int x = sx; x <= ex; ++x)
+                tileGeometries[(z - minTile.y_) * rectWidth + x - minTile.x_].Push(i);
+        }
+    }
+
+    // Collect the geometry of a batch of tiles on the main thread, run the Recast pipelines on the work queue, then add the
+    // finished tiles in order. Batching bounds the memory used by the collected geometry
+    auto* queue = threadedBuild_ ? GetSubsystem<WorkQueue>() : nullptr;
+    unsigned batchSize = queue && queue->GetNumThreads() ? (queue->GetNumThreads() + 1) * TILES_PER_THREAD : 1;
+    unsigned numTiles = 0;
+
+    for (unsigned batchStart = 0; batchStart < tiles.Size(); batchStart += batchSize)
+    {
+        unsigned numBatchTiles = Min(batchSize, tiles.Size() - batchStart);
+        SharedArrayPtr<NavigationTileBuild> tileBuilds(new NavigationTileBuild[numBatchTiles]);
+
+        for (unsigned i = 0; i < numBatchTiles; ++i)
+        {
+            NavigationTileBuild& tileBuild = tileBuilds[i];
+            const IntVector2& tile = tiles[batchStart + i];
+            tileBuild.mesh_ = this;
+            tileBuild.tile_ = tile;
+            PrepareTileBuild(tileBuild, geometryList, &tileGeometries[(tile.y_ - minTile.y_) * rectWidth + tile.x_ - minTile.x_]);
 
-    const BoundingBox tileBoundingBox = GetTileBoudningBox(IntVector2(x, z));
+            if (batchSize > 1)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = BuildTileWork;
+                item->start_ = &tileBuild;
+                queue->AddWorkItem(item);
+            }
+            else
+            {
+                HiresTimer tileTimer;
+                tileBuild.success_ = RasterizeTile(tileBuild);
+                tileBuild.buildTime_ += tileTimer.GetUSec(false);
+            }
+        }
+
+        if (batchSize > 1)
+            queue->Complete(M_MAX_UNSIGNED);
+
+        for (unsigned i = 0; i < numBatchTiles; ++i)
+        {
+            NavigationTileBuild& tileBuild = tileBuilds[i];
+            if (AddBuiltTile(tileBuild))
+                ++numTiles;
+
+            buildStats_.tileTime_ += tileBuild.buildTime_;
+            buildStats_.maxTileTime_ = Max(buildStats_.maxTileTime_, tileBuild.buildTime_);
+        }
+    }
+
+    buildStats_.numTiles_ = numTiles;
+    buildStats_.totalTime_ = totalTimer.GetUSec(false);
+    return numTiles;
+}
+
+void NavigationMesh::SetBuiltGeometry(const Vector<NavigationGeometryInfo>& geometryList)
+{
+    builtGeometry_.Resize(geometryList.Size());
+
+    for (unsigned i = 0; i < geometryList.Size(); ++i)
+    {
+        const NavigationGeometryInfo& info = geometryList[i];
+        NavigationGeometryRecord& record = builtGeometry_[i];
+        record.component_ = info.component_;
+        record.lodLevel_ = info.lodLevel_;
+        record.transform_ = info.transform_;
+        record.boundingBox_ = info.boundingBox_;
+    }
+}
+
+void NavigationMesh::GetChangedTiles(PODVector<IntVector2>& tiles, const Vector<NavigationGeometryInfo>& geometryList)
+{
+    tiles.Clear();
+
+    HashMap<Component*, unsigned> geometryIndices;
+    for (unsigned i = 0; i < geometryList.Size(); ++i)
+        geometryIndices[geometryList[i].component_] = i;
+
+    // Both the old and the new bounds of changed geometry need to be rebuilt
+    PODVector<bool> matched(geometryList.Size());
+    for (unsigned i = 0; i < matched.Size(); ++i)
+        matched[i] = false;
+    PODVector<BoundingBox> changedBounds;
+
+    for (unsigned i = 0; i < builtGeometry_.Size(); ++i)
+    {
+        const NavigationGeometryRecord& record = builtGeometry_[i];
+        HashMap<Component*, unsigned>::ConstIterator j = record.component_ ? geometryIndices.Find(record.component_.Get()) :
+            geometryIndices.End();
+        if (j == geometryIndices.End())
+        {
+            changedBounds.Push(record.boundingBox_);
+            continue;
+        }
+
+        const NavigationGeometryInfo& info = geometryList[j->second_];
+        matched[j->second_] = true;
+        if (info.boundingBox_ != record.boundingBox_ || info.transform_ != record.transform_ || info.lodLevel_ != record.lodLevel_)
+        {
+            changedBounds.Push(record.boundingBox_);
+            changedBounds.Push(info.boundingBox_);
+        }
+    }
+
+    for (unsigned i = 0; i < geometryList.Size(); ++i)
+    {
+        if (!matched[i])
+            changedBounds.Push(geometryList[i].boundingBox_);
+    }
+
+    SetBuiltGeometry(geometryList);
+
+    if (changedBounds.Empty() || !numTilesX_ || !numTilesZ_)
+        return;
+
+    // Geometry affects the neighbour tiles within the border used when building them
+    PODVector<bool> changedTiles((unsigned)(numTilesX_ * numTilesZ_));
+    for (unsigned i = 0; i < changedTiles.Size(); ++i)
+        changedTiles[i] = false;
+
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+    float border = (float)(CeilToInt(agentRadius_ / cellSize_) + 3) * cellSize_;
+
+    for (unsigned i = 0; i < changedBounds.Size(); ++i)
+    {
+        const BoundingBox& box = changedBounds[i];
+        int sx = FloorToInt((box.min_.x_ - border - boundingBox_.min_.x_) / tileEdgeLength);
+        int sz = FloorToInt((box.min_.z_ - border - boundingBox_.min_.z_) / tileEdgeLength);
+        int ex = FloorToInt((box.max_.x_ + border - boundingBox_.min_.x_) / tileEdgeLength);
+        int ez = FloorToInt((box.max_.z_ + border - boundingBox_.min_.z_) / tileEdgeLength);
+        if (ex < 0 || ez < 0 || sx >= numTilesX_ || sz >= numTilesZ_)
+            continue;
+
+        for (int z = Max(sz, 0); z <= Min(ez, numTilesZ_ - 1); ++z)
+        {
+            for (int x = Max(sx, 0); x <= Min(ex, numTilesX_ - 1); ++x)
+                changedTiles[z * numTilesX_ + x] = true;
+        }
+    }
+
+    for (int z = 0; z < numTilesZ_; ++z)
+    {
+        for (int x = 0; x < numTilesX_; ++x)
+        {
+            if (changedTiles[z * numTilesX_ + x])
+                tiles.Push(IntVector2(x, z));
+        }
+    }
+}
 
-    SimpleNavBuildData build;
+void NavigationMesh::PrepareTileBuild(NavigationTileBuild& tileBuild, Vector<NavigationGeometryInfo>& geometryList,
+    const PODVector<unsigned>* geometryIndices)
+{
+    HiresTimer timer;
+
+    tileBuild.boundingBox_ = GetTileBoudningBox(tileBuild.tile_);
 
-    rcConfig cfg;       // NOLINT(hicpp-member-init)
+    rcConfig& cfg = tileBuild.cfg_;
     memset(&cfg, 0, sizeof cfg);
     cfg.cs = cellSize_;
     cfg.ch = cellHeight_;
@@ -1330,15 +2797,34 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     cfg.detailSampleDist = detailSampleDistance_ < 0.9f ? 0.0f : cellSize_ * detailSampleDistance_;
     cfg.detailSampleMaxError = cellHeight_ * detailSampleMaxError_;
 
-    rcVcopy(cfg.bmin, &tileBoundingBox.min_.x_);
-    rcVcopy(cfg.bmax, &tileBoundingBox.max_.x_);
+    rcVcopy(cfg.bmin, &tileBuild.boundingBox_.min_.x_);
+    rcVcopy(cfg.bmax, &tileBuild.boundingBox_.max_.x_);
     cfg.bmin[0] -= cfg.borderSize * cfg.cs;
     cfg.bmin[2] -= cfg.borderSize * cfg.cs;
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    if (!geometryIndices)
+        GetTileGeometry(&tileBuild.build_, geometryList, expandedBox);
+    else
+    {
+        Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+
+        for (PODVector<unsigned>::ConstIterator i = geometryIndices->Begin(); i != geometryIndices->End(); ++i)
+        {
+            if (expandedBox.IsInsideFast(geometryList[*i].boundingBox_) != OUTSIDE)
+                AddTileGeometry(&tileBuild.build_, geometryList[*i], inverse);
+        }
+    }
+
+    tileBuild.buildTime_ = timer.GetUSec(false);
+}
+
+bool NavigationMesh::RasterizeTile(NavigationTileBuild& tileBuild) const
+{
+    SimpleNavBuildData& build = tileBuild.build_;
+    const rcConfig& cfg = tileBuild.cfg_;
 
     if (build.vertices_.Empty() || build.indices_.Empty())
         return true; // Nothing to do
@@ -1462,9 +2948,6 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
             build.polyMesh_->flags[i] = 0x1;
     }
 
-    unsigned char* navData = nullptr;
-    int navDataSize = 0;
-
     dtNavMeshCreateParams params;       // NOLINT(hicpp-member-init)
     memset(&params, 0, sizeof params);
     params.verts = build.polyMesh_->verts;
@@ -1482,8 +2965,8 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     params.walkableHeight = agentHeight_;
     params.walkableRadius = agentRadius_;
     params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
+    params.tileX = tileBuild.tile_.x_;
+    params.tileY = tileBuild.tile_.y_;
     rcVcopy(params.bmin, build.polyMesh_->bmin);
     rcVcopy(params.bmax, build.polyMesh_->bmax);
     params.cs = cfg.cs;
@@ -1501,45 +2984,176 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         params.offMeshConDir = &build.offMeshDir_[0];
     }
 
-    if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+    if (!dtCreateNavMeshData(&params, &tileBuild.navData_, &tileBuild.navDataSize_))
     {
         URHO3D_LOGERROR("Could not build navigation mesh tile data");
         return false;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+    return true;
+}
+
+bool NavigationMesh::AddBuiltTile(NavigationTileBuild& tileBuild)
+{
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(tileBuild.tile_.x_, tileBuild.tile_.y_, 0), nullptr, nullptr);
+    pathClustersDirty_ = true;
+
+    if (!tileBuild.success_)
+        return false;
+    if (!tileBuild.navData_)
+        return true; // Nothing to do
+
+    if (dtStatusFailed(navMesh_->addTile(tileBuild.navData_, tileBuild.navDataSize_, DT_TILE_FREE_DATA, 0, nullptr)))
     {
         URHO3D_LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
         return false;
     }
 
+    // The navigation mesh owns the data now
+    tileBuild.navData_ = nullptr;
+
     // Send a notification of the rebuild of this tile to anyone interested
     {
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
         eventData[P_MESH] = this;
-        eventData[P_BOUNDSMIN] = Variant(tileBoundingBox.min_);
-        eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
+        eventData[P_BOUNDSMIN] = Variant(tileBuild.boundingBox_.min_);
+        eventData[P_BOUNDSMAX] = Variant(tileBuild.boundingBox_.max_);
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
     return true;
 }
 
-unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+void NavigationMesh::BuildTileWork(const WorkItem* item, unsigned threadIndex)
 {
-    unsigned numTiles = 0;
+    auto* tileBuild = reinterpret_cast<NavigationTileBuild*>(item->start_);
 
-    for (int z = from.y_; z <= to.y_; ++z)
+    HiresTimer timer;
+    tileBuild->success_ = tileBuild->mesh_->RasterizeTile(*tileBuild);
+    tileBuild->buildTime_ += timer.GetUSec(false);
+}
+
+bool NavigationMesh::FindClusterPath(PODVector<dtPolyRef>& dest, dtPolyRef startRef, dtPolyRef endRef, const Vector3& start,
+    const Vector3& end, const dtQueryFilter* filter)
+{
+    NavigationPathClusters& clusters = *pathClusters_;
+    if (clusters.clusterSize_ <= 0)
+        return false;
+    if (pathClustersDirty_)
+        BuildPathClusters();
+    if (clusters.portals_.Empty())
+        return false;
+
+    // Points in the same or neighbouring clusters are searched directly
+    const dtNavMesh* navMesh = navMesh_;
+    const unsigned startCluster = GetPolyCluster(navMesh, clusters, startRef);
+    const unsigned endCluster = GetPolyCluster(navMesh, clusters, endRef);
+    if (startCluster >= clusters.clusterPortals_.Size() || endCluster >= clusters.clusterPortals_.Size())
+        return false;
+    const auto numClustersX = (unsigned)clusters.numClustersX_;
+    if (Abs((int)(startCluster % numClustersX) - (int)(endCluster % numClustersX)) <= 1 &&
+        Abs((int)(startCluster / numClustersX) - (int)(endCluster / numClustersX)) <= 1)
+        return false;
+
+    URHO3D_PROFILE(FindClusterPath);
+
+    NavigationClusterGraph graph;
+    PODVector<float> startCosts;
+    PODVector<float> endCosts;
+    BuildClusterGraph(graph, navMesh, queryFilter_.Get(), clusters, startCluster);
+    if (!SearchClusterPortals(startCosts, graph, clusters, startCluster, startRef, start))
+        return false;
+    BuildClusterGraph(graph, navMesh, queryFilter_.Get(), clusters, endCluster);
+    if (!SearchClusterPortals(endCosts, graph, clusters, endCluster, endRef, end))
+        return false;
+
+    // A* over the portals, with the end as the last node
+    const unsigned numPortals = clusters.portals_.Size();
+    const unsigned goal = numPortals;
+    PODVector<float> costs(numPortals + 1);
+    PODVector<unsigned> parents(numPortals + 1);
+    PODVector<unsigned> hopClusters(numPortals + 1);
+    PODVector<bool> closed(numPortals + 1);
+    PODVector<NavigationSearchItem> open;
+    for (unsigned i = 0; i <= numPortals; ++i)
     {
-        for (int x = from.x_; x <= to.x_; ++x)
+        costs[i] = i < numPortals ? startCosts[i] : M_INFINITY;
+        parents[i] = M_MAX_UNSIGNED;
+        hopClusters[i] = startCluster;
+        closed[i] = false;
+        if (costs[i] < M_INFINITY)
+            PushSearchItem(open, costs[i] + (clusters.portals_[i].position_ - end).Length(), i);
+    }
+
+    while (open.Size())
+    {
+        unsigned node = PopSearchItem(open).node_;
+        if (node == goal)
+            break;
+        if (closed[node])
+            continue;
+        closed[node] = true;
+
+        if (endCosts[node] < M_INFINITY && costs[node] + endCosts[node] < costs[goal])
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
+            costs[goal] = costs[node] + endCosts[node];
+            parents[goal] = node;
+            hopClusters[goal] = endCluster;
+            PushSearchItem(open, costs[goal], goal);
+        }
+
+        const PODVector<NavigationPortalEdge>& edges = clusters.portalEdges_[node];
+        for (unsigned i = 0; i < edges.Size(); ++i)
+        {
+            const NavigationPortalEdge& edge = edges[i];
+            float cost = costs[node] + edge.cost_;
+            if (!closed[edge.target_] && cost < costs[edge.target_])
+            {
+                costs[edge.target_] = cost;
+                parents[edge.target_] = node;
+                hopClusters[edge.target_] = edge.cluster_;
+                PushSearchItem(open, cost + (clusters.portals_[edge.target_].position_ - end).Length(), edge.target_);
+            }
         }
     }
-    return numTiles;
+
+    if (parents[goal] == M_MAX_UNSIGNED)
+        return false;
+
+    PODVector<unsigned> route;
+    for (unsigned node = goal; node != M_MAX_UNSIGNED; node = parents[node])
+        route.Insert(0, node);
+
+    // Refine the portal route into a polygon corridor, crossing to the other side of a portal when the route changes cluster
+    dest.Clear();
+    dtPolyRef fromRef = startRef;
+    Vector3 fromPos = start;
+    for (unsigned i = 0; i < route.Size() - 1; ++i)
+    {
+        const NavigationPortal& portal = clusters.portals_[route[i]];
+        if (!navMesh->isValidPolyRef(portal.polys_[0]) || !navMesh->isValidPolyRef(portal.polys_[1]))
+        {
+            pathClustersDirty_ = true;
+            return false;
+        }
+
+        unsigned side = portal.clusters_[0] == hopClusters[route[i]] ? 0 : 1;
+        if (!AppendPathSegment(dest, navMeshQuery_, fromRef, portal.polys_[side], fromPos, portal.position_, filter,
+            pathData_->polys_, MAX_POLYS))
+            return false;
+
+        fromRef = portal.polys_[side];
+        if (hopClusters[route[i + 1]] != hopClusters[route[i]])
+        {
+            fromRef = portal.polys_[1 - side];
+            dest.Push(fromRef);
+        }
+        fromPos = portal.position_;
+    }
+
+    return AppendPathSegment(dest, navMeshQuery_, fromRef, endRef, fromPos, end, filter, pathData_->polys_, MAX_POLYS);
 }
 
 bool NavigationMesh::InitializeQuery()
@@ -1574,11 +3188,163 @@ void NavigationMesh::ReleaseNavigationMesh()
     dtFreeNavMeshQuery(navMeshQuery_);
     navMeshQuery_ = nullptr;
 
+    // Queued path queries start over once a new navigation mesh exists
+    pathQueue_->ReleaseSlots();
+    tileStream_->tiles_.Clear();
+    pathClustersDirty_ = true;
+
     numTilesX_ = 0;
     numTilesZ_ = 0;
     boundingBox_.Clear();
 }
 
+void NavigationMesh::SendPathResults(bool failAll)
+{
+    NavigationPathQueue& queue = *pathQueue_;
+
+    Vector<SharedPtr<NavigationPathQuery> > finished;
+    for (unsigned i = 0; i < queue.active_.Size();)
+    {
+        NavigationPathQuery* query = queue.active_[i];
+        if (failAll || query->finished_)
+        {
+            queue.freeSlots_.Push(query->slot_);
+            query->slot_ = nullptr;
+            finished.Push(queue.active_[i]);
+            queue.active_.Erase(i);
+        }
+        else
+            ++i;
+    }
+    if (failAll)
+    {
+        finished.Push(queue.pending_);
+        queue.pending_.Clear();
+        for (unsigned i = 0; i < finished.Size(); ++i)
+            finished[i]->path_.Clear();
+    }
+
+    NavigationPathStats& stats = queue.stats_;
+    stats.numPending_ = queue.pending_.Size();
+    stats.numActive_ = queue.active_.Size();
+    if (!stats.numPending_ && !stats.numActive_ && !IsStreaming())
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+
+    // The event handlers may queue new queries or remove this component, so only the local list is used from here on
+    WeakPtr<NavigationMesh> self(this);
+    Matrix3x4 transform = node_ ? node_->GetWorldTransform() : Matrix3x4::IDENTITY;
+
+    for (unsigned i = 0; i < finished.Size(); ++i)
+    {
+        NavigationPathQuery* query = finished[i];
+        float latency = (float)query->timer_.GetUSec(false) / 1000000.0f;
+        ++stats.numCompleted_;
+        queue.totalLatency_ += latency;
+        stats.averageLatency_ = (float)(queue.totalLatency_ / stats.numCompleted_);
+        stats.maxLatency_ = Max(stats.maxLatency_, latency);
+
+        // Transform path result back to world space
+        VariantVector path(query->path_.Size());
+        for (unsigned j = 0; j < query->path_.Size(); ++j)
+            path[j] = transform * query->path_[j];
+
+        using namespace NavigationPathResult;
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = node_;
+        eventData[P_MESH] = this;
+        eventData[P_ID] = query->id_;
+        eventData[P_SUCCESS] = !path.Empty();
+        eventData[P_PATH] = path;
+        eventData[P_LATENCY] = latency;
+        SendEvent(E_NAVIGATION_PATH_RESULT, eventData);
+
+        if (self.Expired())
+            return;
+    }
+}
+
+bool NavigationMesh::StartStreaming()
+{
+    NavigationTileStream& stream = *tileStream_;
+    if (!node_)
+    {
+        URHO3D_LOGERROR("Can not stream navigation mesh tiles without a node");
+        return false;
+    }
+
+    SharedPtr<File> file = GetSubsystem<ResourceCache>()->GetFile(stream.fileName_);
+    if (!file)
+        return false;
+
+    if (file->ReadFileID() != "UNVT")
+    {
+        URHO3D_LOGERROR(stream.fileName_ + " is not a valid navigation tile file");
+        return false;
+    }
+
+    BoundingBox boundingBox = file->ReadBoundingBox();
+    int tileSize = file->ReadInt();
+    float cellSize = file->ReadFloat();
+    if (tileSize != tileSize_ || cellSize != cellSize_)
+    {
+        URHO3D_LOGERROR("Navigation tile file " + stream.fileName_ + " was saved with different tile or cell size");
+        return false;
+    }
+
+    unsigned numTiles = file->ReadUInt();
+    for (unsigned i = 0; i < numTiles; ++i)
+    {
+        IntVector2 tile = file->ReadIntVector2();
+        NavigationTileEntry& entry = stream.directory_[tile];
+        entry.offset_ = file->ReadUInt();
+        entry.size_ = file->ReadUInt();
+    }
+    stream.dataStart_ = file->GetPosition();
+
+    // Only the tiles that can be streamed in at once are allocated, regardless of the size of the world
+    if (!Allocate(boundingBox.Transformed(node_->GetWorldTransform()), stream.maxTiles_))
+    {
+        stream.directory_.Clear();
+        return false;
+    }
+
+    stream.file_ = file;
+
+    Scene* scene = GetScene();
+    if (scene && !HasSubscribedToEvent(scene, E_SCENEPOSTUPDATE))
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandleScenePostUpdate));
+
+    URHO3D_LOGDEBUG("Streaming " + String(numTiles) + " navigation mesh tiles from " + stream.fileName_);
+    return true;
+}
+
+void NavigationMesh::StopStreaming()
+{
+    NavigationTileStream& stream = *tileStream_;
+
+    // Remove the tile reads that have not started from the work queue, and wait for the ones in progress
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    for (unsigned i = 0; i < stream.reads_.Size(); ++i)
+    {
+        NavigationTileRead* read = stream.reads_[i];
+        if (read->finished_ || !workQueue || workQueue->RemoveWorkItem(read->item_))
+            continue;
+        while (!read->finished_)
+            Time::Sleep(0);
+    }
+
+    stream.reads_.Clear();
+    stream.directory_.Clear();
+    stream.tiles_.Clear();
+    stream.file_.Reset();
+}
+
+void NavigationMesh::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    UpdatePathQueries();
+    UpdateStreaming();
+}
+
 void NavigationMesh::SetPartitionType(NavmeshPartitionType partitionType)
 {
     partitionType_ = partitionType;
@@ -52,19 +52,80 @@ class NavArea;
 
 struct FindPathData;
 struct NavBuildData;
+struct NavigationPathClusters;
+struct NavigationPathQueue;
+struct NavigationTileBuild;
+struct NavigationTileStream;
+struct WorkItem;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
 {
     /// Component.
-    Component* component_;
+    Component* component_{};
+    /// Geometry LOD level if applicable.
+    unsigned lodLevel_{};
+    /// Transform relative to the navigation mesh root node.
+    Matrix3x4 transform_;
+    /// Bounding box relative to the navigation mesh root node.
+    BoundingBox boundingBox_;
+
+};
+
+/// Navigation mesh geometry as it was at the last build, used to find the tiles that need to be rebuilt.
+struct NavigationGeometryRecord
+{
+    /// Component.
+    WeakPtr<Component> component_;
     /// Geometry LOD level if applicable.
     unsigned lodLevel_;
     /// Transform relative to the navigation mesh root node.
     Matrix3x4 transform_;
     /// Bounding box relative to the navigation mesh root node.
     BoundingBox boundingBox_;
+};
 
+/// Asynchronous path query statistics.
+struct NavigationPathStats
+{
+    /// Number of queued queries which have not started yet.
+    unsigned numPending_{};
+    /// Number of queries in progress.
+    unsigned numActive_{};
+    /// Number of queries completed since the navigation mesh was created.
+    unsigned numCompleted_{};
+    /// A* iterations used on the last update.
+    unsigned iterations_{};
+    /// Average time from queuing a query to sending its result, in seconds.
+    float averageLatency_{};
+    /// Longest time from queuing a query to sending its result, in seconds.
+    float maxLatency_{};
+};
+
+/// Navigation mesh tile build statistics.
+struct NavigationBuildStats
+{
+    /// Number of tiles built.
+    unsigned numTiles_{};
+    /// Wall clock time of building the tiles in microseconds.
+    long long totalTime_{};
+    /// Sum of the individual tile build times in microseconds. Exceeds the total time when the tiles are built in parallel.
+    long long tileTime_{};
+    /// Longest tile build time in microseconds.
+    long long maxTileTime_{};
+};
+
+/// Hierarchical path cluster statistics.
+struct NavigationClusterStats
+{
+    /// Number of path clusters.
+    unsigned numClusters_{};
+    /// Number of portals between the clusters.
+    unsigned numPortals_{};
+    /// Number of edges between the portals of the same cluster.
+    unsigned numEdges_{};
+    /// Time of building the portal graph in microseconds.
+    long long buildTime_{};
 };
 
 /// A flag representing the type of path point- none, the start of a path segment, the end of one, or an off-mesh connection.
@@ -142,6 +203,8 @@ public:
     virtual bool Build(const BoundingBox& boundingBox);
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     virtual bool Build(const IntVector2& from, const IntVector2& to);
+    /// Rebuild only the tiles overlapped by navigable geometry that has been added, removed, moved or resized since the last full or changed tiles build. Return true if successful.
+    virtual bool BuildChangedTiles();
     /// Return tile data.
     virtual PODVector<unsigned char> GetTileData(const IntVector2& tile) const;
     /// Add tile to navigation mesh.
@@ -162,13 +225,13 @@ public:
     /// Try to move along the surface from one point to another.
     Vector3 MoveAlongSurface(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE, int maxVisited = 3,
         const dtQueryFilter* filter = nullptr);
-    /// Find a path between world space points. Return non-empty list of points if successful. Extents specifies how far off the navigation mesh the points can be.
+    /// Find a path between world space points. Return non-empty list of points if successful. Extents specifies how far off the navigation mesh the points can be. Hierarchical search uses the path clusters for points that are not in the same or neighbouring clusters.
     void FindPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
-        const dtQueryFilter* filter = nullptr);
-    /// Find a path between world space points. Return non-empty list of navigation path points if successful. Extents specifies how far off the navigation mesh the points can be.
+        const dtQueryFilter* filter = nullptr, bool hierarchical = false);
+    /// Find a path between world space points. Return non-empty list of navigation path points if successful. Extents specifies how far off the navigation mesh the points can be. Hierarchical search uses the path clusters for points that are not in the same or neighbouring clusters.
     void FindPath
         (PODVector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
-            const dtQueryFilter* filter = nullptr);
+            const dtQueryFilter* filter = nullptr, bool hierarchical = false);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = nullptr, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -179,6 +242,55 @@ public:
     float GetDistanceToWall
         (const Vector3& point, float radius, const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = nullptr,
             Vector3* hitPos = nullptr, Vector3* hitNormal = nullptr);
+    /// Queue a path query between world space points and return its ID. The query runs over several frames on the work queue threads and the result is sent with the E_NAVIGATION_PATH_RESULT event. Queries with higher priority are started first. The filter is copied.
+    unsigned FindPathAsync(const Vector3& start, const Vector3& end, unsigned priority = 0, const Vector3& extents = Vector3::ONE,
+        const dtQueryFilter* filter = nullptr);
+    /// Cancel a queued path query. Its result will not be sent. Return true if it was still queued.
+    bool CancelPathQuery(unsigned id);
+    /// Advance the queued path queries within the iteration budget and send the results of finished ones. Called automatically after the scene update.
+    void UpdatePathQueries();
+    /// Set the A* iterations per update shared by the queued path queries.
+    void SetPathIterationBudget(unsigned iterations);
+    /// Set the maximum number of queued path queries in progress at the same time.
+    void SetMaxActivePathQueries(unsigned num);
+    /// Return the A* iterations per update shared by the queued path queries.
+    unsigned GetPathIterationBudget() const;
+    /// Return the maximum number of queued path queries in progress at the same time.
+    unsigned GetMaxActivePathQueries() const;
+    /// Return asynchronous path query statistics.
+    const NavigationPathStats& GetPathStats() const;
+    /// Set the size of the path clusters in tiles for hierarchical path queries. 0 disables the path clusters.
+    void SetPathClusterSize(int size);
+    /// Return the size of the path clusters in tiles.
+    int GetPathClusterSize() const;
+    /// Rebuild the portal graph between the path clusters. Called automatically after a full build, and before a hierarchical path query when the tiles have changed.
+    void BuildPathClusters();
+    /// Return statistics of the last path cluster build.
+    const NavigationClusterStats& GetPathClusterStats() const;
+    /// Write all tiles into a tile file that can be streamed from, with a directory to read the tiles individually. Return true if successful.
+    bool SaveStreamingData(Serializer& dest) const;
+    /// Set the tile file written by SaveStreamingData() to stream the tiles from. Tiles are then not stored in the scene, but read on the work queue threads around the streaming observers. Empty name stops streaming and keeps the streamed in tiles.
+    void SetStreamingFile(const String& fileName);
+    /// Add a node around which the tiles are streamed in.
+    void AddStreamingObserver(Node* node);
+    /// Remove a streaming observer.
+    void RemoveStreamingObserver(Node* node);
+    /// Set the distance in tiles around the streaming observers within which the tiles are streamed in. Tiles are streamed out once they are one tile further away.
+    void SetStreamingDistance(int distance);
+    /// Set the maximum number of streamed in tiles, which bounds the memory use of the navigation mesh.
+    void SetMaxStreamedTiles(unsigned num);
+    /// Stream in the tiles around the streaming observers and stream out the ones away from them. Called automatically after the scene update.
+    void UpdateStreaming();
+    /// Return the tile file the tiles are streamed from.
+    const String& GetStreamingFile() const;
+    /// Return the distance in tiles around the streaming observers within which the tiles are streamed in.
+    int GetStreamingDistance() const;
+    /// Return the maximum number of streamed in tiles.
+    unsigned GetMaxStreamedTiles() const;
+    /// Return whether the tiles are streamed from a tile file.
+    bool IsStreaming() const;
+    /// Return number of streamed in tiles.
+    unsigned GetNumStreamedTiles() const;
     /// Perform a walkability raycast on the navigation mesh between start and end and return the point where a wall was hit, or the end point if no walls.
     Vector3 Raycast
         (const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = nullptr,
@@ -255,6 +367,15 @@ public:
     /// Return Partition Type.
     NavmeshPartitionType GetPartitionType() const { return partitionType_; }
 
+    /// Set whether to build tiles in parallel on the work queue threads.
+    void SetThreadedBuild(bool enable) { threadedBuild_ = enable; }
+
+    /// Return whether tiles are built in parallel on the work queue threads.
+    bool GetThreadedBuild() const { return threadedBuild_; }
+
+    /// Return statistics of the last tile build.
+    const NavigationBuildStats& GetBuildStats() const { return buildStats_; }
+
     /// Set navigation data attribute.
     virtual void SetNavigationDataAttr(const PODVector<unsigned char>& value);
     /// Return navigation data attribute.
@@ -277,6 +398,26 @@ private:
     void WriteTile(Serializer& dest, int x, int z) const;
     /// Read tile data to the navigation mesh.
     bool ReadTile(Deserializer& source, bool silent);
+    /// Set up a tile build and collect its geometry, optionally only from the listed geometries. Called on the main thread.
+    void PrepareTileBuild(NavigationTileBuild& tileBuild, Vector<NavigationGeometryInfo>& geometryList,
+        const PODVector<unsigned>* geometryIndices);
+    /// Run the Recast pipeline for a tile and create the Detour tile data. Safe to call from worker threads. Return true if successful.
+    bool RasterizeTile(NavigationTileBuild& tileBuild) const;
+    /// Replace the tile in the navigation mesh with the built data and send the rebuild event. Return true if successful.
+    bool AddBuiltTile(NavigationTileBuild& tileBuild);
+    /// Work function for building a tile on the work queue.
+    static void BuildTileWork(const WorkItem* item, unsigned threadIndex);
+    /// Handle scene post-update to advance the queued path queries.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Send the results of finished path queries, or fail all queued queries.
+    void SendPathResults(bool failAll);
+    /// Find a polygon corridor through the path clusters and refine it within each cluster. Return true if successful.
+    bool FindClusterPath(PODVector<dtPolyRef>& dest, dtPolyRef startRef, dtPolyRef endRef, const Vector3& start, const Vector3& end,
+        const dtQueryFilter* filter);
+    /// Open the tile file and allocate the navigation mesh for streaming. Return true if successful.
+    bool StartStreaming();
+    /// Cancel the tile reads in progress and close the tile file.
+    void StopStreaming();
 
 protected:
     /// Collect geometry from under Navigable components.
@@ -285,12 +426,20 @@ protected:
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList, Node* node, HashSet<Node*>& processedNodes, bool recursive);
     /// Get geometry data within a bounding box.
     void GetTileGeometry(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList, BoundingBox& box);
+    /// Add the data of one geometry to the build data.
+    void AddTileGeometry(NavBuildData* build, const NavigationGeometryInfo& info, const Matrix3x4& inverse);
     /// Add a triangle mesh to the geometry data.
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
     /// Build one tile of the navigation mesh. Return true if successful.
     virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
     /// Build tiles in the rectangular area. Return number of built tiles.
     unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Build the listed tiles, in parallel if threaded build is enabled. Return number of built tiles.
+    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const PODVector<IntVector2>& tiles);
+    /// Remember the geometry the navigation mesh was built from.
+    void SetBuiltGeometry(const Vector<NavigationGeometryInfo>& geometryList);
+    /// Return the tiles overlapped by geometry that changed since it was last remembered, then remember the current geometry.
+    void GetChangedTiles(PODVector<IntVector2>& tiles, const Vector<NavigationGeometryInfo>& geometryList);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
     /// Release the navigation mesh and the query.
@@ -306,6 +455,12 @@ protected:
     UniquePtr<dtQueryFilter> queryFilter_;
     /// Temporary data for finding a path.
     UniquePtr<FindPathData> pathData_;
+    /// Queued asynchronous path queries.
+    UniquePtr<NavigationPathQueue> pathQueue_;
+    /// Tile streaming state.
+    UniquePtr<NavigationTileStream> tileStream_;
+    /// Path clusters for hierarchical path queries.
+    UniquePtr<NavigationPathClusters> pathClusters_;
     /// Tile size.
     int tileSize_;
     /// Cell size.
@@ -350,6 +505,14 @@ protected:
     bool drawNavAreas_;
     /// NavAreas for this NavMesh
     Vector<WeakPtr<NavArea> > areas_;
+    /// Geometry of the last full or changed tiles build.
+    Vector<NavigationGeometryRecord> builtGeometry_;
+    /// Statistics of the last tile build.
+    NavigationBuildStats buildStats_;
+    /// Build tiles in parallel.
+    bool threadedBuild_;
+    /// Whether the tiles have changed since the path clusters were built.
+    bool pathClustersDirty_;
 };
 
 /// Register Navigation library objects.
@@ -33,6 +33,7 @@
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
 #include "../Network/Protocol.h"
+#include "../Network/TransformHistory.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
@@ -46,9 +47,39 @@ namespace Urho3D
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+static const unsigned NUM_TIMESTAMPS = 256;
+static const unsigned MAX_PENDING_PACKAGE_MESSAGES = 1000;
+static const unsigned PACKAGE_STATE_SAVE_INTERVAL = 256;
+static const char* PACKAGE_PART_EXTENSION = ".part";
+static const char* PACKAGE_RESUME_EXTENSION = ".resume";
+
+/// Return whether a bit is set in a fragment bitmap.
+static inline bool IsFragmentSet(const PODVector<unsigned char>& bitmap, unsigned index)
+{
+    return (bitmap[index >> 3] & (1u << (index & 7))) != 0;
+}
+
+/// Set the bits of all fragments that lie completely within a byte range of the package file. Return the number of bits that were not set before.
+static unsigned SetFragments(PODVector<unsigned char>& bitmap, unsigned offset, unsigned size)
+{
+    unsigned numSet = 0;
+    unsigned end = Min((offset + size) / PACKAGE_FRAGMENT_SIZE, bitmap.Size() << 3);
+    for (unsigned i = (offset + PACKAGE_FRAGMENT_SIZE - 1) / PACKAGE_FRAGMENT_SIZE; i < end; ++i)
+    {
+        if (!IsFragmentSet(bitmap, i))
+        {
+            bitmap[i >> 3] |= (unsigned char)(1u << (i & 7));
+            ++numSet;
+        }
+    }
+    return numSet;
+}
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
+    numReceivedFragments_(0),
+    unsavedFragments_(0),
+    fileSize_(0),
     checksum_(0),
     initiated_(false)
 {
@@ -65,6 +96,9 @@ Connection::Connection(Context* context, bool isClient, const kNet::SharedPtr<kN
     timeStamp_(0),
     connection_(connection),
     sendMode_(OPSM_NONE),
+    packageUploadAllowance_(0),
+    ackedTimeStamp_(NUM_TIMESTAMPS - 1),
+    controlsReceived_(false),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
@@ -82,6 +116,10 @@ Connection::Connection(Context* context, bool isClient, const kNet::SharedPtr<kN
 
 Connection::~Connection()
 {
+    // Save the state of unfinished downloads so that they can be resumed on the next connection
+    for (HashMap<StringHash, PackageDownload>::Iterator i = downloads_.Begin(); i != downloads_.End(); ++i)
+        SavePackageDownloadState(i->second_);
+
     // Reset scene (remove possible owner references), as this connection is about to be destroyed
     SetScene(nullptr);
 }
@@ -261,6 +299,15 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+
+    // Acknowledge the latest received controls for client-side prediction. The acknowledgement is unreliable, so it is
+    // repeated on every update to replace a lost one. Sent with a fixed content ID so that only the newest is kept
+    if (controlsReceived_)
+    {
+        msg_.Clear();
+        msg_.WriteUByte(timeStamp_);
+        SendMessage(MSG_CONTROLSACK, false, false, msg_, CONTROLS_CONTENT_ID);
+    }
 }
 
 void Connection::SendClientUpdate()
@@ -280,6 +327,11 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // Store the controls for replay until acknowledged
+    if (sentControls_.Empty())
+        sentControls_.Resize(NUM_TIMESTAMPS);
+    sentControls_[timeStamp_] = controls_;
+
     ++timeStamp_;
 }
 
@@ -325,26 +377,54 @@ void Connection::SendRemoteEvents()
 
 void Connection::SendPackages()
 {
-    while (!uploads_.Empty() && connection_->NumOutboundMessagesPending() < 1000)
+    if (uploads_.Empty())
+        return;
+
+    // When the upload rate is limited, accumulate allowance for one network update, but at most for one second
+    unsigned uploadRate = GetSubsystem<Network>()->GetPackageUploadRate();
+    if (uploadRate)
     {
-        unsigned char buffer[PACKAGE_FRAGMENT_SIZE];
+        packageUploadAllowance_ = Min(packageUploadAllowance_ + uploadRate / GetSubsystem<Network>()->GetUpdateFps(),
+            Max(uploadRate, PACKAGE_FRAGMENT_SIZE));
+    }
+
+    unsigned char buffer[PACKAGE_FRAGMENT_SIZE];
 
+    // Send one fragment of each upload in turn so that simultaneous downloads progress evenly
+    while (!uploads_.Empty() && connection_->NumOutboundMessagesPending() < MAX_PENDING_PACKAGE_MESSAGES)
+    {
         for (HashMap<StringHash, PackageUpload>::Iterator i = uploads_.Begin(); i != uploads_.End();)
         {
+            if (uploadRate && packageUploadAllowance_ < PACKAGE_FRAGMENT_SIZE)
+                return;
+
             HashMap<StringHash, PackageUpload>::Iterator current = i++;
             PackageUpload& upload = current->second_;
-            unsigned fragmentSize =
-                Min((upload.file_->GetSize() - upload.file_->GetPosition()), PACKAGE_FRAGMENT_SIZE);
-            upload.file_->Read(buffer, fragmentSize);
 
-            msg_.Clear();
-            msg_.WriteStringHash(current->first_);
-            msg_.WriteUInt(upload.fragment_++);
-            msg_.Write(buffer, fragmentSize);
-            SendMessage(MSG_PACKAGEDATA, true, false, msg_);
+            // Skip the fragments the client already has
+            while (upload.fragment_ < upload.totalFragments_ && IsFragmentSet(upload.skipFragments_, upload.fragment_))
+                ++upload.fragment_;
+
+            if (upload.fragment_ < upload.totalFragments_)
+            {
+                unsigned fragmentStart = upload.fragment_ * PACKAGE_FRAGMENT_SIZE;
+                unsigned fragmentSize = Min(upload.file_->GetSize() - fragmentStart, PACKAGE_FRAGMENT_SIZE);
+                if (upload.file_->GetPosition() != fragmentStart)
+                    upload.file_->Seek(fragmentStart);
+                upload.file_->Read(buffer, fragmentSize);
+
+                msg_.Clear();
+                msg_.WriteStringHash(current->first_);
+                msg_.WriteUInt(upload.fragment_++);
+                msg_.Write(buffer, fragmentSize);
+                SendMessage(MSG_PACKAGEDATA, true, false, msg_);
+
+                if (uploadRate)
+                    packageUploadAllowance_ -= PACKAGE_FRAGMENT_SIZE;
+            }
 
             // Check if upload finished
-            if (upload.fragment_ == upload.totalFragments_)
+            if (upload.fragment_ >= upload.totalFragments_)
                 uploads_.Erase(current);
         }
     }
@@ -401,12 +481,17 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
         ProcessControls(msgID, msg);
         break;
 
+    case MSG_CONTROLSACK:
+        ProcessControlsAck(msgID, msg);
+        break;
+
     case MSG_SCENELOADED:
         ProcessSceneLoaded(msgID, msg);
         break;
 
     case MSG_REQUESTPACKAGE:
     case MSG_PACKAGEDATA:
+    case MSG_PACKAGEPATCH:
         ProcessPackageDownload(msgID, msg);
         break;
 
@@ -760,11 +845,65 @@ void Connection::ProcessPackageDownload(int msgID, MemoryBuffer& msg)
                         return;
                     }
 
-                    URHO3D_LOGINFO("Transmitting package file " + name + " to client " + ToString());
+                    PackageUpload& upload = uploads_[nameHash];
+                    upload.file_ = file;
+                    upload.fragment_ = 0;
+                    upload.totalFragments_ = (file->GetSize() + PACKAGE_FRAGMENT_SIZE - 1) / PACKAGE_FRAGMENT_SIZE;
+                    upload.skipFragments_.Resize((upload.totalFragments_ + 7) >> 3);
+                    if (upload.skipFragments_.Size())
+                        memset(&upload.skipFragments_[0], 0, upload.skipFragments_.Size());
+
+                    // When resuming, the client sends the fragments it already has
+                    if (!msg.IsEof())
+                    {
+                        PODVector<unsigned char> receivedFragments = msg.ReadBuffer();
+                        if (receivedFragments.Size() == upload.skipFragments_.Size())
+                            upload.skipFragments_ = receivedFragments;
+                    }
+
+                    // The client may also list the file entries of an older version of the package. Entries that have not
+                    // changed are copied from it on the client, and the fragments they cover fully are not sent
+                    if (!msg.IsEof())
+                    {
+                        unsigned numBaseEntries = msg.ReadVLE();
+                        unsigned numUnchanged = 0;
+                        unsigned unchangedSize = 0;
+                        VectorBuffer patch;
+
+                        for (unsigned j = 0; j < numBaseEntries && !msg.IsEof(); ++j)
+                        {
+                            String entryName = msg.ReadString();
+                            unsigned checksum = msg.ReadUInt();
+                            unsigned size = msg.ReadUInt();
+                            unsigned storedSize = msg.ReadUInt();
+                            unsigned codec = msg.ReadUByte();
+
+                            const PackageEntry* entry = package->GetEntry(entryName);
+                            if (entry && entry->codec_ == codec && entry->checksum_ == checksum && entry->size_ == size &&
+                                entry->storedSize_ == storedSize)
+                            {
+                                patch.WriteString(entryName);
+                                patch.WriteUInt(entry->offset_);
+                                patch.WriteUInt(storedSize);
+                                SetFragments(upload.skipFragments_, entry->offset_, storedSize);
+                                ++numUnchanged;
+                                unchangedSize += storedSize;
+                            }
+                        }
+
+                        if (numUnchanged)
+                        {
+                            URHO3D_LOGINFO("Client " + ToString() + " has " + String(unchangedSize) + " bytes of package " +
+                                name + " in an older version");
+                            msg_.Clear();
+                            msg_.WriteStringHash(nameHash);
+                            msg_.WriteVLE(numUnchanged);
+                            msg_.Write(patch.GetData(), patch.GetSize());
+                            SendMessage(MSG_PACKAGEPATCH, true, true, msg_);
+                        }
+                    }
 
-                    uploads_[nameHash].file_ = file;
-                    uploads_[nameHash].fragment_ = 0;
-                    uploads_[nameHash].totalFragments_ = (file->GetSize() + PACKAGE_FRAGMENT_SIZE - 1) / PACKAGE_FRAGMENT_SIZE;
+                    URHO3D_LOGINFO("Transmitting package file " + name + " to client " + ToString());
                     return;
                 }
             }
@@ -801,53 +940,98 @@ void Connection::ProcessPackageDownload(int msgID, MemoryBuffer& msg)
                 return;
             }
 
-            // If file has not yet been opened, try to open now. Prepend the checksum to the filename to allow multiple versions
-            if (!download.file_)
+            // If file has not yet been opened, try to open now
+            if (!OpenPackageDownloadFile(download))
             {
-                download.file_ = new File(context_,
-                    GetSubsystem<Network>()->GetPackageCacheDir() + ToStringHex(download.checksum_) + "_" + download.name_,
-                    FILE_WRITE);
-                if (!download.file_->IsOpen())
-                {
-                    OnPackageDownloadFailed(download.name_);
-                    return;
-                }
+                OnPackageDownloadFailed(download.name_);
+                return;
             }
 
             // Write the fragment data to the proper index
             unsigned char buffer[PACKAGE_FRAGMENT_SIZE];
             unsigned index = msg.ReadUInt();
             unsigned fragmentSize = msg.GetSize() - msg.GetPosition();
+            if (index >= download.totalFragments_ || fragmentSize > PACKAGE_FRAGMENT_SIZE)
+                return;
 
-            msg.Read(buffer, fragmentSize);
-            download.file_->Seek(index * PACKAGE_FRAGMENT_SIZE);
-            download.file_->Write(buffer, fragmentSize);
-            download.receivedFragments_.Insert(index);
+            if (!IsFragmentSet(download.receivedFragments_, index))
+            {
+                msg.Read(buffer, fragmentSize);
+                download.file_->Seek(index * PACKAGE_FRAGMENT_SIZE);
+                download.file_->Write(buffer, fragmentSize);
+                download.receivedFragments_[index >> 3] |= (unsigned char)(1u << (index & 7));
+                ++download.numReceivedFragments_;
+
+                if (++download.unsavedFragments_ >= PACKAGE_STATE_SAVE_INTERVAL)
+                    SavePackageDownloadState(download);
+            }
 
             // Check if all fragments received
-            if (download.receivedFragments_.Size() == download.totalFragments_)
+            if (download.numReceivedFragments_ == download.totalFragments_)
+                CompletePackageDownload(nameHash);
+        }
+        break;
+
+    case MSG_PACKAGEPATCH:
+        if (IsClient())
+        {
+            URHO3D_LOGWARNING("Received unexpected PackagePatch message from client");
+            return;
+        }
+        else
+        {
+            StringHash nameHash = msg.ReadStringHash();
+
+            HashMap<StringHash, PackageDownload>::Iterator i = downloads_.Find(nameHash);
+            if (i == downloads_.End())
+                return;
+
+            PackageDownload& download = i->second_;
+            SharedPtr<File> baseFile;
+            if (download.basePackage_)
+                baseFile = new File(context_, download.basePackage_->GetName());
+            if (!baseFile || !baseFile->IsOpen() || !OpenPackageDownloadFile(download))
             {
-                URHO3D_LOGINFO("Package " + download.name_ + " downloaded successfully");
+                OnPackageDownloadFailed(download.name_);
+                return;
+            }
 
-                // Instantiate the package and add to the resource system, as we will need it to load the scene
-                download.file_->Close();
-                GetSubsystem<ResourceCache>()->AddPackageFile(download.file_->GetName(), 0);
+            // Copy the unchanged file entries from the older version
+            PODVector<unsigned char> buffer;
+            unsigned numEntries = msg.ReadVLE();
+            for (unsigned j = 0; j < numEntries; ++j)
+            {
+                String entryName = msg.ReadString();
+                unsigned offset = msg.ReadUInt();
+                unsigned storedSize = msg.ReadUInt();
 
-                // Then start the next download if there are more
-                downloads_.Erase(i);
-                if (downloads_.Empty())
-                    OnPackagesReady();
-                else
+                const PackageEntry* entry = download.basePackage_->GetEntry(entryName);
+                if (!entry || offset + storedSize > download.fileSize_)
                 {
-                    PackageDownload& nextDownload = downloads_.Begin()->second_;
+                    OnPackageDownloadFailed(download.name_);
+                    return;
+                }
 
-                    URHO3D_LOGINFO("Requesting package " + nextDownload.name_ + " from server");
-                    msg_.Clear();
-                    msg_.WriteString(nextDownload.name_);
-                    SendMessage(MSG_REQUESTPACKAGE, true, true, msg_);
-                    nextDownload.initiated_ = true;
+                buffer.Resize(storedSize);
+                baseFile->Seek(entry->offset_);
+                if (storedSize && baseFile->Read(&buffer[0], storedSize) != storedSize)
+                {
+                    OnPackageDownloadFailed(download.name_);
+                    return;
                 }
+                download.file_->Seek(offset);
+                download.file_->Write(buffer.Buffer(), storedSize);
+
+                unsigned numCovered = SetFragments(download.receivedFragments_, offset, storedSize);
+                download.numReceivedFragments_ += numCovered;
+                download.unsavedFragments_ += numCovered;
             }
+
+            URHO3D_LOGINFO("Copied " + String(numEntries) + " unchanged files of package " + download.name_ +
+                " from the older version");
+
+            if (download.numReceivedFragments_ == download.totalFragments_)
+                CompletePackageDownload(nameHash);
         }
         break;
 
@@ -893,6 +1077,7 @@ void Connection::ProcessControls(int msgID, MemoryBuffer& msg)
 
     SetControls(newControls);
     timeStamp_ = msg.ReadUByte();
+    controlsReceived_ = true;
 
     // Client may or may not send observer position & rotation for interest management
     if (!msg.IsEof())
@@ -901,6 +1086,28 @@ void Connection::ProcessControls(int msgID, MemoryBuffer& msg)
         rotation_ = msg.ReadPackedQuaternion();
 }
 
+void Connection::ProcessControlsAck(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected ControlsAck message from client");
+        return;
+    }
+
+    unsigned char timeStamp = msg.ReadUByte();
+    if (timeStamp == ackedTimeStamp_)
+        return;
+
+    ackedTimeStamp_ = timeStamp;
+
+    using namespace ControlsAcknowledged;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_CONNECTION] = this;
+    eventData[P_TIMESTAMP] = (unsigned)timeStamp;
+    SendEvent(E_CONTROLSACKNOWLEDGED, eventData);
+}
+
 void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
 {
     if (!IsClient())
@@ -1051,7 +1258,7 @@ float Connection::GetDownloadProgress() const
     for (HashMap<StringHash, PackageDownload>::ConstIterator i = downloads_.Begin(); i != downloads_.End(); ++i)
     {
         if (i->second_.initiated_)
-            return (float)i->second_.receivedFragments_.Size() / (float)i->second_.totalFragments_;
+            return (float)i->second_.numReceivedFragments_ / (float)i->second_.totalFragments_;
     }
     return 1.0f;
 }
@@ -1092,6 +1299,33 @@ void Connection::ConfigureNetworkSimulator(int latencyMs, float packetLoss)
     }
 }
 
+const Controls& Connection::GetSentControls(unsigned char timeStamp) const
+{
+    static const Controls noControls;
+    return sentControls_.Empty() ? noControls : sentControls_[timeStamp];
+}
+
+void Connection::RewindScene(float interpolationDelay)
+{
+    if (!scene_ || !rewoundHistories_.Empty())
+        return;
+
+    URHO3D_PROFILE(RewindScene);
+
+    float time = scene_->GetElapsedTime() - GetRoundTripTime() * 0.001f - interpolationDelay;
+
+    scene_->GetComponents<TransformHistory>(rewoundHistories_, true);
+    for (PODVector<TransformHistory*>::Iterator i = rewoundHistories_.Begin(); i != rewoundHistories_.End(); ++i)
+        (*i)->Rewind(time);
+}
+
+void Connection::RestoreScene()
+{
+    for (PODVector<TransformHistory*>::Iterator i = rewoundHistories_.Begin(); i != rewoundHistories_.End(); ++i)
+        (*i)->Restore();
+    rewoundHistories_.Clear();
+}
+
 void Connection::HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData)
 {
     sceneLoaded_ = true;
@@ -1456,17 +1690,195 @@ void Connection::RequestPackage(const String& name, unsigned fileSize, unsigned
     PackageDownload& download = downloads_[nameHash];
     download.name_ = name;
     download.totalFragments_ = (fileSize + PACKAGE_FRAGMENT_SIZE - 1) / PACKAGE_FRAGMENT_SIZE;
+    download.fileSize_ = fileSize;
     download.checksum_ = checksum;
+    download.receivedFragments_.Resize((download.totalFragments_ + 7) >> 3);
+    if (download.receivedFragments_.Size())
+        memset(&download.receivedFragments_[0], 0, download.receivedFragments_.Size());
+
+    // Check for an interrupted earlier download of the same package version
+    auto* fileSystem = GetSubsystem<FileSystem>();
+    String partFileName = GetSubsystem<Network>()->GetPackageCacheDir() + ToStringHex(checksum) + "_" + name +
+        PACKAGE_PART_EXTENSION;
+    if (fileSystem->FileExists(partFileName) && fileSystem->FileExists(partFileName + PACKAGE_RESUME_EXTENSION))
+    {
+        File resumeFile(context_, partFileName + PACKAGE_RESUME_EXTENSION);
+        unsigned savedFileSize = resumeFile.ReadUInt();
+        PODVector<unsigned char> receivedFragments = resumeFile.ReadBuffer();
+        unsigned numReceived = 0;
+        if (savedFileSize == fileSize && receivedFragments.Size() == download.receivedFragments_.Size())
+        {
+            for (unsigned i = 0; i < download.totalFragments_; ++i)
+            {
+                if (IsFragmentSet(receivedFragments, i))
+                    ++numReceived;
+            }
+        }
+
+        // If the earlier download was interrupted right before finishing, simply download again, as at least one fragment
+        // is needed to trigger completion
+        if (numReceived && numReceived < download.totalFragments_)
+        {
+            download.receivedFragments_ = receivedFragments;
+            download.numReceivedFragments_ = numReceived;
+
+            URHO3D_LOGINFO("Resuming download of package " + name + " with " + String(download.numReceivedFragments_) + "/" +
+                String(download.totalFragments_) + " fragments");
+        }
+    }
+
+    download.basePackage_ = FindBasePackage(name, checksum);
+
+    StartPackageDownloads();
+}
+
+void Connection::StartPackageDownloads()
+{
+    unsigned numInitiated = 0;
+    for (HashMap<StringHash, PackageDownload>::ConstIterator i = downloads_.Begin(); i != downloads_.End(); ++i)
+    {
+        if (i->second_.initiated_)
+            ++numInitiated;
+    }
 
-    // Start download now only if no existing downloads, else wait for the existing ones to finish
-    if (downloads_.Size() == 1)
+    for (HashMap<StringHash, PackageDownload>::Iterator i = downloads_.Begin(); i != downloads_.End() &&
+        numInitiated < MAX_PACKAGE_DOWNLOADS; ++i)
     {
-        URHO3D_LOGINFO("Requesting package " + name + " from server");
+        PackageDownload& download = i->second_;
+        if (download.initiated_)
+            continue;
+
+        URHO3D_LOGINFO("Requesting package " + download.name_ + " from server");
         msg_.Clear();
-        msg_.WriteString(name);
+        msg_.WriteString(download.name_);
+        // When resuming, send the fragments already received
+        if (download.numReceivedFragments_)
+            msg_.WriteBuffer(download.receivedFragments_);
+        else
+            msg_.WriteVLE(0);
+
+        // List the file entries of an older version, so that the server does not need to send the unchanged ones
+        if (download.basePackage_)
+        {
+            const HashMap<String, PackageEntry>& entries = download.basePackage_->GetEntries();
+            msg_.WriteVLE(entries.Size());
+            for (HashMap<String, PackageEntry>::ConstIterator j = entries.Begin(); j != entries.End(); ++j)
+            {
+                msg_.WriteString(j->first_);
+                msg_.WriteUInt(j->second_.checksum_);
+                msg_.WriteUInt(j->second_.size_);
+                msg_.WriteUInt(j->second_.storedSize_);
+                msg_.WriteUByte((unsigned char)j->second_.codec_);
+            }
+        }
+
         SendMessage(MSG_REQUESTPACKAGE, true, true, msg_);
         download.initiated_ = true;
+        ++numInitiated;
+    }
+}
+
+SharedPtr<PackageFile> Connection::FindBasePackage(const String& name, unsigned checksum)
+{
+    // Check first the resource cache
+    const Vector<SharedPtr<PackageFile> >& packages = GetSubsystem<ResourceCache>()->GetPackageFiles();
+    for (unsigned i = 0; i < packages.Size(); ++i)
+    {
+        if (!GetFileNameAndExtension(packages[i]->GetName()).Compare(name, false) && packages[i]->GetChecksum() != checksum)
+            return packages[i];
+    }
+
+    // Then the download cache, where package file name format is checksum_packagename
+    const String& packageCacheDir = GetSubsystem<Network>()->GetPackageCacheDir();
+    if (packageCacheDir.Empty())
+        return SharedPtr<PackageFile>();
+
+    Vector<String> downloadedPackages;
+    GetSubsystem<FileSystem>()->ScanDir(downloadedPackages, packageCacheDir, "*.*", SCAN_FILES, false);
+    for (unsigned i = 0; i < downloadedPackages.Size(); ++i)
+    {
+        const String& fileName = downloadedPackages[i];
+        if (fileName.Length() != name.Length() + 9 || fileName.Substring(9).Compare(name, false) ||
+            fileName.StartsWith(ToStringHex(checksum)))
+            continue;
+
+        SharedPtr<PackageFile> package(new PackageFile(context_));
+        if (package->Open(packageCacheDir + fileName))
+            return package;
+    }
+
+    return SharedPtr<PackageFile>();
+}
+
+bool Connection::OpenPackageDownloadFile(PackageDownload& download)
+{
+    if (download.file_)
+        return true;
+
+    // Prepend the checksum to the filename to allow multiple versions. Open for read/write to keep the data of an earlier
+    // interrupted download
+    download.file_ = new File(context_, GetSubsystem<Network>()->GetPackageCacheDir() + ToStringHex(download.checksum_) + "_" +
+        download.name_ + PACKAGE_PART_EXTENSION, FILE_READWRITE);
+    return download.file_->IsOpen();
+}
+
+void Connection::SavePackageDownloadState(PackageDownload& download)
+{
+    if (!download.file_ || !download.file_->IsOpen() || !download.unsavedFragments_)
+        return;
+
+    // Make sure the fragment data is on disk before it is recorded as received
+    download.file_->Flush();
+
+    File resumeFile(context_, download.file_->GetName() + PACKAGE_RESUME_EXTENSION, FILE_WRITE);
+    if (resumeFile.IsOpen())
+    {
+        resumeFile.WriteUInt(download.fileSize_);
+        resumeFile.WriteBuffer(download.receivedFragments_);
+    }
+    download.unsavedFragments_ = 0;
+}
+
+void Connection::CompletePackageDownload(StringHash nameHash)
+{
+    HashMap<StringHash, PackageDownload>::Iterator i = downloads_.Find(nameHash);
+    if (i == downloads_.End())
+        return;
+
+    PackageDownload& download = i->second_;
+    auto* fileSystem = GetSubsystem<FileSystem>();
+    String partFileName = download.file_->GetName();
+    String fileName = partFileName.Substring(0, partFileName.Length() - String(PACKAGE_PART_EXTENSION).Length());
+
+    download.file_->Close();
+    fileSystem->Delete(partFileName + PACKAGE_RESUME_EXTENSION);
+    fileSystem->Delete(fileName);
+    fileSystem->Rename(partFileName, fileName);
+
+    // Verify the whole package before use, as it may have been assembled from several connections and an older version
+    SharedPtr<PackageFile> package(new PackageFile(context_));
+    if (!package->Open(fileName) || package->GetTotalSize() != download.fileSize_ || package->GetChecksum() != download.checksum_ ||
+        !package->VerifyChecksums())
+    {
+        package.Reset();
+        fileSystem->Delete(fileName);
+        String name = download.name_;
+        downloads_.Erase(i);
+        OnPackageDownloadFailed(name);
+        return;
     }
+
+    URHO3D_LOGINFO("Package " + download.name_ + " downloaded successfully");
+
+    // Add the package to the resource system, as we will need it to load the scene
+    GetSubsystem<ResourceCache>()->AddPackageFile(package, 0);
+
+    // Then start the next downloads if there are more
+    downloads_.Erase(i);
+    if (downloads_.Empty())
+        OnPackagesReady();
+    else
+        StartPackageDownloads();
 }
 
 void Connection::SendPackageError(const String& name)
@@ -1490,7 +1902,9 @@ void Connection::OnSceneLoadFailed()
 void Connection::OnPackageDownloadFailed(const String& name)
 {
     URHO3D_LOGERROR("Download of package " + name + " failed");
-    // As one package failed, we can not join the scene in any case. Clear the downloads
+    // As one package failed, we can not join the scene in any case. Clear the downloads, but keep the others resumable
+    for (HashMap<StringHash, PackageDownload>::Iterator i = downloads_.Begin(); i != downloads_.End(); ++i)
+        SavePackageDownloadState(i->second_);
     downloads_.Clear();
     OnSceneLoadFailed();
 }
@@ -45,6 +45,7 @@ class Node;
 class Scene;
 class Serializable;
 class PackageFile;
+class TransformHistory;
 
 /// Queued remote event.
 struct RemoteEvent
@@ -67,12 +68,20 @@ struct PackageDownload
 
     /// Destination file.
     SharedPtr<File> file_;
-    /// Already received fragments.
-    HashSet<unsigned> receivedFragments_;
+    /// Older cached version of the package to copy unchanged file entries from, if any.
+    SharedPtr<PackageFile> basePackage_;
+    /// Bitmap of already received fragments.
+    PODVector<unsigned char> receivedFragments_;
     /// Package name.
     String name_;
     /// Total number of fragments.
     unsigned totalFragments_;
+    /// Number of already received fragments.
+    unsigned numReceivedFragments_;
+    /// Number of fragments received since the resume state was last saved.
+    unsigned unsavedFragments_;
+    /// Package file size.
+    unsigned fileSize_;
     /// Checksum.
     unsigned checksum_;
     /// Download initiated flag.
@@ -87,6 +96,8 @@ struct PackageUpload
 
     /// Source file.
     SharedPtr<File> file_;
+    /// Bitmap of fragments the client already has and which are not sent.
+    PODVector<unsigned char> skipFragments_;
     /// Current fragment index.
     unsigned fragment_;
     /// Total number of fragments
@@ -223,6 +234,19 @@ public:
     /// Set network simulation parameters. Called by Network.
     void ConfigureNetworkSimulator(int latencyMs, float packetLoss);
 
+    /// Return the timestamp of the latest controls acknowledged by the server. Valid on the client only.
+    unsigned char GetAckedTimeStamp() const { return ackedTimeStamp_; }
+
+    /// Return number of controls sent to the server but not yet acknowledged. Valid on the client only.
+    unsigned GetNumPendingControls() const { return (unsigned char)(timeStamp_ - ackedTimeStamp_ - 1); }
+
+    /// Return previously sent controls by timestamp, for replaying unacknowledged input after a server correction. Valid on the client only.
+    const Controls& GetSentControls(unsigned char timeStamp) const;
+    /// Rewind all nodes with a TransformHistory component in the scene to the state the client was seeing when it sent its latest controls: round trip time plus the specified client-side interpolation delay in seconds ago. Call RestoreScene() after lag-compensated hit testing. Valid on the server only.
+    void RewindScene(float interpolationDelay = 0.0f);
+    /// Restore the nodes rewound by RewindScene().
+    void RestoreScene();
+
     /// Current controls.
     Controls controls_;
     /// Controls timestamp. Incremented after each sent update.
@@ -245,6 +269,8 @@ private:
     void ProcessIdentity(int msgID, MemoryBuffer& msg);
     /// Process a Controls message from the client. Called by Network.
     void ProcessControls(int msgID, MemoryBuffer& msg);
+    /// Process a ControlsAck message from the server. Called by Network.
+    void ProcessControlsAck(int msgID, MemoryBuffer& msg);
     /// Process a SceneLoaded message from the client. Called by Network.
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
@@ -259,8 +285,18 @@ private:
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Check a package list received from server and initiate package downloads as necessary. Return true on success, or false if failed to initialze downloads (cache dir not set)
     bool RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg);
-    /// Initiate a package download.
+    /// Initiate a package download. Resumes a previously interrupted download of the same package version if found in the cache directory.
     void RequestPackage(const String& name, unsigned fileSize, unsigned checksum);
+    /// Send requests for queued package downloads, up to the maximum number of simultaneous downloads.
+    void StartPackageDownloads();
+    /// Return an older version of a package from the resource cache or the download cache for delta download, or null if none.
+    SharedPtr<PackageFile> FindBasePackage(const String& name, unsigned checksum);
+    /// Open the destination file of a package download. Return true if successful.
+    bool OpenPackageDownloadFile(PackageDownload& download);
+    /// Save the received fragments of a package download to allow resuming it later.
+    void SavePackageDownloadState(PackageDownload& download);
+    /// Finish a package download once all fragments have been received: verify the checksums and add the package to the resource cache.
+    void CompletePackageDownload(StringHash nameHash);
     /// Send an error reply for a package download.
     void SendPackageError(const String& name);
     /// Handle scene load failure on the server or client.
@@ -290,6 +326,10 @@ private:
     VectorBuffer msg_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
+    /// Ring buffer of sent controls indexed by timestamp.
+    Vector<Controls> sentControls_;
+    /// Transform histories rewound by RewindScene().
+    PODVector<TransformHistory*> rewoundHistories_;
     /// Scene file to load once all packages (if any) have been downloaded.
     String sceneFileName_;
     /// Statistics timer.
@@ -304,6 +344,12 @@ private:
     Quaternion rotation_;
     /// Send mode for the observer position & rotation.
     ObserverPositionSendMode sendMode_;
+    /// Package upload allowance in bytes when package upload rate is limited.
+    unsigned packageUploadAllowance_;
+    /// Timestamp of the latest controls acknowledged by the server.
+    unsigned char ackedTimeStamp_;
+    /// Controls received from the client flag.
+    bool controlsReceived_;
     /// Client connection flag.
     bool isClient_;
     /// Connection pending flag.
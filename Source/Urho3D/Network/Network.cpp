@@ -36,6 +36,7 @@
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
 #include "../Network/Protocol.h"
+#include "../Network/TransformHistory.h"
 #include "../Scene/Scene.h"
 
 #include <kNet/kNet.h>
@@ -53,7 +54,8 @@ Network::Network(Context* context) :
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
-    updateAcc_(0.0f)
+    updateAcc_(0.0f),
+    packageUploadRate_(0)
 {
     network_ = new kNet::Network();
 
@@ -145,6 +147,7 @@ u32 Network::ComputeContentID(kNet::message_id_t msgId, const char* data, size_t
     switch (msgId)
     {
     case MSG_CONTROLS:
+    case MSG_CONTROLSACK:
         // Return fixed content ID for controls
         return CONTROLS_CONTENT_ID;
 
@@ -377,6 +380,11 @@ void Network::SetPackageCacheDir(const String& path)
     packageCacheDir_ = AddTrailingSlash(path);
 }
 
+void Network::SetPackageUploadRate(unsigned bytesPerSec)
+{
+    packageUploadRate_ = bytesPerSec;
+}
+
 void Network::SendPackageToClients(Scene* scene, PackageFile* package)
 {
     if (!scene)
@@ -596,6 +604,7 @@ void Network::ConfigureNetworkSimulator()
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
+    TransformHistory::RegisterObject(context);
 }
 
 }
@@ -99,6 +99,8 @@ public:
     void UnregisterAllRemoteEvents();
     /// Set the package download cache directory.
     void SetPackageCacheDir(const String& path);
+    /// Set maximum package upload rate per client connection in bytes per second. 0 (default) is unlimited, in which case uploads are only throttled by the amount of pending outbound messages.
+    void SetPackageUploadRate(unsigned bytesPerSec);
     /// Trigger all client connections in the specified scene to download a package file from the server. Can be used to download additional resource packages when clients are already joined in the scene. The package must have been added as a requirement to the scene, or else the eventual download will fail.
     void SendPackageToClients(Scene* scene, PackageFile* package);
     /// Perform an HTTP request to the specified URL. Empty verb defaults to a GET request. Return a request object which can be used to read the response data.
@@ -129,6 +131,9 @@ public:
     /// Return the package download cache directory.
     const String& GetPackageCacheDir() const { return packageCacheDir_; }
 
+    /// Return maximum package upload rate per client connection in bytes per second.
+    unsigned GetPackageUploadRate() const { return packageUploadRate_; }
+
     /// Process incoming messages from connections. Called by HandleBeginFrame.
     void Update(float timeStep);
     /// Send outgoing messages after frame logic. Called by HandleRenderUpdate.
@@ -168,6 +173,8 @@ private:
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
+    /// Maximum package upload rate per client connection in bytes per second.
+    unsigned packageUploadRate_;
     /// Package cache directory.
     String packageCacheDir_;
 };
@@ -91,6 +91,13 @@ URHO3D_EVENT(E_NETWORKSCENELOADFAILED, NetworkSceneLoadFailed)
     URHO3D_PARAM(P_CONNECTION, Connection);      // Connection pointer
 }
 
+/// Server has acknowledged new client controls. Controls sent after the acknowledged timestamp can be replayed on top of the authoritative state for client-side prediction.
+URHO3D_EVENT(E_CONTROLSACKNOWLEDGED, ControlsAcknowledged)
+{
+    URHO3D_PARAM(P_CONNECTION, Connection);      // Connection pointer
+    URHO3D_PARAM(P_TIMESTAMP, TimeStamp);        // unsigned (0-255)
+}
+
 /// Remote event: adds Connection parameter to the event data
 URHO3D_EVENT(E_REMOTEEVENTDATA, RemoteEventData)
 {
@@ -63,10 +63,16 @@ static const int MSG_REMOTEEVENT = 0x14;
 static const int MSG_REMOTENODEEVENT = 0x15;
 /// Server->client: info about package.
 static const int MSG_PACKAGEINFO = 0x16;
+/// Server->client: timestamp of the latest controls received from the client.
+static const int MSG_CONTROLSACK = 0x17;
+/// Server->client: package file entries that are unchanged in the client's older version of the package and are not sent.
+static const int MSG_PACKAGEPATCH = 0x18;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
+/// Maximum number of simultaneous package downloads.
+static const unsigned MAX_PACKAGE_DOWNLOADS = 4;
 
 }
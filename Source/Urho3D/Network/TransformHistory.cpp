@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Network/NetworkEvents.h"
+#include "../Network/TransformHistory.h"
+#include "../Scene/Scene.h"
+#ifdef URHO3D_PHYSICS
+#include "../Physics/PhysicsWorld.h"
+#include "../Physics/RigidBody.h"
+
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btRigidBody.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* NETWORK_CATEGORY;
+
+TransformHistory::TransformHistory(Context* context) :
+    Component(context),
+    nextSample_(0),
+    numSamples_(0),
+    rewound_(false)
+{
+    samples_.Resize(DEFAULT_TRANSFORM_HISTORY_LENGTH);
+}
+
+TransformHistory::~TransformHistory() = default;
+
+void TransformHistory::RegisterObject(Context* context)
+{
+    context->RegisterFactory<TransformHistory>(NETWORK_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("History Length", GetHistoryLength, SetHistoryLength, unsigned, DEFAULT_TRANSFORM_HISTORY_LENGTH,
+        AM_DEFAULT);
+}
+
+void TransformHistory::SetHistoryLength(unsigned length)
+{
+    length = Max(length, 1U);
+    if (length == samples_.Size())
+        return;
+
+    samples_.Resize(length);
+    ClearHistory();
+}
+
+void TransformHistory::Record(float time)
+{
+    // Never record a rewound transform
+    if (!node_ || rewound_)
+        return;
+
+    TransformSample& sample = samples_[nextSample_];
+    sample.time_ = time;
+    sample.position_ = node_->GetWorldPosition();
+    sample.rotation_ = node_->GetWorldRotation();
+
+    nextSample_ = (nextSample_ + 1) % samples_.Size();
+    if (numSamples_ < samples_.Size())
+        ++numSamples_;
+}
+
+void TransformHistory::ClearHistory()
+{
+    nextSample_ = 0;
+    numSamples_ = 0;
+}
+
+bool TransformHistory::Rewind(float time)
+{
+    if (!node_ || rewound_)
+        return false;
+
+    Vector3 position;
+    Quaternion rotation;
+    if (!GetTransform(time, position, rotation))
+        return false;
+
+    savedPosition_ = node_->GetWorldPosition();
+    savedRotation_ = node_->GetWorldRotation();
+    rewound_ = true;
+    ApplyTransform(position, rotation);
+    return true;
+}
+
+void TransformHistory::Restore()
+{
+    if (!node_ || !rewound_)
+        return;
+
+    ApplyTransform(savedPosition_, savedRotation_);
+    rewound_ = false;
+}
+
+const TransformSample& TransformHistory::GetSample(unsigned index) const
+{
+    unsigned first = (nextSample_ + samples_.Size() - numSamples_) % samples_.Size();
+    return samples_[(first + index) % samples_.Size()];
+}
+
+bool TransformHistory::GetTransform(float time, Vector3& position, Quaternion& rotation) const
+{
+    if (!numSamples_)
+        return false;
+
+    // Search from the newest sample backwards, as rewinds are usually short
+    for (unsigned i = numSamples_ - 1; i > 0; --i)
+    {
+        const TransformSample& newer = GetSample(i);
+        const TransformSample& older = GetSample(i - 1);
+        if (time >= newer.time_)
+        {
+            position = newer.position_;
+            rotation = newer.rotation_;
+            return true;
+        }
+        if (time >= older.time_)
+        {
+            float span = newer.time_ - older.time_;
+            float t = span > M_EPSILON ? (time - older.time_) / span : 1.0f;
+            position = older.position_.Lerp(newer.position_, t);
+            rotation = older.rotation_.Slerp(newer.rotation_, t);
+            return true;
+        }
+    }
+
+    // Older than the whole history, or only one sample: clamp
+    const TransformSample& oldest = GetSample(0);
+    position = oldest.position_;
+    rotation = oldest.rotation_;
+    return true;
+}
+
+void TransformHistory::OnSceneSet(Scene* scene)
+{
+    if (scene)
+        SubscribeToEvent(E_NETWORKUPDATE, URHO3D_HANDLER(TransformHistory, HandleNetworkUpdate));
+    else
+        UnsubscribeFromEvent(E_NETWORKUPDATE);
+
+    ClearHistory();
+    rewound_ = false;
+}
+
+void TransformHistory::ApplyTransform(const Vector3& position, const Quaternion& rotation)
+{
+    node_->SetWorldTransform(position, rotation);
+
+#ifdef URHO3D_PHYSICS
+    // Kinematic bodies do not follow the node outside the simulation step, so move them explicitly. Then refresh the
+    // broadphase bounds so that raycasts against the rewound body hit correctly before the next step
+    auto* body = node_->GetComponent<RigidBody>();
+    if (body && body->GetBody() && body->GetPhysicsWorld())
+    {
+        if (body->IsKinematic())
+        {
+            body->SetPosition(position);
+            body->SetRotation(rotation);
+        }
+        body->GetPhysicsWorld()->GetWorld()->updateSingleAabb(body->GetBody());
+    }
+#endif
+}
+
+void TransformHistory::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+{
+    Scene* scene = GetScene();
+    if (scene && IsEnabledEffective())
+        Record(scene->GetElapsedTime());
+}
+
+}
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2008-2018 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+/// Recorded world transform of a node.
+struct TransformSample
+{
+    /// Scene elapsed time of the sample.
+    float time_;
+    /// World position.
+    Vector3 position_;
+    /// World rotation.
+    Quaternion rotation_;
+};
+
+/// Default number of transform samples kept.
+static const unsigned DEFAULT_TRANSFORM_HISTORY_LENGTH = 32;
+
+/// %Transform history component for lag compensation. Records the node's world transform on each network update into a ring buffer, and can temporarily rewind the node to a past transform for server-side hit testing.
+class URHO3D_API TransformHistory : public Component
+{
+    URHO3D_OBJECT(TransformHistory, Component);
+
+public:
+    /// Construct.
+    explicit TransformHistory(Context* context);
+    /// Destruct.
+    ~TransformHistory() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set number of samples kept. Older samples are overwritten. Clears the existing history.
+    void SetHistoryLength(unsigned length);
+    /// Record the current world transform with the specified scene time. Called automatically on each network update.
+    void Record(float time);
+    /// Clear the recorded history.
+    void ClearHistory();
+    /// Move the node to its interpolated transform at the specified scene time. The current transform is stored for Restore(). Does nothing if already rewound. Return true if a sample was found.
+    bool Rewind(float time);
+    /// Restore the transform stored by Rewind().
+    void Restore();
+
+    /// Return number of samples kept.
+    unsigned GetHistoryLength() const { return samples_.Size(); }
+
+    /// Return number of samples currently recorded.
+    unsigned GetNumSamples() const { return numSamples_; }
+
+    /// Return the recorded sample by index, 0 being the oldest.
+    const TransformSample& GetSample(unsigned index) const;
+    /// Return the interpolated world transform at the specified scene time. Clamps to the oldest or newest sample. Return false if no samples.
+    bool GetTransform(float time, Vector3& position, Quaternion& rotation) const;
+
+    /// Return whether is currently rewound.
+    bool IsRewound() const { return rewound_; }
+
+protected:
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
+
+private:
+    /// Apply a world transform to the node and the physics representation, if any.
+    void ApplyTransform(const Vector3& position, const Quaternion& rotation);
+    /// Handle the network update event.
+    void HandleNetworkUpdate(StringHash eventType, VariantMap& eventData);
+
+    /// Sample ring buffer.
+    PODVector<TransformSample> samples_;
+    /// Index of the next sample to write.
+    unsigned nextSample_;
+    /// Number of valid samples.
+    unsigned numSamples_;
+    /// World position before rewind.
+    Vector3 savedPosition_;
+    /// World rotation before rewind.
+    Quaternion savedRotation_;
+    /// Rewound flag.
+    bool rewound_;
+};
+
+}
@@ -25,9 +25,13 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
+#include "../IO/Deserializer.h"
 #include "../IO/Log.h"
+#include "../IO/Serializer.h"
 #include "../Math/Ray.h"
 #include "../Physics/CollisionShape.h"
 #include "../Physics/Constraint.h"
@@ -40,13 +44,17 @@
 #include "../Scene/SceneEvents.h"
 
 #include <Bullet/BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <Bullet/BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
+#include <Bullet/BulletCollision/CollisionDispatch/btManifoldResult.h>
 #include <Bullet/BulletCollision/CollisionShapes/btBoxShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
 #include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <Bullet/BulletDynamics/Dynamics/btSimulationIslandManagerMt.h>
 
 extern ContactAddedCallback gContactAddedCallback;
 
@@ -57,6 +65,8 @@ const char* PHYSICS_CATEGORY = "Physics";
 extern const char* SUBSYSTEM_CATEGORY;
 
 static const int MAX_SOLVER_ITERATIONS = 256;
+/// Percentage of broadphase pairs checked for removal per step, Bullet's default. Deterministic simulation checks all of them.
+static const int BROADPHASE_CLEANUP_PERCENT = 10;
 static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
 
 PhysicsWorldConfig PhysicsWorld::config;
@@ -66,6 +76,60 @@ static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const Physics
     return lhs.distance_ < rhs.distance_;
 }
 
+static bool CompareCollisionManifolds(const CollisionManifold& lhs, const CollisionManifold& rhs)
+{
+    if (lhs.bodyA_ != rhs.bodyA_)
+        return lhs.bodyA_ < rhs.bodyA_;
+    if (lhs.bodyB_ != rhs.bodyB_)
+        return lhs.bodyB_ < rhs.bodyB_;
+    return lhs.index_ < rhs.index_;
+}
+
+static bool CompareContactPairs(const PhysicsContactPair& lhs, const PhysicsContactPair& rhs)
+{
+    return lhs.bodyA_ != rhs.bodyA_ ? lhs.bodyA_ < rhs.bodyA_ : lhs.bodyB_ < rhs.bodyB_;
+}
+
+/// Return whether collision events are signaled for a rigid body pair.
+static bool IsCollisionEventPair(RigidBody* bodyA, RigidBody* bodyB)
+{
+    // Skip collision event signaling if both objects are static, or if collision event mode does not match
+    if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
+        !bodyA->IsActive() && !bodyB->IsActive())
+        return false;
+    return true;
+}
+
+static bool HasEventReceivers(EventReceiverGroup* group)
+{
+    return group && !group->receivers_.Empty();
+}
+
+/// Return whether an event sent by the object would have receivers.
+static bool HasEventReceivers(Context* context, Object* sender, StringHash eventType)
+{
+    return HasEventReceivers(context->GetEventReceivers(sender, eventType)) || HasEventReceivers(context->GetEventReceivers(eventType));
+}
+
+/// Write the contact points of a pair to a collision event buffer, from the perspective of body A or body B.
+static void WriteContacts(VectorBuffer& dest, const PODVector<PhysicsContactPoint>& contacts, const PhysicsContactPair& pair,
+    bool flipNormals)
+{
+    dest.Clear();
+    for (unsigned i = pair.firstContact_; i < pair.firstContact_ + pair.numContacts_; ++i)
+    {
+        const PhysicsContactPoint& contact = contacts[i];
+        dest.WriteVector3(contact.position_);
+        dest.WriteVector3(flipNormals ? -contact.normal_ : contact.normal_);
+        dest.WriteFloat(contact.distance_);
+        dest.WriteFloat(contact.impulse_);
+    }
+}
+
 void InternalPreTickCallback(btDynamicsWorld* world, btScalar timeStep)
 {
     static_cast<PhysicsWorld*>(world->getWorldUserInfo())->PreStep(timeStep);
@@ -92,57 +156,891 @@ static bool CustomMaterialCombinerCallback(btManifoldPoint& cp, const btCollisio
     cp.m_combinedRestitution =
         colObj0Wrap->getCollisionObject()->getRestitution() * colObj1Wrap->getCollisionObject()->getRestitution();
 
-    return true;
+    return true;
+}
+
+void RemoveCachedGeometryImpl(CollisionGeometryDataCache& cache, Model* model)
+{
+    for (auto i = cache.Begin(); i != cache.End();)
+    {
+        auto current = i++;
+        if (current->first_.first_ == model)
+            cache.Erase(current);
+    }
+}
+
+void CleanupGeometryCacheImpl(CollisionGeometryDataCache& cache)
+{
+    for (auto i = cache.Begin(); i != cache.End();)
+    {
+        auto current = i++;
+        if (current->second_.Refs() == 1)
+            cache.Erase(current);
+    }
+}
+
+#if BT_THREADSAFE
+/// Minimum collision pairs per work item in threaded collision dispatch.
+static const int MIN_PAIRS_PER_WORK_ITEM = 64;
+
+/// Collision dispatcher which can process the overlapping pairs on the work queue.
+class PhysicsCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+    /// Construct.
+    explicit PhysicsCollisionDispatcher(btCollisionConfiguration* collisionConfiguration) :
+        btCollisionDispatcher(collisionConfiguration)
+    {
+    }
+
+    /// Create a contact manifold. Locked while dispatching on multiple threads.
+    btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1) override
+    {
+        if (!workQueue_ && !lockManifolds_)
+            return btCollisionDispatcher::getNewManifold(b0, b1);
+
+        MutexLock lock(manifoldMutex_);
+        return btCollisionDispatcher::getNewManifold(b0, b1);
+    }
+
+    /// Release a contact manifold. Locked while dispatching on multiple threads.
+    void releaseManifold(btPersistentManifold* manifold) override
+    {
+        if (!workQueue_ && !lockManifolds_)
+        {
+            btCollisionDispatcher::releaseManifold(manifold);
+            return;
+        }
+
+        MutexLock lock(manifoldMutex_);
+        btCollisionDispatcher::releaseManifold(manifold);
+    }
+
+    /// Process all overlapping pairs.
+    void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher) override
+    {
+        int numPairs = pairCache->getNumOverlappingPairs();
+        if (!workQueue_ || numPairs < 2 * MIN_PAIRS_PER_WORK_ITEM)
+        {
+            btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+            return;
+        }
+
+        btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+        dispatchInfo_ = &dispatchInfo;
+
+        // Use several items per thread to even out the varying cost of the pairs
+        int pairsPerItem = Max(numPairs / (int)((workQueue_->GetNumThreads() + 1) * 4), MIN_PAIRS_PER_WORK_ITEM);
+        for (int start = 0; start < numPairs; start += pairsPerItem)
+        {
+            SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = DispatchPairsWork;
+            item->aux_ = this;
+            item->start_ = pairs + start;
+            item->end_ = pairs + Min(start + pairsPerItem, numPairs);
+            workQueue_->AddWorkItem(item);
+        }
+        workQueue_->Complete(M_MAX_UNSIGNED);
+    }
+
+    /// Process a range of collision pairs in a worker thread.
+    static void DispatchPairsWork(const WorkItem* item, unsigned /*threadIndex*/)
+    {
+        auto* dispatcher = reinterpret_cast<PhysicsCollisionDispatcher*>(item->aux_);
+        btNearCallback nearCallback = dispatcher->getNearCallback();
+        auto* start = reinterpret_cast<btBroadphasePair*>(item->start_);
+        auto* end = reinterpret_cast<btBroadphasePair*>(item->end_);
+
+        for (btBroadphasePair* pair = start; pair != end; ++pair)
+            nearCallback(*pair, *dispatcher, *dispatcher->dispatchInfo_);
+    }
+
+    /// Work queue to dispatch on, or null to dispatch on the calling thread.
+    WorkQueue* workQueue_{};
+    /// Lock the manifold array also outside threaded dispatch. Set while batched queries run on multiple threads.
+    bool lockManifolds_{};
+
+private:
+    /// Dispatch info during threaded dispatch.
+    const btDispatcherInfo* dispatchInfo_{};
+    /// Manifold array mutex.
+    Mutex manifoldMutex_;
+};
+
+/// Constraint solver which holds one sequential impulse solver per thread, so that simulation islands can be solved in parallel.
+class PhysicsConstraintSolverPool : public btConstraintSolver
+{
+public:
+    /// Construct with number of solvers.
+    explicit PhysicsConstraintSolverPool(unsigned numSolvers)
+    {
+        for (unsigned i = 0; i < Max(numSolvers, 1U); ++i)
+            solvers_.Push(new PooledSolver());
+    }
+
+    /// Destruct.
+    ~PhysicsConstraintSolverPool() override
+    {
+        for (unsigned i = 0; i < solvers_.Size(); ++i)
+            delete solvers_[i];
+    }
+
+    /// Prepare all solvers.
+    void prepareSolve(int numBodies, int numManifolds) override
+    {
+        for (unsigned i = 0; i < solvers_.Size(); ++i)
+            solvers_[i]->solver_.prepareSolve(numBodies, numManifolds);
+    }
+
+    /// Solve an island with the first solver not in use by another thread.
+    btScalar solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+        btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer,
+        btDispatcher* dispatcher) override
+    {
+        // Always terminates, as there is a solver for each thread that can solve islands
+        for (unsigned i = 0;; i = (i + 1) % solvers_.Size())
+        {
+            PooledSolver* entry = solvers_[i];
+            if (entry->mutex_.TryAcquire())
+            {
+                btScalar ret = entry->solver_.solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints,
+                    info, debugDrawer, dispatcher);
+                entry->mutex_.Release();
+                return ret;
+            }
+        }
+    }
+
+    /// Finish solving on all solvers.
+    void allSolved(const btContactSolverInfo& info, btIDebugDraw* debugDrawer) override
+    {
+        for (unsigned i = 0; i < solvers_.Size(); ++i)
+            solvers_[i]->solver_.allSolved(info, debugDrawer);
+    }
+
+    /// Reset all solvers.
+    void reset() override
+    {
+        for (unsigned i = 0; i < solvers_.Size(); ++i)
+            solvers_[i]->solver_.reset();
+    }
+
+    /// Return solver type.
+    btConstraintSolverType getSolverType() const override { return BT_SEQUENTIAL_IMPULSE_SOLVER; }
+
+private:
+    /// Solver with its lock.
+    struct PooledSolver
+    {
+        /// Solver.
+        btSequentialImpulseConstraintSolver solver_;
+        /// Lock held while solving.
+        Mutex mutex_;
+    };
+
+    /// Solvers.
+    PODVector<PooledSolver*> solvers_;
+};
+
+/// Island solving callback which carries the work queue of the physics world being stepped to the island dispatch function.
+class IslandDispatchCallback : public btSimulationIslandManagerMt::IslandCallback
+{
+public:
+    /// Construct.
+    IslandDispatchCallback(btSimulationIslandManagerMt::IslandCallback* callback, WorkQueue* workQueue) :
+        callback_(callback),
+        workQueue_(workQueue)
+    {
+    }
+
+    /// Solve an island with the wrapped callback.
+    void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+        btTypedConstraint** constraints, int numConstraints, int islandId) override
+    {
+        callback_->processIsland(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, islandId);
+    }
+
+    /// Wrapped callback.
+    btSimulationIslandManagerMt::IslandCallback* callback_;
+    /// Work queue to dispatch the islands on, or null to solve them on the calling thread.
+    WorkQueue* workQueue_;
+};
+
+/// Simulation islands dispatched to a work item.
+struct IslandDispatchWork
+{
+    /// Islands.
+    btAlignedObjectArray<btSimulationIslandManagerMt::Island*>* islands_;
+    /// Island solving callback.
+    btSimulationIslandManagerMt::IslandCallback* callback_;
+    /// First island index.
+    int first_;
+    /// Index step between islands.
+    int stride_;
+};
+
+static void SolveIslandsWork(const WorkItem* item, unsigned /*threadIndex*/)
+{
+    const IslandDispatchWork* work = reinterpret_cast<IslandDispatchWork*>(item->aux_);
+    btAlignedObjectArray<btSimulationIslandManagerMt::Island*>& islands = *work->islands_;
+
+    for (int i = work->first_; i < islands.size(); i += work->stride_)
+    {
+        btSimulationIslandManagerMt::Island* island = islands[i];
+        work->callback_->processIsland(&island->bodyArray[0], island->bodyArray.size(),
+            island->manifoldArray.size() ? &island->manifoldArray[0] : nullptr, island->manifoldArray.size(),
+            island->constraintArray.size() ? &island->constraintArray[0] : nullptr, island->constraintArray.size(), island->id);
+    }
+}
+
+static void ThreadedIslandDispatch(btAlignedObjectArray<btSimulationIslandManagerMt::Island*>* islands,
+    btSimulationIslandManagerMt::IslandCallback* callback)
+{
+    // The island manager always passes its dispatch callback, which also knows the work queue
+    auto* dispatchCallback = static_cast<IslandDispatchCallback*>(callback);
+    WorkQueue* queue = dispatchCallback->workQueue_;
+    callback = dispatchCallback->callback_;
+    if (!queue || islands->size() < 2)
+    {
+        btSimulationIslandManagerMt::defaultIslandDispatch(islands, callback);
+        return;
+    }
+
+    // The islands are sorted from largest to smallest, so interleaving them between the work items balances the load
+    int numItems = Min((int)queue->GetNumThreads() + 1, islands->size());
+    PODVector<IslandDispatchWork> work(numItems);
+    for (int i = 0; i < numItems; ++i)
+    {
+        work[i].islands_ = islands;
+        work[i].callback_ = callback;
+        work[i].first_ = i;
+        work[i].stride_ = numItems;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = SolveIslandsWork;
+        item->aux_ = &work[i];
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+/// Simulation island manager which can solve the islands on the work queue.
+class PhysicsIslandManager : public btSimulationIslandManagerMt
+{
+public:
+    /// Construct.
+    PhysicsIslandManager()
+    {
+        setIslandDispatchFunction(ThreadedIslandDispatch);
+    }
+
+    /// Build the simulation islands and solve them, passing the work queue to the island dispatch.
+    void buildAndProcessIslands(btDispatcher* dispatcher, btCollisionWorld* collisionWorld,
+        btAlignedObjectArray<btTypedConstraint*>& constraints, IslandCallback* callback) override
+    {
+        IslandDispatchCallback dispatchCallback(callback, workQueue_);
+        btSimulationIslandManagerMt::buildAndProcessIslands(dispatcher, collisionWorld, constraints, &dispatchCallback);
+    }
+
+    /// Work queue to solve the islands on. Only set for the duration of a threaded step.
+    WorkQueue* workQueue_{};
+};
+#endif
+
+/// Collision pair cache which can sort its pairs into proxy ID order without destroying their collision algorithms.
+class PhysicsPairCache : public btHashedOverlappingPairCache
+{
+public:
+    /// Sort the pairs and rebuild the hash table for the new pair indices.
+    void SortPairs()
+    {
+        btBroadphasePairArray& pairs = getOverlappingPairArray();
+        pairs.quickSort(ComparePairs);
+
+        int hashMask = pairs.capacity() - 1;
+        for (int i = 0; i < m_hashTable.size(); ++i)
+            m_hashTable[i] = BT_NULL_PAIR;
+        for (int i = 0; i < pairs.size(); ++i)
+        {
+            int hash = (int)(GetHash((unsigned)pairs[i].m_pProxy0->getUid(), (unsigned)pairs[i].m_pProxy1->getUid()) & hashMask);
+            m_next[i] = m_hashTable[hash];
+            m_hashTable[hash] = i;
+        }
+    }
+
+private:
+    /// Compare pairs by proxy IDs. The first proxy of a pair always has the lower ID.
+    static bool ComparePairs(const btBroadphasePair& lhs, const btBroadphasePair& rhs)
+    {
+        if (lhs.m_pProxy0->getUid() != rhs.m_pProxy0->getUid())
+            return lhs.m_pProxy0->getUid() < rhs.m_pProxy0->getUid();
+        return lhs.m_pProxy1->getUid() < rhs.m_pProxy1->getUid();
+    }
+
+    /// Hash a pair of proxy IDs. Must match the private hash function of btHashedOverlappingPairCache.
+    static unsigned GetHash(unsigned proxyId1, unsigned proxyId2)
+    {
+        int key = static_cast<int>(proxyId1 | (proxyId2 << 16));
+        key += ~(key << 15);
+        key ^= (key >> 10);
+        key += (key << 3);
+        key ^= (key >> 6);
+        key += ~(key << 11);
+        key ^= (key >> 16);
+        return static_cast<unsigned>(key);
+    }
+};
+
+#if BT_THREADSAFE
+using DynamicsWorldBase = btDiscreteDynamicsWorldMt;
+#else
+using DynamicsWorldBase = btDiscreteDynamicsWorld;
+#endif
+
+/// Dynamics world which exposes its fixed timestep accumulator for state snapshots, and can keep the collision pairs and
+/// contact manifolds in a deterministic order.
+class PhysicsDynamicsWorld : public DynamicsWorldBase
+{
+public:
+    /// Construct.
+    PhysicsDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver,
+        btCollisionConfiguration* collisionConfiguration) :
+        DynamicsWorldBase(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+    {
+#if BT_THREADSAFE
+        // Replace the island manager created by the base class with one that can use the work queue
+        m_islandManager->~btSimulationIslandManager();
+        btAlignedFree(m_islandManager);
+        void* mem = btAlignedAlloc(sizeof(PhysicsIslandManager), 16);
+        auto* islandManager = new(mem) PhysicsIslandManager();
+        islandManager->setMinimumSolverBatchSize(m_solverInfo.m_minimumSolverBatchSize);
+        m_islandManager = islandManager;
+#endif
+    }
+
+#if BT_THREADSAFE
+    /// Return the island manager.
+    PhysicsIslandManager* GetIslandManager() const { return static_cast<PhysicsIslandManager*>(m_islandManager); }
+#endif
+
+    /// Set time accumulated towards the next fixed step.
+    void SetLocalTime(btScalar localTime) { m_localTime = localTime; }
+    /// Set fixed timestep of the last step.
+    void SetFixedTimeStep(btScalar fixedTimeStep) { m_fixedTimeStep = fixedTimeStep; }
+    /// Return time accumulated towards the next fixed step.
+    btScalar GetLocalTime() const { return m_localTime; }
+    /// Return fixed timestep of the last step.
+    btScalar GetFixedTimeStep() const { return m_fixedTimeStep; }
+
+    /// Update the broadphase and process the collision pairs. When deterministic, the pairs are processed and the contact
+    /// manifolds kept in proxy ID order, so that island solving depends neither on the broadphase tree nor on thread timing.
+    void performDiscreteCollisionDetection() override
+    {
+        if (!deterministic_)
+        {
+            DynamicsWorldBase::performDiscreteCollisionDetection();
+            return;
+        }
+
+        updateAabbs();
+        computeOverlappingPairs();
+        static_cast<PhysicsPairCache*>(m_broadphasePairCache->getOverlappingPairCache())->SortPairs();
+        m_dispatcher1->dispatchAllCollisionPairs(m_broadphasePairCache->getOverlappingPairCache(), getDispatchInfo(), m_dispatcher1);
+        SortManifolds();
+    }
+
+    /// Rebuild the contact manifold array in collision pair order.
+    void SortManifolds()
+    {
+        int numManifolds = m_dispatcher1->getNumManifolds();
+        if (!numManifolds)
+            return;
+
+        btPersistentManifold** manifolds = m_dispatcher1->getInternalManifoldPointer();
+        previousManifolds_.resizeNoInitialize(0);
+        for (int i = 0; i < numManifolds; ++i)
+        {
+            previousManifolds_.push_back(manifolds[i]);
+            manifolds[i]->m_index1a = -1;
+        }
+
+        int count = 0;
+        btBroadphasePairArray& pairs = m_broadphasePairCache->getOverlappingPairCache()->getOverlappingPairArray();
+        for (int i = 0; i < pairs.size(); ++i)
+        {
+            if (!pairs[i].m_algorithm)
+                continue;
+
+            pairManifolds_.resizeNoInitialize(0);
+            pairs[i].m_algorithm->getAllContactManifolds(pairManifolds_);
+            for (int j = 0; j < pairManifolds_.size(); ++j)
+            {
+                btPersistentManifold* manifold = pairManifolds_[j];
+                if (manifold->m_index1a < 0)
+                {
+                    manifold->m_index1a = count;
+                    manifolds[count++] = manifold;
+                }
+            }
+        }
+
+        // Manifolds not listed by any pair keep their relative order at the end
+        for (int i = 0; i < numManifolds; ++i)
+        {
+            btPersistentManifold* manifold = previousManifolds_[i];
+            if (manifold->m_index1a < 0)
+            {
+                manifold->m_index1a = count;
+                manifolds[count++] = manifold;
+            }
+        }
+    }
+
+    /// Deterministic pair and manifold order flag.
+    bool deterministic_{true};
+
+private:
+    /// Manifold array before sorting.
+    btManifoldArray previousManifolds_;
+    /// Manifolds of one collision pair.
+    btManifoldArray pairManifolds_;
+};
+
+/// Physics snapshot file identifier.
+static const char* PHYSICS_SNAPSHOT_ID = "UPSN";
+
+static void WriteBtVector3(Serializer& dest, const btVector3& vector)
+{
+    dest.WriteFloat(vector.x());
+    dest.WriteFloat(vector.y());
+    dest.WriteFloat(vector.z());
+}
+
+static btVector3 ReadBtVector3(Deserializer& source)
+{
+    float x = source.ReadFloat();
+    float y = source.ReadFloat();
+    float z = source.ReadFloat();
+    return btVector3(x, y, z);
+}
+
+/// Write a transform with the full basis, as converting through a quaternion would not restore it exactly.
+static void WriteBtTransform(Serializer& dest, const btTransform& transform)
+{
+    const btMatrix3x3& basis = transform.getBasis();
+    for (int i = 0; i < 3; ++i)
+        WriteBtVector3(dest, basis[i]);
+    WriteBtVector3(dest, transform.getOrigin());
+}
+
+static btTransform ReadBtTransform(Deserializer& source)
+{
+    btVector3 row0 = ReadBtVector3(source);
+    btVector3 row1 = ReadBtVector3(source);
+    btVector3 row2 = ReadBtVector3(source);
+    btVector3 origin = ReadBtVector3(source);
+    return btTransform(btMatrix3x3(row0.x(), row0.y(), row0.z(), row1.x(), row1.y(), row1.z(), row2.x(), row2.y(), row2.z()),
+        origin);
+}
+
+static void WriteManifoldPoint(Serializer& dest, const btManifoldPoint& point)
+{
+    WriteBtVector3(dest, point.m_localPointA);
+    WriteBtVector3(dest, point.m_localPointB);
+    WriteBtVector3(dest, point.m_positionWorldOnB);
+    WriteBtVector3(dest, point.m_positionWorldOnA);
+    WriteBtVector3(dest, point.m_normalWorldOnB);
+    WriteBtVector3(dest, point.m_lateralFrictionDir1);
+    WriteBtVector3(dest, point.m_lateralFrictionDir2);
+    dest.WriteFloat(point.m_distance1);
+    dest.WriteFloat(point.m_combinedFriction);
+    dest.WriteFloat(point.m_combinedRollingFriction);
+    dest.WriteFloat(point.m_combinedSpinningFriction);
+    dest.WriteFloat(point.m_combinedRestitution);
+    dest.WriteInt(point.m_partId0);
+    dest.WriteInt(point.m_partId1);
+    dest.WriteInt(point.m_index0);
+    dest.WriteInt(point.m_index1);
+    dest.WriteInt(point.m_contactPointFlags);
+    dest.WriteFloat(point.m_appliedImpulse);
+    dest.WriteFloat(point.m_appliedImpulseLateral1);
+    dest.WriteFloat(point.m_appliedImpulseLateral2);
+    dest.WriteFloat(point.m_contactMotion1);
+    dest.WriteFloat(point.m_contactMotion2);
+    dest.WriteFloat(point.m_contactCFM);
+    dest.WriteFloat(point.m_contactERP);
+    dest.WriteFloat(point.m_frictionCFM);
+    dest.WriteInt(point.m_lifeTime);
+}
+
+static void ReadManifoldPoint(Deserializer& source, btManifoldPoint& point)
+{
+    point.m_localPointA = ReadBtVector3(source);
+    point.m_localPointB = ReadBtVector3(source);
+    point.m_positionWorldOnB = ReadBtVector3(source);
+    point.m_positionWorldOnA = ReadBtVector3(source);
+    point.m_normalWorldOnB = ReadBtVector3(source);
+    point.m_lateralFrictionDir1 = ReadBtVector3(source);
+    point.m_lateralFrictionDir2 = ReadBtVector3(source);
+    point.m_distance1 = source.ReadFloat();
+    point.m_combinedFriction = source.ReadFloat();
+    point.m_combinedRollingFriction = source.ReadFloat();
+    point.m_combinedSpinningFriction = source.ReadFloat();
+    point.m_combinedRestitution = source.ReadFloat();
+    point.m_partId0 = source.ReadInt();
+    point.m_partId1 = source.ReadInt();
+    point.m_index0 = source.ReadInt();
+    point.m_index1 = source.ReadInt();
+    point.m_contactPointFlags = source.ReadInt();
+    point.m_appliedImpulse = source.ReadFloat();
+    point.m_appliedImpulseLateral1 = source.ReadFloat();
+    point.m_appliedImpulseLateral2 = source.ReadFloat();
+    point.m_contactMotion1 = source.ReadFloat();
+    point.m_contactMotion2 = source.ReadFloat();
+    point.m_contactCFM = source.ReadFloat();
+    point.m_contactERP = source.ReadFloat();
+    point.m_frictionCFM = source.ReadFloat();
+    point.m_lifeTime = source.ReadInt();
+    point.m_userPersistentData = nullptr;
+}
+
+/// Contact manifold read from a physics snapshot.
+struct SnapshotManifold
+{
+    /// First body.
+    btRigidBody* bodyA_{};
+    /// Second body.
+    btRigidBody* bodyB_{};
+    /// Collision pair of the bodies.
+    btBroadphasePair* pair_{};
+    /// Number of contact points.
+    unsigned numContacts_{};
+    /// Contact points.
+    btManifoldPoint points_[MANIFOLD_CACHE_SIZE];
+};
+
+/// Return the rigid body component of a broadphase proxy, or null if the collision object does not belong to one.
+static RigidBody* GetProxyRigidBody(const btBroadphaseProxy* proxy)
+{
+    return static_cast<RigidBody*>(static_cast<btCollisionObject*>(proxy->m_clientObject)->getUserPointer());
+}
+
+/// Return the Bullet rigid body of a rigid body component by ID, or null if not found.
+static btRigidBody* GetBtRigidBody(Scene* scene, unsigned id)
+{
+    Component* component = scene->GetComponent(id);
+    return component && component->GetType() == RigidBody::GetTypeStatic() ? static_cast<RigidBody*>(component)->GetBody() : nullptr;
+}
+
+/// Return a pair of broadphase proxies with the lower proxy ID first, as stored in the pair cache.
+static Pair<btBroadphaseProxy*, btBroadphaseProxy*> MakeProxyPair(btBroadphaseProxy* proxyA, btBroadphaseProxy* proxyB)
+{
+    if (proxyA->getUid() > proxyB->getUid())
+        Swap(proxyA, proxyB);
+    return MakePair(proxyA, proxyB);
+}
+
+/// Move a broadphase proxy to a stage with a leaf volume, and to the tree of that stage. The structure of the tree can differ
+/// from the one the state was saved from, which only changes the order the new pairs are found in.
+static void RestoreBroadphaseProxy(btDbvtBroadphase* broadphase, btDbvtProxy* proxy, const btVector3& aabbMin,
+    const btVector3& aabbMax, btDbvtVolume volume, int stage)
+{
+    int oldSet = proxy->stage == btDbvtBroadphase::STAGECOUNT ? btDbvtBroadphase::FIXED_SET : btDbvtBroadphase::DYNAMIC_SET;
+    int newSet = stage == btDbvtBroadphase::STAGECOUNT ? btDbvtBroadphase::FIXED_SET : btDbvtBroadphase::DYNAMIC_SET;
+    if (oldSet == newSet)
+        broadphase->m_sets[newSet].update(proxy->leaf, volume);
+    else
+    {
+        broadphase->m_sets[oldSet].remove(proxy->leaf);
+        proxy->leaf = broadphase->m_sets[newSet].insert(volume, proxy);
+    }
+
+    // Unlink from the old stage list and link to the front of the new one
+    btDbvtProxy*& oldList = broadphase->m_stageRoots[proxy->stage];
+    if (proxy->links[0])
+        proxy->links[0]->links[1] = proxy->links[1];
+    else
+        oldList = proxy->links[1];
+    if (proxy->links[1])
+        proxy->links[1]->links[0] = proxy->links[0];
+
+    btDbvtProxy*& newList = broadphase->m_stageRoots[stage];
+    proxy->links[0] = nullptr;
+    proxy->links[1] = newList;
+    if (newList)
+        newList->links[0] = proxy;
+    newList = proxy;
+
+    proxy->stage = stage;
+    proxy->m_aabbMin = aabbMin;
+    proxy->m_aabbMax = aabbMax;
+}
+
+/// Create the collision algorithm of a pair and let it create its contact manifolds, as the dispatcher does when it first
+/// processes the pair. Also done for sleeping bodies, whose manifolds persist.
+static void CreateCollisionAlgorithm(btBroadphasePair& pair, btDispatcher* dispatcher, const btDispatcherInfo& dispatchInfo)
+{
+    auto* objectA = static_cast<btCollisionObject*>(pair.m_pProxy0->m_clientObject);
+    auto* objectB = static_cast<btCollisionObject*>(pair.m_pProxy1->m_clientObject);
+    btCollisionObjectWrapper wrapperA(nullptr, objectA->getCollisionShape(), objectA, objectA->getWorldTransform(), -1, -1);
+    btCollisionObjectWrapper wrapperB(nullptr, objectB->getCollisionShape(), objectB, objectB->getWorldTransform(), -1, -1);
+
+    pair.m_algorithm = dispatcher->findAlgorithm(&wrapperA, &wrapperB, nullptr, BT_CONTACT_POINT_ALGORITHMS);
+    if (pair.m_algorithm)
+    {
+        btManifoldResult result(&wrapperA, &wrapperB);
+        pair.m_algorithm->processCollision(&wrapperA, &wrapperB, dispatchInfo, &result);
+    }
+}
+
+static unsigned HashBtVector3(unsigned hash, const btVector3& vector)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        float value = vector[i];
+        auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (unsigned j = 0; j < sizeof(float); ++j)
+            hash = SDBMHash(hash, bytes[j]);
+    }
+    return hash;
+}
+
+/// Callback for physics world queries.
+struct PhysicsQueryCallback : public btCollisionWorld::ContactResultCallback
+{
+    /// Construct.
+    PhysicsQueryCallback(PODVector<RigidBody*>& result, unsigned collisionMask) :
+        result_(result),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Add a contact result.
+    btScalar addSingleResult(btManifoldPoint&, const btCollisionObjectWrapper* colObj0Wrap, int, int,
+        const btCollisionObjectWrapper* colObj1Wrap, int, int) override
+    {
+        auto* body = reinterpret_cast<RigidBody*>(colObj0Wrap->getCollisionObject()->getUserPointer());
+        if (body && !result_.Contains(body) && (body->GetCollisionLayer() & collisionMask_))
+            result_.Push(body);
+        body = reinterpret_cast<RigidBody*>(colObj1Wrap->getCollisionObject()->getUserPointer());
+        if (body && !result_.Contains(body) && (body->GetCollisionLayer() & collisionMask_))
+            result_.Push(body);
+        return 0.0f;
+    }
+
+    /// Found rigid bodies.
+    PODVector<RigidBody*>& result_;
+    /// Collision mask for the query.
+    unsigned collisionMask_;
+};
+
+/// Minimum batched queries per work item.
+static const unsigned MIN_QUERIES_PER_WORK_ITEM = 32;
+
+/// Closest-hit convex sweep callback which ignores one collision object.
+struct PhysicsConvexCastCallback : public btCollisionWorld::ClosestConvexResultCallback
+{
+    /// Construct.
+    PhysicsConvexCastCallback(const btVector3& convexFromWorld, const btVector3& convexToWorld, const btCollisionObject* ignoredObject) :
+        btCollisionWorld::ClosestConvexResultCallback(convexFromWorld, convexToWorld),
+        ignoredObject_(ignoredObject)
+    {
+    }
+
+    /// Return whether a broadphase proxy should be tested.
+    bool needsCollision(btBroadphaseProxy* proxy0) const override
+    {
+        return proxy0->m_clientObject != ignoredObject_ && btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0);
+    }
+
+    /// Collision object to ignore.
+    const btCollisionObject* ignoredObject_;
+};
+
+/// Convex cast with the collision shape's offset and rigid body resolved on the main thread.
+struct ResolvedConvexCast
+{
+    /// Convex shape, or null if invalid.
+    btConvexShape* shape_;
+    /// Effective start position.
+    Vector3 startPos_;
+    /// Effective start rotation.
+    Quaternion startRot_;
+    /// Effective end position.
+    Vector3 endPos_;
+    /// Effective end rotation.
+    Quaternion endRot_;
+    /// Collision object of the shape's rigid body.
+    const btCollisionObject* ignoredObject_;
+    /// Collision mask.
+    unsigned collisionMask_;
+};
+
+/// Batched queries shared by the work items.
+template <class Query, class Result> struct BatchQueryContext
+{
+    /// Collision world.
+    btCollisionWorld* world_;
+    /// First query.
+    const Query* queries_;
+    /// First result.
+    Result* results_;
+};
+
+static void ResetRaycastResult(PhysicsRaycastResult& result)
+{
+    result.body_ = nullptr;
+    result.position_ = Vector3::ZERO;
+    result.normal_ = Vector3::ZERO;
+    result.distance_ = M_INFINITY;
+    result.hitFraction_ = 0.0f;
+}
+
+static void SetConvexCastResult(PhysicsRaycastResult& result, const btCollisionWorld::ClosestConvexResultCallback& callback,
+    float length)
+{
+    if (callback.hasHit())
+    {
+        result.body_ = static_cast<RigidBody*>(callback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(callback.m_hitPointWorld);
+        result.normal_ = ToVector3(callback.m_hitNormalWorld);
+        result.distance_ = callback.m_closestHitFraction * length;
+        result.hitFraction_ = callback.m_closestHitFraction;
+    }
+    else
+        ResetRaycastResult(result);
+}
+
+static void BatchRaycast(btCollisionWorld* world, PhysicsRaycastResult& result, const PhysicsRaycastQuery& query)
+{
+    const Ray& ray = query.ray_;
+    Vector3 endPos = ray.origin_ + query.maxDistance_ * ray.direction_;
+    btVector3 from = ToBtVector3(ray.origin_);
+    btVector3 to = ToBtVector3(endPos);
+
+    if (query.radius_ > 0.0f)
+    {
+        btSphereShape shape(query.radius_);
+        btCollisionWorld::ClosestConvexResultCallback convexCallback(from, to);
+        convexCallback.m_collisionFilterGroup = (short)0xffff;
+        convexCallback.m_collisionFilterMask = (short)query.collisionMask_;
+
+        world->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), from), btTransform(btQuaternion::getIdentity(), to),
+            convexCallback);
+        SetConvexCastResult(result, convexCallback, (endPos - ray.origin_).Length());
+        return;
+    }
+
+    btCollisionWorld::ClosestRayResultCallback rayCallback(from, to);
+    rayCallback.m_collisionFilterGroup = (short)0xffff;
+    rayCallback.m_collisionFilterMask = (short)query.collisionMask_;
+
+    world->rayTest(from, to, rayCallback);
+
+    if (rayCallback.hasHit())
+    {
+        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
+        result.distance_ = (result.position_ - ray.origin_).Length();
+        result.hitFraction_ = rayCallback.m_closestHitFraction;
+        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
+    }
+    else
+        ResetRaycastResult(result);
+}
+
+static void BatchConvexCast(btCollisionWorld* world, PhysicsRaycastResult& result, const ResolvedConvexCast& cast)
+{
+    if (!cast.shape_)
+    {
+        ResetRaycastResult(result);
+        return;
+    }
+
+    PhysicsConvexCastCallback convexCallback(ToBtVector3(cast.startPos_), ToBtVector3(cast.endPos_), cast.ignoredObject_);
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = (short)cast.collisionMask_;
+
+    world->convexSweepTest(cast.shape_, btTransform(ToBtQuaternion(cast.startRot_), convexCallback.m_convexFromWorld),
+        btTransform(ToBtQuaternion(cast.endRot_), convexCallback.m_convexToWorld), convexCallback);
+    SetConvexCastResult(result, convexCallback, (cast.endPos_ - cast.startPos_).Length());
 }
 
-void RemoveCachedGeometryImpl(CollisionGeometryDataCache& cache, Model* model)
+static void BatchOverlap(btCollisionWorld* world, PODVector<RigidBody*>& result, const PhysicsOverlapQuery& query)
 {
-    for (auto i = cache.Begin(); i != cache.End();)
+    result.Clear();
+
+    // Test with a collision object which is not added to the world, so that the world is not modified
+    btCollisionObject object;
+    PhysicsQueryCallback callback(result, query.collisionMask_);
+
+    if (query.box_.Defined())
     {
-        auto current = i++;
-        if (current->first_.first_ == model)
-            cache.Erase(current);
+        btBoxShape boxShape(ToBtVector3(query.box_.HalfSize()));
+        object.setCollisionShape(&boxShape);
+        object.setWorldTransform(btTransform(btQuaternion::getIdentity(), ToBtVector3(query.box_.Center())));
+        world->contactTest(&object, callback);
+    }
+    else if (query.sphere_.Defined())
+    {
+        btSphereShape sphereShape(query.sphere_.radius_);
+        object.setCollisionShape(&sphereShape);
+        object.setWorldTransform(btTransform(btQuaternion::getIdentity(), ToBtVector3(query.sphere_.center_)));
+        world->contactTest(&object, callback);
     }
 }
 
-void CleanupGeometryCacheImpl(CollisionGeometryDataCache& cache)
+template <class Query, class Result, void (*Function)(btCollisionWorld*, Result&, const Query&)>
+static void BatchQueryWork(const WorkItem* item, unsigned /*threadIndex*/)
 {
-    for (auto i = cache.Begin(); i != cache.End();)
-    {
-        auto current = i++;
-        if (current->second_.Refs() == 1)
-            cache.Erase(current);
-    }
+    auto* context = reinterpret_cast<BatchQueryContext<Query, Result>*>(item->aux_);
+    auto* start = reinterpret_cast<const Query*>(item->start_);
+    auto* end = reinterpret_cast<const Query*>(item->end_);
+
+    for (const Query* query = start; query != end; ++query)
+        Function(context->world_, context->results_[query - context->queries_], *query);
 }
 
-/// Callback for physics world queries.
-struct PhysicsQueryCallback : public btCollisionWorld::ContactResultCallback
+/// Run batched queries, split into work items if a work queue is given.
+template <class Query, class Result, void (*Function)(btCollisionWorld*, Result&, const Query&)>
+static void RunBatchQueries(WorkQueue* queue, btCollisionWorld* world, Result* results, const Query* queries, unsigned numQueries)
 {
-    /// Construct.
-    PhysicsQueryCallback(PODVector<RigidBody*>& result, unsigned collisionMask) :
-        result_(result),
-        collisionMask_(collisionMask)
+    if (!queue || numQueries < 2 * MIN_QUERIES_PER_WORK_ITEM)
     {
+        for (unsigned i = 0; i < numQueries; ++i)
+            Function(world, results[i], queries[i]);
+        return;
     }
 
-    /// Add a contact result.
-    btScalar addSingleResult(btManifoldPoint&, const btCollisionObjectWrapper* colObj0Wrap, int, int,
-        const btCollisionObjectWrapper* colObj1Wrap, int, int) override
+    BatchQueryContext<Query, Result> context;
+    context.world_ = world;
+    context.queries_ = queries;
+    context.results_ = results;
+
+    unsigned queriesPerItem = Max(numQueries / ((queue->GetNumThreads() + 1) * 4), MIN_QUERIES_PER_WORK_ITEM);
+    for (unsigned start = 0; start < numQueries; start += queriesPerItem)
     {
-        auto* body = reinterpret_cast<RigidBody*>(colObj0Wrap->getCollisionObject()->getUserPointer());
-        if (body && !result_.Contains(body) && (body->GetCollisionLayer() & collisionMask_))
-            result_.Push(body);
-        body = reinterpret_cast<RigidBody*>(colObj1Wrap->getCollisionObject()->getUserPointer());
-        if (body && !result_.Contains(body) && (body->GetCollisionLayer() & collisionMask_))
-            result_.Push(body);
-        return 0.0f;
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = BatchQueryWork<Query, Result, Function>;
+        item->aux_ = &context;
+        item->start_ = const_cast<Query*>(queries + start);
+        item->end_ = const_cast<Query*>(queries + Min(start + queriesPerItem, numQueries));
+        queue->AddWorkItem(item);
     }
+    queue->Complete(M_MAX_UNSIGNED);
+}
 
-    /// Found rigid bodies.
-    PODVector<RigidBody*>& result_;
-    /// Collision mask for the query.
-    unsigned collisionMask_;
-};
+/// Create the broadphase with a pair cache that can be sorted. The broadphase releases the pair cache.
+static btDbvtBroadphase* CreateBroadphase()
+{
+    void* mem = btAlignedAlloc(sizeof(PhysicsPairCache), 16);
+    auto* broadphase = new btDbvtBroadphase(new(mem) PhysicsPairCache());
+    broadphase->m_releasepaircache = true;
+    return broadphase;
+}
 
 PhysicsWorld::PhysicsWorld(Context* context) :
     Component(context),
@@ -156,12 +1054,24 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     else
         collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
+#if BT_THREADSAFE
+    // Use the multithreading-capable dispatcher, solver and world. They behave as the single-threaded ones until threaded
+    // simulation is enabled
+    auto* queue = GetSubsystem<WorkQueue>();
+    collisionDispatcher_ = new PhysicsCollisionDispatcher(collisionConfiguration_);
+    btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.Get()));
+
+    broadphase_ = CreateBroadphase();
+    solver_ = new PhysicsConstraintSolverPool(queue ? queue->GetNumThreads() + 1 : 1);
+    world_ = new PhysicsDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+#else
     collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
     btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.Get()));
 
-    broadphase_ = new btDbvtBroadphase();
+    broadphase_ = CreateBroadphase();
     solver_ = new btSequentialImpulseConstraintSolver();
-    world_ = new btDiscreteDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+    world_ = new PhysicsDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+#endif
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
@@ -170,6 +1080,7 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     world_->setInternalTickCallback(InternalPreTickCallback, static_cast<void*>(this), true);
     world_->setInternalTickCallback(InternalTickCallback, static_cast<void*>(this), false);
     world_->setSynchronizeAllMotionStates(true);
+    SetDeterministic(deterministic_);
 }
 
 PhysicsWorld::~PhysicsWorld()
@@ -210,6 +1121,8 @@ void PhysicsWorld::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Interpolation", bool, interpolation_, true, AM_FILE);
     URHO3D_ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Threaded Simulation", GetThreadedSimulation, SetThreadedSimulation, bool, false, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Deterministic", GetDeterministic, SetDeterministic, bool, true, AM_FILE);
 }
 
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
@@ -270,6 +1183,17 @@ void PhysicsWorld::Update(float timeStep)
     delayedWorldTransforms_.Clear();
     simulating_ = true;
 
+    HiresTimer updateTimer;
+
+#if BT_THREADSAFE
+    // Dispatch to the work queue only for the duration of the step, and only when it has threads
+    auto* queue = threadedSimulation_ ? GetSubsystem<WorkQueue>() : nullptr;
+    if (queue && !queue->GetNumThreads())
+        queue = nullptr;
+    static_cast<PhysicsCollisionDispatcher*>(collisionDispatcher_.Get())->workQueue_ = queue;
+    static_cast<PhysicsDynamicsWorld*>(world_.Get())->GetIslandManager()->workQueue_ = queue;
+#endif
+
     if (interpolation_)
         world_->stepSimulation(timeStep, maxSubSteps, internalTimeStep);
     else
@@ -283,8 +1207,19 @@ void PhysicsWorld::Update(float timeStep)
         }
     }
 
+#if BT_THREADSAFE
+    static_cast<PhysicsCollisionDispatcher*>(collisionDispatcher_.Get())->workQueue_ = nullptr;
+    static_cast<PhysicsDynamicsWorld*>(world_.Get())->GetIslandManager()->workQueue_ = nullptr;
+#endif
+
+    updateTime_ = updateTimer.GetUSec(false);
     simulating_ = false;
 
+    ApplyDelayedWorldTransforms();
+}
+
+void PhysicsWorld::ApplyDelayedWorldTransforms()
+{
     // Apply delayed (parented) world transforms now
     while (!delayedWorldTransforms_.Empty())
     {
@@ -310,6 +1245,340 @@ void PhysicsWorld::UpdateCollisions()
     world_->performDiscreteCollisionDetection();
 }
 
+bool PhysicsWorld::SaveSnapshot(Serializer& dest) const
+{
+    URHO3D_PROFILE(SavePhysicsSnapshot);
+
+    // Write to a buffer first so that the destination receives the snapshot with a single write
+    VectorBuffer buffer;
+    auto* world = static_cast<PhysicsDynamicsWorld*>(world_.Get());
+    auto* broadphase = static_cast<btDbvtBroadphase*>(broadphase_.Get());
+    buffer.WriteFileID(PHYSICS_SNAPSHOT_ID);
+    buffer.WriteFloat(timeAcc_);
+    buffer.WriteFloat(world->GetLocalTime());
+    buffer.WriteFloat(world->GetFixedTimeStep());
+
+    // The broadphase stage decides when moved proxies go to the fixed tree, which shrinks their volume to the exact bounds
+    buffer.WriteUByte((unsigned char)broadphase->m_stageCurrent);
+    buffer.WriteInt(broadphase->m_cid);
+    buffer.WriteBool(broadphase->m_needcleanup);
+
+    buffer.WriteVLE(rigidBodies_.Size());
+    for (PODVector<RigidBody*>::ConstIterator i = rigidBodies_.Begin(); i != rigidBodies_.End(); ++i)
+    {
+        btRigidBody* body = (*i)->GetBody();
+        buffer.WriteUInt((*i)->GetID());
+        buffer.WriteBool(body != nullptr);
+        if (!body)
+            continue;
+
+        WriteBtTransform(buffer, body->getWorldTransform());
+        WriteBtTransform(buffer, body->getInterpolationWorldTransform());
+        WriteBtVector3(buffer, body->getLinearVelocity());
+        WriteBtVector3(buffer, body->getAngularVelocity());
+        WriteBtVector3(buffer, body->getInterpolationLinearVelocity());
+        WriteBtVector3(buffer, body->getInterpolationAngularVelocity());
+        WriteBtVector3(buffer, body->getTotalForce());
+        WriteBtVector3(buffer, body->getTotalTorque());
+        buffer.WriteUByte((unsigned char)body->getActivationState());
+        buffer.WriteFloat(body->getDeactivationTime());
+        buffer.WriteFloat(body->getHitFraction());
+
+        // The leaf volume is enlarged for motion and only updated once the body leaves it, so it decides which pairs exist
+        auto* proxy = static_cast<btDbvtProxy*>(body->getBroadphaseHandle());
+        buffer.WriteBool(proxy != nullptr);
+        if (!proxy)
+            continue;
+
+        WriteBtVector3(buffer, proxy->m_aabbMin);
+        WriteBtVector3(buffer, proxy->m_aabbMax);
+        WriteBtVector3(buffer, proxy->leaf->volume.Mins());
+        WriteBtVector3(buffer, proxy->leaf->volume.Maxs());
+        buffer.WriteUByte((unsigned char)proxy->stage);
+    }
+
+    // Broadphase pairs between rigid bodies in pair array order. They hold the collision algorithms and outlive the overlap of
+    // the bodies until the broadphase cleans them up
+    const btBroadphasePairArray& pairs = broadphase->getOverlappingPairCache()->getOverlappingPairArray();
+    unsigned numSavedPairs = 0;
+    for (int i = 0; i < pairs.size(); ++i)
+    {
+        if (GetProxyRigidBody(pairs[i].m_pProxy0) && GetProxyRigidBody(pairs[i].m_pProxy1))
+            ++numSavedPairs;
+    }
+
+    buffer.WriteVLE(numSavedPairs);
+    for (int i = 0; i < pairs.size(); ++i)
+    {
+        RigidBody* bodyA = GetProxyRigidBody(pairs[i].m_pProxy0);
+        RigidBody* bodyB = GetProxyRigidBody(pairs[i].m_pProxy1);
+        if (!bodyA || !bodyB)
+            continue;
+
+        buffer.WriteUInt(bodyA->GetID());
+        buffer.WriteUInt(bodyB->GetID());
+    }
+
+    // Contact manifolds hold the impulses used to warm start the solver on the next step. Empty manifolds are saved too, as
+    // a collision algorithm may own several and they are matched in the order the algorithm lists them
+    int numManifolds = collisionDispatcher_->getNumManifolds();
+    unsigned numSavedManifolds = 0;
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        const btPersistentManifold* manifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        if (manifold->getBody0()->getUserPointer() && manifold->getBody1()->getUserPointer())
+            ++numSavedManifolds;
+    }
+
+    buffer.WriteVLE(numSavedManifolds);
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        const btPersistentManifold* manifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        auto* bodyA = static_cast<RigidBody*>(manifold->getBody0()->getUserPointer());
+        auto* bodyB = static_cast<RigidBody*>(manifold->getBody1()->getUserPointer());
+        if (!bodyA || !bodyB)
+            continue;
+
+        buffer.WriteUInt(bodyA->GetID());
+        buffer.WriteUInt(bodyB->GetID());
+        buffer.WriteUByte((unsigned char)manifold->getNumContacts());
+        for (int j = 0; j < manifold->getNumContacts(); ++j)
+            WriteManifoldPoint(buffer, manifold->getContactPoint(j));
+    }
+
+    // Joint rows are not warm started by the solver, but the applied impulse is kept for feedback and breaking, which can
+    // also disable the constraint
+    buffer.WriteVLE(constraints_.Size());
+    for (PODVector<Constraint*>::ConstIterator i = constraints_.Begin(); i != constraints_.End(); ++i)
+    {
+        btTypedConstraint* constraint = (*i)->GetConstraint();
+        buffer.WriteUInt((*i)->GetID());
+        buffer.WriteBool(constraint != nullptr);
+        if (!constraint)
+            continue;
+
+        buffer.WriteBool(constraint->isEnabled());
+        buffer.WriteFloat(constraint->internalGetAppliedImpulse());
+    }
+
+    return dest.Write(buffer.GetData(), buffer.GetSize()) == buffer.GetSize();
+}
+
+bool PhysicsWorld::RestoreSnapshot(Deserializer& source)
+{
+    URHO3D_PROFILE(RestorePhysicsSnapshot);
+
+    Scene* scene = GetScene();
+    if (!scene)
+    {
+        URHO3D_LOGERROR("Physics world not in a scene, can not restore snapshot");
+        return false;
+    }
+    if (source.ReadFileID() != PHYSICS_SNAPSHOT_ID)
+    {
+        URHO3D_LOGERROR("Invalid physics snapshot");
+        return false;
+    }
+
+    auto* world = static_cast<PhysicsDynamicsWorld*>(world_.Get());
+    auto* broadphase = static_cast<btDbvtBroadphase*>(broadphase_.Get());
+    btOverlappingPairCache* pairCache = broadphase->getOverlappingPairCache();
+    timeAcc_ = source.ReadFloat();
+    world->SetLocalTime(source.ReadFloat());
+    world->SetFixedTimeStep(source.ReadFloat());
+    broadphase->m_stageCurrent = Min((int)source.ReadUByte(), (int)btDbvtBroadphase::STAGECOUNT - 1);
+    broadphase->m_cid = source.ReadInt();
+    broadphase->m_needcleanup = source.ReadBool();
+
+    // The bodies stay in the world, so that they keep their order in the collision object array and their proxy IDs, which
+    // order the collision pairs
+    unsigned numBodies = source.ReadVLE();
+    for (unsigned i = 0; i < numBodies; ++i)
+    {
+        btRigidBody* body = GetBtRigidBody(scene, source.ReadUInt());
+        if (!source.ReadBool())
+            continue;
+
+        btTransform worldTransform = ReadBtTransform(source);
+        btTransform interpolationWorldTransform = ReadBtTransform(source);
+        btVector3 linearVelocity = ReadBtVector3(source);
+        btVector3 angularVelocity = ReadBtVector3(source);
+        btVector3 interpolationLinearVelocity = ReadBtVector3(source);
+        btVector3 interpolationAngularVelocity = ReadBtVector3(source);
+        btVector3 totalForce = ReadBtVector3(source);
+        btVector3 totalTorque = ReadBtVector3(source);
+        int activationState = source.ReadUByte();
+        float deactivationTime = source.ReadFloat();
+        float hitFraction = source.ReadFloat();
+
+        bool hasProxy = source.ReadBool();
+        btVector3 aabbMin, aabbMax, leafMin, leafMax;
+        int stage = 0;
+        if (hasProxy)
+        {
+            aabbMin = ReadBtVector3(source);
+            aabbMax = ReadBtVector3(source);
+            leafMin = ReadBtVector3(source);
+            leafMax = ReadBtVector3(source);
+            stage = Min((int)source.ReadUByte(), (int)btDbvtBroadphase::STAGECOUNT);
+        }
+
+        // Bodies created after the snapshot was saved keep their current state
+        if (!body)
+            continue;
+
+        body->setWorldTransform(worldTransform);
+        body->setInterpolationWorldTransform(interpolationWorldTransform);
+        body->setLinearVelocity(linearVelocity);
+        body->setAngularVelocity(angularVelocity);
+        body->setInterpolationLinearVelocity(interpolationLinearVelocity);
+        body->setInterpolationAngularVelocity(interpolationAngularVelocity);
+        body->clearForces();
+        body->applyCentralForce(totalForce);
+        body->applyTorque(totalTorque);
+        body->updateInertiaTensor();
+        body->forceActivationState(activationState);
+        body->setDeactivationTime(deactivationTime);
+        body->setHitFraction(hitFraction);
+
+        auto* proxy = static_cast<btDbvtProxy*>(body->getBroadphaseHandle());
+        if (proxy && hasProxy)
+            RestoreBroadphaseProxy(broadphase, proxy, aabbMin, aabbMax, btDbvtVolume::FromMM(leafMin, leafMax), stage);
+    }
+    broadphase->m_fixedleft = broadphase->m_sets[btDbvtBroadphase::FIXED_SET].m_leaves;
+
+    // Remove the pairs between rigid bodies that did not exist when saving, along with their collision algorithms and
+    // contact manifolds, then add the missing ones
+    HashSet<Pair<btBroadphaseProxy*, btBroadphaseProxy*> > savedPairs;
+    PODVector<Pair<btBroadphaseProxy*, btBroadphaseProxy*> > addPairs;
+    unsigned numPairs = source.ReadVLE();
+    for (unsigned i = 0; i < numPairs; ++i)
+    {
+        btRigidBody* bodyA = GetBtRigidBody(scene, source.ReadUInt());
+        btRigidBody* bodyB = GetBtRigidBody(scene, source.ReadUInt());
+        btBroadphaseProxy* proxyA = bodyA ? bodyA->getBroadphaseHandle() : nullptr;
+        btBroadphaseProxy* proxyB = bodyB ? bodyB->getBroadphaseHandle() : nullptr;
+        if (!proxyA || !proxyB)
+            continue;
+
+        savedPairs.Insert(MakeProxyPair(proxyA, proxyB));
+        addPairs.Push(MakeProxyPair(proxyA, proxyB));
+    }
+
+    for (int i = pairCache->getNumOverlappingPairs() - 1; i >= 0; --i)
+    {
+        btBroadphasePair& pair = pairCache->getOverlappingPairArray()[i];
+        btBroadphaseProxy* proxyA = pair.m_pProxy0;
+        btBroadphaseProxy* proxyB = pair.m_pProxy1;
+        if (GetProxyRigidBody(proxyA) && GetProxyRigidBody(proxyB) && !savedPairs.Contains(MakeProxyPair(proxyA, proxyB)))
+            pairCache->removeOverlappingPair(proxyA, proxyB, collisionDispatcher_.Get());
+    }
+
+    for (PODVector<Pair<btBroadphaseProxy*, btBroadphaseProxy*> >::ConstIterator i = addPairs.Begin(); i != addPairs.End(); ++i)
+    {
+        if (!pairCache->findPair(i->first_, i->second_))
+            pairCache->addOverlappingPair(i->first_, i->second_);
+    }
+    if (deterministic_)
+        static_cast<PhysicsPairCache*>(pairCache)->SortPairs();
+
+    // Read the manifolds and create the collision algorithms of the added pairs, which creates their manifolds
+    unsigned numManifolds = source.ReadVLE();
+    Vector<SnapshotManifold> manifolds(numManifolds);
+    for (unsigned i = 0; i < numManifolds; ++i)
+    {
+        SnapshotManifold& manifold = manifolds[i];
+        manifold.bodyA_ = GetBtRigidBody(scene, source.ReadUInt());
+        manifold.bodyB_ = GetBtRigidBody(scene, source.ReadUInt());
+        manifold.numContacts_ = Min((unsigned)source.ReadUByte(), (unsigned)MANIFOLD_CACHE_SIZE);
+        for (unsigned j = 0; j < manifold.numContacts_; ++j)
+            ReadManifoldPoint(source, manifold.points_[j]);
+
+        btBroadphaseProxy* proxyA = manifold.bodyA_ ? manifold.bodyA_->getBroadphaseHandle() : nullptr;
+        btBroadphaseProxy* proxyB = manifold.bodyB_ ? manifold.bodyB_->getBroadphaseHandle() : nullptr;
+        manifold.pair_ = proxyA && proxyB ? pairCache->findPair(proxyA, proxyB) : nullptr;
+        if (manifold.pair_ && !manifold.pair_->m_algorithm)
+            CreateCollisionAlgorithm(*manifold.pair_, collisionDispatcher_.Get(), world_->getDispatchInfo());
+    }
+
+    // Clear the contacts between rigid bodies, then fill the manifolds of each pair in the order its algorithm lists them
+    for (int i = 0; i < collisionDispatcher_->getNumManifolds(); ++i)
+    {
+        btPersistentManifold* manifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        if (manifold->getBody0()->getUserPointer() && manifold->getBody1()->getUserPointer())
+            manifold->clearManifold();
+    }
+
+    HashMap<btBroadphasePair*, unsigned> pairManifoldIndices;
+    btManifoldArray pairManifolds;
+    for (Vector<SnapshotManifold>::ConstIterator i = manifolds.Begin(); i != manifolds.End(); ++i)
+    {
+        if (!i->pair_ || !i->pair_->m_algorithm)
+            continue;
+
+        unsigned& index = pairManifoldIndices[i->pair_];
+        pairManifolds.resizeNoInitialize(0);
+        i->pair_->m_algorithm->getAllContactManifolds(pairManifolds);
+        btPersistentManifold* manifold = index < (unsigned)pairManifolds.size() ? pairManifolds[index] : nullptr;
+        ++index;
+        if (!manifold || manifold->getBody0() != i->bodyA_ || manifold->getBody1() != i->bodyB_)
+            continue;
+
+        for (unsigned j = 0; j < i->numContacts_; ++j)
+            manifold->getContactPoint(j) = i->points_[j];
+        manifold->setNumContacts(i->numContacts_);
+    }
+    if (deterministic_)
+        world->SortManifolds();
+
+    unsigned numConstraints = source.ReadVLE();
+    for (unsigned i = 0; i < numConstraints; ++i)
+    {
+        Component* component = scene->GetComponent(source.ReadUInt());
+        if (!source.ReadBool())
+            continue;
+
+        bool enabled = source.ReadBool();
+        float appliedImpulse = source.ReadFloat();
+
+        btTypedConstraint* constraint = component && component->GetType() == Constraint::GetTypeStatic() ?
+            static_cast<Constraint*>(component)->GetConstraint() : nullptr;
+        if (!constraint)
+            continue;
+
+        constraint->setEnabled(enabled);
+        constraint->internalSetAppliedImpulse(appliedImpulse);
+    }
+
+    // Update the scene nodes from the restored transforms
+    world_->synchronizeMotionStates();
+    ApplyDelayedWorldTransforms();
+
+    return true;
+}
+
+unsigned PhysicsWorld::GetStateHash() const
+{
+    unsigned hash = 0;
+
+    for (PODVector<RigidBody*>::ConstIterator i = rigidBodies_.Begin(); i != rigidBodies_.End(); ++i)
+    {
+        btRigidBody* body = (*i)->GetBody();
+        if (!body)
+            continue;
+
+        const btTransform& transform = body->getWorldTransform();
+        for (int j = 0; j < 3; ++j)
+            hash = HashBtVector3(hash, transform.getBasis()[j]);
+        hash = HashBtVector3(hash, transform.getOrigin());
+        hash = HashBtVector3(hash, body->getLinearVelocity());
+        hash = HashBtVector3(hash, body->getAngularVelocity());
+        hash = SDBMHash(hash, (unsigned char)body->getActivationState());
+    }
+
+    return hash;
+}
+
 void PhysicsWorld::SetFps(int fps)
 {
     fps_ = (unsigned)Clamp(fps, 1, 1000);
@@ -362,6 +1631,25 @@ void PhysicsWorld::SetSplitImpulse(bool enable)
     MarkNetworkUpdate();
 }
 
+void PhysicsWorld::SetThreadedSimulation(bool enable)
+{
+#if BT_THREADSAFE
+    threadedSimulation_ = enable;
+#else
+    if (enable)
+        URHO3D_LOGWARNING("Threaded physics simulation is not available without URHO3D_THREADING");
+#endif
+}
+
+void PhysicsWorld::SetDeterministic(bool enable)
+{
+    deterministic_ = enable;
+    static_cast<PhysicsDynamicsWorld*>(world_.Get())->deterministic_ = enable;
+    // Remove every pair which no longer overlaps when the broadphase cleans up, so that the remaining pairs do not depend
+    // on their order
+    static_cast<btDbvtBroadphase*>(broadphase_.Get())->m_cupdates = enable ? 100 : BROADPHASE_CLEANUP_PERCENT;
+}
+
 void PhysicsWorld::SetMaxNetworkAngularVelocity(float velocity)
 {
     maxNetworkAngularVelocity_ = Clamp(velocity, 1.0f, 32767.0f);
@@ -607,6 +1895,93 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, btCollisionShape* sh
     }
 }
 
+void PhysicsWorld::RaycastBatch(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries)
+{
+    URHO3D_PROFILE(PhysicsRaycastBatch);
+
+    RunBatchQueries<PhysicsRaycastQuery, PhysicsRaycastResult, BatchRaycast>(GetBatchQueryWorkQueue(), world_.Get(), results,
+        queries, numQueries);
+}
+
+void PhysicsWorld::RaycastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries)
+{
+    results.Resize(queries.Size());
+    if (!queries.Empty())
+        RaycastBatch(&results[0], &queries[0], queries.Size());
+}
+
+void PhysicsWorld::ConvexCastBatch(PhysicsRaycastResult* results, const PhysicsConvexCastQuery* queries, unsigned numQueries)
+{
+    URHO3D_PROFILE(PhysicsConvexCastBatch);
+
+    // Resolve the shape offsets and rigid bodies here, as accessing the scene nodes is not safe from the worker threads
+    PODVector<ResolvedConvexCast> casts(numQueries);
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        const PhysicsConvexCastQuery& query = queries[i];
+        ResolvedConvexCast& cast = casts[i];
+        btCollisionShape* shape = query.shape_ ? query.shape_->GetCollisionShape() : nullptr;
+
+        if (!shape || !shape->isConvex())
+        {
+            URHO3D_LOGERROR("Null or non-convex collision shape for convex cast");
+            cast.shape_ = nullptr;
+            continue;
+        }
+
+        Node* shapeNode = query.shape_->GetNode();
+        Vector3 scale = shapeNode ? shapeNode->GetWorldScale() : Vector3::ONE;
+        auto* bodyComp = query.shape_->GetComponent<RigidBody>();
+
+        cast.shape_ = static_cast<btConvexShape*>(shape);
+        cast.startPos_ = Matrix3x4(query.startPos_, query.startRot_, scale) * query.shape_->GetPosition();
+        cast.startRot_ = query.startRot_ * query.shape_->GetRotation();
+        cast.endPos_ = Matrix3x4(query.endPos_, query.endRot_, scale) * query.shape_->GetPosition();
+        cast.endRot_ = query.endRot_ * query.shape_->GetRotation();
+        cast.ignoredObject_ = bodyComp ? bodyComp->GetBody() : nullptr;
+        cast.collisionMask_ = query.collisionMask_;
+    }
+
+    if (numQueries)
+    {
+        RunBatchQueries<ResolvedConvexCast, PhysicsRaycastResult, BatchConvexCast>(GetBatchQueryWorkQueue(), world_.Get(), results,
+            &casts[0], numQueries);
+    }
+}
+
+void PhysicsWorld::ConvexCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsConvexCastQuery>& queries)
+{
+    results.Resize(queries.Size());
+    if (!queries.Empty())
+        ConvexCastBatch(&results[0], &queries[0], queries.Size());
+}
+
+void PhysicsWorld::GetRigidBodiesBatch(PODVector<RigidBody*>* results, const PhysicsOverlapQuery* queries, unsigned numQueries)
+{
+    URHO3D_PROFILE(PhysicsOverlapBatch);
+
+    WorkQueue* queue = GetBatchQueryWorkQueue();
+
+#if BT_THREADSAFE
+    // The narrowphase algorithms create and release temporary contact manifolds
+    auto* dispatcher = static_cast<PhysicsCollisionDispatcher*>(collisionDispatcher_.Get());
+    dispatcher->lockManifolds_ = queue != nullptr;
+#endif
+
+    RunBatchQueries<PhysicsOverlapQuery, PODVector<RigidBody*>, BatchOverlap>(queue, world_.Get(), results, queries, numQueries);
+
+#if BT_THREADSAFE
+    dispatcher->lockManifolds_ = false;
+#endif
+}
+
+void PhysicsWorld::GetRigidBodiesBatch(Vector<PODVector<RigidBody*> >& results, const PODVector<PhysicsOverlapQuery>& queries)
+{
+    results.Resize(queries.Size());
+    if (!queries.Empty())
+        GetRigidBodiesBatch(&results[0], &queries[0], queries.Size());
+}
+
 void PhysicsWorld::RemoveCachedGeometry(Model* model)
 {
     RemoveCachedGeometryImpl(triMeshCache_, model);
@@ -680,18 +2055,20 @@ void PhysicsWorld::GetCollidingBodies(PODVector<RigidBody*>& result, const Rigid
 
     result.Clear();
 
-    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator i = currentCollisions_.Begin();
-         i != currentCollisions_.End(); ++i)
+    for (PODVector<PhysicsContactPair>::ConstIterator i = contactPairs_.Begin(); i != contactPairs_.End(); ++i)
     {
-        if (i->first_.first_ == body)
+        if (i->state_ == PCS_END)
+            continue;
+
+        if (i->bodyA_ == body)
         {
-            if (i->first_.second_)
-                result.Push(i->first_.second_);
+            if (i->bodyB_)
+                result.Push(i->bodyB_);
         }
-        else if (i->first_.second_ == body)
+        else if (i->bodyB_ == body)
         {
-            if (i->first_.first_)
-                result.Push(i->first_.first_);
+            if (i->bodyA_)
+                result.Push(i->bodyA_);
         }
     }
 }
@@ -711,6 +2088,17 @@ bool PhysicsWorld::GetSplitImpulse() const
     return world_->getSolverInfo().m_splitImpulse != 0;
 }
 
+unsigned PhysicsWorld::GetNumActiveBodies() const
+{
+    unsigned num = 0;
+    for (PODVector<RigidBody*>::ConstIterator i = rigidBodies_.Begin(); i != rigidBodies_.End(); ++i)
+    {
+        if ((*i)->IsActive())
+            ++num;
+    }
+    return num;
+}
+
 void PhysicsWorld::AddRigidBody(RigidBody* body)
 {
     rigidBodies_.Push(body);
@@ -721,6 +2109,15 @@ void PhysicsWorld::RemoveRigidBody(RigidBody* body)
     rigidBodies_.Remove(body);
     // Remove possible dangling pointer from the delayedWorldTransforms structure
     delayedWorldTransforms_.Erase(body);
+
+    // Null the body in the contact buffer, which is also used to detect new and ceased collisions on the next step
+    for (PODVector<PhysicsContactPair>::Iterator i = contactPairs_.Begin(); i != contactPairs_.End(); ++i)
+    {
+        if (i->bodyA_ == body)
+            i->bodyA_ = nullptr;
+        else if (i->bodyB_ == body)
+            i->bodyB_ = nullptr;
+    }
 }
 
 void PhysicsWorld::AddCollisionShape(CollisionShape* shape)
@@ -830,114 +2227,163 @@ void PhysicsWorld::PostStep(float timeStep)
     SendEvent(E_PHYSICSPOSTSTEP, eventData);
 }
 
+WorkQueue* PhysicsWorld::GetBatchQueryWorkQueue() const
+{
+#if BT_THREADSAFE
+    // The broadphase ray test uses per-thread stacks only when Bullet is built thread-safe
+    auto* queue = GetSubsystem<WorkQueue>();
+    return queue && queue->GetNumThreads() ? queue : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
 void PhysicsWorld::SendCollisionEvents()
 {
     URHO3D_PROFILE(SendCollisionEvents);
 
-    currentCollisions_.Clear();
-    physicsCollisionData_.Clear();
-    nodeCollisionData_.Clear();
+    // The buffer of the previous step classifies the collisions. Bodies removed from the world since then have been nulled
+    previousContactPairs_.Swap(contactPairs_);
+    contactPairs_.Clear();
+    contactPoints_.Clear();
+    collisionManifolds_.Clear();
 
     int numManifolds = collisionDispatcher_->getNumManifolds();
 
-    if (numManifolds)
+    for (int i = 0; i < numManifolds; ++i)
     {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
-
-        for (int i = 0; i < numManifolds; ++i)
-        {
-            btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
-            // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
-            if (!contactManifold->getNumContacts())
-                continue;
-
-            const btCollisionObject* objectA = contactManifold->getBody0();
-            const btCollisionObject* objectB = contactManifold->getBody1();
-
-            auto* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
-            auto* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
-            // If it's not a rigidbody, maybe a ghost object
-            if (!bodyA || !bodyB)
-                continue;
+        btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
+        if (!contactManifold->getNumContacts())
+            continue;
+
+        const btCollisionObject* objectA = contactManifold->getBody0();
+        const btCollisionObject* objectB = contactManifold->getBody1();
+
+        auto* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
+        auto* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
+        // If it's not a rigidbody, maybe a ghost object
+        if (!bodyA || !bodyB)
+            continue;
+
+        if (!IsCollisionEventPair(bodyA, bodyB))
+            continue;
+
+        CollisionManifold collision;
+        collision.bodyA_ = Min(bodyA, bodyB);
+        collision.bodyB_ = Max(bodyA, bodyB);
+        collision.manifold_ = contactManifold;
+        collision.index_ = (unsigned)i;
+        collision.flipped_ = bodyB < bodyA;
+        collisionManifolds_.Push(collision);
+    }
 
-            // Skip collision event signaling if both objects are static, or if collision event mode does not match
-            if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                !bodyA->IsActive() && !bodyB->IsActive())
-                continue;
+    Sort(collisionManifolds_.Begin(), collisionManifolds_.End(), CompareCollisionManifolds);
 
-            WeakPtr<RigidBody> bodyWeakA(bodyA);
-            WeakPtr<RigidBody> bodyWeakB(bodyB);
+    // Merge the manifolds of each body pair into one contact pair. There may be several, for example with compound shapes
+    for (unsigned i = 0; i < collisionManifolds_.Size();)
+    {
+        PhysicsContactPair pair;
+        pair.bodyA_ = collisionManifolds_[i].bodyA_;
+        pair.bodyB_ = collisionManifolds_[i].bodyB_;
+        pair.state_ = PCS_BEGIN;
+        pair.trigger_ = pair.bodyA_->IsTrigger() || pair.bodyB_->IsTrigger();
+        pair.firstContact_ = contactPoints_.Size();
+
+        for (; i < collisionManifolds_.Size() && collisionManifolds_[i].bodyA_ == pair.bodyA_ &&
+            collisionManifolds_[i].bodyB_ == pair.bodyB_; ++i)
+        {
+            // Flip the normals of a manifold which has the body pointers flipped
+            btPersistentManifold* contactManifold = collisionManifolds_[i].manifold_;
+            float normalSign = collisionManifolds_[i].flipped_ ? -1.0f : 1.0f;
 
-            // First only store the collision pair as weak pointers and the manifold pointer, so user code can safely destroy
-            // objects during collision event handling
-            Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> > bodyPair;
-            if (bodyA < bodyB)
-            {
-                bodyPair = MakePair(bodyWeakA, bodyWeakB);
-                currentCollisions_[bodyPair].manifold_ = contactManifold;
-            }
-            else
+            for (int j = 0; j < contactManifold->getNumContacts(); ++j)
             {
-                bodyPair = MakePair(bodyWeakB, bodyWeakA);
-                currentCollisions_[bodyPair].flippedManifold_ = contactManifold;
+                btManifoldPoint& point = contactManifold->getContactPoint(j);
+                PhysicsContactPoint contact;
+                contact.position_ = ToVector3(point.m_positionWorldOnB);
+                contact.normal_ = normalSign * ToVector3(point.m_normalWorldOnB);
+                contact.distance_ = point.m_distance1;
+                contact.impulse_ = point.m_appliedImpulse;
+                contactPoints_.Push(contact);
             }
         }
 
-        for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator i = currentCollisions_.Begin();
-             i != currentCollisions_.End(); ++i)
+        pair.numContacts_ = contactPoints_.Size() - pair.firstContact_;
+        contactPairs_.Push(pair);
+    }
+
+    // Both pair lists are sorted, so walk them together to find the ongoing collisions. Append the ceased ones after the current
+    unsigned numCurrentPairs = contactPairs_.Size();
+    unsigned current = 0;
+    for (unsigned i = 0; i < previousContactPairs_.Size(); ++i)
+    {
+        const PhysicsContactPair& previous = previousContactPairs_[i];
+        if (previous.state_ == PCS_END || !previous.bodyA_ || !previous.bodyB_)
+            continue;
+
+        while (current < numCurrentPairs && CompareContactPairs(contactPairs_[current], previous))
+            ++current;
+
+        if (current < numCurrentPairs && contactPairs_[current].bodyA_ == previous.bodyA_ &&
+            contactPairs_[current].bodyB_ == previous.bodyB_)
+            contactPairs_[current].state_ = PCS_PERSIST;
+        else if (IsCollisionEventPair(previous.bodyA_, previous.bodyB_))
         {
-            RigidBody* bodyA = i->first_.first_;
-            RigidBody* bodyB = i->first_.second_;
-            if (!bodyA || !bodyB)
-                continue;
+            PhysicsContactPair pair;
+            pair.bodyA_ = previous.bodyA_;
+            pair.bodyB_ = previous.bodyB_;
+            pair.state_ = PCS_END;
+            pair.trigger_ = previous.bodyA_->IsTrigger() || previous.bodyB_->IsTrigger();
+            pair.firstContact_ = contactPoints_.Size();
+            pair.numContacts_ = 0;
+            contactPairs_.Push(pair);
+        }
+    }
 
-            Node* nodeA = bodyA->GetNode();
-            Node* nodeB = bodyB->GetNode();
-            WeakPtr<Node> nodeWeakA(nodeA);
-            WeakPtr<Node> nodeWeakB(nodeB);
+    // Send the collision events only where there are receivers, as filling the event data and contact buffers for every pair
+    // is expensive
+    bool sendCollisionStart = HasEventReceivers(context_, this, E_PHYSICSCOLLISIONSTART);
+    bool sendCollision = HasEventReceivers(context_, this, E_PHYSICSCOLLISION);
+    bool sendCollisionEnd = HasEventReceivers(context_, this, E_PHYSICSCOLLISIONEND);
+    bool sendAllNodeCollisionStart = HasEventReceivers(context_->GetEventReceivers(E_NODECOLLISIONSTART));
+    bool sendAllNodeCollision = HasEventReceivers(context_->GetEventReceivers(E_NODECOLLISION));
+    bool sendAllNodeCollisionEnd = HasEventReceivers(context_->GetEventReceivers(E_NODECOLLISIONEND));
 
-            bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
-            bool newCollision = !previousCollisions_.Contains(i->first_);
+    physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
 
+    for (unsigned i = 0; i < numCurrentPairs; ++i)
+    {
+        // Bodies removed as a response to an event are nulled in the contact pair, so access it through the index
+        RigidBody* bodyA = contactPairs_[i].bodyA_;
+        RigidBody* bodyB = contactPairs_[i].bodyB_;
+        if (!bodyA || !bodyB)
+            continue;
+
+        Node* nodeA = bodyA->GetNode();
+        Node* nodeB = bodyB->GetNode();
+        bool newCollision = contactPairs_[i].state_ == PCS_BEGIN;
+        bool sendWorld = sendCollision || (newCollision && sendCollisionStart);
+        bool sendNodeA = sendAllNodeCollision || HasEventReceivers(context_->GetEventReceivers(nodeA, E_NODECOLLISION)) ||
+            (newCollision && (sendAllNodeCollisionStart || HasEventReceivers(context_->GetEventReceivers(nodeA, E_NODECOLLISIONSTART))));
+        bool sendNodeB = sendAllNodeCollision || HasEventReceivers(context_->GetEventReceivers(nodeB, E_NODECOLLISION)) ||
+            (newCollision && (sendAllNodeCollisionStart || HasEventReceivers(context_->GetEventReceivers(nodeB, E_NODECOLLISIONSTART))));
+        if (!sendWorld && !sendNodeA && !sendNodeB)
+            continue;
+
+        WeakPtr<Node> nodeWeakA(nodeA);
+        WeakPtr<Node> nodeWeakB(nodeB);
+        bool trigger = contactPairs_[i].trigger_;
+
+        WriteContacts(contacts_, contactPoints_, contactPairs_[i], false);
+
+        if (sendWorld)
+        {
             physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
             physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
             physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
             physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
             physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
-            contacts_.Clear();
-
-            // "Pointers not flipped"-manifold, send unmodified normals
-            btPersistentManifold* contactManifold = i->second_.manifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
-            // "Pointers flipped"-manifold, flip normals also
-            contactManifold = i->second_.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
-
             physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
 
             // Send separate collision start event if collision is new
@@ -945,58 +2391,41 @@ void PhysicsWorld::SendCollisionEvents()
             {
                 SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
                     continue;
             }
 
             // Then send the ongoing collision event
             SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+            if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
                 continue;
+        }
+
+        nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
 
+        if (sendNodeA)
+        {
             nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
             nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
             nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
             nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
 
             if (newCollision)
             {
                 nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
                     continue;
             }
 
             nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+            if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
                 continue;
+        }
 
+        if (sendNodeB)
+        {
             // Flip perspective to body B
-            contacts_.Clear();
-            contactManifold = i->second_.manifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
-            contactManifold = i->second_.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
+            WriteContacts(contacts_, contactPoints_, contactPairs_[i], true);
 
             nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
             nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
@@ -1006,7 +2435,7 @@ void PhysicsWorld::SendCollisionEvents()
             if (newCollision)
             {
                 nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
                     continue;
             }
 
@@ -1014,66 +2443,62 @@ void PhysicsWorld::SendCollisionEvents()
         }
     }
 
-    // Send collision end events as applicable
+    // Send collision end events as applicable. They carry no contacts, so use separate event data
+    for (unsigned i = numCurrentPairs; i < contactPairs_.Size(); ++i)
     {
-        physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
-
-        for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator
-                 i = previousCollisions_.Begin(); i != previousCollisions_.End(); ++i)
+        RigidBody* bodyA = contactPairs_[i].bodyA_;
+        RigidBody* bodyB = contactPairs_[i].bodyB_;
+        if (!bodyA || !bodyB)
+            continue;
+
+        Node* nodeA = bodyA->GetNode();
+        Node* nodeB = bodyB->GetNode();
+        bool sendNodeA = sendAllNodeCollisionEnd || HasEventReceivers(context_->GetEventReceivers(nodeA, E_NODECOLLISIONEND));
+        bool sendNodeB = sendAllNodeCollisionEnd || HasEventReceivers(context_->GetEventReceivers(nodeB, E_NODECOLLISIONEND));
+        if (!sendCollisionEnd && !sendNodeA && !sendNodeB)
+            continue;
+
+        WeakPtr<Node> nodeWeakA(nodeA);
+        WeakPtr<Node> nodeWeakB(nodeB);
+        bool trigger = contactPairs_[i].trigger_;
+
+        if (sendCollisionEnd)
         {
-            if (!currentCollisions_.Contains(i->first_))
-            {
-                RigidBody* bodyA = i->first_.first_;
-                RigidBody* bodyB = i->first_.second_;
-                if (!bodyA || !bodyB)
-                    continue;
-
-                bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
-
-                // Skip collision event signaling if both objects are static, or if collision event mode does not match
-                if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                    !bodyA->IsActive() && !bodyB->IsActive())
-                    continue;
-
-                Node* nodeA = bodyA->GetNode();
-                Node* nodeB = bodyB->GetNode();
-                WeakPtr<Node> nodeWeakA(nodeA);
-                WeakPtr<Node> nodeWeakB(nodeB);
-
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+            collisionEndData_[PhysicsCollisionEnd::P_WORLD] = this;
+            collisionEndData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
+            collisionEndData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
+            collisionEndData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
+            collisionEndData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
+            collisionEndData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+
+            SendEvent(E_PHYSICSCOLLISIONEND, collisionEndData_);
+            // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+            if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
+                continue;
+        }
 
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
+        nodeCollisionEndData_[NodeCollisionEnd::P_TRIGGER] = trigger;
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+        if (sendNodeA)
+        {
+            nodeCollisionEndData_[NodeCollisionEnd::P_BODY] = bodyA;
+            nodeCollisionEndData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
+            nodeCollisionEndData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
 
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
+            nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionEndData_);
+            if (!nodeWeakA || !nodeWeakB || !contactPairs_[i].bodyA_ || !contactPairs_[i].bodyB_)
+                continue;
+        }
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+        if (sendNodeB)
+        {
+            nodeCollisionEndData_[NodeCollisionEnd::P_BODY] = bodyB;
+            nodeCollisionEndData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
+            nodeCollisionEndData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
 
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-            }
+            nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionEndData_);
         }
     }
-
-    previousCollisions_ = currentCollisions_;
 }
 
 void RegisterPhysicsLibrary(Context* context)
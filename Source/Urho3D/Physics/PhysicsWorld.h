@@ -25,6 +25,8 @@
 #include "../Container/HashSet.h"
 #include "../IO/VectorBuffer.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Quaternion.h"
+#include "../Math/Ray.h"
 #include "../Math/Sphere.h"
 #include "../Math/Vector3.h"
 #include "../Scene/Component.h"
@@ -48,10 +50,10 @@ class Deserializer;
 class Constraint;
 class Model;
 class Node;
-class Ray;
 class RigidBody;
 class Scene;
 class Serializer;
+class WorkQueue;
 class XMLElement;
 
 struct CollisionGeometryData;
@@ -83,6 +85,76 @@ struct URHO3D_API PhysicsRaycastResult
     RigidBody* body_;
 };
 
+/// Closest-hit ray or sphere cast request for a batched query.
+struct URHO3D_API PhysicsRaycastQuery
+{
+    /// Construct with defaults.
+    PhysicsRaycastQuery() = default;
+
+    /// Construct with ray, maximum distance, sphere radius and collision mask.
+    PhysicsRaycastQuery(const Ray& ray, float maxDistance, float radius = 0.0f, unsigned collisionMask = M_MAX_UNSIGNED) :
+        ray_(ray),
+        maxDistance_(maxDistance),
+        radius_(radius),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Ray.
+    Ray ray_;
+    /// Maximum distance.
+    float maxDistance_{};
+    /// Swept sphere radius, or zero to cast a ray.
+    float radius_{};
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
+/// Swept convex shape request for a batched query.
+struct URHO3D_API PhysicsConvexCastQuery
+{
+    /// Collision shape to sweep. The rigid body it belongs to is not returned as a hit.
+    CollisionShape* shape_{};
+    /// Start position.
+    Vector3 startPos_;
+    /// Start rotation.
+    Quaternion startRot_;
+    /// End position.
+    Vector3 endPos_;
+    /// End rotation.
+    Quaternion endRot_;
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
+/// Sphere or box overlap request for a batched query.
+struct URHO3D_API PhysicsOverlapQuery
+{
+    /// Construct with defaults.
+    PhysicsOverlapQuery() = default;
+
+    /// Construct with sphere and collision mask.
+    PhysicsOverlapQuery(const Sphere& sphere, unsigned collisionMask = M_MAX_UNSIGNED) :
+        sphere_(sphere),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Construct with box and collision mask.
+    PhysicsOverlapQuery(const BoundingBox& box, unsigned collisionMask = M_MAX_UNSIGNED) :
+        box_(box),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Query sphere. Used when the box is undefined.
+    Sphere sphere_;
+    /// Query box.
+    BoundingBox box_;
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
 /// Delayed world transform assignment for parented rigidbodies.
 struct DelayedWorldTransform
 {
@@ -96,20 +168,57 @@ struct DelayedWorldTransform
     Quaternion worldRotation_;
 };
 
-/// Manifold pointers stored during collision processing.
-struct ManifoldPair
+/// Manifold pointer stored during collision processing.
+struct CollisionManifold
 {
-    /// Construct with defaults.
-    ManifoldPair() :
-        manifold_(nullptr),
-        flippedManifold_(nullptr)
-    {
-    }
-
-    /// Manifold without the body pointers flipped.
+    /// Rigid body with the lower address.
+    RigidBody* bodyA_;
+    /// Rigid body with the higher address.
+    RigidBody* bodyB_;
+    /// Manifold.
     btPersistentManifold* manifold_;
-    /// Manifold with the body pointers flipped.
-    btPersistentManifold* flippedManifold_;
+    /// Manifold index in the dispatcher, used to keep the contact order stable.
+    unsigned index_;
+    /// Whether the manifold has the body pointers flipped.
+    bool flipped_;
+};
+
+/// Collision state of a rigid body pair in the contact buffer.
+enum PhysicsContactState
+{
+    PCS_BEGIN = 0,
+    PCS_PERSIST,
+    PCS_END
+};
+
+/// Contact point in the contact buffer.
+struct URHO3D_API PhysicsContactPoint
+{
+    /// Worldspace position on body B.
+    Vector3 position_;
+    /// Worldspace normal on body B, pointing towards body A.
+    Vector3 normal_;
+    /// Distance, negative when interpenetrating.
+    float distance_;
+    /// Impulse applied in collision.
+    float impulse_;
+};
+
+/// Colliding rigid body pair in the contact buffer.
+struct URHO3D_API PhysicsContactPair
+{
+    /// Rigid body with the lower address. Null if removed from the world after the buffer was built.
+    RigidBody* bodyA_;
+    /// Rigid body with the higher address. Null if removed from the world after the buffer was built.
+    RigidBody* bodyB_;
+    /// Whether the collision began on this step, is ongoing, or has ceased.
+    PhysicsContactState state_;
+    /// Whether either of the bodies is a trigger.
+    bool trigger_;
+    /// Index of the first contact point.
+    unsigned firstContact_;
+    /// Number of contact points. Zero for a collision that has ceased.
+    unsigned numContacts_;
 };
 
 /// Custom overrides of physics internals. To use overrides, must be set before the physics component is created.
@@ -171,6 +280,10 @@ public:
     void Update(float timeStep);
     /// Refresh collisions only without updating dynamics.
     void UpdateCollisions();
+    /// Write the simulation state of all rigid bodies, contacts and constraints to a binary buffer, for rollback or replays. Does not modify the simulation. Return true if successful.
+    bool SaveSnapshot(Serializer& dest) const;
+    /// Restore the simulation state from a snapshot. Rigid bodies are matched by component ID and are not re-created. With deterministic simulation order, a world with the same rigid bodies continues exactly as it did after saving. Return true if successful.
+    bool RestoreSnapshot(Deserializer& source);
     /// Set simulation substeps per second.
     void SetFps(int fps);
     /// Set gravity.
@@ -187,6 +300,10 @@ public:
     void SetInternalEdge(bool enable);
     /// Set split impulse collision mode. This is more accurate, but slower. Disabled by default.
     void SetSplitImpulse(bool enable);
+    /// Set whether to process collision pairs and solve simulation islands on the work queue's threads. Requires URHO3D_THREADING. Disabled by default.
+    void SetThreadedSimulation(bool enable);
+    /// Set whether to process collision pairs and keep contact manifolds in a fixed order, so that results depend neither on broadphase history nor on thread timing. Required for exact resimulation from a snapshot. Enabled by default.
+    void SetDeterministic(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
     /// Perform a physics world raycast and return all hits.
@@ -205,6 +322,18 @@ public:
     /// Perform a physics world swept convex test using a user-supplied Bullet collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, btCollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of closest-hit ray and sphere casts, on the work queue's threads if available. Writes one result per query. Must not be called during the physics step.
+    void RaycastBatch(PhysicsRaycastResult* results, const PhysicsRaycastQuery* queries, unsigned numQueries);
+    /// Perform a batch of closest-hit ray and sphere casts. The result vector is resized to the number of queries.
+    void RaycastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries);
+    /// Perform a batch of swept convex shape tests, on the work queue's threads if available. Writes one result per query. Must not be called during the physics step.
+    void ConvexCastBatch(PhysicsRaycastResult* results, const PhysicsConvexCastQuery* queries, unsigned numQueries);
+    /// Perform a batch of swept convex shape tests. The result vector is resized to the number of queries.
+    void ConvexCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsConvexCastQuery>& queries);
+    /// Perform a batch of sphere and box overlap queries, on the work queue's threads if available. Writes one rigid body vector per query. Must not be called during the physics step.
+    void GetRigidBodiesBatch(PODVector<RigidBody*>* results, const PhysicsOverlapQuery* queries, unsigned numQueries);
+    /// Perform a batch of sphere and box overlap queries. The result vector is resized to the number of queries; the inner vectors keep their capacity between calls.
+    void GetRigidBodiesBatch(Vector<PODVector<RigidBody*> >& results, const PODVector<PhysicsOverlapQuery>& queries);
     /// Invalidate cached collision geometry for a model.
     void RemoveCachedGeometry(Model* model);
     /// Return rigid bodies by a sphere query.
@@ -215,6 +344,12 @@ public:
     void GetRigidBodies(PODVector<RigidBody*>& result, const RigidBody* body);
     /// Return rigid bodies that have been in collision with the specified body on the last simulation step. Only returns collisions that were sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
     void GetCollidingBodies(PODVector<RigidBody*>& result, const RigidBody* body);
+    /// Return the colliding rigid body pairs of the last simulation step, sorted by the body addresses and followed by the collisions that ceased. Filtered like the collision events, and valid until the next step.
+    const PODVector<PhysicsContactPair>& GetContactPairs() const { return contactPairs_; }
+    /// Return the contact points of the last simulation step. Each contact pair refers to a range of them.
+    const PODVector<PhysicsContactPoint>& GetContactPoints() const { return contactPoints_; }
+    /// Return a hash of the rigid body transforms, velocities and activation states, for comparing simulation runs.
+    unsigned GetStateHash() const;
 
     /// Return gravity.
     Vector3 GetGravity() const;
@@ -237,6 +372,18 @@ public:
     /// Return whether split impulse collision mode is enabled.
     bool GetSplitImpulse() const;
 
+    /// Return whether threaded simulation is enabled.
+    bool GetThreadedSimulation() const { return threadedSimulation_; }
+
+    /// Return whether simulation order is deterministic.
+    bool GetDeterministic() const { return deterministic_; }
+
+    /// Return duration of the last simulation update in microseconds.
+    long long GetUpdateTime() const { return updateTime_; }
+
+    /// Return number of rigid bodies that are currently active (not sleeping.)
+    unsigned GetNumActiveBodies() const;
+
     /// Return simulation steps per second.
     int GetFps() const { return fps_; }
 
@@ -304,6 +451,10 @@ private:
     void PostStep(float timeStep);
     /// Send accumulated collision events.
     void SendCollisionEvents();
+    /// Apply delayed (parented) world transforms to the scene nodes.
+    void ApplyDelayedWorldTransforms();
+    /// Return the work queue to run batched queries on, or null to run them on the calling thread.
+    WorkQueue* GetBatchQueryWorkQueue() const;
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_{};
@@ -323,10 +474,14 @@ private:
     PODVector<CollisionShape*> collisionShapes_;
     /// Constraints in the world.
     PODVector<Constraint*> constraints_;
-    /// Collision pairs on this frame.
-    HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> currentCollisions_;
-    /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
-    HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> previousCollisions_;
+    /// Contact manifolds on this step, sorted by body pair.
+    PODVector<CollisionManifold> collisionManifolds_;
+    /// Collision pairs on this step.
+    PODVector<PhysicsContactPair> contactPairs_;
+    /// Collision pairs on the previous step. Used to check if a collision is new or has ceased.
+    PODVector<PhysicsContactPair> previousContactPairs_;
+    /// Contact points on this step.
+    PODVector<PhysicsContactPoint> contactPoints_;
     /// Delayed (parented) world transform assignments.
     HashMap<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
     /// Cache for trimesh geometry data by model and LOD level.
@@ -339,6 +494,10 @@ private:
     VariantMap physicsCollisionData_;
     /// Preallocated event data map for node collision events.
     VariantMap nodeCollisionData_;
+    /// Preallocated event data map for physics collision end events.
+    VariantMap collisionEndData_;
+    /// Preallocated event data map for node collision end events.
+    VariantMap nodeCollisionEndData_;
     /// Preallocated buffer for physics collision contact data.
     VectorBuffer contacts_;
     /// Simulation substeps per second.
@@ -349,12 +508,18 @@ private:
     float timeAcc_{};
     /// Maximum angular velocity for network replication.
     float maxNetworkAngularVelocity_{DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY};
+    /// Duration of the last simulation update in microseconds.
+    long long updateTime_{};
     /// Automatic simulation update enabled flag.
     bool updateEnabled_{true};
     /// Interpolation flag.
     bool interpolation_{true};
     /// Use internal edge utility flag.
     bool internalEdge_{true};
+    /// Threaded simulation flag.
+    bool threadedSimulation_{};
+    /// Deterministic simulation order flag.
+    bool deterministic_{true};
     /// Applying transforms flag.
     bool applyingTransforms_{};
     /// Simulating flag.
@@ -31,97 +31,145 @@
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 
+#include <algorithm>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
-BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
+BackgroundLoaderThread::BackgroundLoaderThread(BackgroundLoader* owner) :
     owner_(owner)
 {
 }
 
+void BackgroundLoaderThread::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        if (!owner_->LoadNextResource())
+            Time::Sleep(5);
+    }
+}
+
+BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
+    owner_(owner),
+    loadSequence_(0),
+    numThreads_(1),
+    numFinished_(0),
+    numFailed_(0),
+    numCancelled_(0),
+    totalLatency_(0),
+    maxLatency_(0),
+    totalLoadTime_(0)
+{
+}
+
 BackgroundLoader::~BackgroundLoader()
 {
+    // Stop the worker threads first so that none of them is accessing the queue
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Stop();
+    threads_.Clear();
+
     MutexLock lock(backgroundLoadMutex_);
 
     backgroundLoadQueue_.Clear();
+    loadOrder_.Clear();
+    readyToFinish_.Clear();
 }
 
-void BackgroundLoader::ThreadFunction()
+bool BackgroundLoader::LoadNextResource()
 {
-    while (shouldRun_)
+    backgroundLoadMutex_.Acquire();
+
+    // Take the highest priority queued resource from the heap. Skip the entries of resources that have been cancelled or
+    // already claimed, and the entries pushed before the priority was raised
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator best = backgroundLoadQueue_.End();
+    while (!loadOrder_.Empty())
     {
-        backgroundLoadMutex_.Acquire();
+        BackgroundLoadOrder order = loadOrder_.Front();
+        std::pop_heap(loadOrder_.Buffer(), loadOrder_.Buffer() + loadOrder_.Size());
+        loadOrder_.Pop();
 
-        // Search for a queued resource that has not been loaded yet
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-        while (i != backgroundLoadQueue_.End())
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(order.key_);
+        if (i != backgroundLoadQueue_.End() && i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED &&
+            i->second_.priority_ == order.priority_)
         {
-            if (i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
+            best = i;
+            break;
         }
+    }
 
-        if (i == backgroundLoadQueue_.End())
-        {
-            // No resources to load found
-            backgroundLoadMutex_.Release();
-            Time::Sleep(5);
-        }
-        else
-        {
-            BackgroundLoadItem& item = i->second_;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
+    if (best == backgroundLoadQueue_.End())
+    {
+        // No resources to load found
+        backgroundLoadMutex_.Release();
+        return false;
+    }
 
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
+    Pair<StringHash, StringHash> key = best->first_;
+    BackgroundLoadItem& item = best->second_;
+    Resource* resource = item.resource_;
+    // Claim the item while still holding the mutex so that no other worker thread picks it. We can be sure that
+    // the item is not removed from the queue as long as it is in the "queued" or "loading" state
+    resource->SetAsyncLoadState(ASYNC_LOADING);
+    backgroundLoadMutex_.Release();
+
+    HiresTimer loadTimer;
+    bool success = false;
+    SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
+    if (file)
+        success = resource->BeginLoad(*file);
+    file.Reset();
+    long long loadTime = loadTimer.GetUSec(false);
+
+    // Process dependencies now
+    // Need to lock the queue again when manipulating other entries
+    backgroundLoadMutex_.Acquire();
+    ReleaseDependents(item);
+    totalLoadTime_ += loadTime;
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+    CheckReadyToFinish(key, item);
+    backgroundLoadMutex_.Release();
 
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.Size())
-            {
-                for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item.dependents_.Begin();
-                     i != item.dependents_.End(); ++i)
-                {
-                    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
-                    if (j != backgroundLoadQueue_.End())
-                        j->second_.dependencies_.Erase(key);
-                }
+    return true;
+}
 
-                item.dependents_.Clear();
-            }
+void BackgroundLoader::SetNumThreads(unsigned num)
+{
+    numThreads_ = Max(num, 1U);
 
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
-        }
-    }
+    // Apply immediately if the threads have already been started
+    if (!threads_.Empty())
+        UpdateThreads();
 }
 
-bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority)
 {
     StringHash nameHash(name);
     Pair<StringHash, StringHash> key = MakePair(type, nameHash);
 
     MutexLock lock(backgroundLoadMutex_);
 
-    // Check if already exists in the queue
-    if (backgroundLoadQueue_.Find(key) != backgroundLoadQueue_.End())
+    // Check if already exists in the queue. If so, only raise the priority
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator existing = backgroundLoadQueue_.Find(key);
+    if (existing != backgroundLoadQueue_.End())
+    {
+        if (priority > existing->second_.priority_)
+        {
+            existing->second_.priority_ = priority;
+            if (existing->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+                PushLoadOrder(key, priority);
+        }
         return false;
+    }
 
     BackgroundLoadItem& item = backgroundLoadQueue_[key];
     item.sendEventOnFailure_ = sendEventOnFailure;
+    item.priority_ = priority;
+    item.cancelled_ = false;
+    item.queueTimer_.Reset();
 
     // Make sure the pointer is non-null and is a Resource subclass
     item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
@@ -156,6 +204,8 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
         {
             BackgroundLoadItem& callerItem = j->second_;
             item.dependents_.Insert(callerKey);
+            // Dependencies are needed before the caller can finish, so load them at least at the caller's priority
+            item.priority_ = Max(item.priority_, callerItem.priority_);
             callerItem.dependencies_.Insert(key);
         }
         else
@@ -163,9 +213,44 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
                        " requested for a background loaded resource but was not in the background load queue");
     }
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+    PushLoadOrder(key, item.priority_);
+
+    // Start the background loader threads now. Resources can only be queued from the worker threads when they are
+    // already running, so the thread list is only modified from the main thread
+    if (threads_.Size() < numThreads_ && Thread::IsMainThread())
+        UpdateThreads();
+
+    return true;
+}
+
+bool BackgroundLoader::CancelResource(StringHash type, StringHash nameHash)
+{
+    MutexLock lock(backgroundLoadMutex_);
+
+    Pair<StringHash, StringHash> key = MakePair(type, nameHash);
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
+    if (i == backgroundLoadQueue_.End())
+        return false;
+
+    BackgroundLoadItem& item = i->second_;
+    if (!item.cancelled_)
+    {
+        URHO3D_LOGDEBUG("Cancelled background loading of resource " + item.resource_->GetName());
+        ++numCancelled_;
+    }
+
+    if (item.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+    {
+        // Not picked by a worker thread yet, so can be removed right away
+        ReleaseDependents(item);
+        item.resource_->SetAsyncLoadState(ASYNC_DONE);
+        backgroundLoadQueue_.Erase(i);
+    }
+    else
+    {
+        // Being loaded or waiting to finish: let the loading complete, then discard the resource
+        item.cancelled_ = true;
+    }
 
     return true;
 }
@@ -179,6 +264,19 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
     if (i != backgroundLoadQueue_.End())
     {
+        // The resource is needed now, so it must be finished even if it was cancelled
+        if (i->second_.cancelled_)
+        {
+            i->second_.cancelled_ = false;
+            --numCancelled_;
+        }
+        // Make sure it is picked first if still queued
+        if (i->second_.priority_ != M_MAX_INT)
+        {
+            i->second_.priority_ = M_MAX_INT;
+            if (i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+                PushLoadOrder(key, M_MAX_INT);
+        }
         backgroundLoadMutex_.Release();
 
         {
@@ -217,35 +315,51 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
+    if (!threads_.Empty())
     {
         HiresTimer timer;
 
         backgroundLoadMutex_.Acquire();
 
-        for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-             i != backgroundLoadQueue_.End();)
+        // Only visit the resources that have become ready to finish, in the order they did. The worker threads may append
+        // more while the mutex is released
+        unsigned numProcessed = 0;
+        while (numProcessed < readyToFinish_.Size())
         {
+            HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i =
+                backgroundLoadQueue_.Find(readyToFinish_[numProcessed++]);
+            // The resource may have been finished already by WaitForResource()
+            if (i == backgroundLoadQueue_.End())
+                continue;
+
             Resource* resource = i->second_.resource_;
             unsigned numDeps = i->second_.dependencies_.Size();
             AsyncLoadState state = resource->GetAsyncLoadState();
+            // An entry left from a resource of the same name that was finished and queued again
             if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                ++i;
-            else
+                continue;
+
+            if (i->second_.cancelled_)
             {
-                // Finishing a resource may need it to wait for other resources to load, in which case we can not
-                // hold on to the mutex
-                backgroundLoadMutex_.Release();
-                FinishBackgroundLoading(i->second_);
-                backgroundLoadMutex_.Acquire();
-                i = backgroundLoadQueue_.Erase(i);
+                // Discard without finishing or sending events
+                resource->SetAsyncLoadState(ASYNC_DONE);
+                backgroundLoadQueue_.Erase(i);
+                continue;
             }
 
+            // Finishing a resource may need it to wait for other resources to load, in which case we can not
+            // hold on to the mutex
+            backgroundLoadMutex_.Release();
+            FinishBackgroundLoading(i->second_);
+            backgroundLoadMutex_.Acquire();
+            backgroundLoadQueue_.Erase(i);
+
             // Break when the time limit passed so that we keep sufficient FPS
             if (timer.GetUSec(false) >= maxMs * 1000LL)
                 break;
         }
 
+        readyToFinish_.Erase(0, numProcessed);
         backgroundLoadMutex_.Release();
     }
 }
@@ -256,6 +370,86 @@ unsigned BackgroundLoader::GetNumQueuedResources() const
     return backgroundLoadQueue_.Size();
 }
 
+void BackgroundLoader::GetStats(BackgroundLoadStats& stats) const
+{
+    MutexLock lock(backgroundLoadMutex_);
+
+    stats.numQueued_ = 0;
+    stats.numLoading_ = 0;
+    stats.numWaitingFinish_ = 0;
+    for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::ConstIterator i = backgroundLoadQueue_.Begin();
+         i != backgroundLoadQueue_.End(); ++i)
+    {
+        AsyncLoadState state = i->second_.resource_->GetAsyncLoadState();
+        if (state == ASYNC_QUEUED)
+            ++stats.numQueued_;
+        else if (state == ASYNC_LOADING)
+            ++stats.numLoading_;
+        else
+            ++stats.numWaitingFinish_;
+    }
+
+    stats.numFinished_ = numFinished_;
+    stats.numFailed_ = numFailed_;
+    stats.numCancelled_ = numCancelled_;
+    stats.averageLatency_ = numFinished_ ? (float)((double)totalLatency_ / numFinished_ / 1000.0) : 0.0f;
+    stats.maxLatency_ = (float)(maxLatency_ / 1000.0);
+    stats.averageLoadTime_ = numFinished_ ? (float)((double)totalLoadTime_ / numFinished_ / 1000.0) : 0.0f;
+}
+
+void BackgroundLoader::UpdateThreads()
+{
+    while (threads_.Size() > numThreads_)
+    {
+        threads_.Back()->Stop();
+        threads_.Pop();
+    }
+
+    while (threads_.Size() < numThreads_)
+    {
+        SharedPtr<BackgroundLoaderThread> thread(new BackgroundLoaderThread(this));
+        if (!thread->Run())
+        {
+            URHO3D_LOGERROR("Failed to start background loader thread");
+            break;
+        }
+        threads_.Push(thread);
+    }
+}
+
+void BackgroundLoader::ReleaseDependents(BackgroundLoadItem& item)
+{
+    if (item.dependents_.Size())
+    {
+        Pair<StringHash, StringHash> key = MakePair(item.resource_->GetType(), item.resource_->GetNameHash());
+        for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item.dependents_.Begin(); i != item.dependents_.End(); ++i)
+        {
+            HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
+            if (j != backgroundLoadQueue_.End() && j->second_.dependencies_.Erase(key))
+                CheckReadyToFinish(*i, j->second_);
+        }
+
+        item.dependents_.Clear();
+    }
+}
+
+void BackgroundLoader::PushLoadOrder(const Pair<StringHash, StringHash>& key, int priority)
+{
+    BackgroundLoadOrder order;
+    order.key_ = key;
+    order.priority_ = priority;
+    order.sequence_ = loadSequence_++;
+    loadOrder_.Push(order);
+    std::push_heap(loadOrder_.Buffer(), loadOrder_.Buffer() + loadOrder_.Size());
+}
+
+void BackgroundLoader::CheckReadyToFinish(const Pair<StringHash, StringHash>& key, BackgroundLoadItem& item)
+{
+    AsyncLoadState state = item.resource_->GetAsyncLoadState();
+    if (item.dependencies_.Empty() && (state == ASYNC_SUCCESS || state == ASYNC_FAIL))
+        readyToFinish_.Push(key);
+}
+
 void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
     Resource* resource = item.resource_;
@@ -281,6 +475,16 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
     }
     resource->SetAsyncLoadState(ASYNC_DONE);
 
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        long long latency = item.queueTimer_.GetUSec(false);
+        ++numFinished_;
+        if (!success)
+            ++numFailed_;
+        totalLatency_ += latency;
+        maxLatency_ = Max(maxLatency_, latency);
+    }
+
     if (!success && item.sendEventOnFailure_)
     {
         using namespace LoadFailed;
@@ -28,14 +28,18 @@
 #include "../Container/Ptr.h"
 #include "../Container/RefCounted.h"
 #include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../Math/StringHash.h"
 
 namespace Urho3D
 {
 
+class BackgroundLoader;
 class Resource;
 class ResourceCache;
 
+struct BackgroundLoadStats;
+
 /// Queue item for background loading of a resource.
 struct BackgroundLoadItem
 {
@@ -45,36 +49,91 @@ struct BackgroundLoadItem
     HashSet<Pair<StringHash, StringHash> > dependencies_;
     /// Resources that depend on this resource's loading.
     HashSet<Pair<StringHash, StringHash> > dependents_;
+    /// Timer started when queued, for measuring the load latency.
+    HiresTimer queueTimer_;
+    /// Priority. Higher value = will be loaded first.
+    int priority_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
+    /// Whether the load was cancelled while already in progress. The resource will be discarded when finished.
+    bool cancelled_;
+};
+
+/// Entry of the background load order heap. Entries are not removed when their item is cancelled or its priority raised, but skipped when they no longer match.
+struct BackgroundLoadOrder
+{
+    /// Test for lower loading order, for the max-heap.
+    bool operator <(const BackgroundLoadOrder& rhs) const
+    {
+        return priority_ != rhs.priority_ ? priority_ < rhs.priority_ : sequence_ > rhs.sequence_;
+    }
+
+    /// Resource type and name hash.
+    Pair<StringHash, StringHash> key_;
+    /// Priority of the item when the entry was pushed.
+    int priority_;
+    /// Queueing order among resources of the same priority.
+    unsigned sequence_;
+};
+
+/// Background loader worker thread.
+class BackgroundLoaderThread : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    explicit BackgroundLoaderThread(BackgroundLoader* owner);
+
+    /// Load queued resources until stopped.
+    void ThreadFunction() override;
+
+private:
+    /// Background loader.
+    BackgroundLoader* owner_;
 };
 
-/// Background loader of resources. Owned by the ResourceCache.
-class BackgroundLoader : public RefCounted, public Thread
+/// Background loader of resources. Runs resource BeginLoad() calls on a pool of worker threads. Owned by the ResourceCache.
+class BackgroundLoader : public RefCounted
 {
 public:
     /// Construct.
     explicit BackgroundLoader(ResourceCache* owner);
 
-    /// Destruct. Forcibly clear the load queue.
+    /// Destruct. Stop the worker threads and forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
-    void ThreadFunction() override;
+    /// Take the highest priority queued resource and call its BeginLoad(). Return false if there was nothing to load. Called by the worker threads.
+    bool LoadNextResource();
 
-    /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
-    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller);
+    /// Set number of worker threads. The threads start on the first background load request.
+    void SetNumThreads(unsigned num);
+    /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type). If already queued, raises the priority instead.
+    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority = 0);
+    /// Cancel background loading of a resource. If already being loaded, the result is discarded. Return true if the resource was in the load queue.
+    bool CancelResource(StringHash type, StringHash nameHash);
     /// Wait and finish possible loading of a resource when being requested from the cache.
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
 
+    /// Return number of worker threads.
+    unsigned GetNumThreads() const { return numThreads_; }
+
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
+    /// Return load queue depth and latency statistics.
+    void GetStats(BackgroundLoadStats& stats) const;
 
 private:
+    /// Start or stop worker threads to match the requested number. Must be called with the mutex not held.
+    void UpdateThreads();
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
+    /// Remove a resource from the dependencies of its dependents. Must be called with the mutex held.
+    void ReleaseDependents(BackgroundLoadItem& item);
+    /// Push a queued resource to the load order heap with its current priority. Must be called with the mutex held.
+    void PushLoadOrder(const Pair<StringHash, StringHash>& key, int priority);
+    /// Mark a resource ready to finish if it has been loaded and its dependencies have been loaded. Must be called with the mutex held.
+    void CheckReadyToFinish(const Pair<StringHash, StringHash>& key, BackgroundLoadItem& item);
 
     /// Resource cache.
     ResourceCache* owner_;
@@ -82,6 +141,28 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Max-heap of queued resources in loading order, so that the worker threads do not search the whole queue.
+    PODVector<BackgroundLoadOrder> loadOrder_;
+    /// Resources whose loading and dependencies have completed, in the order they became ready to finish.
+    PODVector<Pair<StringHash, StringHash> > readyToFinish_;
+    /// Counter for the loading order of resources with the same priority.
+    unsigned loadSequence_;
+    /// Worker threads.
+    Vector<SharedPtr<BackgroundLoaderThread> > threads_;
+    /// Requested number of worker threads.
+    unsigned numThreads_;
+    /// Number of resources finished since start.
+    unsigned numFinished_;
+    /// Number of resources that failed to load since start.
+    unsigned numFailed_;
+    /// Number of cancelled resources since start.
+    unsigned numCancelled_;
+    /// Total queue-to-finish latency of the finished resources in microseconds.
+    long long totalLatency_;
+    /// Maximum queue-to-finish latency in microseconds.
+    long long maxLatency_;
+    /// Total time spent in BeginLoad() by the worker threads in microseconds.
+    long long totalLoadTime_;
 };
 
 }
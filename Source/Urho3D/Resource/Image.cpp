@@ -2288,6 +2288,14 @@ unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height
 {
     unsigned dataSize = source.GetSize();
 
+    // Decode directly from memory if the source allows
+    const unsigned char* data = source.GetMemoryView();
+    if (data)
+    {
+        source.Seek(dataSize);
+        return stbi_load_from_memory(data, dataSize, &width, &height, (int*)&components, 0);
+    }
+
     SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
     source.Read(buffer.Get(), dataSize);
     return stbi_load_from_memory(buffer.Get(), dataSize, &width, &height, (int*)&components, 0);
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
 #include "../IO/FileSystem.h"
@@ -81,6 +82,7 @@ ResourceCache::ResourceCache(Context* context) :
 #ifdef URHO3D_THREADING
     // Create resource background loader. Its thread will start on the first background request
     backgroundLoader_ = new BackgroundLoader(this);
+    backgroundLoader_->SetNumThreads((unsigned)Clamp((int)GetNumPhysicalCPUs() - 1, 1, 4));
 #endif
 
     // Subscribe BeginFrame for handling directory watchers and background loaded resource finalization
@@ -635,7 +637,7 @@ Resource* ResourceCache::GetResource(StringHash type, const String& name, bool s
     return resource;
 }
 
-bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority)
 {
 #ifdef URHO3D_THREADING
     // If empty name, fail immediately
@@ -648,13 +650,33 @@ bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name,
     if (FindResource(type, nameHash) != noResource)
         return false;
 
-    return backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, caller);
+    return backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, caller, priority);
 #else
     // When threading not supported, fall back to synchronous loading
     return GetResource(type, name, sendEventOnFailure);
 #endif
 }
 
+bool ResourceCache::CancelBackgroundLoadResource(StringHash type, const String& name)
+{
+#ifdef URHO3D_THREADING
+    String sanitatedName = SanitateResourceName(name);
+    if (sanitatedName.Empty())
+        return false;
+
+    return backgroundLoader_->CancelResource(type, StringHash(sanitatedName));
+#else
+    return false;
+#endif
+}
+
+void ResourceCache::SetNumBackgroundLoadThreads(unsigned num)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumThreads(num);
+#endif
+}
+
 SharedPtr<Resource> ResourceCache::GetTempResource(StringHash type, const String& name, bool sendEventOnFailure)
 {
     String sanitatedName = SanitateResourceName(name);
@@ -717,6 +739,24 @@ unsigned ResourceCache::GetNumBackgroundLoadResources() const
 #endif
 }
 
+BackgroundLoadStats ResourceCache::GetBackgroundLoadStats() const
+{
+    BackgroundLoadStats stats;
+#ifdef URHO3D_THREADING
+    backgroundLoader_->GetStats(stats);
+#endif
+    return stats;
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumThreads();
+#else
+    return 0;
+#endif
+}
+
 void ResourceCache::GetResources(PODVector<Resource*>& result, StringHash type) const
 {
     result.Clear();
@@ -63,6 +63,29 @@ enum ResourceRequest
     RESOURCE_GETFILE = 1
 };
 
+/// Background resource loading statistics.
+struct BackgroundLoadStats
+{
+    /// Number of resources waiting for a worker thread.
+    unsigned numQueued_{};
+    /// Number of resources being loaded by the worker threads.
+    unsigned numLoading_{};
+    /// Number of resources loaded by the worker threads and waiting to be finished in the main thread.
+    unsigned numWaitingFinish_{};
+    /// Number of resources finished since start.
+    unsigned numFinished_{};
+    /// Number of resources that failed to load since start.
+    unsigned numFailed_{};
+    /// Number of cancelled resources since start.
+    unsigned numCancelled_{};
+    /// Average time in milliseconds from queueing to finishing a resource.
+    float averageLatency_{};
+    /// Maximum time in milliseconds from queueing to finishing a resource.
+    float maxLatency_{};
+    /// Average time in milliseconds spent loading a resource in a worker thread.
+    float averageLoadTime_{};
+};
+
 /// Optional resource request processor. Can deny requests, re-route resource file names, or perform other processing per request.
 class URHO3D_API ResourceRouter : public Object
 {
@@ -128,6 +151,8 @@ public:
 
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
+    /// Set number of background loading worker threads. Default is the number of physical CPU cores minus one, clamped to 1-4.
+    void SetNumBackgroundLoadThreads(unsigned num);
 
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
@@ -140,10 +165,14 @@ public:
     Resource* GetResource(StringHash type, const String& name, bool sendEventOnFailure = true);
     /// Load a resource without storing it in the resource cache. Return null if not found or if fails. Can be called from outside the main thread if the resource itself is safe to load completely (it does not possess for example GPU data.)
     SharedPtr<Resource> GetTempResource(StringHash type, const String& name, bool sendEventOnFailure = true);
-    /// Background load a resource. An event will be sent when complete. Return true if successfully stored to the load queue, false if eg. already exists. Can be called from outside the main thread.
-    bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
+    /// Background load a resource. An event will be sent when complete. Higher priority resources are loaded first. Return true if successfully stored to the load queue, false if eg. already exists. Can be called from outside the main thread.
+    bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, int priority = 0);
+    /// Cancel a pending background load. No events will be sent for it. Return true if the resource was in the load queue. Can be called only from the main thread.
+    bool CancelBackgroundLoadResource(StringHash type, const String& name);
     /// Return number of pending background-loaded resources.
     unsigned GetNumBackgroundLoadResources() const;
+    /// Return background loading queue depth and latency statistics.
+    BackgroundLoadStats GetBackgroundLoadStats() const;
     /// Return all loaded resources of a specific type.
     void GetResources(PODVector<Resource*>& result, StringHash type) const;
     /// Return an already loaded resource of specific type & name, or null if not found. Will not load if does not exist.
@@ -167,7 +196,9 @@ public:
     /// Template version of releasing a resource by name.
     template <class T> void ReleaseResource(const String& name, bool force = false);
     /// Template version of queueing a resource background load.
-    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
+    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, int priority = 0);
+    /// Template version of cancelling a resource background load.
+    template <class T> bool CancelBackgroundLoadResource(const String& name);
     /// Template version of returning loaded resources of a specific type.
     template <class T> void GetResources(PODVector<T*>& result) const;
     /// Return whether a file exists in the resource directories or package files. Does not check manually added in-memory resources.
@@ -193,6 +224,9 @@ public:
     /// Return how many milliseconds maximum to spend on finishing background loaded resources.
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
 
+    /// Return number of background loading worker threads.
+    unsigned GetNumBackgroundLoadThreads() const;
+
     /// Return a resource router by index.
     ResourceRouter* GetResourceRouter(unsigned index) const;
 
@@ -278,10 +312,16 @@ template <class T> SharedPtr<T> ResourceCache::GetTempResource(const String& nam
     return StaticCast<T>(GetTempResource(type, name, sendEventOnFailure));
 }
 
-template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller)
+template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller, int priority)
+{
+    StringHash type = T::GetTypeStatic();
+    return BackgroundLoadResource(type, name, sendEventOnFailure, caller, priority);
+}
+
+template <class T> bool ResourceCache::CancelBackgroundLoadResource(const String& name)
 {
     StringHash type = T::GetTypeStatic();
-    return BackgroundLoadResource(type, name, sendEventOnFailure, caller);
+    return CancelBackgroundLoadResource(type, name);
 }
 
 template <class T> void ResourceCache::GetResources(PODVector<T*>& result) const
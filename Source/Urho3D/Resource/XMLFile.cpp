@@ -85,11 +85,24 @@ bool XMLFile::BeginLoad(Deserializer& source)
         return false;
     }
 
-    SharedArrayPtr<char> buffer(new char[dataSize]);
-    if (source.Read(buffer.Get(), dataSize) != dataSize)
-        return false;
+    // Parse directly from memory if the source allows, otherwise read to a temporary buffer first
+    SharedArrayPtr<char> buffer;
+    const char* data = (const char*)source.GetMemoryView();
+    if (data)
+    {
+        data += source.GetPosition();
+        dataSize -= source.GetPosition();
+        source.Seek(source.GetSize());
+    }
+    else
+    {
+        buffer = new char[dataSize];
+        if (source.Read(buffer.Get(), dataSize) != dataSize)
+            return false;
+        data = buffer.Get();
+    }
 
-    if (!document_->load_buffer(buffer.Get(), dataSize))
+    if (!document_->load_buffer(data, dataSize))
     {
         URHO3D_LOGERROR("Could not parse XML data from " + source.GetName());
         document_->reset();
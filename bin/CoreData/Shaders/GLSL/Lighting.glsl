@@ -174,6 +174,96 @@ float GetIntensity(vec3 color)
     return dot(color, vec3(0.299, 0.587, 0.114));
 }
 
+#if defined(CLUSTERED) && !defined(GL_ES)
+#define MAXCLUSTERLIGHTS 32
+
+vec4 GetClusterTexel(float index)
+{
+    float y = floor(index * cClusterTexParams.y);
+    float x = index - y * cClusterTexParams.x;
+    return texture2D(sLightBuffer, vec2((x + 0.5) * cClusterTexParams.y, (y + 0.5) * cClusterTexParams.z));
+}
+
+// Return the cluster record of a position: x = first light index, y = number of lights
+vec4 GetCluster(vec4 clusterPos)
+{
+    vec2 tile = clamp(floor((clusterPos.xy / clusterPos.w * 0.5 + 0.5) * cClusterParams.xy), vec2(0.0, 0.0), cClusterParams.xy - 1.0);
+    float slice = clamp(floor(log(max(clusterPos.z, 0.0001)) * cClusterDepth.x + cClusterDepth.y), 0.0, cClusterParams.z - 1.0);
+    return GetClusterTexel(tile.x + (tile.y + slice * cClusterParams.y) * cClusterParams.x);
+}
+
+// Return the range-scaled vector from a position to a clustered light, along with the light color and spot attenuation
+vec3 GetClusterLightVec(vec4 lightIndex, vec3 worldPos, out vec3 lightColor, out float spotAtten)
+{
+    // Light data is laid out like vertex lights: (color, 1 / range), (-direction, cutoff), (position, 1 / (1 - cutoff))
+    vec4 color = GetClusterTexel(lightIndex.x);
+    vec4 lightDir = GetClusterTexel(lightIndex.x + 1.0);
+    vec4 lightPos = GetClusterTexel(lightIndex.x + 2.0);
+
+    vec3 lightVec = (lightPos.xyz - worldPos) * color.w;
+    lightColor = color.rgb;
+    spotAtten = clamp((dot(normalize(lightVec), lightDir.xyz) - lightDir.w) * lightPos.w, 0.0, 1.0);
+    return lightVec;
+}
+
+vec3 GetClusteredLight(vec4 clusterPos, vec3 worldPos, vec3 normal, vec3 diffColor, vec3 specColor)
+{
+    vec4 cluster = GetCluster(clusterPos);
+
+    vec3 result = vec3(0.0, 0.0, 0.0);
+    for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+    {
+        if (float(i) >= cluster.y)
+            break;
+
+        vec4 lightIndex = GetClusterTexel(cluster.x + float(i));
+        vec3 lightColor;
+        float spotAtten;
+        vec3 lightVec = GetClusterLightVec(lightIndex, worldPos, lightColor, spotAtten);
+        float lightDist = length(lightVec);
+        vec3 localDir = lightVec / lightDist;
+        #ifdef TRANSLUCENT
+            float NdotL = abs(dot(normal, localDir));
+        #else
+            float NdotL = max(dot(normal, localDir), 0.0);
+        #endif
+        float atten = clamp(1.0 - lightDist * lightDist, 0.0, 1.0);
+        float diff = NdotL * atten * spotAtten;
+
+        #ifdef SPECULAR
+            float spec = GetSpecular(normal, cCameraPosPS - worldPos, localDir, cMatSpecColor.a);
+            result += diff * lightColor * (diffColor + spec * specColor * lightIndex.y);
+        #else
+            result += diff * lightColor * diffColor;
+        #endif
+    }
+
+    return result;
+}
+
+// Return the lighting of all clustered lights on a volumetric (normal-less) surface such as a particle
+vec3 GetClusteredLightVolumetric(vec4 clusterPos, vec3 worldPos)
+{
+    vec4 cluster = GetCluster(clusterPos);
+
+    vec3 result = vec3(0.0, 0.0, 0.0);
+    for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+    {
+        if (float(i) >= cluster.y)
+            break;
+
+        vec3 lightColor;
+        float spotAtten;
+        vec3 lightVec = GetClusterLightVec(GetClusterTexel(cluster.x + float(i)), worldPos, lightColor, spotAtten);
+        float lightDist = length(lightVec);
+        float atten = clamp(1.0 - lightDist * lightDist, 0.0, 1.0);
+        result += atten * spotAtten * lightColor;
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #if defined(DIRLIGHT) && (!defined(GL_ES) || defined(WEBGL))
@@ -30,6 +30,9 @@ varying vec4 vWorldPos;
     #endif
 #else
     varying vec3 vVertexLight;
+    #ifdef CLUSTERED
+        varying vec4 vClusterPos;
+    #endif
 #endif
 
 void VS()
@@ -74,6 +77,10 @@ void VS()
             for (int i = 0; i < NUMVERTEXLIGHTS; ++i)
                 vVertexLight += GetVertexLightVolumetric(i, worldPos) * cVertexLights[i * 3].rgb;
         #endif
+
+        #ifdef CLUSTERED
+            vClusterPos = vec4(worldPos, 1.0) * cClusterViewProj;
+        #endif
     #endif
 }
 
@@ -154,6 +161,11 @@ void PS()
         // Ambient & per-vertex lighting
         vec3 finalColor = vVertexLight * diffColor.rgb;
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLightVolumetric(vClusterPos, vWorldPos.xyz) * diffColor.rgb;
+        #endif
+
         gl_FragColor = vec4(GetFog(finalColor, fogFactor), diffColor.a);
     #endif
 }
@@ -33,6 +33,9 @@ varying vec4 vWorldPos;
 #else
     varying vec3 vVertexLight;
     varying vec4 vScreenPos;
+    #ifdef CLUSTERED
+        varying vec4 vClusterPos;
+    #endif
     #ifdef ENVCUBEMAP
         varying vec3 vReflectionVec;
     #endif
@@ -98,6 +101,10 @@ void VS()
         
         vScreenPos = GetScreenPos(gl_Position);
 
+        #ifdef CLUSTERED
+            vClusterPos = vec4(worldPos, 1.0) * cClusterViewProj;
+        #endif
+
         #ifdef ENVCUBEMAP
             vReflectionVec = worldPos - cCameraPos;
         #endif
@@ -228,6 +235,11 @@ void PS()
             finalColor += lightInput.rgb * diffColor.rgb + lightSpecColor * specColor;
         #endif
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLight(vClusterPos, vWorldPos.xyz, normal, diffColor.rgb, specColor);
+        #endif
+
         #ifdef ENVCUBEMAP
             finalColor += cMatEnvMapColor * textureCube(sEnvCubeMap, reflect(vReflectionVec, normal)).rgb;
         #endif
@@ -157,4 +157,43 @@
 
         return diffuseFactor + specularFactor;
 	}
+
+    #if defined(CLUSTERED) && !defined(GL_ES)
+    // Return the summed PBR lighting of all point and spot lights binned to the pixel's cluster
+    // Clustered lights are evaluated as punctual lights with the forward spot light falloff
+    vec3 GetClusteredLightPBR(vec4 clusterPos, vec3 worldPos, vec3 toCamera, vec3 normal, float roughness, vec3 diffColor, vec3 specColor)
+    {
+        vec4 cluster = GetCluster(clusterPos);
+        float ndv = abs(dot(normal, toCamera)) + 1e-5;
+
+        vec3 result = vec3(0.0, 0.0, 0.0);
+        for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+        {
+            if (float(i) >= cluster.y)
+                break;
+
+            vec3 lightColor;
+            float spotAtten;
+            vec3 lightVec = GetClusterLightVec(GetClusterTexel(cluster.x + float(i)), worldPos, lightColor, spotAtten);
+            float lightDist = length(lightVec);
+            vec3 lightDir = lightVec / lightDist;
+            float falloff = pow(clamp(1.0 - pow(lightDist, 4.0), 0.0, 1.0), 2.0) / (lightDist * lightDist + 1.0);
+
+            vec3 Hn = normalize(toCamera + lightDir);
+            float vdh = clamp(dot(toCamera, Hn), M_EPSILON, 1.0);
+            float ndh = clamp(dot(normal, Hn), M_EPSILON, 1.0);
+            float ndl = clamp(dot(normal, lightDir), M_EPSILON, 1.0);
+            float ldh = clamp(dot(lightDir, Hn), M_EPSILON, 1.0);
+
+            vec3 BRDF = Diffuse(diffColor, roughness, ndv, ndl, vdh);
+            #ifdef SPECULAR
+                BRDF += Fresnel(specColor, vdh, ldh) * Distribution(ndh, roughness) * Visibility(ndl, ndv, roughness) / M_PI;
+            #endif
+
+            result += BRDF * lightColor * (ndl * falloff * spotAtten) / M_PI;
+        }
+
+        return result;
+    }
+    #endif
 #endif
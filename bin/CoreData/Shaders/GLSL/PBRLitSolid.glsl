@@ -37,6 +37,9 @@ varying vec4 vWorldPos;
 #else
     varying vec3 vVertexLight;
     varying vec4 vScreenPos;
+    #ifdef CLUSTERED
+        varying vec4 vClusterPos;
+    #endif
     #ifdef ENVCUBEMAP
         varying vec3 vReflectionVec;
     #endif
@@ -102,6 +105,10 @@ void VS()
 
         vScreenPos = GetScreenPos(gl_Position);
 
+        #ifdef CLUSTERED
+            vClusterPos = vec4(worldPos, 1.0) * cClusterViewProj;
+        #endif
+
         #ifdef ENVCUBEMAP
             vReflectionVec = worldPos - cCameraPos;
         #endif
@@ -234,6 +241,12 @@ void PS()
         #endif
 
         vec3 toCamera = normalize(vWorldPos.xyz - cCameraPosPS);
+
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLightPBR(vClusterPos, vWorldPos.xyz, -toCamera, normal, roughness, diffColor.rgb, specColor);
+        #endif
+
         vec3 reflection = normalize(reflect(toCamera, normal));
 
         vec3 cubeColor = vVertexLight.rgb;
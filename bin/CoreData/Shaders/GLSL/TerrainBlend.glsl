@@ -32,6 +32,9 @@ varying vec4 vWorldPos;
 #else
     varying vec3 vVertexLight;
     varying vec4 vScreenPos;
+    #ifdef CLUSTERED
+        varying vec4 vClusterPos;
+    #endif
     #ifdef ENVCUBEMAP
         varying vec3 vReflectionVec;
     #endif
@@ -97,6 +100,10 @@ void VS()
         
         vScreenPos = GetScreenPos(gl_Position);
 
+        #ifdef CLUSTERED
+            vClusterPos = vec4(worldPos, 1.0) * cClusterViewProj;
+        #endif
+
         #ifdef ENVCUBEMAP
             vReflectionVec = worldPos - cCameraPos;
         #endif
@@ -190,6 +197,11 @@ void PS()
             finalColor += lightInput.rgb * diffColor.rgb + lightSpecColor * specColor;
         #endif
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLight(vClusterPos, vWorldPos.xyz, normal, diffColor.rgb, specColor);
+        #endif
+
         gl_FragColor = vec4(GetFog(finalColor, fogFactor), diffColor.a);
     #endif
 }
@@ -43,6 +43,9 @@ uniform mat4 cZone;
 #ifdef GL3
     uniform vec4 cClipPlane;
 #endif
+#ifdef CLUSTERED
+    uniform mat4 cClusterViewProj;
+#endif
 #endif
 
 #ifdef COMPILEPS
@@ -87,6 +90,11 @@ uniform mat4 cLightMatricesPS[4];
 #ifdef VSM_SHADOW
 uniform vec2 cVSMShadowParams;
 #endif
+#ifdef CLUSTERED
+    uniform vec4 cClusterParams;
+    uniform vec2 cClusterDepth;
+    uniform vec3 cClusterTexParams;
+#endif
 #endif
 
 #else
@@ -113,6 +121,9 @@ uniform CameraVS
     mat4 cViewInv;
     mat4 cViewProj;
     vec4 cClipPlane;
+#ifdef CLUSTERED
+    mat4 cClusterViewProj;
+#endif
 };
 
 uniform ZoneVS
@@ -171,6 +182,11 @@ uniform CameraPS
     vec2 cGBufferInvSize;
     float cNearClipPS;
     float cFarClipPS;
+#ifdef CLUSTERED
+    vec4 cClusterParams;
+    vec2 cClusterDepth;
+    vec3 cClusterTexParams;
+#endif
 };
 
 uniform ZonePS
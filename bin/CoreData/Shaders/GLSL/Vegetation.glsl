@@ -36,6 +36,9 @@ varying vec4 vWorldPos;
 #else
     varying vec3 vVertexLight;
     varying vec4 vScreenPos;
+    #ifdef CLUSTERED
+        varying vec4 vClusterPos;
+    #endif
     #ifdef ENVCUBEMAP
         varying vec3 vReflectionVec;
     #endif
@@ -107,6 +110,10 @@ void VS()
 
         vScreenPos = GetScreenPos(gl_Position);
 
+        #ifdef CLUSTERED
+            vClusterPos = vec4(worldPos, 1.0) * cClusterViewProj;
+        #endif
+
         #ifdef ENVCUBEMAP
             vReflectionVec = worldPos - cCameraPos;
         #endif
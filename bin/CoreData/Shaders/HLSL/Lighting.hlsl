@@ -187,6 +187,96 @@ float GetIntensity(float3 color)
     return dot(color, float3(0.299, 0.587, 0.114));
 }
 
+#ifdef CLUSTERED
+#define MAXCLUSTERLIGHTS 32
+
+float4 GetClusterTexel(float index)
+{
+    float y = floor(index * cClusterTexParams.y);
+    float x = index - y * cClusterTexParams.x;
+    return Sample2DLod0(LightBuffer, float2((x + 0.5) * cClusterTexParams.y, (y + 0.5) * cClusterTexParams.z));
+}
+
+// Return the cluster record of a position: x = first light index, y = number of lights
+float4 GetCluster(float4 clusterPos)
+{
+    float2 tile = clamp(floor((clusterPos.xy / clusterPos.w * 0.5 + 0.5) * cClusterParams.xy), float2(0.0, 0.0), cClusterParams.xy - 1.0);
+    float slice = clamp(floor(log(max(clusterPos.z, 0.0001)) * cClusterDepth.x + cClusterDepth.y), 0.0, cClusterParams.z - 1.0);
+    return GetClusterTexel(tile.x + (tile.y + slice * cClusterParams.y) * cClusterParams.x);
+}
+
+// Return the range-scaled vector from a position to a clustered light, along with the light color and spot attenuation
+float3 GetClusterLightVec(float4 lightIndex, float3 worldPos, out float3 lightColor, out float spotAtten)
+{
+    // Light data is laid out like vertex lights: (color, 1 / range), (-direction, cutoff), (position, 1 / (1 - cutoff))
+    float4 color = GetClusterTexel(lightIndex.x);
+    float4 lightDir = GetClusterTexel(lightIndex.x + 1.0);
+    float4 lightPos = GetClusterTexel(lightIndex.x + 2.0);
+
+    float3 lightVec = (lightPos.xyz - worldPos) * color.w;
+    lightColor = color.rgb;
+    spotAtten = saturate((dot(normalize(lightVec), lightDir.xyz) - lightDir.w) * lightPos.w);
+    return lightVec;
+}
+
+float3 GetClusteredLight(float4 clusterPos, float3 worldPos, float3 normal, float3 diffColor, float3 specColor)
+{
+    float4 cluster = GetCluster(clusterPos);
+
+    float3 result = float3(0.0, 0.0, 0.0);
+    for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+    {
+        if (i >= cluster.y)
+            break;
+
+        float4 lightIndex = GetClusterTexel(cluster.x + i);
+        float3 lightColor;
+        float spotAtten;
+        float3 lightVec = GetClusterLightVec(lightIndex, worldPos, lightColor, spotAtten);
+        float lightDist = length(lightVec);
+        float3 localDir = lightVec / lightDist;
+        #ifdef TRANSLUCENT
+            float NdotL = abs(dot(normal, localDir));
+        #else
+            float NdotL = saturate(dot(normal, localDir));
+        #endif
+        float atten = saturate(1.0 - lightDist * lightDist);
+        float diff = NdotL * atten * spotAtten;
+
+        #ifdef SPECULAR
+            float spec = GetSpecular(normal, cCameraPosPS - worldPos, localDir, cMatSpecColor.a);
+            result += diff * lightColor * (diffColor + spec * specColor * lightIndex.y);
+        #else
+            result += diff * lightColor * diffColor;
+        #endif
+    }
+
+    return result;
+}
+
+// Return the lighting of all clustered lights on a volumetric (normal-less) surface such as a particle
+float3 GetClusteredLightVolumetric(float4 clusterPos, float3 worldPos)
+{
+    float4 cluster = GetCluster(clusterPos);
+
+    float3 result = float3(0.0, 0.0, 0.0);
+    for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+    {
+        if (i >= cluster.y)
+            break;
+
+        float3 lightColor;
+        float spotAtten;
+        float3 lightVec = GetClusterLightVec(GetClusterTexel(cluster.x + i), worldPos, lightColor, spotAtten);
+        float lightDist = length(lightVec);
+        float atten = saturate(1.0 - lightDist * lightDist);
+        result += atten * spotAtten * lightColor;
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #ifdef DIRLIGHT
@@ -58,6 +58,9 @@ void VS(float4 iPos : POSITION,
         #endif
     #else
         out float3 oVertexLight : TEXCOORD4,
+        #ifdef CLUSTERED
+            out float4 oClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         out float4 oColor : COLOR0,
@@ -115,6 +118,10 @@ void VS(float4 iPos : POSITION,
             for (int i = 0; i < NUMVERTEXLIGHTS; ++i)
                 oVertexLight += GetVertexLightVolumetric(i, worldPos) * cVertexLights[i * 3].rgb;
         #endif
+
+        #ifdef CLUSTERED
+            oClusterPos = mul(float4(worldPos, 1.0), cClusterViewProj);
+        #endif
     #endif
 }
 
@@ -135,6 +142,9 @@ void PS(float2 iTexCoord : TEXCOORD0,
         #endif
     #else
         float3 iVertexLight : TEXCOORD4,
+        #ifdef CLUSTERED
+            float4 iClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         float4 iColor : COLOR0,
@@ -217,6 +227,11 @@ void PS(float2 iTexCoord : TEXCOORD0,
         // Ambient & per-vertex lighting
         float3 finalColor = iVertexLight * diffColor.rgb;
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLightVolumetric(iClusterPos, iWorldPos.xyz) * diffColor.rgb;
+        #endif
+
         oColor = float4(GetFog(finalColor, fogFactor), diffColor.a);
     #endif
 }
@@ -58,6 +58,9 @@ void VS(float4 iPos : POSITION,
         #if defined(LIGHTMAP) || defined(AO)
             out float2 oTexCoord2 : TEXCOORD7,
         #endif
+        #ifdef CLUSTERED
+            out float4 oClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         out float4 oColor : COLOR0,
@@ -130,6 +133,10 @@ void VS(float4 iPos : POSITION,
         
         oScreenPos = GetScreenPos(oPos);
 
+        #ifdef CLUSTERED
+            oClusterPos = mul(float4(worldPos, 1.0), cClusterViewProj);
+        #endif
+
         #ifdef ENVCUBEMAP
             oReflectionVec = worldPos - cCameraPos;
         #endif
@@ -164,6 +171,9 @@ void PS(
         #if defined(LIGHTMAP) || defined(AO)
             float2 iTexCoord2 : TEXCOORD7,
         #endif
+        #ifdef CLUSTERED
+            float4 iClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         float4 iColor : COLOR0,
@@ -302,6 +312,11 @@ void PS(
             finalColor += lightInput.rgb * diffColor.rgb + lightSpecColor * specColor;
         #endif
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLight(iClusterPos, iWorldPos.xyz, normal, diffColor.rgb, specColor);
+        #endif
+
         #ifdef ENVCUBEMAP
             finalColor += cMatEnvMapColor * SampleCube(EnvCubeMap, reflect(iReflectionVec, normal)).rgb;
         #endif
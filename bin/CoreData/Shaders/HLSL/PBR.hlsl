@@ -158,4 +158,43 @@
 
         return diffuseFactor + specularFactor;
 	}
+
+    #ifdef CLUSTERED
+    // Return the summed PBR lighting of all point and spot lights binned to the pixel's cluster
+    // Clustered lights are evaluated as punctual lights with the forward spot light falloff
+    float3 GetClusteredLightPBR(float4 clusterPos, float3 worldPos, float3 toCamera, float3 normal, float roughness, float3 diffColor, float3 specColor)
+    {
+        float4 cluster = GetCluster(clusterPos);
+        const float ndv = clamp((dot(normal, toCamera)), M_EPSILON, 1.0);
+
+        float3 result = float3(0.0, 0.0, 0.0);
+        for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+        {
+            if (i >= cluster.y)
+                break;
+
+            float3 lightColor;
+            float spotAtten;
+            float3 lightVec = GetClusterLightVec(GetClusterTexel(cluster.x + i), worldPos, lightColor, spotAtten);
+            float lightDist = length(lightVec);
+            float3 lightDir = lightVec / lightDist;
+            float falloff = pow(saturate(1.0 - pow(lightDist, 4.0)), 2.0) / (lightDist * lightDist + 1.0);
+
+            const float3 Hn = normalize(toCamera + lightDir);
+            const float vdh = clamp((dot(toCamera, Hn)), M_EPSILON, 1.0);
+            const float ndh = clamp((dot(normal, Hn)), M_EPSILON, 1.0);
+            const float ndl = clamp((dot(normal, lightDir)), M_EPSILON, 1.0);
+            const float ldh = clamp((dot(lightDir, Hn)), M_EPSILON, 1.0);
+
+            float3 BRDF = Diffuse(diffColor, roughness, ndv, ndl, vdh) * ndl;
+            #ifdef SPECULAR
+                BRDF += Distribution(ndh, roughness) * Visibility(ndl, ndv, roughness) * Fresnel(specColor, vdh, ldh) * ndl / M_PI;
+            #endif
+
+            result += BRDF * lightColor * (ndl * falloff * spotAtten) / M_PI;
+        }
+
+        return result;
+    }
+    #endif
 #endif
@@ -61,6 +61,9 @@ void VS(float4 iPos : POSITION,
         #if defined(LIGHTMAP) || defined(AO)
             out float2 oTexCoord2 : TEXCOORD7,
         #endif
+        #ifdef CLUSTERED
+            out float4 oClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         out float4 oColor : COLOR0,
@@ -133,6 +136,10 @@ void VS(float4 iPos : POSITION,
 
         oScreenPos = GetScreenPos(oPos);
 
+        #ifdef CLUSTERED
+            oClusterPos = mul(float4(worldPos, 1.0), cClusterViewProj);
+        #endif
+
         #ifdef ENVCUBEMAP
             oReflectionVec = worldPos - cCameraPos;
         #endif
@@ -167,6 +174,9 @@ void PS(
         #if defined(LIGHTMAP) || defined(AO)
             float2 iTexCoord2 : TEXCOORD7,
         #endif
+        #ifdef CLUSTERED
+            float4 iClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         float4 iColor : COLOR0,
@@ -318,6 +328,11 @@ void PS(
 
         const float3 toCamera = normalize(iWorldPos.xyz - cCameraPosPS);
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLightPBR(iClusterPos, iWorldPos.xyz, -toCamera, normal, roughness, diffColor.rgb, specColor);
+        #endif
+
         const float3 reflection = normalize(reflect(toCamera, normal));
         float3 cubeColor = iVertexLight.rgb;
 
@@ -71,6 +71,9 @@ void VS(float4 iPos : POSITION,
     #else
         out float3 oVertexLight : TEXCOORD4,
         out float4 oScreenPos : TEXCOORD5,
+        #ifdef CLUSTERED
+            out float4 oClusterPos : TEXCOORD8,
+        #endif
     #endif
     #if defined(D3D11) && defined(CLIPPLANE)
         out float oClip : SV_CLIPDISTANCE0,
@@ -116,6 +119,10 @@ void VS(float4 iPos : POSITION,
         #endif
         
         oScreenPos = GetScreenPos(oPos);
+
+        #ifdef CLUSTERED
+            oClusterPos = mul(float4(worldPos, 1.0), cClusterViewProj);
+        #endif
     #endif
 }
 
@@ -136,6 +143,9 @@ void PS(float2 iTexCoord : TEXCOORD0,
     #else
         float3 iVertexLight : TEXCOORD4,
         float4 iScreenPos : TEXCOORD5,
+        #ifdef CLUSTERED
+            float4 iClusterPos : TEXCOORD8,
+        #endif
     #endif
     #if defined(D3D11) && defined(CLIPPLANE)
         float iClip : SV_CLIPDISTANCE0,
@@ -237,6 +247,11 @@ void PS(float2 iTexCoord : TEXCOORD0,
             finalColor += lightInput.rgb * diffColor.rgb + lightSpecColor * specColor;
         #endif
 
+        #ifdef CLUSTERED
+            // Add all point and spot lights binned to the pixel's cluster
+            finalColor += GetClusteredLight(iClusterPos, iWorldPos.xyz, normal, diffColor.rgb, specColor);
+        #endif
+
         oColor = float4(GetFog(finalColor, fogFactor), diffColor.a);
     #endif
 }
@@ -36,6 +36,9 @@ uniform float4x3 cZone;
 #else
     uniform float4x4 cLightMatrices[4];
 #endif
+#ifdef CLUSTERED
+    uniform float4x4 cClusterViewProj;
+#endif
 #endif
 
 #ifdef COMPILEPS
@@ -76,6 +79,11 @@ uniform float4x4 cLightMatricesPS[4];
 #ifdef VSM_SHADOW
 uniform float2 cVSMShadowParams;
 #endif
+#ifdef CLUSTERED
+    uniform float4 cClusterParams;
+    uniform float2 cClusterDepth;
+    uniform float3 cClusterTexParams;
+#endif
 #endif
 
 #else
@@ -103,6 +111,9 @@ cbuffer CameraVS : register(b1)
     float4x3 cViewInv;
     float4x4 cViewProj;
     float4 cClipPlane;
+#ifdef CLUSTERED
+    float4x4 cClusterViewProj;
+#endif
 }
 
 cbuffer ZoneVS : register(b2)
@@ -160,6 +171,11 @@ cbuffer CameraPS : register(b1)
     float2 cGBufferInvSize;
     float cNearClipPS;
     float cFarClipPS;
+#ifdef CLUSTERED
+    float4 cClusterParams;
+    float2 cClusterDepth;
+    float3 cClusterTexParams;
+#endif
 }
 
 cbuffer ZonePS : register(b2)
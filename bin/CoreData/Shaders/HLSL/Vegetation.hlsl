@@ -79,6 +79,9 @@ void VS(float4 iPos : POSITION,
         #if defined(LIGHTMAP) || defined(AO)
             out float2 oTexCoord2 : TEXCOORD7,
         #endif
+        #ifdef CLUSTERED
+            out float4 oClusterPos : TEXCOORD8,
+        #endif
     #endif
     #ifdef VERTEXCOLOR
         out float4 oColor : COLOR0,
@@ -157,6 +160,10 @@ void VS(float4 iPos : POSITION,
 
         oScreenPos = GetScreenPos(oPos);
 
+        #ifdef CLUSTERED
+            oClusterPos = mul(float4(worldPos, 1.0), cClusterViewProj);
+        #endif
+
         #ifdef ENVCUBEMAP
             oReflectionVec = worldPos - cCameraPos;
         #endif